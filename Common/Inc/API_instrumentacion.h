@@ -0,0 +1,120 @@
+/**
+ * @file API_instrumentacion.h
+ * @brief Módulo opcional de instrumentación de los drivers.
+ *        Registra, para cada operación, la cantidad de llamadas,
+ *        los bytes transferidos, los timeouts y un histograma de
+ *        latencia medido con el contador de ciclos. Se habilita
+ *        compilando con INSTR_HABILITADA = 1. Con el valor por
+ *        defecto (0) las macros no generan código y el módulo
+ *        no ocupa memoria.
+ */
+
+#ifndef API_INC_API_INSTRUMENTACION_H_
+#define API_INC_API_INSTRUMENTACION_H_
+
+#include "API_types.h"
+
+#ifndef INSTR_HABILITADA
+#define INSTR_HABILITADA			0
+#endif
+
+//cantidad de buckets del histograma. El bucket 0 cuenta las latencias
+//menores a 2^INSTR_BITS_BUCKET_0 ciclos, cada bucket siguiente duplica
+//el límite y el último cuenta todas las latencias mayores.
+#define INSTR_CANTIDAD_BUCKETS		16
+#define INSTR_BITS_BUCKET_0			6
+
+/**
+ *   @brief Operaciones instrumentadas.
+ */
+typedef enum {
+	INSTR_SPI_WRITE,
+	INSTR_SPI_READ,
+	INSTR_I2C_WRITE,
+	INSTR_DELAY,
+	INSTR_LEER_UID,
+	INSTR_ESPERAR_RESPUESTA,
+	INSTR_LCD_PRINT_TEXT,
+	INSTR_CANTIDAD_OPERACIONES
+} instr_operacion_enum;
+
+/**
+ *   @brief Estadísticas de una operación.
+ */
+typedef struct {
+	uint32_t llamadas;
+	uint32_t bytes;
+	uint32_t timeouts;
+	uint64_t ciclosTotales;
+	uint32_t ciclosMaximo;
+	uint32_t histograma[INSTR_CANTIDAD_BUCKETS];
+} instr_estadisticas_t;
+
+/**
+ *   @brief Tipo de función que recibe cada línea de texto
+ *          generada por instr_volcar.
+ */
+typedef void (*instr_salidaTypedef)(const char*);
+
+#if INSTR_HABILITADA
+
+/**
+ *   @brief Macros para medir una operación. INSTR_INICIO
+ *          declara la variable marca con el contador de ciclos
+ *          e INSTR_FIN registra la operación. Sin instrumentación
+ *          no generan código, por lo que sus argumentos no deben
+ *          tener efectos secundarios.
+ */
+#define INSTR_INICIO(marca)					uint32_t marca = instr_leerCiclos()
+#define INSTR_FIN(op, marca, bytes, timeout) \
+	instr_registrar((op), (bytes), instr_leerCiclos() - (marca), (timeout))
+
+/**
+ *   @brief Habilita el contador de ciclos y borra las estadísticas.
+ */
+void instr_init();
+
+/**
+ *   @brief Habilita el contador de ciclos y devuelve su valor.
+ *          Se implementan en API_instrumentacion_port.c.
+ */
+void instr_iniciarContador();
+uint32_t instr_leerCiclos();
+
+/**
+ *   @brief Registra una llamada a una operación.
+ */
+void instr_registrar(instr_operacion_enum op, uint32_t bytes,
+		uint32_t ciclos, bool_t timeout);
+
+/**
+ *   @brief Copia las estadísticas de una operación.
+ *   @retval Falso si la operación no es válida.
+ */
+bool_t instr_leer(instr_operacion_enum op, instr_estadisticas_t *destino);
+
+/**
+ *   @brief Borra las estadísticas de todas las operaciones.
+ */
+void instr_borrar();
+
+/**
+ *   @brief Devuelve el nombre de una operación.
+ */
+const char* instr_nombre(instr_operacion_enum op);
+
+/**
+ *   @brief Genera una línea de texto por cada operación con
+ *          llamadas, bytes, timeouts, ciclos promedio y máximo,
+ *          y el histograma, y la entrega a la función salida.
+ */
+void instr_volcar(instr_salidaTypedef salida);
+
+#else
+
+#define INSTR_INICIO(marca)
+#define INSTR_FIN(op, marca, bytes, timeout)
+
+#endif /* INSTR_HABILITADA */
+
+#endif /* API_INC_API_INSTRUMENTACION_H_ */
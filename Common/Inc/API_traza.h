@@ -0,0 +1,145 @@
+/**
+ * @file API_traza.h
+ * @brief Módulo opcional que registra cada transacción de los
+ *        buses SPI e I2C (tiempo, tipo, lector o bus, registro o
+ *        dirección, datos y error) en un buffer circular en RAM,
+ *        para volcarlo luego por una salida de texto y reproducirlo
+ *        en la PC con Host/Tools/comparar_trazas.c. Cuando el buffer
+ *        se llena se descartan las transacciones más antiguas.
+ *        Se habilita compilando con TRAZA_HABILITADA = 1. Con el
+ *        valor por defecto (0) las macros no generan código y el
+ *        módulo no ocupa memoria.
+ */
+
+#ifndef API_INC_API_TRAZA_H_
+#define API_INC_API_TRAZA_H_
+
+#include "API_types.h"
+
+#ifndef TRAZA_HABILITADA
+#define TRAZA_HABILITADA			0
+#endif
+
+//tamaño en bytes del buffer circular. Cada transacción ocupa
+//TRAZA_BYTES_ENCABEZADO bytes más sus datos.
+#ifndef TRAZA_TAMANIO_BUFFER
+#define TRAZA_TAMANIO_BUFFER		4096
+#endif
+#define TRAZA_BYTES_ENCABEZADO		5
+//máximo de bytes de datos que se guardan por transacción. Si se
+//transfieren más, se guardan los primeros y el largo real.
+#define TRAZA_MAX_DATOS				128
+//cantidad de lectores o buses que se pueden distinguir
+#define TRAZA_MAX_DISPOSITIVOS		32
+
+/**
+ *   @brief Tipos de transacción. En TRAZA_SPI_TRANSFERENCIA los
+ *          datos son los bytes transmitidos seguidos de los
+ *          recibidos, por lo que ocupan el doble del largo.
+ */
+typedef enum {
+	TRAZA_SPI_ESCRITURA,
+	TRAZA_SPI_LECTURA,
+	TRAZA_SPI_TRANSFERENCIA,
+	TRAZA_I2C_ESCRITURA,
+	TRAZA_CANTIDAD_TIPOS
+} traza_tipo_enum;
+
+/**
+ *   @brief Transacción leída de la traza. direccion es el
+ *          byte de dirección del registro tal como se envía
+ *          por SPI, o la dirección de 7 bits del I2C. tiempoUs
+ *          se cuenta desde la primera transacción registrada
+ *          luego de traza_init; las pausas de más de 65 ms entre
+ *          dos transacciones se registran como 65 ms. Los largos
+ *          mayores a 255 bytes se registran como 255.
+ */
+typedef struct {
+	uint32_t tiempoUs;
+	traza_tipo_enum tipo;
+	uint8_t dispositivo;
+	uint8_t direccion;
+	bool_t error;
+	uint16_t largo;			//bytes transferidos (sin la dirección)
+	uint16_t guardados;		//bytes de datos guardados
+	uint8_t datos[2 * TRAZA_MAX_DATOS];
+} traza_transaccion_t;
+
+/**
+ *   @brief Tipo de función que recibe cada línea de texto
+ *          generada por traza_volcar.
+ */
+typedef void (*traza_salidaTypedef)(const char*);
+
+#if TRAZA_HABILITADA
+
+/**
+ *   @brief Macros para registrar una transacción desde los ports.
+ *          Sin traza no generan código, por lo que sus argumentos
+ *          no deben tener efectos secundarios.
+ */
+#define TRAZA_REGISTRAR(tipo, dispositivo, direccion, datos, largo, error) \
+	traza_registrar((tipo), (dispositivo), (direccion), (datos), (largo), (error))
+#define TRAZA_TRANSFERENCIA(lector, tx, rx, largo, error) \
+	traza_registrarTransferencia((lector), (tx), (rx), (largo), (error))
+
+/**
+ *   @brief Vacía el buffer y comienza a registrar.
+ */
+void traza_init();
+
+/**
+ *   @brief Registra una transacción con sus datos. Se puede
+ *          llamar desde interrupciones.
+ */
+void traza_registrar(traza_tipo_enum tipo, uint8_t dispositivo,
+		uint8_t direccion, const uint8_t *datos, uint16_t largo, bool_t error);
+
+/**
+ *   @brief Registra una transferencia SPI full-duplex con los
+ *          bytes transmitidos y recibidos. rx puede ser NULL.
+ */
+void traza_registrarTransferencia(uint8_t lector, const uint8_t *tx,
+		const uint8_t *rx, uint16_t largo, bool_t error);
+
+/**
+ *   @brief Deja de registrar (por ejemplo, mientras se vuelca
+ *          la traza por un bus trazado) o vuelve a registrar.
+ */
+void traza_pausar(bool_t pausa);
+
+/**
+ *   @brief Extrae del buffer la transacción más antigua.
+ *   @retval Falso si el buffer está vacío.
+ */
+bool_t traza_leer(traza_transaccion_t *destino);
+
+/**
+ *   @brief Cantidad de transacciones descartadas por
+ *          falta de lugar desde traza_init.
+ */
+uint32_t traza_descartadas();
+
+/**
+ *   @brief Extrae todas las transacciones del buffer y genera
+ *          una línea de texto por cada una, que entrega a la
+ *          función salida. Durante el volcado no se registra.
+ */
+void traza_volcar(traza_salidaTypedef salida);
+
+/**
+ *   @brief Tiempo en uS y sección crítica para registrar desde
+ *          interrupciones. Se implementan en API_traza_port.c.
+ */
+uint32_t traza_leerUs();
+uint32_t traza_bloquear();
+void traza_desbloquear(uint32_t estado);
+
+#else
+
+#define TRAZA_REGISTRAR(tipo, dispositivo, direccion, datos, largo, error)
+#define TRAZA_TRANSFERENCIA(lector, tx, rx, largo, error)
+
+#endif /* TRAZA_HABILITADA */
+
+#endif /* API_INC_API_TRAZA_H_ */
@@ -0,0 +1,138 @@
+/**
+ * @file API_instrumentacion.c
+ * @brief Implementación del módulo de instrumentación.
+ *        Las estadísticas se guardan en un arreglo estático
+ *        de tamaño fijo, sin memoria dinámica.
+ */
+
+#include "API_instrumentacion.h"
+
+#if INSTR_HABILITADA
+
+#define LARGO_LINEA					256
+
+static instr_estadisticas_t estadisticas[INSTR_CANTIDAD_OPERACIONES];
+
+static const char *const NOMBRES[INSTR_CANTIDAD_OPERACIONES] = { "spiWrite",
+		"spiRead", "i2cWrite", "delay", "leerUIDTarjeta",
+		"esperarRespuesta", "LCD_printText" };
+
+static uint8_t instr_bucket(uint32_t);
+static char* instr_agregarTexto(char*, const char*);
+static char* instr_agregarNumero(char*, uint64_t);
+
+void instr_init() {
+	instr_iniciarContador();
+	instr_borrar();
+}
+
+/**
+ *	@brief Registra una llamada. No debe llamarse desde
+ *		   interrupciones, ya que la actualización de las
+ *		   estadísticas no es atómica.
+ */
+void instr_registrar(instr_operacion_enum op, uint32_t bytes,
+		uint32_t ciclos, bool_t timeout) {
+	if (op >= INSTR_CANTIDAD_OPERACIONES)
+		return;
+
+	instr_estadisticas_t *e = &estadisticas[op];
+	e->llamadas++;
+	e->bytes += bytes;
+	if (timeout)
+		e->timeouts++;
+	e->ciclosTotales += ciclos;
+	if (ciclos > e->ciclosMaximo)
+		e->ciclosMaximo = ciclos;
+	e->histograma[instr_bucket(ciclos)]++;
+}
+
+bool_t instr_leer(instr_operacion_enum op, instr_estadisticas_t *destino) {
+	if (op >= INSTR_CANTIDAD_OPERACIONES || destino == NULL)
+		return false;
+	*destino = estadisticas[op];
+	return true;
+}
+
+void instr_borrar() {
+	instr_estadisticas_t vacio = { 0 };
+	for (uint8_t op = 0; op < INSTR_CANTIDAD_OPERACIONES; op++) {
+		estadisticas[op] = vacio;
+	}
+}
+
+const char* instr_nombre(instr_operacion_enum op) {
+	if (op >= INSTR_CANTIDAD_OPERACIONES)
+		return "";
+	return NOMBRES[op];
+}
+
+/**
+ *	@brief Genera una línea por operación con el formato:
+ *		   nombre llamadas=N bytes=N timeouts=N prom=N max=N h=[b0 ... b15]
+ *		   No utiliza printf para no agregar dependencias.
+ */
+void instr_volcar(instr_salidaTypedef salida) {
+	if (salida == NULL)
+		return;
+
+	char linea[LARGO_LINEA];
+	for (uint8_t op = 0; op < INSTR_CANTIDAD_OPERACIONES; op++) {
+		const instr_estadisticas_t *e = &estadisticas[op];
+		char *p = instr_agregarTexto(linea, NOMBRES[op]);
+		p = instr_agregarTexto(p, " llamadas=");
+		p = instr_agregarNumero(p, e->llamadas);
+		p = instr_agregarTexto(p, " bytes=");
+		p = instr_agregarNumero(p, e->bytes);
+		p = instr_agregarTexto(p, " timeouts=");
+		p = instr_agregarNumero(p, e->timeouts);
+		p = instr_agregarTexto(p, " prom=");
+		p = instr_agregarNumero(p,
+				e->llamadas ? e->ciclosTotales / e->llamadas : 0);
+		p = instr_agregarTexto(p, " max=");
+		p = instr_agregarNumero(p, e->ciclosMaximo);
+		p = instr_agregarTexto(p, " h=[");
+		for (uint8_t b = 0; b < INSTR_CANTIDAD_BUCKETS; b++) {
+			if (b > 0)
+				p = instr_agregarTexto(p, " ");
+			p = instr_agregarNumero(p, e->histograma[b]);
+		}
+		instr_agregarTexto(p, "]");
+		salida(linea);
+	}
+}
+
+/**
+ *	@brief Bucket del histograma para una latencia.
+ */
+static uint8_t instr_bucket(uint32_t ciclos) {
+	uint8_t bucket = 0;
+	ciclos >>= INSTR_BITS_BUCKET_0;
+	while (ciclos != 0 && bucket < INSTR_CANTIDAD_BUCKETS - 1) {
+		ciclos >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+static char* instr_agregarTexto(char *destino, const char *texto) {
+	while (*texto != '\0')
+		*destino++ = *texto++;
+	*destino = '\0';
+	return destino;
+}
+
+static char* instr_agregarNumero(char *destino, uint64_t valor) {
+	char digitos[20];
+	uint8_t cantidad = 0;
+	do {
+		digitos[cantidad++] = (char) ('0' + valor % 10);
+		valor /= 10;
+	} while (valor != 0);
+	while (cantidad > 0)
+		*destino++ = digitos[--cantidad];
+	*destino = '\0';
+	return destino;
+}
+
+#endif /* INSTR_HABILITADA */
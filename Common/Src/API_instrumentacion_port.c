@@ -0,0 +1,29 @@
+/**
+ * @file API_instrumentacion_port.c
+ * @brief Acceso al contador de ciclos del DWT
+ *        para el módulo de instrumentación.
+ */
+
+#include "API_instrumentacion.h"
+
+#if INSTR_HABILITADA
+
+#include "stm32f4xx.h"
+
+/**
+ *   @brief Habilita el contador de ciclos del DWT. No lo
+ *		   reinicia, ya que el driver del LCD también lo usa.
+ */
+void instr_iniciarContador() {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ *   @brief Devuelve el contador de ciclos del DWT.
+ */
+uint32_t instr_leerCiclos() {
+	return DWT->CYCCNT;
+}
+
+#endif /* INSTR_HABILITADA */
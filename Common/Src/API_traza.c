@@ -0,0 +1,267 @@
+/**
+ * @file API_traza.c
+ * @brief Implementación del módulo de traza. Las transacciones
+ *        se guardan una detrás de otra en un arreglo estático
+ *        usado como buffer circular, sin memoria dinámica. Cada
+ *        una ocupa un encabezado de TRAZA_BYTES_ENCABEZADO bytes:
+ *        - tipo (bits 7-6), error (bit 5) y dispositivo (bits 4-0)
+ *        - dirección del registro o del dispositivo I2C
+ *        - uS desde la transacción anterior (16 bits, little endian)
+ *        - largo transferido
+ *        seguido de los datos guardados.
+ */
+
+#include "API_traza.h"
+
+#if TRAZA_HABILITADA
+
+#if TRAZA_TAMANIO_BUFFER <= TRAZA_BYTES_ENCABEZADO + 2 * TRAZA_MAX_DATOS
+#error "TRAZA_TAMANIO_BUFFER no alcanza para una transacción"
+#endif
+
+#define BITS_TIPO					6
+#define BIT_ERROR					(1 << 5)
+#define MASCARA_DISPOSITIVO			(TRAZA_MAX_DISPOSITIVOS - 1)
+#define MAX_DELTA_US				UINT16_MAX
+#define MAX_LARGO					UINT8_MAX
+#define LARGO_LINEA					(48 + 4 * TRAZA_MAX_DATOS + 2)
+
+static uint8_t buffer[TRAZA_TAMANIO_BUFFER];
+static uint32_t inicio;			//primer byte de la transacción más antigua
+static uint32_t ocupados;
+static uint32_t ultimoUs;		//tiempo de la última transacción registrada
+static uint32_t tiempoLecturaUs;	//tiempo de la última transacción extraída
+static uint32_t descartadas;
+static bool_t primera;
+static bool_t registrando;
+
+static const char *const TIPOS[TRAZA_CANTIDAD_TIPOS] = { "SW", "SR", "ST",
+		"IW" };
+
+static void traza_escribir(traza_tipo_enum, uint8_t, uint8_t, const uint8_t*,
+		const uint8_t*, uint16_t, bool_t);
+static uint16_t traza_guardados(traza_tipo_enum, uint16_t);
+static uint8_t traza_byte(uint32_t);
+static void traza_agregarByte(uint8_t);
+static bool_t traza_extraer(traza_transaccion_t*);
+static char* traza_agregarTexto(char*, const char*);
+static char* traza_agregarNumero(char*, uint32_t);
+static char* traza_agregarHex(char*, const uint8_t*, uint16_t);
+
+void traza_init() {
+	uint32_t estado = traza_bloquear();
+	inicio = 0;
+	ocupados = 0;
+	tiempoLecturaUs = 0;
+	descartadas = 0;
+	primera = true;
+	registrando = true;
+	traza_desbloquear(estado);
+}
+
+void traza_registrar(traza_tipo_enum tipo, uint8_t dispositivo,
+		uint8_t direccion, const uint8_t *datos, uint16_t largo, bool_t error) {
+	if (tipo >= TRAZA_CANTIDAD_TIPOS || tipo == TRAZA_SPI_TRANSFERENCIA)
+		return;
+	traza_escribir(tipo, dispositivo, direccion, datos, NULL, largo, error);
+}
+
+void traza_registrarTransferencia(uint8_t lector, const uint8_t *tx,
+		const uint8_t *rx, uint16_t largo, bool_t error) {
+	traza_escribir(TRAZA_SPI_TRANSFERENCIA, lector, 0, tx, rx, largo, error);
+}
+
+void traza_pausar(bool_t pausa) {
+	registrando = !pausa;
+}
+
+bool_t traza_leer(traza_transaccion_t *destino) {
+	if (destino == NULL)
+		return false;
+	uint32_t estado = traza_bloquear();
+	bool_t exito = traza_extraer(destino);
+	traza_desbloquear(estado);
+	return exito;
+}
+
+uint32_t traza_descartadas() {
+	return descartadas;
+}
+
+/**
+ *	@brief Genera una línea por transacción con el formato:
+ *		   tiempoUs tipo dispositivo direccion largo error datos
+ *		   donde tipo es SW, SR, ST o IW, direccion y datos están
+ *		   en hexadecimal, error es E o -, y en ST los bytes
+ *		   transmitidos y recibidos se separan con '/'. Si no hay
+ *		   datos guardados se escribe '-'. La primera línea indica
+ *		   las transacciones descartadas. No utiliza printf para no
+ *		   agregar dependencias.
+ */
+void traza_volcar(traza_salidaTypedef salida) {
+	static traza_transaccion_t transaccion;
+	char linea[LARGO_LINEA];
+	if (salida == NULL)
+		return;
+
+	bool_t estabaRegistrando = registrando;
+	registrando = false;
+	char *p = traza_agregarTexto(linea, "# descartadas=");
+	traza_agregarNumero(p, descartadas);
+	salida(linea);
+
+	while (traza_leer(&transaccion)) {
+		p = traza_agregarNumero(linea, transaccion.tiempoUs);
+		p = traza_agregarTexto(p, " ");
+		p = traza_agregarTexto(p, TIPOS[transaccion.tipo]);
+		p = traza_agregarTexto(p, " ");
+		p = traza_agregarNumero(p, transaccion.dispositivo);
+		p = traza_agregarTexto(p, " ");
+		p = traza_agregarHex(p, &transaccion.direccion, 1);
+		p = traza_agregarTexto(p, " ");
+		p = traza_agregarNumero(p, transaccion.largo);
+		p = traza_agregarTexto(p, transaccion.error ? " E " : " - ");
+		if (transaccion.guardados == 0) {
+			traza_agregarTexto(p, "-");
+		} else if (transaccion.tipo == TRAZA_SPI_TRANSFERENCIA) {
+			uint16_t mitad = transaccion.guardados / 2;
+			p = traza_agregarHex(p, transaccion.datos, mitad);
+			p = traza_agregarTexto(p, "/");
+			traza_agregarHex(p, transaccion.datos + mitad, mitad);
+		} else {
+			traza_agregarHex(p, transaccion.datos, transaccion.guardados);
+		}
+		salida(linea);
+	}
+	registrando = estabaRegistrando;
+}
+
+/**
+ *	@brief Agrega una transacción al buffer. Si no hay lugar
+ *		   descarta las más antiguas, sumando su tiempo al de
+ *		   lectura para que no cambien las marcas de tiempo de
+ *		   las siguientes. En una transferencia se guardan los
+ *		   bytes transmitidos y luego los recibidos (0 si rx es NULL).
+ */
+static void traza_escribir(traza_tipo_enum tipo, uint8_t dispositivo,
+		uint8_t direccion, const uint8_t *tx, const uint8_t *rx,
+		uint16_t largo, bool_t error) {
+	if (!registrando || (tx == NULL && largo > 0))
+		return;
+	if (largo > MAX_LARGO)
+		largo = MAX_LARGO;
+	uint16_t guardados = traza_guardados(tipo, largo);
+	uint16_t porParte = (tipo == TRAZA_SPI_TRANSFERENCIA) ?
+			guardados / 2 : guardados;
+
+	uint32_t estado = traza_bloquear();
+	uint32_t ahora = traza_leerUs();
+	uint32_t delta = primera ? 0 : ahora - ultimoUs;
+	if (delta > MAX_DELTA_US)
+		delta = MAX_DELTA_US;
+	ultimoUs = ahora;
+	primera = false;
+
+	uint32_t tamanioNueva = TRAZA_BYTES_ENCABEZADO + guardados;
+	while (TRAZA_TAMANIO_BUFFER - ocupados < tamanioNueva) {
+		uint16_t tamanio = TRAZA_BYTES_ENCABEZADO
+				+ traza_guardados((traza_tipo_enum) (traza_byte(0) >> BITS_TIPO),
+						traza_byte(4));
+		tiempoLecturaUs += traza_byte(2) | (uint16_t) traza_byte(3) << 8;
+		inicio = (inicio + tamanio) % TRAZA_TAMANIO_BUFFER;
+		ocupados -= tamanio;
+		descartadas++;
+	}
+
+	traza_agregarByte((uint8_t) (tipo << BITS_TIPO | (error ? BIT_ERROR : 0)
+			| (dispositivo & MASCARA_DISPOSITIVO)));
+	traza_agregarByte(direccion);
+	traza_agregarByte((uint8_t) delta);
+	traza_agregarByte((uint8_t) (delta >> 8));
+	traza_agregarByte((uint8_t) largo);
+	for (uint16_t i = 0; i < porParte; i++)
+		traza_agregarByte(tx[i]);
+	if (tipo == TRAZA_SPI_TRANSFERENCIA) {
+		for (uint16_t i = 0; i < porParte; i++)
+			traza_agregarByte(rx != NULL ? rx[i] : 0);
+	}
+	traza_desbloquear(estado);
+}
+
+/**
+ *	@brief Bytes de datos que se guardan para una transacción.
+ */
+static uint16_t traza_guardados(traza_tipo_enum tipo, uint16_t largo) {
+	uint16_t guardados = largo < TRAZA_MAX_DATOS ? largo : TRAZA_MAX_DATOS;
+	return tipo == TRAZA_SPI_TRANSFERENCIA ? 2 * guardados : guardados;
+}
+
+/**
+ *	@brief Byte del buffer a partir de la transacción más antigua.
+ */
+static uint8_t traza_byte(uint32_t desplazamiento) {
+	return buffer[(inicio + desplazamiento) % TRAZA_TAMANIO_BUFFER];
+}
+
+static void traza_agregarByte(uint8_t valor) {
+	buffer[(inicio + ocupados) % TRAZA_TAMANIO_BUFFER] = valor;
+	ocupados++;
+}
+
+/**
+ *	@brief Extrae la transacción más antigua. Se llama
+ *		   dentro de la sección crítica.
+ */
+static bool_t traza_extraer(traza_transaccion_t *destino) {
+	if (ocupados == 0)
+		return false;
+	uint8_t primerByte = traza_byte(0);
+	destino->tipo = (traza_tipo_enum) (primerByte >> BITS_TIPO);
+	destino->error = (primerByte & BIT_ERROR) != 0;
+	destino->dispositivo = primerByte & MASCARA_DISPOSITIVO;
+	destino->direccion = traza_byte(1);
+	tiempoLecturaUs += traza_byte(2) | (uint16_t) traza_byte(3) << 8;
+	destino->tiempoUs = tiempoLecturaUs;
+	destino->largo = traza_byte(4);
+	destino->guardados = traza_guardados(destino->tipo, destino->largo);
+	for (uint16_t i = 0; i < destino->guardados; i++)
+		destino->datos[i] = traza_byte(TRAZA_BYTES_ENCABEZADO + i);
+
+	uint16_t tamanio = TRAZA_BYTES_ENCABEZADO + destino->guardados;
+	inicio = (inicio + tamanio) % TRAZA_TAMANIO_BUFFER;
+	ocupados -= tamanio;
+	return true;
+}
+
+static char* traza_agregarTexto(char *destino, const char *texto) {
+	while (*texto != '\0')
+		*destino++ = *texto++;
+	*destino = '\0';
+	return destino;
+}
+
+static char* traza_agregarNumero(char *destino, uint32_t valor) {
+	char digitos[10];
+	uint8_t cantidad = 0;
+	do {
+		digitos[cantidad++] = (char) ('0' + valor % 10);
+		valor /= 10;
+	} while (valor != 0);
+	while (cantidad > 0)
+		*destino++ = digitos[--cantidad];
+	*destino = '\0';
+	return destino;
+}
+
+static char* traza_agregarHex(char *destino, const uint8_t *datos,
+		uint16_t largo) {
+	static const char HEX[] = "0123456789ABCDEF";
+	for (uint16_t i = 0; i < largo; i++) {
+		*destino++ = HEX[datos[i] >> 4];
+		*destino++ = HEX[datos[i] & 0x0F];
+	}
+	*destino = '\0';
+	return destino;
+}
+
+#endif /* TRAZA_HABILITADA */
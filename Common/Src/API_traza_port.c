@@ -0,0 +1,52 @@
+/**
+ * @file API_traza_port.c
+ * @brief Tiempo en uS, a partir del contador de ciclos del
+ *        DWT, y sección crítica para el módulo de traza.
+ */
+
+#include "API_traza.h"
+
+#if TRAZA_HABILITADA
+
+#include "stm32f4xx.h"
+
+/**
+ *   @brief Acumula los ciclos transcurridos desde la llamada
+ *		   anterior, por lo que el tiempo no se reinicia cuando
+ *		   el contador de 32 bits da la vuelta, siempre que se
+ *		   llame al menos una vez por vuelta (51 s a 84 MHz).
+ *		   Se llama dentro de la sección crítica.
+ */
+uint32_t traza_leerUs() {
+	static uint32_t ultimoCiclo, restoCiclos, tiempoUs;
+	static bool_t iniciado = false;
+	if (!iniciado) {
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+		ultimoCiclo = DWT->CYCCNT;
+		iniciado = true;
+	}
+	uint32_t ciclo = DWT->CYCCNT;
+	uint32_t ciclosPorUs = SystemCoreClock / 1000000;
+	restoCiclos += ciclo - ultimoCiclo;
+	ultimoCiclo = ciclo;
+	tiempoUs += restoCiclos / ciclosPorUs;
+	restoCiclos %= ciclosPorUs;
+	return tiempoUs;
+}
+
+/**
+ *   @brief Deshabilita las interrupciones y devuelve
+ *		   el estado anterior para restaurarlo.
+ */
+uint32_t traza_bloquear() {
+	uint32_t estado = __get_PRIMASK();
+	__disable_irq();
+	return estado;
+}
+
+void traza_desbloquear(uint32_t estado) {
+	__set_PRIMASK(estado);
+}
+
+#endif /* TRAZA_HABILITADA */
@@ -0,0 +1,197 @@
+/**
+ * @file bench_cpp.cpp
+ * @brief Benchmark de PC de las interfaces en C++ de ambos
+ * 		  drivers (API_mfrc522.hpp y API_lcd.hpp). Usa dos lectores
+ * 		  y dos displays de geometrías distintas, cada uno con su
+ * 		  propio tipo, y compara las transacciones, los bytes y el
+ * 		  tiempo de cada operación con las del driver en C sobre
+ * 		  los mismos modelos.
+ *
+ * 		  Compilación (los drivers y los ports en C se compilan
+ * 		  como C y el benchmark como C++17):
+ * 		  gcc -std=c11 -O2 -c -DAPI_PORT_HOST -DIRQ_HABILITADA=0
+ * 		      -IRC522_driver/Inc -ILCD16x2_driver/Inc -IHost/Inc -ICommon/Inc
+ * 		      Host/Src/host_plataforma.c Host/Src/sim_mfrc522.c
+ * 		      Host/Src/sim_hd44780.c Host/Src/API_mfrc522_port_host.c
+ * 		      Host/Src/API_lcd_port_host.c RC522_driver/Src/API_mfrc522.c
+ * 		      LCD16x2_driver/Src/API_lcd.c
+ * 		      LCD16x2_driver/Src/API_lcd_glifos.c
+ * 		      LCD16x2_driver/Src/API_lcd_formato.c
+ * 		  g++ -std=c++17 -O2 -DAPI_PORT_HOST -DIRQ_HABILITADA=0
+ * 		      -IRC522_driver/Inc -ILCD16x2_driver/Inc -IHost/Inc -ICommon/Inc
+ * 		      Host/Bench/bench_cpp.cpp *.o -o bench_cpp
+ *
+ * 		  Con IRQ_HABILITADA = 0 ambos drivers consultan ComIrqReg
+ * 		  por SPI, por lo que la comparación es en igualdad de
+ * 		  condiciones.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "API_mfrc522.hpp"
+#include "API_lcd.hpp"
+#include "host_puertos.hpp"
+
+extern "C" {
+#include "sim_mfrc522.h"
+#include "sim_hd44780.h"
+#include "host_plataforma.h"
+}
+
+using Lector0 = Mfrc522<host::BusSpi, host::PinCs<0>>;
+using Lector1 = Mfrc522<host::BusSpi, host::PinCs<1>>;
+using Display16x2 = Lcd<host::BusI2c<0>, 0x26, 16, 2>;
+using Display20x4 = Lcd<host::BusI2c<0>, 0x25, 20, 4>;
+
+static const uint8_t UID_DOBLE[] = { 0x04, 0x11, 0x22, 0x33, 0x44, 0x55,
+		0x66 };
+static const char TEXTO_PRUEBA[] = "Acceso permitido";
+
+static uint64_t inicioMedicion = 0;
+
+static void iniciarMedicion();
+static void reportar(const char*, host_bus_enum);
+static void compararLectores();
+static void compararDisplays();
+static bool_t textoCorrecto(int, uint8_t, const char*);
+
+int main(void) {
+	printf("%-32s %6s %7s %10s %11s\n", "operacion", "trans", "bytes",
+			"bus[us]", "total[us]");
+
+	compararLectores();
+	compararDisplays();
+	return host_errores() ? 1 : 0;
+}
+
+static void iniciarMedicion() {
+	host_borrarContadores();
+	inicioMedicion = host_tiempoNs();
+}
+
+static void reportar(const char *operacion, host_bus_enum bus) {
+	host_estadisticasBus_t estadisticas = host_leerBus(bus);
+	printf("%-32s %6lu %7lu %10.1f %11.1f\n", operacion,
+			(unsigned long) estadisticas.transacciones,
+			(unsigned long) estadisticas.bytes, estadisticas.tiempoNs / 1000.0,
+			(host_tiempoNs() - inicioMedicion) / 1000.0);
+}
+
+/**
+ *	@brief Inicializa y lee un UID simple y uno doble con el
+ *		   driver en C y con los tipos Lector0 y Lector1. Entre
+ *		   ambos se reinicia el modelo, porque un REQA a una
+ *		   tarjeta ya seleccionada no tiene respuesta.
+ */
+static void compararLectores() {
+	mfrc522_t lectores[2];
+	mfrc522_uid_t uid;
+
+	host_reiniciar();
+	simMfrc522_reset();
+	iniciarMedicion();
+	host_verificar(mfrc522_lectorInit(&lectores[0], 0),
+			"mfrc522_lectorInit fallo");
+	reportar("C   mfrc522_lectorInit", HOST_BUS_SPI);
+	mfrc522_lectorInit(&lectores[1], 1);
+
+	simMfrc522_agregarTarjeta(0, HOST_UID_PRUEBA, sizeof(HOST_UID_PRUEBA));
+	simMfrc522_agregarTarjeta(1, UID_DOBLE, sizeof(UID_DOBLE));
+	iniciarMedicion();
+	host_verificar(mfrc522_lectorLeerUID(&lectores[0], &uid)
+			&& uid.largo == sizeof(HOST_UID_PRUEBA)
+			&& memcmp(uid.uid, HOST_UID_PRUEBA, uid.largo) == 0,
+			"C: UID simple incorrecto");
+	reportar("C   leer UID simple", HOST_BUS_SPI);
+	iniciarMedicion();
+	host_verificar(mfrc522_lectorLeerUID(&lectores[1], &uid)
+			&& uid.largo == sizeof(UID_DOBLE)
+			&& memcmp(uid.uid, UID_DOBLE, uid.largo) == 0,
+			"C: UID doble incorrecto");
+	reportar("C   leer UID doble", HOST_BUS_SPI);
+	iniciarMedicion();
+	host_verificar(!mfrc522_lectorLeerUID(&lectores[0], &uid),
+			"C: REQA a una tarjeta seleccionada");
+	reportar("C   leer sin tarjeta", HOST_BUS_SPI);
+
+	host_reiniciar();
+	simMfrc522_reset();
+	iniciarMedicion();
+	host_verificar(Lector0::init(), "Lector0::init fallo");
+	reportar("C++ Lector0::init", HOST_BUS_SPI);
+	Lector1::init();
+
+	simMfrc522_agregarTarjeta(0, HOST_UID_PRUEBA, sizeof(HOST_UID_PRUEBA));
+	simMfrc522_agregarTarjeta(1, UID_DOBLE, sizeof(UID_DOBLE));
+	iniciarMedicion();
+	host_verificar(Lector0::leerUID(uid) && uid.largo == sizeof(HOST_UID_PRUEBA)
+			&& memcmp(uid.uid, HOST_UID_PRUEBA, uid.largo) == 0,
+			"C++: UID simple incorrecto");
+	reportar("C++ Lector0::leerUID simple", HOST_BUS_SPI);
+	iniciarMedicion();
+	host_verificar(Lector1::leerUID(uid) && uid.largo == sizeof(UID_DOBLE)
+			&& memcmp(uid.uid, UID_DOBLE, uid.largo) == 0,
+			"C++: UID doble incorrecto");
+	reportar("C++ Lector1::leerUID doble", HOST_BUS_SPI);
+	iniciarMedicion();
+	host_verificar(!Lector0::leerUID(uid),
+			"C++: REQA a una tarjeta seleccionada");
+	reportar("C++ Lector0::leerUID sin tarjeta", HOST_BUS_SPI);
+}
+
+/**
+ *	@brief Inicializa un display de 16x2 con el driver en C y
+ *		   uno de 16x2 y otro de 20x4 con los tipos Display16x2
+ *		   y Display20x4, y escribe el mismo texto en cada uno.
+ */
+static void compararDisplays() {
+	LCD_HandleTypedef lcd;
+
+	host_reiniciar();
+	simHd44780_reset();
+	int displayC = simHd44780_agregar(0x27, host_tiempoNs());
+	int display16x2 = simHd44780_agregar(0x26, host_tiempoNs());
+	int display20x4 = simHd44780_agregar(0x25, host_tiempoNs());
+
+	iniciarMedicion();
+	host_verificar(LCD_displayInit(&lcd, 0, 0x27, 16, 2) == LCD_OK,
+			"LCD_displayInit fallo");
+	reportar("C   LCD_displayInit", HOST_BUS_I2C);
+	iniciarMedicion();
+	LCD_displayWriteSpan(&lcd, LCD_FILA_2, 0, TEXTO_PRUEBA,
+			sizeof(TEXTO_PRUEBA) - 1);
+	reportar("C   LCD_displayWriteSpan", HOST_BUS_I2C);
+	host_verificar(textoCorrecto(displayC, LCD_FILA_2, TEXTO_PRUEBA),
+			"C: texto incorrecto");
+
+	iniciarMedicion();
+	host_verificar(Display16x2::init(), "Display16x2::init fallo");
+	reportar("C++ Display16x2::init", HOST_BUS_I2C);
+	iniciarMedicion();
+	Display16x2::writeSpan(1, 0, TEXTO_PRUEBA, sizeof(TEXTO_PRUEBA) - 1);
+	reportar("C++ Display16x2::writeSpan", HOST_BUS_I2C);
+	host_verificar(textoCorrecto(display16x2, LCD_FILA_2, TEXTO_PRUEBA),
+			"C++: texto incorrecto en 16x2");
+
+	host_verificar(Display20x4::init(), "Display20x4::init fallo");
+	Display20x4::setCursor(3, 2);
+	Display20x4::printText(TEXTO_PRUEBA);
+	host_verificar(textoCorrecto(display20x4, LCD_FILA_4(20) + 2, TEXTO_PRUEBA),
+			"C++: texto incorrecto en la fila 4 del 20x4");
+	host_verificar(simHd44780_violacionesTiempo(displayC) == 0
+			&& simHd44780_violacionesTiempo(display16x2) == 0
+			&& simHd44780_violacionesTiempo(display20x4) == 0,
+			"instrucciones enviadas con el display ocupado");
+}
+
+/**
+ *	@brief Compara el texto con la DDRAM del display a partir
+ *		   de la dirección indicada.
+ */
+static bool_t textoCorrecto(int display, uint8_t direccion, const char *texto) {
+	for (uint8_t i = 0; texto[i] != '\0'; i++) {
+		if (simHd44780_ddram(display, direccion + i) != (uint8_t) texto[i])
+			return false;
+	}
+	return true;
+}
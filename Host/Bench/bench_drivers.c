@@ -0,0 +1,841 @@
+/**
+ * @file bench_drivers.c
+ * @brief Benchmark de PC que ejecuta los drivers sobre los
+ * 		  ports simulados y reporta, para cada operación, las
+ * 		  transacciones, los bytes y el tiempo de ocupación del
+ * 		  bus SPI o I2C, junto con el tiempo virtual total. Como
+ * 		  el tiempo es virtual, los resultados son reproducibles
+ * 		  y permiten comparar el costo de cada cambio en los drivers.
+ *
+ * 		  También compara las lecturas por segundo de varios
+ * 		  lectores MFRC522 leídos uno por vez y con el
+ * 		  planificador intercalado mfrc522_leerLectores, y las
+ * 		  pantallas por segundo de varios displays en el mismo
+ * 		  bus I2C actualizados uno por vez y con la cola asíncrona
+ * 		  repartida por turnos, y el costo por paso de una
+ * 		  marquesina con el desplazamiento del display frente
+ * 		  a volver a escribir la fila en cada paso. Compara
+ * 		  el seguimiento de presencia de una tarjeta apoyada en
+ * 		  el lector con repetir la lectura completa, y verifica
+ * 		  que el callback de la cola asíncrona de un display no
+ * 		  se llame antes de que termine su transferencia cuando
+ * 		  otro display del bus le cede el bus desde la
+ * 		  interrupción. Por último mide la inicialización de
+ * 		  ambos drivers luego de un reinicio en caliente del
+ * 		  procesador.
+ *
+ * 		  Compilación:
+ * 		  gcc -std=c11 -O2 -DAPI_PORT_HOST -DMFRC522_CANTIDAD_LECTORES=4
+ * 		      -IRC522_driver/Inc -ILCD16x2_driver/Inc -IHost/Inc
+ * 		      -ICommon/Inc Host/Bench/bench_drivers.c
+ * 		      Host/Src/host_plataforma.c Host/Src/sim_mfrc522.c
+ * 		      Host/Src/sim_hd44780.c Host/Src/API_mfrc522_port_host.c
+ * 		      Host/Src/API_lcd_port_host.c RC522_driver/Src/API_mfrc522.c
+ * 		      LCD16x2_driver/Src/API_lcd.c
+ * 		      LCD16x2_driver/Src/API_lcd_glifos.c
+ * 		      LCD16x2_driver/Src/API_lcd_formato.c -o bench_drivers
+ *
+ * 		  Agregando -DINSTR_HABILITADA=1
+ * 		  Common/Src/API_instrumentacion.c
+ * 		  Host/Src/API_instrumentacion_port_host.c también se
+ * 		  vuelcan las estadísticas de la instrumentación.
+ *
+ * 		  Agregando -DTRAZA_HABILITADA=1 -DTRAZA_TAMANIO_BUFFER=65536
+ * 		  Common/Src/API_traza.c
+ * 		  Host/Src/API_traza_port_host.c se guarda en ARCHIVO_TRAZA
+ * 		  la traza de las primeras operaciones de ambos drivers, para
+ * 		  reproducirla con Host/Tools/comparar_trazas.c.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "API_mfrc522.h"
+#include "API_mfrc522_port.h"
+#include "API_lcd.h"
+#include "API_lcd_port.h"
+#include "sim_mfrc522.h"
+#include "sim_hd44780.h"
+#include "host_plataforma.h"
+#include "API_instrumentacion.h"
+#include "API_traza.h"
+
+//archivo con la traza de las primeras operaciones (con TRAZA_HABILITADA)
+#define ARCHIVO_TRAZA			"traza_bench.txt"
+
+static const char TEXTO_PRUEBA[] = "Acceso permitido";
+//textos con caracteres que no están en la ROM del display (UTF-8)
+static const char TEXTO_GLIFOS[] = "¿Acción? Sí";
+static const char TEXTO_GLIFOS_2[] = "¿Camión? Sí";
+//texto más largo que una fila, para la marquesina
+static const char TEXTO_MARQUESINA[] = "Bienvenido al laboratorio de sistemas";
+//tarjetas del inventario: UIDs simples, dobles y triples que colisionan de a
+//pares en el último nivel de cascada, y el cascade tag con los UIDs simples
+static const struct {
+	uint8_t largo;
+	uint8_t uid[MFRC522_UID_MAX];
+} TARJETAS_INVENTARIO[] = {
+	{ 4, { 0x04, 0xA1, 0xB2, 0xC3 } },
+	{ 4, { 0x04, 0xA1, 0xB2, 0x43 } },
+	{ 7, { 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 } },
+	{ 7, { 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x67 } },
+	{ 10, { 0x04, 0x11, 0x22, 0x80, 0x91, 0xA2, 0xB3, 0xC4, 0xD5, 0xE6 } },
+	{ 10, { 0x04, 0x11, 0x22, 0x80, 0x91, 0xA2, 0x33, 0xC4, 0xD5, 0xE6 } } };
+#define CANTIDAD_INVENTARIO \
+	(sizeof(TARJETAS_INVENTARIO) / sizeof(TARJETAS_INVENTARIO[0]))
+
+//cantidad de lecturas de cada lector en la comparación de lectores
+#define RONDAS_LECTORES			100
+//cantidad de inventarios con cada cantidad de tarjetas en el campo
+#define RONDAS_INVENTARIO		20
+//período entre llamadas y cantidad de sondeos del seguimiento de presencia
+#define PERIODO_PRESENCIA_MS	20
+#define RONDAS_PRESENCIA		50
+//cantidad de pantallas de cada display en la comparación de displays
+#define RONDAS_DISPLAYS			20
+//pasos y período de la marquesina
+#define PASOS_MARQUESINA		8
+#define PERIODO_MARQUESINA_MS	100
+//displays de la comparación (uno de los lugares del bus lo ocupa el display por defecto)
+#define DISPLAYS_BENCH			(LCD_MAX_DISPLAYS_BUS - 1)
+#define DIRECCION_DISPLAYS		0x20
+//esperas de la respuesta de la tarjeta: la larga supera 1,6 s y aumenta
+//el prescaler del timer del MFRC522
+#define ESPERA_CORTA_US			5000UL
+#define ESPERA_LARGA_US			2000000UL
+//tiempo de guarda del campo luego de encender la antena (ISO/IEC 14443-3)
+#define GUARDA_CAMPO_MS			5
+
+static LCD_HandleTypedef displaysBench[DISPLAYS_BENCH];
+static uint8_t callbacksDisplay = 0;
+static bool_t callbackConBusOcupado = false;
+
+static uint64_t inicioMedicion = 0;
+
+static void iniciarMedicion();
+static void reportar(const char*, host_bus_enum);
+static void compararLectores();
+static double lecturasPorSegundo(uint8_t, bool_t, bool_t);
+static void compararInventario();
+static void probarPresencia();
+static void probarEspera();
+static void probarGlifos(int);
+static void probarMarquesina(int);
+static void probarFormato(int);
+static void probarArranqueEnCaliente(int);
+static void compararDisplays();
+static void probarCallbackDisplays();
+static void callbackDisplay(LCD_StatusTypedef);
+static double pantallasPorSegundo(uint8_t, bool_t);
+#if INSTR_HABILITADA
+static void imprimirLinea(const char*);
+#endif
+#if TRAZA_HABILITADA
+static FILE *archivoTraza;
+static void escribirLineaTraza(const char*);
+#endif
+
+int main(void) {
+	uint8_t uid[4];
+
+	printf("%-28s %6s %7s %10s %11s\n", "operacion", "trans", "bytes",
+			"bus[us]", "total[us]");
+
+	// MFRC522
+	host_reiniciar();
+	simMfrc522_reset();
+#if INSTR_HABILITADA
+	instr_init();
+#endif
+#if TRAZA_HABILITADA
+	traza_init();
+#endif
+
+	iniciarMedicion();
+	mfrc522_init();
+	reportar("mfrc522_init", HOST_BUS_SPI);
+
+	int tarjeta = simMfrc522_agregarTarjeta(0, HOST_UID_PRUEBA,
+			sizeof(HOST_UID_PRUEBA));
+	iniciarMedicion();
+	bool_t leida = mfrc522_leerUIDTarjeta(uid);
+	reportar("mfrc522_leerUIDTarjeta hit", HOST_BUS_SPI);
+	host_verificar(leida && memcmp(uid, HOST_UID_PRUEBA, sizeof(uid)) == 0,
+			"UID leido incorrecto");
+
+	simMfrc522_quitarTarjeta(0, tarjeta);
+	iniciarMedicion();
+	leida = mfrc522_leerUIDTarjeta(uid);
+	reportar("mfrc522_leerUIDTarjeta miss", HOST_BUS_SPI);
+	host_verificar(!leida, "se leyo una tarjeta ausente");
+
+	//la traza cubre las lecturas de mfrc522_lectorLeerUID que
+	//reproduce comparar_trazas, y no el seguimiento de presencia
+#if TRAZA_HABILITADA
+	traza_pausar(true);
+#endif
+	probarPresencia();
+	probarEspera();
+#if TRAZA_HABILITADA
+	traza_pausar(false);
+#endif
+
+	// LCD
+	simHd44780_reset();
+	int display = simHd44780_agregar(LCD_ADDRESS, host_tiempoNs());
+
+	iniciarMedicion();
+	host_verificar(LCD_init() == LCD_OK, "LCD_init fallo");
+	reportar("LCD_init", HOST_BUS_I2C);
+
+	iniciarMedicion();
+	host_verificar(LCD_printText(TEXTO_PRUEBA) == LCD_OK,
+			"LCD_printText fallo");
+	reportar("LCD_printText (16 chars)", HOST_BUS_I2C);
+
+	for (uint8_t i = 0; i < sizeof(TEXTO_PRUEBA) - 1; i++) {
+		if (simHd44780_caracter(display, 0, i) != (uint8_t) TEXTO_PRUEBA[i]) {
+			host_verificar(false, "el LCD no muestra el texto enviado");
+			break;
+		}
+	}
+	host_verificar(simHd44780_violacionesTiempo(display) == 0,
+			"instrucciones enviadas con el LCD ocupado");
+
+#if TRAZA_HABILITADA
+	archivoTraza = fopen(ARCHIVO_TRAZA, "w");
+	host_verificar(archivoTraza != NULL, "no se puede crear " ARCHIVO_TRAZA);
+	if (archivoTraza != NULL) {
+		traza_volcar(escribirLineaTraza);
+		fclose(archivoTraza);
+	}
+	traza_pausar(true);
+#endif
+
+	probarGlifos(display);
+	probarMarquesina(display);
+	probarFormato(display);
+	probarArranqueEnCaliente(display);
+
+	compararLectores();
+	compararInventario();
+	compararDisplays();
+	probarCallbackDisplays();
+
+#if INSTR_HABILITADA
+	printf("\ninstrumentacion (ciclos a %lu MHz):\n",
+			(unsigned long) (HOST_FRECUENCIA_CPU / 1000000));
+	instr_volcar(imprimirLinea);
+#endif
+	return host_errores() ? 1 : 0;
+}
+
+/**
+ *	@brief Borra los contadores y guarda el instante
+ *		   de inicio de la operación a medir.
+ */
+static void iniciarMedicion() {
+	host_borrarContadores();
+	inicioMedicion = host_tiempoNs();
+}
+
+static void reportar(const char *operacion, host_bus_enum bus) {
+	host_estadisticasBus_t estadisticas = host_leerBus(bus);
+	printf("%-28s %6lu %7lu %10.1f %11.1f\n", operacion,
+			(unsigned long) estadisticas.transacciones,
+			(unsigned long) estadisticas.bytes, estadisticas.tiempoNs / 1000.0,
+			(host_tiempoNs() - inicioMedicion) / 1000.0);
+}
+
+/**
+ *	@brief Sigue una tarjeta que se apoya en el lector: mide
+ *		   la llegada, un sondeo de presencia y RONDAS_PRESENCIA
+ *		   sondeos seguidos frente a repetir la lectura completa.
+ *		   Verifica que una tarjeta que se aleja por menos de
+ *		   la ventana no se informa de nuevo, que al retirarla
+ *		   se informa un único retiro y que, luego del bajo
+ *		   consumo, se espera el tiempo de guarda del campo.
+ */
+static void probarPresencia() {
+	mfrc522_uid_t uid;
+	uint32_t presentes = 0;
+
+	int tarjeta = simMfrc522_agregarTarjeta(0, HOST_UID_PRUEBA,
+			sizeof(HOST_UID_PRUEBA));
+	iniciarMedicion();
+	host_verificar(mfrc522_presencia(&uid) == MFRC522_EVENTO_LLEGADA
+			&& memcmp(uid.uid, HOST_UID_PRUEBA, sizeof(HOST_UID_PRUEBA)) == 0,
+			"no se informo la llegada de la tarjeta");
+	reportar("mfrc522_presencia llegada", HOST_BUS_SPI);
+
+	host_avanzarNs(PERIODO_PRESENCIA_MS * 1000000ULL);
+	iniciarMedicion();
+	host_verificar(mfrc522_presencia(&uid) == MFRC522_EVENTO_PRESENTE,
+			"no se confirmo la tarjeta presente");
+	reportar("mfrc522_presencia presente", HOST_BUS_SPI);
+
+	iniciarMedicion();
+	for (uint16_t i = 0; i < RONDAS_PRESENCIA; i++) {
+		host_avanzarNs(PERIODO_PRESENCIA_MS * 1000000ULL);
+		if (mfrc522_presencia(&uid) == MFRC522_EVENTO_PRESENTE)
+			presentes++;
+	}
+	reportar("presencia x50 (sondeo)", HOST_BUS_SPI);
+	host_verificar(presentes == RONDAS_PRESENCIA,
+			"la tarjeta dejo de estar presente");
+
+	// La tarjeta se aleja por dos sondeos y vuelve en IDLE
+	simMfrc522_quitarTarjeta(0, tarjeta);
+	for (uint8_t i = 0; i < 2; i++) {
+		host_avanzarNs(PERIODO_PRESENCIA_MS * 1000000ULL);
+		host_verificar(mfrc522_presencia(&uid) == MFRC522_EVENTO_NINGUNO,
+				"se informo el retiro antes de la ventana");
+	}
+	tarjeta = simMfrc522_agregarTarjeta(0, HOST_UID_PRUEBA,
+			sizeof(HOST_UID_PRUEBA));
+	host_avanzarNs(PERIODO_PRESENCIA_MS * 1000000ULL);
+	host_verificar(mfrc522_presencia(&uid) == MFRC522_EVENTO_PRESENTE,
+			"la tarjeta que volvio no se confirmo como presente");
+
+	iniciarMedicion();
+	for (uint16_t i = 0; i < RONDAS_PRESENCIA; i++) {
+		host_avanzarNs(PERIODO_PRESENCIA_MS * 1000000ULL);
+		mfrc522_leerUIDCompleto(&uid);
+	}
+	reportar("leerUIDCompleto x50", HOST_BUS_SPI);
+
+	// La lectura completa dejó la tarjeta en IDLE: el sondeo usa WUPA
+	simMfrc522_quitarTarjeta(0, tarjeta);
+	uint8_t retiros = 0;
+	for (uint16_t i = 0; i < RONDAS_PRESENCIA; i++) {
+		host_avanzarNs(PERIODO_PRESENCIA_MS * 1000000ULL);
+		mfrc522_evento_enum evento = mfrc522_presencia(&uid);
+		if (evento == MFRC522_EVENTO_RETIRO)
+			retiros++;
+		else if (evento != MFRC522_EVENTO_NINGUNO)
+			host_verificar(false, "evento inesperado sin tarjeta");
+	}
+	host_verificar(retiros == 1, "no se informo un unico retiro");
+
+	// Desde el bajo consumo, REQA espera a que el campo energice la tarjeta
+	mfrc522_pollConfigurar(MFRC522_POLL_BAJO_CONSUMO_MS,
+			MFRC522_POLL_BAJO_CONSUMO_MS);
+	host_verificar(!mfrc522_poll(&uid), "se leyo una tarjeta ausente");
+	tarjeta = simMfrc522_agregarTarjeta(0, HOST_UID_PRUEBA,
+			sizeof(HOST_UID_PRUEBA));
+	iniciarMedicion();
+	host_verificar(mfrc522_presencia(&uid) == MFRC522_EVENTO_LLEGADA,
+			"no se informo la llegada luego del bajo consumo");
+	reportar("presencia desde bajo consumo", HOST_BUS_SPI);
+	host_verificar(host_tiempoNs() - inicioMedicion
+			>= GUARDA_CAMPO_MS * 1000000ULL,
+			"REQA enviado antes del tiempo de guarda del campo");
+	simMfrc522_quitarTarjeta(0, tarjeta);
+	mfrc522_pollConfigurar(MFRC522_POLL_MIN_MS, MFRC522_POLL_MAX_MS);
+}
+
+/**
+ *	@brief Lee sin tarjeta con esperas configuradas con
+ *		   mfrc522_esperaConfigurar: una que usa el prescaler
+ *		   por defecto del timer y otra de más de 1,6 s que lo
+ *		   aumenta. Verifica que la lectura dura la espera, que
+ *		   con la espera larga se lee una tarjeta y que al volver
+ *		   a la espera por defecto se restaura el prescaler.
+ */
+static void probarEspera() {
+	uint8_t uid[4];
+
+	mfrc522_esperaConfigurar(ESPERA_CORTA_US);
+	iniciarMedicion();
+	host_verificar(!mfrc522_leerUIDTarjeta(uid), "se leyo una tarjeta ausente");
+	reportar("leerUIDTarjeta miss 5 ms", HOST_BUS_SPI);
+	uint64_t duracionNs = host_tiempoNs() - inicioMedicion;
+	host_verificar(duracionNs >= ESPERA_CORTA_US * 1000
+			&& duracionNs < (ESPERA_CORTA_US + 1000) * 1000,
+			"la lectura no duro la espera configurada");
+
+	mfrc522_esperaConfigurar(ESPERA_LARGA_US);
+	iniciarMedicion();
+	host_verificar(!mfrc522_leerUIDTarjeta(uid), "se leyo una tarjeta ausente");
+	reportar("leerUIDTarjeta miss 2 s", HOST_BUS_SPI);
+	duracionNs = host_tiempoNs() - inicioMedicion;
+	host_verificar(duracionNs >= ESPERA_LARGA_US * 1000
+			&& duracionNs < (ESPERA_LARGA_US + 1000) * 1000,
+			"la lectura no duro la espera larga");
+
+	int tarjeta = simMfrc522_agregarTarjeta(0, HOST_UID_PRUEBA,
+			sizeof(HOST_UID_PRUEBA));
+	host_verificar(mfrc522_leerUIDTarjeta(uid)
+			&& memcmp(uid, HOST_UID_PRUEBA, sizeof(uid)) == 0,
+			"no se leyo la tarjeta con la espera larga");
+	simMfrc522_quitarTarjeta(0, tarjeta);
+
+	mfrc522_esperaConfigurar(MFRC522_ESPERA_TRAMA_US);
+	iniciarMedicion();
+	host_verificar(!mfrc522_leerUIDTarjeta(uid), "se leyo una tarjeta ausente");
+	reportar("leerUIDTarjeta miss 200 us", HOST_BUS_SPI);
+	host_verificar(host_tiempoNs() - inicioMedicion < ESPERA_CORTA_US * 1000,
+			"no se restauro el prescaler del timer");
+}
+
+/**
+ *	@brief Imprime las lecturas por segundo de 1 a
+ *		   MFRC522_CANTIDAD_LECTORES lectores en el mismo bus,
+ *		   sin tarjetas y con una tarjeta en cada lector.
+ */
+static void compararLectores() {
+	printf("\n%-9s %23s %23s\n", "", "sin tarjeta [lect/s]",
+			"con tarjeta [lect/s]");
+	printf("%-9s %11s %11s %11s %11s\n", "lectores", "secuencial",
+			"intercalado", "secuencial", "intercalado");
+	for (uint8_t n = 1; n <= MFRC522_CANTIDAD_LECTORES; n++) {
+		printf("%-9u %11.0f %11.0f %11.0f %11.0f\n", n,
+				lecturasPorSegundo(n, false, false),
+				lecturasPorSegundo(n, false, true),
+				lecturasPorSegundo(n, true, false),
+				lecturasPorSegundo(n, true, true));
+	}
+}
+
+/**
+ *	@brief Realiza RONDAS_LECTORES lecturas en cada uno de
+ *		   los cantidad lectores, uno por vez o intercaladas,
+ *		   y verifica los UIDs leídos. Como la tarjeta queda
+ *		   seleccionada, no responde al REQA siguiente, por lo
+ *		   que con tarjeta se alternan lecturas con y sin éxito.
+ *	@retval Lecturas por segundo de tiempo virtual.
+ */
+static double lecturasPorSegundo(uint8_t cantidad, bool_t conTarjeta,
+		bool_t intercalado) {
+	mfrc522_t lectores[MFRC522_CANTIDAD_LECTORES];
+	mfrc522_uid_t uids[MFRC522_CANTIDAD_LECTORES];
+	uint8_t uidLector[4];
+
+	host_reiniciar();
+	simMfrc522_reset();
+	for (uint8_t i = 0; i < cantidad; i++) {
+		mfrc522_lectorInit(&lectores[i], i);
+		memcpy(uidLector, HOST_UID_PRUEBA, sizeof(uidLector));
+		uidLector[3] = i;
+		if (conTarjeta)
+			simMfrc522_agregarTarjeta(i, uidLector, sizeof(uidLector));
+	}
+	//la primera lectura espera el tiempo de guarda del campo
+	host_avanzarNs((GUARDA_CAMPO_MS + 1) * 1000000ULL);
+
+	uint32_t leidas = 0;
+	uint64_t inicio = host_tiempoNs();
+	for (uint16_t ronda = 0; ronda < RONDAS_LECTORES; ronda++) {
+		if (intercalado) {
+			leidas += mfrc522_leerLectores(lectores, cantidad, uids);
+		} else {
+			for (uint8_t i = 0; i < cantidad; i++) {
+				uids[i].largo = 0;
+				if (mfrc522_lectorLeerUID(&lectores[i], &uids[i]))
+					leidas++;
+			}
+		}
+		for (uint8_t i = 0; i < cantidad; i++) {
+			if (uids[i].largo != 0 && uids[i].uid[3] != i)
+				host_verificar(false, "UID leido en el lector equivocado");
+		}
+	}
+	double segundos = (host_tiempoNs() - inicio) / 1e9;
+
+	uint32_t esperadas = conTarjeta ? cantidad * RONDAS_LECTORES / 2 : 0;
+	host_verificar(leidas == esperadas,
+			"cantidad de tarjetas leidas incorrecta");
+	return cantidad * RONDAS_LECTORES / segundos;
+}
+
+/**
+ *	@brief Imprime las tarjetas por segundo que lee
+ *		   mfrc522_inventario con 1 a CANTIDAD_INVENTARIO
+ *		   tarjetas de TARJETAS_INVENTARIO en el campo, y los
+ *		   intercambios con las tarjetas por cada una leída.
+ *		   Verifica que cada UID se lee una única vez y que
+ *		   al terminar todas quedan detenidas con HLTA.
+ */
+static void compararInventario() {
+	mfrc522_t lector;
+	mfrc522_uid_t leidas[CANTIDAD_INVENTARIO + 1];
+	mfrc522_uid_t uid;
+	int indices[CANTIDAD_INVENTARIO];
+
+	printf("\n%-9s %15s %15s\n", "tarjetas", "inventario[t/s]",
+			"intercambios/t");
+	for (uint8_t n = 1; n <= CANTIDAD_INVENTARIO; n++) {
+		host_reiniciar();
+		simMfrc522_reset();
+		mfrc522_lectorInit(&lector, 0);
+		//la primera lectura espera el tiempo de guarda del campo
+		host_avanzarNs((GUARDA_CAMPO_MS + 1) * 1000000ULL);
+
+		uint64_t duracionNs = 0;
+		uint32_t intercambios = 0;
+		bool_t correcto = true;
+		for (uint16_t ronda = 0; ronda < RONDAS_INVENTARIO; ronda++) {
+			for (uint8_t i = 0; i < n; i++)
+				indices[i] = simMfrc522_agregarTarjeta(0,
+						TARJETAS_INVENTARIO[i].uid,
+						TARJETAS_INVENTARIO[i].largo);
+
+			uint64_t inicio = host_tiempoNs();
+			uint32_t intercambiosInicio = simMfrc522_cantidadIntercambios(0);
+			uint8_t cantidad = mfrc522_lectorInventario(&lector, leidas,
+					CANTIDAD_INVENTARIO + 1);
+			duracionNs += host_tiempoNs() - inicio;
+			intercambios += simMfrc522_cantidadIntercambios(0)
+					- intercambiosInicio;
+
+			correcto = correcto && cantidad == n
+					&& !mfrc522_lectorLeerUID(&lector, &uid);
+			for (uint8_t i = 0; i < n; i++) {
+				uint8_t veces = 0;
+				for (uint8_t j = 0; j < cantidad; j++) {
+					if (leidas[j].largo == TARJETAS_INVENTARIO[i].largo
+							&& memcmp(leidas[j].uid, TARJETAS_INVENTARIO[i].uid,
+									leidas[j].largo) == 0)
+						veces++;
+				}
+				correcto = correcto && veces == 1;
+			}
+
+			for (uint8_t i = 0; i < n; i++)
+				simMfrc522_quitarTarjeta(0, indices[i]);
+		}
+		host_verificar(correcto,
+				"el inventario no leyo cada tarjeta una unica vez");
+		printf("%-9u %15.0f %15.1f\n", n,
+				n * RONDAS_INVENTARIO / (duracionNs / 1e9),
+				(double) intercambios / (n * RONDAS_INVENTARIO));
+	}
+}
+
+/**
+ *	@brief Escribe textos con glifos propios. La primera vez
+ *		   se cargan los glifos en la CGRAM; al repetir el texto
+ *		   no se envía nada, y con otro texto que usa los mismos
+ *		   glifos solo se envían los caracteres que cambiaron.
+ */
+static void probarGlifos(int display) {
+	iniciarMedicion();
+	host_verificar(LCD_printText(TEXTO_GLIFOS) == LCD_OK,
+			"LCD_printText con glifos fallo");
+	reportar("LCD_printText glifos nuevos", HOST_BUS_I2C);
+
+	uint8_t codigo = simHd44780_caracter(display, 0, 0);
+	bool_t correcto = codigo >= 0x08 && codigo < 0x10;
+	const uint8_t *patron = LCD_patronGlifo(
+			LCD_traducirLatin1((uint8_t) 0xBF).glifo);
+	for (uint8_t fila = 0; correcto && fila < LCD_FILAS_GLIFO; fila++) {
+		if (simHd44780_cgram(display, (codigo - 0x08) * LCD_FILAS_GLIFO + fila)
+				!= patron[fila])
+			correcto = false;
+	}
+	host_verificar(correcto, "el LCD no muestra el glifo cargado");
+
+	iniciarMedicion();
+	LCD_printText(TEXTO_GLIFOS);
+	reportar("LCD_printText mismo texto", HOST_BUS_I2C);
+
+	iniciarMedicion();
+	LCD_printText(TEXTO_GLIFOS_2);
+	reportar("LCD_printText glifos cargados", HOST_BUS_I2C);
+	host_verificar(simHd44780_caracter(display, 0, 1) == 'C'
+			&& simHd44780_caracter(display, 0, 5) >= 0x08
+			&& simHd44780_caracter(display, 0, 5) < 0x10,
+			"el LCD no muestra el segundo texto");
+	host_verificar(simHd44780_violacionesTiempo(display) == 0,
+			"instrucciones enviadas con el LCD ocupado");
+}
+
+/**
+ *	@brief Desplaza el texto largo PASOS_MARQUESINA posiciones,
+ *		   primero volviendo a escribir la fila 1 en cada paso y
+ *		   luego con la marquesina, que escribe el texto una vez
+ *		   en la DDRAM y envía un comando de desplazamiento por paso.
+ *		   Luego verifica que un glifo no se cargue con la posición
+ *		   del cursor desconocida.
+ */
+static void probarMarquesina(int display) {
+	char ventana[LCD_CANTIDAD_COLUMNAS + 1] = { 0 };
+
+	LCD_clear();
+	iniciarMedicion();
+	for (uint8_t paso = 1; paso <= PASOS_MARQUESINA; paso++) {
+		memcpy(ventana, &TEXTO_MARQUESINA[paso], LCD_CANTIDAD_COLUMNAS);
+		LCD_bufferWrite(LCD_FILA_1, 0, ventana);
+		LCD_flush();
+	}
+	reportar("scroll por software 8 pasos", HOST_BUS_I2C);
+
+	LCD_clear();
+	iniciarMedicion();
+	host_verificar(
+			LCD_marquesinaEscribir(LCD_FILA_1, TEXTO_MARQUESINA) == LCD_OK,
+			"LCD_marquesinaEscribir fallo");
+	reportar("LCD_marquesinaEscribir", HOST_BUS_I2C);
+
+	LCD_marquesinaIniciar(PERIODO_MARQUESINA_MS);
+	iniciarMedicion();
+	uint8_t pasos = 0;
+	while (pasos < PASOS_MARQUESINA) {
+		if (LCD_marquesinaTick() == LCD_OK)
+			pasos++;
+		LCD_process();
+	}
+	while (LCD_process() == LCD_BUSY)
+		;
+	reportar("marquesina 8 pasos", HOST_BUS_I2C);
+
+	bool_t correcto = true;
+	for (uint8_t columna = 0; columna < LCD_CANTIDAD_COLUMNAS; columna++) {
+		if (simHd44780_caracter(display, 0, columna)
+				!= (uint8_t) TEXTO_MARQUESINA[PASOS_MARQUESINA + columna])
+			correcto = false;
+	}
+	host_verificar(correcto, "la marquesina no muestra el texto desplazado");
+
+	host_verificar(LCD_marquesinaDetener() == LCD_OK,
+			"LCD_marquesinaDetener fallo");
+	host_verificar(simHd44780_caracter(display, 0, 0)
+			== (uint8_t) TEXTO_MARQUESINA[0],
+			"el display no volvio a su posicion original");
+
+	//luego de escribir la marquesina la DDRAM no está direccionada, por
+	//lo que un caracter que necesita cargar un glifo se rechaza. Los
+	//códigos 0x00 a 0x0F muestran la CGRAM
+	uint8_t cgram[LCD_CANTIDAD_CGRAM * LCD_FILAS_GLIFO];
+	LCD_marquesinaEscribir(LCD_FILA_1, TEXTO_MARQUESINA);
+	for (uint8_t i = 0; i < sizeof(cgram); i++)
+		cgram[i] = simHd44780_cgram(display, i);
+	host_verificar(LCD_printChar('\xD1') == LCD_ERROR,
+			"glifo cargado con el cursor desconocido");
+	bool_t intacta = true;
+	for (uint8_t i = 0; i < sizeof(cgram); i++) {
+		if (simHd44780_cgram(display, i) != cgram[i])
+			intacta = false;
+	}
+	host_verificar(intacta, "la CGRAM se modifico con el cursor desconocido");
+	host_verificar(LCD_setCursor(LCD_FILA_1, 0) == LCD_OK
+			&& LCD_printChar('\xD1') == LCD_OK
+			&& simHd44780_caracter(display, 0, 0) < 2 * LCD_CANTIDAD_CGRAM,
+			"el glifo no se muestra luego de ubicar el cursor");
+	host_verificar(simHd44780_violacionesTiempo(display) == 0,
+			"instrucciones enviadas con el LCD ocupado");
+}
+
+/**
+ *	@brief Muestra el UID de prueba con LCD_printf y luego
+ *		   cambia un valor en punto fijo con LCD_printAt, que
+ *		   solo envía los caracteres que cambiaron. El UID ocupa
+ *		   la fila 1 completa, por lo que el texto sigue en la
+ *		   fila 2 sin '\n'.
+ */
+static void probarFormato(int display) {
+	static const char ESPERADO[] = "UID: 04 A1 B2 C3";
+
+	LCD_clear();
+	iniciarMedicion();
+	host_verificar(LCD_printf("UID: %*hT:%5.1qC", (int) sizeof(HOST_UID_PRUEBA),
+			HOST_UID_PRUEBA, 235) == LCD_OK, "LCD_printf fallo");
+	reportar("LCD_printf UID", HOST_BUS_I2C);
+
+	bool_t correcto = true;
+	for (uint8_t i = 0; i < sizeof(ESPERADO) - 1; i++) {
+		if (simHd44780_caracter(display, 0, i) != (uint8_t) ESPERADO[i])
+			correcto = false;
+	}
+	host_verificar(correcto, "el LCD no muestra el UID formateado");
+
+	iniciarMedicion();
+	host_verificar(LCD_printAt(LCD_FILA_2, 2, "%5.1q", -45) == LCD_OK,
+			"LCD_printAt fallo");
+	reportar("LCD_printAt 1 valor", HOST_BUS_I2C);
+	host_verificar(simHd44780_caracter(display, 1, 3) == '-'
+			&& simHd44780_caracter(display, 1, 6) == '5'
+			&& simHd44780_caracter(display, 1, 7) == 'C',
+			"el LCD no muestra el valor formateado");
+}
+
+/**
+ *	@brief Simula un reinicio del procesador sin cortar la
+ *		   alimentación: el MFRC522 y el display conservan su
+ *		   configuración, por lo que ambos drivers evitan la
+ *		   inicialización completa. Verifica que luego se pueda
+ *		   leer una tarjeta y escribir en el display.
+ */
+static void probarArranqueEnCaliente(int display) {
+	uint8_t uid[4];
+
+	host_simularReinicio(true);
+	iniciarMedicion();
+	mfrc522_init();
+	reportar("mfrc522_init en caliente", HOST_BUS_SPI);
+
+	int tarjeta = simMfrc522_agregarTarjeta(0, HOST_UID_PRUEBA,
+			sizeof(HOST_UID_PRUEBA));
+	host_verificar(mfrc522_leerUIDTarjeta(uid)
+			&& memcmp(uid, HOST_UID_PRUEBA, sizeof(uid)) == 0,
+			"no se leyo la tarjeta luego del arranque en caliente");
+	simMfrc522_quitarTarjeta(0, tarjeta);
+
+	iniciarMedicion();
+	host_verificar(LCD_init() == LCD_OK, "LCD_init en caliente fallo");
+	reportar("LCD_init en caliente", HOST_BUS_I2C);
+
+	LCD_printText(TEXTO_PRUEBA);
+	host_verificar(
+			simHd44780_caracter(display, 0, 0) == (uint8_t) TEXTO_PRUEBA[0]
+					&& simHd44780_caracter(display, 1, 0) == ' ',
+			"el LCD no muestra el texto luego del arranque en caliente");
+	host_verificar(simHd44780_violacionesTiempo(display) == 0,
+			"instrucciones enviadas con el LCD ocupado");
+	host_simularReinicio(false);
+}
+
+/**
+ *	@brief Imprime las pantallas por segundo de 1 a
+ *		   DISPLAYS_BENCH displays de 16x2 en el mismo bus I2C.
+ */
+static void compararDisplays() {
+	printf("\n%-9s %23s\n", "", "pantallas/s");
+	printf("%-9s %11s %11s\n", "displays", "secuencial", "por turnos");
+	for (uint8_t n = 1; n <= DISPLAYS_BENCH; n++) {
+		printf("%-9u %11.0f %11.0f\n", n, pantallasPorSegundo(n, false),
+				pantallasPorSegundo(n, true));
+	}
+}
+
+/**
+ *	@brief Muestra RONDAS_DISPLAYS pantallas en cada uno de los
+ *		   cantidad displays. Cada pantalla borra el display y
+ *		   escribe las dos filas. En forma secuencial se usan las
+ *		   funciones bloqueantes, y por turnos se encolan todas las
+ *		   pantallas y se vacían las colas con LCD_displayProcess.
+ *		   Al final verifica el contenido de cada display.
+ *	@retval Pantallas por segundo de tiempo virtual.
+ */
+static double pantallasPorSegundo(uint8_t cantidad, bool_t porTurnos) {
+	char texto[2 * LCD_CANTIDAD_COLUMNAS + 2];
+	int modelos[DISPLAYS_BENCH];
+
+	host_reiniciar();
+	simHd44780_reset();
+	for (uint8_t i = 0; i < cantidad; i++) {
+		modelos[i] = simHd44780_agregar(DIRECCION_DISPLAYS + i, host_tiempoNs());
+		host_verificar(LCD_displayInit(&displaysBench[i], LCD_BUS,
+				DIRECCION_DISPLAYS + i, LCD_CANTIDAD_COLUMNAS,
+				LCD_CANTIDAD_FILAS) == LCD_OK, "LCD_displayInit fallo");
+	}
+
+	uint64_t inicio = host_tiempoNs();
+	for (uint16_t ronda = 0; ronda < RONDAS_DISPLAYS; ronda++) {
+		for (uint8_t i = 0; i < cantidad; i++) {
+			LCD_HandleTypedef *lcd = &displaysBench[i];
+			snprintf(texto, sizeof(texto), "Display %u\nPantalla %u", i, ronda);
+			if (porTurnos) {
+				LCD_displayClearAsync(lcd);
+				LCD_displayBufferWrite(lcd, LCD_FILA_1, 0, texto);
+				host_verificar(LCD_displayFlushAsync(lcd) == LCD_OK,
+						"la cola asincronica se lleno");
+			} else {
+				LCD_displayClear(lcd);
+				LCD_displayPrintText(lcd, texto);
+			}
+		}
+		if (!porTurnos)
+			continue;
+		bool_t pendientes = true;
+		while (pendientes) {
+			pendientes = false;
+			for (uint8_t i = 0; i < cantidad; i++) {
+				LCD_StatusTypedef estado = LCD_displayProcess(&displaysBench[i]);
+				host_verificar(estado != LCD_ERROR, "LCD_displayProcess fallo");
+				if (estado == LCD_BUSY)
+					pendientes = true;
+			}
+		}
+	}
+	double segundos = (host_tiempoNs() - inicio) / 1e9;
+
+	for (uint8_t i = 0; i < cantidad; i++) {
+		snprintf(texto, sizeof(texto), "Display %u", i);
+		for (uint8_t c = 0; texto[c] != '\0'; c++) {
+			if (simHd44780_caracter(modelos[i], 0, c) != (uint8_t) texto[c]) {
+				host_verificar(false, "un display no muestra su texto");
+				break;
+			}
+		}
+		host_verificar(simHd44780_violacionesTiempo(modelos[i]) == 0,
+				"instrucciones enviadas con un display ocupado");
+	}
+	return cantidad * RONDAS_DISPLAYS / segundos;
+}
+
+/**
+ *	@brief Dos displays en el mismo bus: mientras se transmite
+ *		   el lote del display B, el display A encola un texto y
+ *		   se procesa. La interrupción de fin de B le da el bus a A
+ *		   durante LCD_displayProcess(A) (el lote anterior de A
+ *		   terminó con un comando lento, por lo que el driver
+ *		   consulta el tiempo). Verifica que el callback de A se
+ *		   llame una vez, con el bus ya libre.
+ */
+static void probarCallbackDisplays() {
+	LCD_HandleTypedef *a = &displaysBench[0], *b = &displaysBench[1];
+
+	host_reiniciar();
+	simHd44780_reset();
+	simHd44780_agregar(DIRECCION_DISPLAYS, host_tiempoNs());
+	simHd44780_agregar(DIRECCION_DISPLAYS + 1, host_tiempoNs());
+	host_verificar(LCD_displayInit(a, LCD_BUS, DIRECCION_DISPLAYS,
+			LCD_CANTIDAD_COLUMNAS, LCD_CANTIDAD_FILAS) == LCD_OK
+			&& LCD_displayInit(b, LCD_BUS, DIRECCION_DISPLAYS + 1,
+					LCD_CANTIDAD_COLUMNAS, LCD_CANTIDAD_FILAS) == LCD_OK,
+			"LCD_displayInit fallo");
+
+	//lote de A que termina con un comando lento; la espera vence sin consultarla
+	LCD_displayClearAsync(a);
+	LCD_displayProcess(a);
+	while (port_i2cOcupado(LCD_BUS))
+		;
+	host_avanzarNs(5000000ULL);
+
+	//lote de B en el bus, y un texto para A
+	LCD_displayPrintTextAsync(b, "B");
+	iniciarMedicion();
+	LCD_displayProcess(b);
+	uint64_t finB = inicioMedicion + host_leerBus(HOST_BUS_I2C).tiempoNs;
+	LCD_displayPrintTextAsync(a, "A");
+	callbacksDisplay = 0;
+	callbackConBusOcupado = false;
+	LCD_displaySetCallback(a, callbackDisplay);
+	if (host_tiempoNs() + HOST_NS_POR_CONSULTA < finB)
+		host_avanzarNs(finB - HOST_NS_POR_CONSULTA - host_tiempoNs());
+
+	while (LCD_displayProcess(a) == LCD_BUSY || LCD_displayProcess(b) == LCD_BUSY)
+		;
+	LCD_displaySetCallback(a, NULL);
+	host_verificar(callbacksDisplay == 1, "el callback no se llamo una vez");
+	host_verificar(!callbackConBusOcupado,
+			"callback del display con su transferencia en curso");
+}
+
+static void callbackDisplay(LCD_StatusTypedef estado) {
+	callbacksDisplay++;
+	if (estado != LCD_OK || port_i2cOcupado(LCD_BUS))
+		callbackConBusOcupado = true;
+}
+
+#if INSTR_HABILITADA
+static void imprimirLinea(const char *linea) {
+	printf("%s\n", linea);
+}
+#endif
+
+#if TRAZA_HABILITADA
+static void escribirLineaTraza(const char *linea) {
+	fprintf(archivoTraza, "%s\n", linea);
+}
+#endif
@@ -0,0 +1,187 @@
+/**
+ * @file bench_lista_accesos.c
+ * @brief Benchmark de PC que compara el tiempo de búsqueda
+ * 		  de un UID en una lista recorrida linealmente, en la
+ * 		  tabla dinámica y en la tabla estática de API_accesos,
+ * 		  para listas de distinto tamaño. El tiempo por búsqueda
+ * 		  de las tablas debe mantenerse constante al crecer la
+ * 		  lista, mientras que el de la lista lineal crece con ella.
+ *
+ * 		  Compilación:
+ * 		  gcc -std=c11 -O2 -IRC522_driver/Inc -IHost/Inc
+ * 		      Host/Bench/bench_lista_accesos.c
+ * 		      Host/Src/constructor_accesos.c
+ * 		      RC522_driver/Src/API_accesos.c -o bench_lista_accesos
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "constructor_accesos.h"
+
+#define CANTIDAD_BUSQUEDAS		200000UL
+#define MAX_BUSQUEDAS_LINEALES	20000UL
+
+static const uint32_t TAMANOS[] = { 16, 256, 4096, 32768, 50000 };
+
+static uint32_t estadoAleatorio = 12345;
+static volatile uint32_t sumidero;
+
+static uint32_t aleatorio(void);
+static void uidAleatorio(accesos_entrada_t*, uint32_t);
+static double tiempoNs(void);
+static bool_t buscarLineal(const accesos_entrada_t*, uint32_t,
+		const accesos_entrada_t*);
+
+int main(void) {
+	// Una tabla sin inicializar (capacidad 0) rechaza todas las operaciones
+	const uint8_t uid[] = { 0x04, 0xA1, 0xB2, 0xC3 };
+	accesos_tabla_t vacia = { 0 };
+	if (accesos_tablaAgregar(&vacia, uid, sizeof(uid))
+			|| accesos_tablaQuitar(&vacia, uid, sizeof(uid))
+			|| accesos_tablaBuscar(&vacia, uid, sizeof(uid))) {
+		fprintf(stderr, "operacion aceptada en una tabla sin inicializar\n");
+		return 1;
+	}
+
+	printf("%8s  %8s  %12s  %12s  %12s\n", "UIDs", "caso",
+			"lineal[ns]", "dinamica[ns]", "estatica[ns]");
+
+	for (size_t t = 0; t < sizeof(TAMANOS) / sizeof(TAMANOS[0]); t++) {
+		uint32_t cantidad = TAMANOS[t];
+
+		// Lista de UIDs autorizados y UIDs que no están en ella
+		accesos_entrada_t *lista = malloc(cantidad * sizeof(accesos_entrada_t));
+		accesos_entrada_t *ajenos = malloc(
+				cantidad * sizeof(accesos_entrada_t));
+		for (uint32_t i = 0; i < cantidad; i++) {
+			uidAleatorio(&lista[i], i);
+			uidAleatorio(&ajenos[i], i);
+			ajenos[i].uid[0] |= 0x80;	// bit que no se repite en lista
+			lista[i].uid[0] &= 0x7F;
+		}
+
+		uint32_t capacidad = 1;
+		while (capacidad * ACCESOS_CARGA_MAXIMA < (cantidad + 1) * 100)
+			capacidad <<= 1;
+		accesos_entrada_t *almacenamiento = malloc(
+				capacidad * sizeof(accesos_entrada_t));
+		accesos_tabla_t dinamica;
+		accesos_tablaInit(&dinamica, almacenamiento, capacidad);
+		for (uint32_t i = 0; i < cantidad; i++)
+			accesos_tablaAgregar(&dinamica, lista[i].uid, lista[i].largo);
+
+		accesos_tablaEstatica_t estatica;
+		if (!constructor_construir(&estatica, lista, cantidad)) {
+			fprintf(stderr, "no se pudo construir la tabla de %lu UIDs\n",
+					(unsigned long) cantidad);
+			return 1;
+		}
+
+		for (int caso = 0; caso < 2; caso++) {
+			const accesos_entrada_t *consultas = caso ? ajenos : lista;
+			uint32_t aciertos = 0;
+			double inicio;
+
+			uint32_t lineales = CANTIDAD_BUSQUEDAS;
+			if (lineales * cantidad > MAX_BUSQUEDAS_LINEALES * 4096)
+				lineales = MAX_BUSQUEDAS_LINEALES * 4096 / cantidad;
+			inicio = tiempoNs();
+			for (uint32_t i = 0; i < lineales; i++) {
+				aciertos += buscarLineal(lista, cantidad,
+						&consultas[(i * 7919) % cantidad]);
+			}
+			double lineal = (tiempoNs() - inicio) / lineales;
+
+			inicio = tiempoNs();
+			for (uint32_t i = 0; i < CANTIDAD_BUSQUEDAS; i++) {
+				const accesos_entrada_t *c = &consultas[(i * 7919) % cantidad];
+				aciertos += accesos_tablaBuscar(&dinamica, c->uid, c->largo);
+			}
+			double tiempoDinamica = (tiempoNs() - inicio) / CANTIDAD_BUSQUEDAS;
+
+			inicio = tiempoNs();
+			for (uint32_t i = 0; i < CANTIDAD_BUSQUEDAS; i++) {
+				const accesos_entrada_t *c = &consultas[(i * 7919) % cantidad];
+				aciertos += accesos_estaticaBuscar(&estatica, c->uid,
+						c->largo);
+			}
+			double tiempoEstatica = (tiempoNs() - inicio) / CANTIDAD_BUSQUEDAS;
+
+			uint32_t esperados = caso ? 0 : lineales + 2 * CANTIDAD_BUSQUEDAS;
+			if (aciertos != esperados) {
+				fprintf(stderr, "resultado incorrecto con %lu UIDs\n",
+						(unsigned long) cantidad);
+				return 1;
+			}
+			sumidero += aciertos;
+			printf("%8lu  %8s  %12.1f  %12.1f  %12.1f\n",
+					(unsigned long) cantidad, caso ? "ausente" : "presente",
+					lineal, tiempoDinamica, tiempoEstatica);
+		}
+
+		// Se quita la mitad de la lista y se verifica la tabla dinámica
+		for (uint32_t i = 0; i < cantidad; i += 2)
+			accesos_tablaQuitar(&dinamica, lista[i].uid, lista[i].largo);
+		for (uint32_t i = 0; i < cantidad; i++) {
+			if (accesos_tablaBuscar(&dinamica, lista[i].uid, lista[i].largo)
+					!= (i % 2 == 1)) {
+				fprintf(stderr, "error al quitar con %lu UIDs\n",
+						(unsigned long) cantidad);
+				return 1;
+			}
+		}
+
+		constructor_liberar(&estatica);
+		free(almacenamiento);
+		free(ajenos);
+		free(lista);
+	}
+	return 0;
+}
+
+static uint32_t aleatorio(void) {
+	estadoAleatorio ^= estadoAleatorio << 13;
+	estadoAleatorio ^= estadoAleatorio >> 17;
+	estadoAleatorio ^= estadoAleatorio << 5;
+	return estadoAleatorio;
+}
+
+/**
+ *	@brief Genera un UID aleatorio de 4 o 7 bytes. Los
+ *		   bytes 1 a 3 llevan el índice para que no haya
+ *		   UIDs repetidos en la lista.
+ */
+static void uidAleatorio(accesos_entrada_t *uid, uint32_t indice) {
+	uid->largo = (aleatorio() % 4 == 0) ? 7 : 4;
+	for (uint8_t i = 0; i < MFRC522_UID_MAX; i++)
+		uid->uid[i] = (i < uid->largo) ? (uint8_t) aleatorio() : 0;
+	uid->uid[1] = (uint8_t) indice;
+	uid->uid[2] = (uint8_t) (indice >> 8);
+	uid->uid[3] = (uint8_t) (indice >> 16);
+}
+
+static double tiempoNs(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ *	@brief Búsqueda lineal, como la que se hace
+ *		   sin un índice.
+ */
+static bool_t buscarLineal(const accesos_entrada_t *lista, uint32_t cantidad,
+		const accesos_entrada_t *uid) {
+	for (uint32_t i = 0; i < cantidad; i++) {
+		if (lista[i].largo != uid->largo)
+			continue;
+		uint8_t j = 0;
+		while (j < uid->largo && lista[i].uid[j] == uid->uid[j])
+			j++;
+		if (j == uid->largo)
+			return true;
+	}
+	return false;
+}
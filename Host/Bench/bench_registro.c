@@ -0,0 +1,285 @@
+/**
+ * @file bench_registro.c
+ * @brief Benchmark de PC del registro de accesos sobre la
+ * 		  flash simulada en un archivo. Compara escribir cada
+ * 		  evento en la flash apenas ocurre con acumularlos en
+ * 		  RAM y escribir páginas completas, mide la recuperación
+ * 		  al arrancar y el recorrido para exportar el registro, y
+ * 		  verifica el desgaste de los sectores luego de varias
+ * 		  vueltas y la recuperación luego de cortar la
+ * 		  alimentación durante una escritura o de una
+ * 		  programación fallida.
+ *
+ * 		  Compilación:
+ * 		  gcc -std=c11 -O2 -DAPI_PORT_HOST -IRC522_driver/Inc
+ * 		      -IHost/Inc Host/Bench/bench_registro.c
+ * 		      Host/Src/host_plataforma.c Host/Src/sim_flash.c
+ * 		      Host/Src/API_registro_port_host.c
+ * 		      RC522_driver/Src/API_registro.c -o bench_registro
+ */
+
+#include <stdio.h>
+#include "API_registro.h"
+#include "API_registro_port.h"
+#include "sim_flash.h"
+#include "host_plataforma.h"
+
+#ifndef REGISTRO_ARCHIVO_HOST
+#define REGISTRO_ARCHIVO_HOST		"registro_flash.bin"
+#endif
+
+#define EVENTOS_PRUEBA			256
+#define VUELTAS_DESGASTE		10
+#define PERIODO_EVENTOS_NS		50000000ULL	//una lectura cada 50 mS
+#define EVENTOS_SECTOR			(REGISTRO_TAMANO_SECTOR / sizeof(registro_evento_t))
+#define POSICIONES_REGISTRO		(EVENTOS_SECTOR * REGISTRO_CANTIDAD_SECTORES)
+
+static uint64_t inicioMedicion = 0;
+static uint32_t leidosInicio = 0;
+static uint32_t programadosInicio = 0;
+static uint32_t programacionesInicio = 0;
+
+static void iniciarMedicion();
+static void reportar(const char*, uint32_t);
+static void agregarEvento(uint32_t);
+static uint32_t recorrer(uint32_t*);
+static void compararEscritura();
+static void probarDesgaste();
+static void probarCorte();
+static void probarFalla();
+
+int main(void) {
+	printf("%-30s %8s %10s %12s %12s %12s\n", "operacion", "eventos",
+			"leidos[B]", "escritos[B]", "escrituras", "tiempo[us]");
+
+	host_reiniciar();
+	remove(REGISTRO_ARCHIVO_HOST);
+
+	iniciarMedicion();
+	host_verificar(registro_init(), "no se pudo abrir la flash");
+	reportar("registro_init vacio", 0);
+
+	compararEscritura();
+	probarDesgaste();
+	probarCorte();
+	probarFalla();
+
+	remove(REGISTRO_ARCHIVO_HOST);
+	return host_errores() ? 1 : 0;
+}
+
+static void iniciarMedicion() {
+	inicioMedicion = host_tiempoNs();
+	leidosInicio = simFlash_bytesLeidos();
+	programadosInicio = simFlash_bytesProgramados();
+	programacionesInicio = simFlash_programaciones();
+}
+
+static void reportar(const char *operacion, uint32_t eventos) {
+	printf("%-30s %8lu %10lu %12lu %12lu %12.1f\n", operacion,
+			(unsigned long) eventos,
+			(unsigned long) (simFlash_bytesLeidos() - leidosInicio),
+			(unsigned long) (simFlash_bytesProgramados() - programadosInicio),
+			(unsigned long) (simFlash_programaciones() - programacionesInicio),
+			(host_tiempoNs() - inicioMedicion) / 1000.0);
+}
+
+/**
+ *	@brief Agrega un evento con el UID de prueba, cuyo último
+ *		   byte y marca de tiempo identifican al evento.
+ */
+static void agregarEvento(uint32_t numero) {
+	uint8_t uid[sizeof(HOST_UID_PRUEBA)];
+	for (uint8_t i = 0; i < sizeof(uid); i++)
+		uid[i] = HOST_UID_PRUEBA[i];
+	uid[sizeof(uid) - 1] = (uint8_t) numero;
+	host_verificar(registro_agregar(uid, sizeof(uid),
+			numero % 3 ? REGISTRO_ACCESO_PERMITIDO : REGISTRO_ACCESO_DENEGADO,
+			numero), "buffer del registro lleno");
+}
+
+/**
+ *	@brief Recorre el registro verificando que las secuencias
+ *		   sean crecientes y que cada evento conserve su UID.
+ *	@retval Cantidad de eventos recorridos. En ultimo se
+ *			guarda la marca de tiempo del último.
+ */
+static uint32_t recorrer(uint32_t *ultimo) {
+	registro_iterador_t iterador;
+	registro_evento_t evento;
+	uint32_t cantidad = 0;
+	uint32_t secuencia = 0;
+
+	registro_iniciarRecorrido(&iterador);
+	while (registro_siguiente(&iterador, &evento)) {
+		if (cantidad > 0 && evento.secuencia <= secuencia)
+			host_verificar(false, "secuencia no creciente");
+		if (evento.largo != sizeof(HOST_UID_PRUEBA)
+				|| evento.uid[sizeof(HOST_UID_PRUEBA) - 1]
+						!= (uint8_t) evento.tiempo)
+			host_verificar(false, "evento con datos incorrectos");
+		secuencia = evento.secuencia;
+		*ultimo = evento.tiempo;
+		cantidad++;
+	}
+	return cantidad;
+}
+
+/**
+ *	@brief Escribe EVENTOS_PRUEBA eventos de a uno y luego
+ *		   otros tantos de a páginas, y mide la recuperación
+ *		   y el recorrido del registro resultante.
+ */
+static void compararEscritura() {
+	uint32_t numero = 0;
+	uint32_t ultimo = 0;
+
+	// El primer evento borra el sector inicial; no se incluye en la medición
+	agregarEvento(numero++);
+	registro_sincronizar();
+
+	iniciarMedicion();
+	for (uint32_t i = 0; i < EVENTOS_PRUEBA; i++) {
+		agregarEvento(numero++);
+		registro_sincronizar();
+	}
+	reportar("escritura de a un evento", EVENTOS_PRUEBA);
+
+	iniciarMedicion();
+	uint64_t maximoNs = 0;
+	for (uint32_t i = 0; i < EVENTOS_PRUEBA; i++) {
+		agregarEvento(numero++);
+		uint64_t antes = host_tiempoNs();
+		registro_procesar();
+		if (host_tiempoNs() - antes > maximoNs)
+			maximoNs = host_tiempoNs() - antes;
+	}
+	registro_sincronizar();
+	reportar("escritura por paginas", EVENTOS_PRUEBA);
+	printf("%-30s %8s %10s %12s %12s %12.1f\n", "  registro_procesar maximo",
+			"", "", "", "", maximoNs / 1000.0);
+
+	iniciarMedicion();
+	host_verificar(registro_init(), "no se pudo abrir la flash");
+	reportar("registro_init recuperacion", registro_cantidad());
+
+	iniciarMedicion();
+	uint32_t recorridos = recorrer(&ultimo);
+	reportar("recorrido completo", recorridos);
+	host_verificar(recorridos == numero && ultimo == numero - 1,
+			"no se recuperaron todos los eventos");
+}
+
+/**
+ *	@brief Escribe VUELTAS_DESGASTE veces la capacidad del
+ *		   registro, con un evento cada PERIODO_EVENTOS_NS y una
+ *		   llamada a registro_procesar por evento, y verifica
+ *		   que no se pierden eventos durante los borrados, que
+ *		   todos los sectores se borraron la misma cantidad de
+ *		   veces (más o menos uno) y que se conservan los
+ *		   eventos más recientes.
+ */
+static void probarDesgaste() {
+	uint32_t ultimo = 0;
+	uint32_t eventos = VUELTAS_DESGASTE * POSICIONES_REGISTRO;
+
+	host_verificar(registro_init(), "no se pudo abrir la flash");
+	iniciarMedicion();
+	for (uint32_t i = 0; i < eventos; i++) {
+		agregarEvento(i);
+		registro_procesar();
+		host_avanzarNs(PERIODO_EVENTOS_NS);
+	}
+	registro_sincronizar();
+	reportar("vueltas del registro", eventos);
+	host_verificar(registro_perdidos() == 0,
+			"eventos perdidos durante un borrado");
+
+	uint32_t minimo = UINT32_MAX, maximo = 0;
+	printf("borrados por sector:");
+	for (uint8_t sector = 0; sector < REGISTRO_CANTIDAD_SECTORES; sector++) {
+		uint32_t borrados = simFlash_borrados(sector);
+		printf(" %lu", (unsigned long) borrados);
+		if (borrados < minimo)
+			minimo = borrados;
+		if (borrados > maximo)
+			maximo = borrados;
+	}
+	printf("\n");
+	host_verificar(maximo - minimo <= 1, "desgaste desparejo de los sectores");
+
+	host_verificar(registro_init(), "no se pudo abrir la flash");
+	uint32_t recorridos = recorrer(&ultimo);
+	host_verificar(
+			recorridos >= POSICIONES_REGISTRO / REGISTRO_CANTIDAD_SECTORES
+					&& ultimo == eventos - 1,
+			"se perdieron los eventos recientes");
+}
+
+/**
+ *	@brief Corta la alimentación a mitad de la escritura de una
+ *		   página. Al arrancar, el evento incompleto se descarta
+ *		   por su CRC, los anteriores se conservan y los nuevos
+ *		   continúan la secuencia en las posiciones siguientes.
+ */
+static void probarCorte() {
+	uint32_t ultimo = 0;
+
+	host_verificar(registro_init(), "no se pudo abrir la flash");
+	uint32_t antes = recorrer(&ultimo);
+
+	for (uint32_t i = 0; i < 3; i++)
+		agregarEvento(ultimo + 1 + i);
+	simFlash_cortarProgramacion(sizeof(registro_evento_t) + 10);
+	registro_sincronizar();
+
+	iniciarMedicion();
+	host_verificar(registro_init(), "no se pudo abrir la flash");
+	reportar("registro_init luego de corte", registro_cantidad());
+	uint32_t despues = recorrer(&ultimo);
+	host_verificar(despues == antes + 1, "el evento incompleto no se descarto");
+
+	agregarEvento(ultimo + 1);
+	registro_sincronizar();
+	host_verificar(registro_init(), "no se pudo abrir la flash");
+	host_verificar(recorrer(&ultimo) == despues + 1,
+			"no se continuo luego del evento incompleto");
+}
+
+/**
+ *	@brief Sobre un registro vacío, hace fallar la programación
+ *		   de la página que contiene la mitad del primer sector,
+ *		   donde registro_init busca primero la posición libre, y
+ *		   escribe páginas después. Al arrancar se deben recuperar
+ *		   todos los eventos, y los nuevos no deben escribirse
+ *		   sobre los que siguen a la página fallida.
+ */
+static void probarFalla() {
+	uint32_t numero = 0, ultimo = 0;
+	uint32_t paginasAntes = EVENTOS_SECTOR / 2 / REGISTRO_EVENTOS_PAGINA;
+
+	remove(REGISTRO_ARCHIVO_HOST);
+	host_verificar(registro_init(), "no se pudo abrir la flash");
+	for (uint32_t pagina = 0; pagina < paginasAntes + 3; pagina++) {
+		for (uint32_t i = 0; i < REGISTRO_EVENTOS_PAGINA; i++)
+			agregarEvento(numero++);
+		if (pagina == paginasAntes)
+			simFlash_fallarProgramacion(0);
+		registro_sincronizar();
+		if (pagina == paginasAntes)
+			registro_sincronizar();		//los eventos quedaron en el buffer
+	}
+
+	iniciarMedicion();
+	host_verificar(registro_init(), "no se pudo abrir la flash");
+	reportar("registro_init luego de falla", registro_cantidad());
+	host_verificar(recorrer(&ultimo) == numero && ultimo == numero - 1,
+			"se perdieron eventos luego de la programacion fallida");
+
+	for (uint32_t i = 0; i < REGISTRO_EVENTOS_PAGINA; i++)
+		agregarEvento(numero++);
+	registro_sincronizar();
+	host_verificar(registro_init(), "no se pudo abrir la flash");
+	host_verificar(recorrer(&ultimo) == numero && ultimo == numero - 1,
+			"se sobrescribieron eventos luego de la programacion fallida");
+}
@@ -0,0 +1,174 @@
+/**
+ * @file bench_rf.c
+ * @brief Benchmark de PC de la telemetría de RF y del ajuste
+ * 		  automático del receptor. Para enlaces de RF con distinta
+ * 		  atenuación y ruido (sim_mfrc522, simMfrc522_configurarEnlace)
+ * 		  simula tarjetas acercadas a la puerta: cada una se lee con
+ * 		  mfrc522_lectorLeerUID hasta lograrlo. Compara la
+ * 		  configuración por defecto del MFRC522 con la elegida por
+ * 		  mfrc522_lectorAutoajustar: lecturas logradas, intentos y
+ * 		  reintentos por lectura, errores informados por la
+ * 		  telemetría y latencia hasta leer el UID.
+ *
+ * 		  Compilación:
+ * 		  gcc -std=c11 -O2 -DAPI_PORT_HOST -IRC522_driver/Inc
+ * 		      -IHost/Inc -ICommon/Inc Host/Bench/bench_rf.c
+ * 		      Host/Src/host_plataforma.c Host/Src/sim_mfrc522.c
+ * 		      Host/Src/API_mfrc522_port_host.c
+ * 		      RC522_driver/Src/API_mfrc522.c -o bench_rf
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "API_mfrc522.h"
+#include "host_plataforma.h"
+#include "sim_mfrc522.h"
+
+#define LECTURAS_PUERTA			200		//tarjetas acercadas en cada medición
+#define MAX_INTENTOS			20		//intentos antes de dar la lectura por fallida
+#define INTENTOS_AJUSTE			8
+
+/**
+ *	@brief Enlace de RF de una instalación.
+ */
+typedef struct {
+	const char *nombre;
+	uint8_t atenuacionDb;
+	uint8_t ruidoDb;
+} escenario_t;
+
+/**
+ *	@brief Resultado de las lecturas en la puerta.
+ */
+typedef struct {
+	uint32_t logradas;
+	uint32_t intentos;
+	uint64_t latenciaNs;
+	uint64_t latenciaMaxNs;
+	mfrc522_telemetria_t telemetria;
+} medicion_t;
+
+static const escenario_t ESCENARIOS[] = { { "sin obstaculos", 0, 0 }, {
+		"marco metalico", 6, 4 }, { "marco metalico cercano", 8, 6 } };
+
+static medicion_t medirPuerta(mfrc522_t*);
+static void imprimir(const char*, const mfrc522_rf_t*, const medicion_t*);
+
+int main(void) {
+	printf("%-26s %-12s %6s %8s %8s %5s %5s %5s %5s %9s %9s\n", "enlace",
+			"rf", "ok[%]", "intentos", "reintent", "tmo", "par", "crc",
+			"err", "media[ms]", "max[ms]");
+
+	for (uint8_t i = 0; i < sizeof(ESCENARIOS) / sizeof(ESCENARIOS[0]); i++) {
+		const escenario_t *escenario = &ESCENARIOS[i];
+		mfrc522_t lector;
+		mfrc522_rf_t rf;
+
+		host_reiniciar();
+		simMfrc522_reset();
+		simMfrc522_configurarEnlace(0, escenario->atenuacionDb,
+				escenario->ruidoDb);
+		host_verificar(mfrc522_lectorInit(&lector, 0), "lectorInit fallo");
+
+		mfrc522_lectorRfLeer(&lector, &rf);
+		host_verificar(rf.ganancia == 4 && rf.umbral == 8
+				&& rf.conductanciaP == 0x20 && rf.conductanciaN == 8,
+				"configuracion de RF inicial inesperada");
+		medicion_t inicial = medirPuerta(&lector);
+		imprimir(escenario->nombre, &rf, &inicial);
+
+		//ajuste con una tarjeta apoyada en el lector
+		int tarjeta = simMfrc522_agregarTarjeta(0, HOST_UID_PRUEBA,
+				sizeof(HOST_UID_PRUEBA));
+		host_borrarContadores();
+		uint64_t inicio = host_tiempoNs();
+		bool_t ajustado = mfrc522_lectorAutoajustar(&lector, INTENTOS_AJUSTE,
+				&rf);
+		uint64_t duracion = host_tiempoNs() - inicio;
+		host_estadisticasBus_t spi = host_leerBus(HOST_BUS_SPI);
+		simMfrc522_quitarTarjeta(0, tarjeta);
+		host_verificar(ajustado, "el ajuste no leyo la tarjeta");
+
+		mfrc522_rf_t escrita;
+		mfrc522_lectorRfLeer(&lector, &escrita);
+		host_verificar(memcmp(&escrita, &rf, sizeof(rf)) == 0,
+				"la configuracion elegida no quedo escrita");
+
+		mfrc522_lectorTelemetriaBorrar(&lector);
+		medicion_t ajustada = medirPuerta(&lector);
+		imprimir("  ajustada", &rf, &ajustada);
+		printf("  (ajuste: %.1f ms, %lu transacciones SPI)\n", duracion / 1e6,
+				(unsigned long) spi.transacciones);
+
+		host_verificar(ajustada.logradas >= inicial.logradas
+				&& ajustada.intentos <= inicial.intentos,
+				"el ajuste empeoro las lecturas");
+		host_verificar(ajustada.telemetria.aciertos == ajustada.logradas,
+				"la telemetria no cuenta los aciertos");
+	}
+
+	//sin tarjeta el ajuste falla y restaura la configuración
+	mfrc522_t lector;
+	mfrc522_rf_t antes, despues;
+	host_reiniciar();
+	simMfrc522_reset();
+	mfrc522_lectorInit(&lector, 0);
+	mfrc522_lectorRfLeer(&lector, &antes);
+	host_verificar(!mfrc522_lectorAutoajustar(&lector, INTENTOS_AJUSTE, NULL),
+			"ajuste sin tarjeta");
+	mfrc522_lectorRfLeer(&lector, &despues);
+	host_verificar(memcmp(&antes, &despues, sizeof(antes)) == 0,
+			"el ajuste fallido no restauro la configuracion");
+
+	return host_errores() ? 1 : 0;
+}
+
+/**
+ *	@brief Acerca LECTURAS_PUERTA tarjetas al lector de a
+ *		   una, y lee cada una hasta lograrlo o hasta
+ *		   MAX_INTENTOS. La latencia es el tiempo virtual desde
+ *		   el primer intento hasta leer el UID.
+ */
+static medicion_t medirPuerta(mfrc522_t *lector) {
+	medicion_t medicion = { 0 };
+	mfrc522_uid_t uid;
+
+	mfrc522_lectorTelemetriaBorrar(lector);
+	for (uint32_t i = 0; i < LECTURAS_PUERTA; i++) {
+		int tarjeta = simMfrc522_agregarTarjeta(0, HOST_UID_PRUEBA,
+				sizeof(HOST_UID_PRUEBA));
+		uint64_t inicio = host_tiempoNs();
+		for (uint8_t intento = 0; intento < MAX_INTENTOS; intento++) {
+			medicion.intentos++;
+			if (mfrc522_lectorLeerUID(lector, &uid)) {
+				uint64_t latencia = host_tiempoNs() - inicio;
+				medicion.logradas++;
+				medicion.latenciaNs += latencia;
+				if (latencia > medicion.latenciaMaxNs)
+					medicion.latenciaMaxNs = latencia;
+				host_verificar(memcmp(uid.uid, HOST_UID_PRUEBA,
+						sizeof(HOST_UID_PRUEBA)) == 0, "UID leido incorrecto");
+				break;
+			}
+		}
+		simMfrc522_quitarTarjeta(0, tarjeta);
+	}
+	mfrc522_lectorTelemetria(lector, &medicion.telemetria);
+	return medicion;
+}
+
+static void imprimir(const char *nombre, const mfrc522_rf_t *rf,
+		const medicion_t *m) {
+	char config[16];
+	const mfrc522_telemetria_t *t = &m->telemetria;
+	snprintf(config, sizeof(config), "%u/%u/%02X/%X", rf->ganancia, rf->umbral,
+			rf->conductanciaP, rf->conductanciaN);
+	printf("%-26s %-12s %6.1f %8.2f %8.2f %5lu %5lu %5lu  0x%02X %9.2f %9.2f\n",
+			nombre, config, 100.0 * m->logradas / LECTURAS_PUERTA,
+			(double) m->intentos / LECTURAS_PUERTA,
+			t->aciertos ? (double) t->reintentos / t->aciertos : 0.0,
+			(unsigned long) t->timeouts, (unsigned long) t->erroresParidad,
+			(unsigned long) t->erroresCrc, t->ultimoErrorReg,
+			m->logradas ? m->latenciaNs / 1e6 / m->logradas : 0.0,
+			m->latenciaMaxNs / 1e6);
+}
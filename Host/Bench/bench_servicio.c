@@ -0,0 +1,222 @@
+/**
+ * @file bench_servicio.c
+ * @brief Benchmark de PC del servicio de lectura en segundo
+ * 		  plano. El servicio sondea dos lectores simulados desde
+ * 		  un hilo (API_servicio_port_host.c) mientras en cada uno
+ * 		  se acercan y se retiran tarjetas, y el hilo principal,
+ * 		  ocupado con otro trabajo, extrae los eventos de a lotes.
+ * 		  A mitad de la prueba el hilo principal se detiene un
+ * 		  tiempo para que la cola se llene. Verifica que cada
+ * 		  evento se reciba o se cuente como descartado, en orden,
+ * 		  e informa la latencia de detección, el tamaño de los
+ * 		  lotes y el tiempo que el loop principal hubiera estado
+ * 		  bloqueado si sondeara los lectores él mismo.
+ *
+ * 		  Compilación:
+ * 		  gcc -std=c11 -O2 -pthread -DAPI_PORT_HOST -IRC522_driver/Inc
+ * 		      -IHost/Inc -ICommon/Inc Host/Bench/bench_servicio.c
+ * 		      Host/Src/host_plataforma.c Host/Src/sim_mfrc522.c
+ * 		      Host/Src/API_mfrc522_port_host.c
+ * 		      Host/Src/API_servicio_port_host.c
+ * 		      RC522_driver/Src/API_mfrc522.c
+ * 		      RC522_driver/Src/API_servicio.c -o bench_servicio
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <time.h>
+#include "API_servicio.h"
+#include "API_mfrc522.h"
+#include "host_servicio.h"
+#include "host_plataforma.h"
+#include "sim_mfrc522.h"
+
+#define LECTORES				2
+#define TARJETAS_POR_LECTOR		100
+#define PERIODO_MS				20
+#define CICLO_MS				1200	//una tarjeta nueva en cada lector cada 1,2 s
+#define PERMANENCIA_MS			400		//tiempo que cada tarjeta queda en el campo
+#define DESFASE_MS				300		//entre las tarjetas de un lector y el siguiente
+#define EVENTOS_ESPERADOS		(2 * LECTORES * TARJETAS_POR_LECTOR)
+#define LOTE_MAXIMO				8
+#define TRABAJO_US				200		//trabajo del loop principal entre extracciones
+#define EVENTOS_ANTES_PAUSA		100
+#define PAUSA_MS				100		//el loop principal no extrae durante este tiempo
+#define LIMITE_S				30
+#define NS_POR_MS				1000000ULL
+
+/**
+ *	@brief Tarjeta en el campo de cada lector simulado.
+ */
+typedef struct {
+	int tarjeta;		//número de tarjeta del escenario, o -1
+	int indice;			//índice en simMfrc522
+} campo_t;
+
+static campo_t campos[LECTORES];
+
+static void escenario(uint64_t);
+static uint32_t llegadaMs(uint8_t, uint8_t);
+static void dormirUs(uint32_t);
+static double tiempoRealS(void);
+
+int main(void) {
+	mfrc522_t lectores[LECTORES];
+	servicio_evento_t lote[LOTE_MAXIMO];
+	int ultimaTarjeta[LECTORES];
+	uint8_t ultimoEvento[LECTORES];
+	uint32_t recibidos = 0, lotes = 0, maxPendientes = 0;
+	uint32_t latenciaLlegadaMax = 0, latenciaRetiroMax = 0;
+	uint64_t latenciaLlegadaTotal = 0, latenciaRetiroTotal = 0;
+	uint32_t llegadas = 0, retiros = 0;
+	bool_t pausado = false;
+
+	host_reiniciar();
+	simMfrc522_reset();
+	for (uint8_t i = 0; i < LECTORES; i++) {
+		host_verificar(mfrc522_lectorInit(&lectores[i], i), "lectorInit fallo");
+		campos[i].tarjeta = -1;
+		ultimaTarjeta[i] = -1;
+		ultimoEvento[i] = MFRC522_EVENTO_RETIRO;
+	}
+
+	host_servicioEscenario(escenario);
+	host_verificar(servicio_iniciar(lectores, LECTORES, PERIODO_MS),
+			"servicio_iniciar fallo");
+	double inicio = tiempoRealS();
+
+	while (recibidos + servicio_desbordes() < EVENTOS_ESPERADOS
+			&& tiempoRealS() - inicio < LIMITE_S) {
+		uint32_t pendientes = servicio_pendientes();
+		if (pendientes > maxPendientes)
+			maxPendientes = pendientes;
+
+		uint32_t cantidad = servicio_extraer(lote, LOTE_MAXIMO);
+		if (cantidad > 0)
+			lotes++;
+		for (uint32_t j = 0; j < cantidad; j++) {
+			const servicio_evento_t *e = &lote[j];
+			uint8_t lector = e->uid.uid[1];
+			int tarjeta = e->uid.uid[2];
+			if (e->lector >= LECTORES || lector != e->lector
+					|| tarjeta >= TARJETAS_POR_LECTOR) {
+				host_verificar(false, "evento con un UID desconocido");
+				continue;
+			}
+			//los eventos de cada lector llegan en el orden del escenario
+			host_verificar(tarjeta > ultimaTarjeta[lector]
+					|| (tarjeta == ultimaTarjeta[lector]
+							&& ultimoEvento[lector] == MFRC522_EVENTO_LLEGADA
+							&& e->evento == MFRC522_EVENTO_RETIRO),
+					"evento fuera de orden");
+			ultimaTarjeta[lector] = tarjeta;
+			ultimoEvento[lector] = e->evento;
+
+			uint32_t llegada = llegadaMs(lector, (uint8_t) tarjeta);
+			if (e->evento == MFRC522_EVENTO_LLEGADA) {
+				uint32_t latencia = e->tiempo - llegada;
+				latenciaLlegadaTotal += latencia;
+				if (latencia > latenciaLlegadaMax)
+					latenciaLlegadaMax = latencia;
+				llegadas++;
+			} else {
+				uint32_t latencia = e->tiempo - (llegada + PERMANENCIA_MS);
+				latenciaRetiroTotal += latencia;
+				if (latencia > latenciaRetiroMax)
+					latenciaRetiroMax = latencia;
+				retiros++;
+			}
+		}
+		recibidos += cantidad;
+
+		if (!pausado && recibidos >= EVENTOS_ANTES_PAUSA) {
+			pausado = true;
+			dormirUs(PAUSA_MS * 1000);
+		} else {
+			dormirUs(TRABAJO_US);
+		}
+	}
+	servicio_detener();
+	double duracion = tiempoRealS() - inicio;
+
+	uint32_t desbordes = servicio_desbordes();
+	uint32_t pasadas = host_servicioPasadas();
+	host_estadisticasBus_t spi = host_leerBus(HOST_BUS_SPI);
+
+	printf("%-34s %10lu\n", "eventos esperados", (unsigned long) EVENTOS_ESPERADOS);
+	printf("%-34s %10lu\n", "eventos recibidos", (unsigned long) recibidos);
+	printf("%-34s %10lu\n", "eventos descartados (cola llena)",
+			(unsigned long) desbordes);
+	printf("%-34s %10lu (%.1f eventos por lote)\n", "lotes extraidos",
+			(unsigned long) lotes, lotes ? (double) recibidos / lotes : 0.0);
+	printf("%-34s %10lu de %u\n", "maximo en la cola",
+			(unsigned long) maxPendientes, SERVICIO_CAPACIDAD_COLA);
+	printf("%-34s %10.1f / %lu ms\n", "latencia de llegada media / max",
+			llegadas ? (double) latenciaLlegadaTotal / llegadas : 0.0,
+			(unsigned long) latenciaLlegadaMax);
+	printf("%-34s %10.1f / %lu ms\n", "latencia de retiro media / max",
+			retiros ? (double) latenciaRetiroTotal / retiros : 0.0,
+			(unsigned long) latenciaRetiroMax);
+	printf("%-34s %10lu (%.1f s virtuales, %.2f s reales)\n",
+			"pasadas del servicio", (unsigned long) pasadas,
+			host_tiempoNs() / 1e9, duracion);
+	printf("%-34s %10.1f us\n", "bloqueo evitado por pasada",
+			pasadas ? host_servicioOcupadoNs() / 1000.0 / pasadas : 0.0);
+	printf("%-34s %10.1f trans, %.1f bytes\n", "SPI por pasada",
+			pasadas ? (double) spi.transacciones / pasadas : 0.0,
+			pasadas ? (double) spi.bytes / pasadas : 0.0);
+
+	host_verificar(recibidos + desbordes == EVENTOS_ESPERADOS,
+			"eventos perdidos sin contabilizar");
+	host_verificar(desbordes > 0, "la pausa no lleno la cola");
+	host_verificar(latenciaLlegadaMax <= 2 * PERIODO_MS,
+			"llegada detectada tarde");
+	host_verificar(servicio_extraer(lote, LOTE_MAXIMO) == 0,
+			"eventos luego de detener el servicio");
+	return host_errores() ? 1 : 0;
+}
+
+/**
+ *	@brief Tarjeta k del lector i: llega en k * CICLO_MS
+ *		   + i * DESFASE_MS y se retira PERMANENCIA_MS después.
+ *		   El byte 1 del UID es el lector y el 2 el número de
+ *		   tarjeta. Se ejecuta en el hilo del servicio.
+ */
+static void escenario(uint64_t tiempoNs) {
+	uint32_t ahora = (uint32_t) (tiempoNs / NS_POR_MS);
+
+	for (uint8_t i = 0; i < LECTORES; i++) {
+		int tarjeta = -1;
+		if (ahora >= i * DESFASE_MS) {
+			uint32_t t = ahora - i * DESFASE_MS;
+			if (t / CICLO_MS < TARJETAS_POR_LECTOR
+					&& t % CICLO_MS < PERMANENCIA_MS)
+				tarjeta = (int) (t / CICLO_MS);
+		}
+		if (tarjeta == campos[i].tarjeta)
+			continue;
+
+		if (campos[i].tarjeta >= 0)
+			simMfrc522_quitarTarjeta(i, campos[i].indice);
+		campos[i].tarjeta = tarjeta;
+		if (tarjeta >= 0) {
+			const uint8_t uid[] = { 0x04, i, (uint8_t) tarjeta, 0x5A };
+			campos[i].indice = simMfrc522_agregarTarjeta(i, uid, sizeof(uid));
+		}
+	}
+}
+
+static uint32_t llegadaMs(uint8_t lector, uint8_t tarjeta) {
+	return tarjeta * CICLO_MS + lector * DESFASE_MS;
+}
+
+static void dormirUs(uint32_t us) {
+	struct timespec espera = { us / 1000000, (us % 1000000) * 1000L };
+	nanosleep(&espera, NULL);
+}
+
+static double tiempoRealS(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file constructor_accesos.h
+ * @brief Construcción en PC de tablas estáticas de
+ * 		  accesos con hash perfecto. Lo usan la herramienta
+ * 		  gen_tabla_accesos y los benchmarks.
+ */
+
+#ifndef HOST_INC_CONSTRUCTOR_ACCESOS_H_
+#define HOST_INC_CONSTRUCTOR_ACCESOS_H_
+
+#include "API_accesos.h"
+
+//cantidad promedio de UIDs por grupo
+#define CONSTRUCTOR_UIDS_POR_GRUPO		4
+//posiciones de la tabla por cada 4 UIDs
+#define CONSTRUCTOR_FACTOR_TAMANO		5
+//semillas a probar antes de abandonar
+#define CONSTRUCTOR_MAX_SEMILLAS		32
+
+/**
+ *   @brief Construye una tabla estática a partir de una lista
+ *          de UIDs sin repetidos. Los arreglos de la tabla se
+ *          reservan con malloc y se liberan con
+ *          constructor_liberar().
+ *   @retval Falso si no se pudo construir la tabla.
+ */
+bool_t constructor_construir(accesos_tablaEstatica_t *tabla,
+		const accesos_entrada_t *uids, uint32_t cantidad);
+
+/**
+ *   @brief Libera los arreglos de una tabla construida.
+ */
+void constructor_liberar(accesos_tablaEstatica_t *tabla);
+
+#endif /* HOST_INC_CONSTRUCTOR_ACCESOS_H_ */
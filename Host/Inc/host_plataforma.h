@@ -0,0 +1,98 @@
+/**
+ * @file host_plataforma.h
+ * @brief Tiempo virtual y contadores de bus compartidos
+ *        por los ports de PC. El tiempo sólo avanza cuando
+ *        los ports simulan una transferencia o una espera,
+ *        por lo que las mediciones son reproducibles.
+ */
+
+#ifndef HOST_INC_HOST_PLATAFORMA_H_
+#define HOST_INC_HOST_PLATAFORMA_H_
+
+#include "API_types.h"
+
+//frecuencia del reloj SPI simulado (APB2 de 84 MHz con prescaler 128)
+#define HOST_SPI_CLOCK				656250UL
+//frecuencia del procesador simulado, para convertir el tiempo virtual a ciclos
+#define HOST_FRECUENCIA_CPU			84000000ULL
+//tiempo de CPU que consume cada consulta de un estado que depende del tiempo
+#define HOST_NS_POR_CONSULTA		1000UL
+
+/**
+ *   @brief Buses cuyas transferencias se contabilizan.
+ */
+typedef enum {
+	HOST_BUS_SPI, HOST_BUS_I2C, HOST_CANTIDAD_BUSES
+} host_bus_enum;
+
+/**
+ *   @brief Contadores de un bus.
+ */
+typedef struct {
+	uint32_t transacciones;
+	uint32_t bytes;
+	uint64_t tiempoNs;		//tiempo de ocupación del bus
+} host_estadisticasBus_t;
+
+//UID de la tarjeta que usan los benchmarks
+extern const uint8_t HOST_UID_PRUEBA[4];
+
+/**
+ *   @brief Vuelve el tiempo virtual a cero y borra los contadores.
+ */
+void host_reiniciar();
+
+/**
+ *   @brief Simula un reinicio del procesador en caliente
+ *          (los periféricos simulados conservan su estado) o
+ *          en frío. host_reiniciar() lo vuelve a frío.
+ */
+void host_simularReinicio(bool_t enCaliente);
+
+/**
+ *   @brief Indica si el último reinicio simulado fue en caliente.
+ */
+bool_t host_reinicioEnCaliente();
+
+/**
+ *   @brief Tiempo virtual en nS desde host_reiniciar().
+ */
+uint64_t host_tiempoNs();
+
+/**
+ *   @brief Avanza el tiempo virtual.
+ */
+void host_avanzarNs(uint64_t ns);
+
+/**
+ *   @brief Registra una transacción de un bus. No avanza el
+ *          tiempo virtual, ya que en una transferencia asíncrona
+ *          el procesador sigue ejecutando mientras el bus está ocupado.
+ */
+void host_registrarTransaccion(host_bus_enum bus, uint32_t bytes,
+		uint64_t tiempoNs);
+
+/**
+ *   @brief Devuelve los contadores de un bus.
+ */
+host_estadisticasBus_t host_leerBus(host_bus_enum bus);
+
+/**
+ *   @brief Borra los contadores de todos los buses sin
+ *          modificar el tiempo virtual.
+ */
+void host_borrarContadores();
+
+/**
+ *   @brief Verificación de los benchmarks: si la condición
+ *          es falsa informa el mensaje por stderr y cuenta
+ *          el error. host_reiniciar() no borra la cuenta.
+ */
+void host_verificar(bool_t condicion, const char *mensaje);
+
+/**
+ *   @brief Cantidad de verificaciones fallidas.
+ */
+uint32_t host_errores();
+
+#endif /* HOST_INC_HOST_PLATAFORMA_H_ */
@@ -0,0 +1,73 @@
+/**
+ * @file host_puertos.hpp
+ * @brief Bus SPI, pin de CS y bus I2C de PC para las interfaces
+ *        en C++ (API_mfrc522.hpp y API_lcd.hpp), sobre los ports
+ *        de PC de los drivers en C, por lo que las transferencias
+ *        llegan a los mismos modelos y se contabilizan igual.
+ *        El pin de CS solo indica el lector simulado. Como el
+ *        modelo del MFRC522 resuelve cada intercambio al iniciarlo,
+ *        la consulta de ComIrqReg ve el fin enseguida, igual que
+ *        el driver en C con IRQ_HABILITADA = 0.
+ */
+
+#ifndef HOST_INC_HOST_PUERTOS_HPP_
+#define HOST_INC_HOST_PUERTOS_HPP_
+
+extern "C" {
+#include "API_mfrc522_port.h"
+#include "API_lcd_port.h"
+}
+
+namespace host {
+
+template<uint8_t Lector>
+struct PinCs {
+	static_assert(Lector < MFRC522_CANTIDAD_LECTORES,
+			"lector fuera de MFRC522_CANTIDAD_LECTORES");
+	static constexpr uint8_t LECTOR = Lector;
+
+	static void iniciar() {
+		portInit(Lector);
+	}
+	static void activar() {
+	}
+	static void liberar() {
+	}
+};
+
+struct BusSpi {
+	static bool iniciar() {
+		return true;
+	}
+
+	template<class Cs>
+	static void transferir(const uint8_t *tx, uint8_t *rx, uint16_t largo) {
+		spiTransfer(Cs::LECTOR, tx, rx, largo);
+	}
+
+	static uint32_t tickMs() {
+		return portGetTick();
+	}
+};
+
+template<uint8_t Bus>
+struct BusI2c {
+	static_assert(Bus < I2C_CANTIDAD_BUSES, "bus fuera de I2C_CANTIDAD_BUSES");
+
+	static bool iniciar() {
+		return port_init(Bus);
+	}
+
+	static bool escribir(uint8_t direccion, const uint8_t *datos,
+			uint16_t largo) {
+		return port_i2cWriteBuffer(Bus, direccion, datos, largo);
+	}
+
+	static void esperarUs(uint32_t us) {
+		port_delayUs(us);
+	}
+};
+
+} /* namespace host */
+
+#endif /* HOST_INC_HOST_PUERTOS_HPP_ */
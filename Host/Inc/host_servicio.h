@@ -0,0 +1,42 @@
+/**
+ * @file host_servicio.h
+ * @brief Funciones propias del port de PC del servicio de
+ *        lectura (API_servicio_port_host.c), que ejecuta el
+ *        servicio en un hilo de POSIX. El hilo es el único que
+ *        usa el tiempo virtual, los contadores de host_plataforma
+ *        y los lectores simulados mientras el servicio está
+ *        iniciado; el hilo principal solo debe usar la cola.
+ */
+
+#ifndef HOST_INC_HOST_SERVICIO_H_
+#define HOST_INC_HOST_SERVICIO_H_
+
+#include "API_types.h"
+
+//tiempo real que el hilo cede al procesador luego de cada pasada, en uS
+#ifndef HOST_SERVICIO_ESPERA_US
+#define HOST_SERVICIO_ESPERA_US		20
+#endif
+
+/**
+ *   @brief Función que el hilo llama antes de cada pasada con
+ *          el tiempo virtual, para agregar o quitar tarjetas
+ *          de los lectores simulados.
+ */
+typedef void (*host_escenario_t)(uint64_t tiempoNs);
+
+/**
+ *   @brief Configura el escenario. Debe llamarse con el
+ *          servicio detenido.
+ */
+void host_servicioEscenario(host_escenario_t escenario);
+
+/**
+ *   @brief Pasadas del servicio y tiempo virtual que ocuparon,
+ *          desde el último servicio_iniciar. Solo son válidos
+ *          luego de servicio_detener.
+ */
+uint32_t host_servicioPasadas();
+uint64_t host_servicioOcupadoNs();
+
+#endif /* HOST_INC_HOST_SERVICIO_H_ */
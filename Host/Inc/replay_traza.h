@@ -0,0 +1,86 @@
+/**
+ * @file replay_traza.h
+ * @brief Carga de trazas volcadas con traza_volcar y reproducción
+ *        de las transacciones SPI en el driver del MFRC522 mediante
+ *        el port API_mfrc522_port_replay.c: cada lectura que hace el
+ *        driver devuelve los datos que devolvió el lector en la traza,
+ *        por lo que el driver compilado en la PC recorre los mismos
+ *        caminos que el que generó la traza, y sus transacciones se
+ *        contabilizan en host_plataforma para compararlas con las
+ *        grabadas.
+ */
+
+#ifndef HOST_INC_REPLAY_TRAZA_H_
+#define HOST_INC_REPLAY_TRAZA_H_
+
+#include "API_traza.h"
+#include "host_plataforma.h"
+
+//cantidad de transacciones del mismo lector, a partir de la posición
+//actual, en las que se busca la que corresponde a la del driver
+#define REPLAY_VENTANA				64
+//valor de dispositivo para sumar las transacciones de todos
+#define REPLAY_TODOS				(-1)
+
+/**
+ *   @brief Traza cargada de un archivo.
+ */
+typedef struct {
+	traza_transaccion_t *transacciones;
+	uint32_t cantidad;
+	uint32_t descartadas;		//informadas por el equipo al volcarla
+} replay_traza_t;
+
+/**
+ *   @brief Resultado de reproducir la traza de un lector.
+ */
+typedef struct {
+	uint32_t coincidentes;		//transacciones del driver halladas en la traza
+	uint32_t agregadas;			//transacciones del driver que no están en la traza
+	uint32_t omitidas;			//transacciones de la traza que el driver no hizo
+	uint32_t pendientes;		//transacciones de la traza no alcanzadas
+} replay_resultado_t;
+
+/**
+ *   @brief Lee una traza con el formato de traza_volcar.
+ *          Las líneas vacías y las que empiezan con '#' se
+ *          ignoran, salvo la de transacciones descartadas.
+ *   @retval Falso si el archivo no existe o tiene una línea
+ *           inválida (se informa por stderr).
+ */
+bool_t replay_cargar(const char *archivo, replay_traza_t *traza);
+
+void replay_liberar(replay_traza_t *traza);
+
+/**
+ *   @brief Costo en el bus de las transacciones grabadas de un
+ *          dispositivo (o de todos), calculado como en los ports
+ *          de PC: HOST_SPI_CLOCK para el SPI y start, dirección,
+ *          9 bits por byte y stop a I2C_CLOCK_SPEED para el I2C.
+ */
+host_estadisticasBus_t replay_costo(const replay_traza_t *traza,
+		host_bus_enum bus, int dispositivo);
+
+/**
+ *   @brief Lectores con transacciones SPI en la traza
+ *          (bit n = lector n).
+ */
+uint32_t replay_lectores(const replay_traza_t *traza);
+
+/**
+ *   @brief Prepara el port de reproducción para la traza, que
+ *          debe permanecer válida mientras se reproduce.
+ */
+void replay_iniciar(const replay_traza_t *traza);
+
+/**
+ *   @brief Indica si quedan transacciones del lector sin reproducir.
+ */
+bool_t replay_pendiente(uint8_t lector);
+
+/**
+ *   @brief Resultado de la reproducción del lector hasta el momento.
+ */
+replay_resultado_t replay_resultado(uint8_t lector);
+
+#endif /* HOST_INC_REPLAY_TRAZA_H_ */
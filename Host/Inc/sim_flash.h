@@ -0,0 +1,82 @@
+/**
+ * @file sim_flash.h
+ * @brief Modelo de la flash del STM32F4 para ejecutar el
+ *        registro de accesos en una PC. El contenido se guarda
+ *        en un archivo, por lo que se conserva entre ejecuciones
+ *        como la flash al cortar la alimentación. Simula que la
+ *        programación solo pasa bits de 1 a 0, el borrado por
+ *        sectores y los tiempos de ambas operaciones, y permite
+ *        cortar una programación a mitad de camino.
+ */
+
+#ifndef HOST_INC_SIM_FLASH_H_
+#define HOST_INC_SIM_FLASH_H_
+
+#include "API_types.h"
+
+//tiempos típicos del STM32F401 con 2,7 a 3,6 V (programación de a 32 bits)
+#define SIM_FLASH_NS_POR_PALABRA	16000ULL
+#define SIM_FLASH_NS_BORRADO		250000000ULL	//sector de 16 KB
+#define SIM_FLASH_MAX_SECTORES		8
+
+/**
+ *   @brief Abre el archivo que contiene la flash. Si no existe
+ *          o su tamaño no coincide, se crea con todos los bytes
+ *          borrados (0xFF). Los contadores se conservan, como
+ *          si se reiniciara solo el microcontrolador.
+ *   @retval Falso si no se puede crear el archivo.
+ */
+bool_t simFlash_abrir(const char *archivo, uint8_t sectores,
+		uint32_t tamanoSector);
+
+/**
+ *   @brief Cierra el archivo. Una programación o borrado en
+ *          curso queda como si se hubiera cortado la alimentación.
+ */
+void simFlash_cerrar();
+
+void simFlash_leer(uint32_t direccion, void *datos, uint32_t largo);
+
+/**
+ *   @brief Programa los datos con un AND sobre el contenido.
+ *   @retval Duración de la programación en nS, o 0 si la
+ *           dirección está fuera de la flash o la programación
+ *           falló (ver simFlash_fallarProgramacion).
+ */
+uint64_t simFlash_programar(uint32_t direccion, const void *datos,
+		uint32_t largo);
+
+/**
+ *   @brief Borra el sector. Termina SIM_FLASH_NS_BORRADO
+ *          después del instante indicado.
+ */
+void simFlash_borrar(uint8_t sector, uint64_t tiempoNs);
+
+/**
+ *   @brief Indica si hay un borrado en curso en el instante indicado.
+ */
+bool_t simFlash_ocupada(uint64_t tiempoNs);
+
+/**
+ *   @brief Limita la próxima programación a los primeros bytes
+ *          indicados, como si se cortara la alimentación.
+ */
+void simFlash_cortarProgramacion(uint32_t bytes);
+
+/**
+ *   @brief Hace fallar la próxima programación luego de
+ *          programar los primeros bytes indicados.
+ */
+void simFlash_fallarProgramacion(uint32_t bytes);
+
+/**
+ *   @brief Contadores desde el inicio del programa: bytes
+ *          leídos, bytes programados, llamadas a
+ *          simFlash_programar y borrados de un sector.
+ */
+uint32_t simFlash_bytesLeidos();
+uint32_t simFlash_bytesProgramados();
+uint32_t simFlash_programaciones();
+uint32_t simFlash_borrados(uint8_t sector);
+
+#endif /* HOST_INC_SIM_FLASH_H_ */
@@ -0,0 +1,101 @@
+/**
+ * @file sim_hd44780.h
+ * @brief Modelo de un display HD44780 conectado a través
+ *        de un expansor PCF8574 (adaptador I2C), para ejecutar
+ *        el driver en una PC. Simula el modo de 4 bits, la
+ *        DDRAM de 2x40, la CGRAM, el desplazamiento del display
+ *        y los tiempos de ejecución de cada instrucción. Se
+ *        pueden conectar varios displays, cada uno con la
+ *        dirección I2C de su expansor. El modelo no distingue
+ *        buses, por lo que las direcciones deben ser únicas.
+ */
+
+#ifndef HOST_INC_SIM_HD44780_H_
+#define HOST_INC_SIM_HD44780_H_
+
+#include "API_types.h"
+
+//bits del PCF8574 conectados al display
+#define SIM_PCF8574_RS				(1<<0)
+#define SIM_PCF8574_RW				(1<<1)
+#define SIM_PCF8574_E				(1<<2)
+#define SIM_PCF8574_BACKLIGHT		(1<<3)
+
+//tamaño de la DDRAM por fila en modo de 2 filas
+#define SIM_HD44780_COLUMNAS_DDRAM	40
+//cantidad máxima de displays (direcciones posibles de un PCF8574)
+#define SIM_MAX_DISPLAYS			8
+
+/**
+ *   @brief Desconecta todos los displays.
+ */
+void simHd44780_reset();
+
+/**
+ *   @brief Conecta un display en la dirección I2C de 7 bits
+ *          indicada y lo enciende en el instante indicado (en
+ *          modo de 8 bits, con la memoria en blanco).
+ *   @retval Índice del display para las consultas, o -1 si
+ *           la dirección está ocupada o no hay lugar.
+ */
+int simHd44780_agregar(uint8_t direccionI2C, uint64_t tiempoNs);
+
+/**
+ *   @brief Indica si algún expansor responde (ACK) en la dirección.
+ */
+bool_t simHd44780_presente(uint8_t direccionI2C);
+
+/**
+ *   @brief Nuevo valor de las salidas del PCF8574 en la
+ *          dirección indicada, escrito en el instante indicado.
+ *          Un flanco descendente de E captura el nibble de D4-D7.
+ *   @retval Falso si ningún expansor responde en la dirección.
+ */
+bool_t simHd44780_escribirExpansor(uint8_t direccionI2C, uint8_t valor,
+		uint64_t tiempoNs);
+
+/**
+ *   @brief Caracter visible en una posición de la pantalla,
+ *          teniendo en cuenta el desplazamiento del display.
+ */
+uint8_t simHd44780_caracter(uint8_t display, uint8_t fila, uint8_t columna);
+
+/**
+ *   @brief Contenido de la DDRAM en una dirección.
+ */
+uint8_t simHd44780_ddram(uint8_t display, uint8_t direccion);
+
+/**
+ *   @brief Contenido de la CGRAM en una dirección (0 a 63).
+ */
+uint8_t simHd44780_cgram(uint8_t display, uint8_t direccion);
+
+/**
+ *   @brief Valor actual del contador de direcciones.
+ */
+uint8_t simHd44780_contadorDirecciones(uint8_t display);
+
+/**
+ *   @brief Desplazamiento del display en columnas (0 a 39).
+ */
+uint8_t simHd44780_desplazamiento(uint8_t display);
+
+/**
+ *   @brief Indica si el display y el backlight están encendidos.
+ */
+bool_t simHd44780_displayEncendido(uint8_t display);
+bool_t simHd44780_backlight(uint8_t display);
+
+/**
+ *   @brief Cantidad de instrucciones y escrituras ejecutadas.
+ */
+uint32_t simHd44780_instrucciones(uint8_t display);
+
+/**
+ *   @brief Cantidad de instrucciones recibidas mientras el
+ *          controlador estaba ocupado. Estas instrucciones
+ *          se descartan, igual que en el display real.
+ */
+uint32_t simHd44780_violacionesTiempo(uint8_t display);
+
+#endif /* HOST_INC_SIM_HD44780_H_ */
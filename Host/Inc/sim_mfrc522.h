@@ -0,0 +1,82 @@
+/**
+ * @file sim_mfrc522.h
+ * @brief Modelo a nivel de registros del MFRC522 para
+ *        ejecutar el driver en una PC. Simula el protocolo
+ *        SPI, la FIFO, el timer, el pin IRQ y las tarjetas
+ *        ISO/IEC 14443-3 presentes en el campo RF. Se pueden
+ *        simular varios lectores, cada uno con su campo RF.
+ */
+
+#ifndef HOST_INC_SIM_MFRC522_H_
+#define HOST_INC_SIM_MFRC522_H_
+
+#include "API_types.h"
+
+//cantidad máxima de tarjetas simuladas en el campo RF de cada lector
+#define SIM_MAX_TARJETAS			8
+//cantidad de lectores simulados
+#define SIM_MAX_LECTORES			8
+
+/**
+ *   @brief Vuelve todos los lectores a su estado de encendido
+ *          y quita todas las tarjetas de sus campos RF.
+ */
+void simMfrc522_reset();
+
+/**
+ *   @brief Agrega una tarjeta con un UID de 4, 7 o 10
+ *          bytes al campo RF del lector.
+ *   @retval Índice de la tarjeta, o -1 si no hay lugar.
+ */
+int simMfrc522_agregarTarjeta(uint8_t lector, const uint8_t *uid,
+		uint8_t largo);
+
+/**
+ *   @brief Quita una tarjeta del campo RF del lector.
+ */
+void simMfrc522_quitarTarjeta(uint8_t lector, int indice);
+
+/**
+ *   @brief Configura el enlace de RF entre el lector y sus
+ *          tarjetas. atenuacionDb se resta a la portadora y otra
+ *          vez a la respuesta de la tarjeta (por ejemplo, por un
+ *          marco metálico cerca de la antena), y ruidoDb se suma
+ *          al ruido del receptor. Con ambos en 0 (valor de
+ *          simMfrc522_reset) el enlace es ideal. Si no, cada
+ *          respuesta se recibe según la ganancia (RFCfgReg), el
+ *          umbral (RxThresholdReg) y la potencia (CWGsPReg y
+ *          GsNReg) configurados: si supera poco el umbral puede
+ *          perderse (timeout), y si el ruido amplificado se acerca
+ *          al umbral cada byte puede tener errores de paridad o,
+ *          con menor probabilidad, de dos bits que solo detectan
+ *          el BCC o el CRC_A. Los errores son pseudoaleatorios,
+ *          con la misma secuencia luego de cada simMfrc522_reset.
+ */
+void simMfrc522_configurarEnlace(uint8_t lector, uint8_t atenuacionDb,
+		uint8_t ruidoDb);
+
+/**
+ *   @brief Realiza una transferencia SPI con el CS
+ *          del lector activo. rx puede ser NULL.
+ */
+void simMfrc522_transferencia(uint8_t lector, const uint8_t *tx, uint8_t *rx,
+		uint16_t largo);
+
+/**
+ *   @brief Estado del pin IRQ del lector (verdadero = activo).
+ */
+bool_t simMfrc522_irqActivo(uint8_t lector);
+
+/**
+ *   @brief Tiempo en uS que demora el último intercambio del
+ *          lector con las tarjetas (transmisión, respuesta o timeout).
+ */
+uint32_t simMfrc522_duracionIntercambioUs(uint8_t lector);
+
+/**
+ *   @brief Cantidad de intercambios del lector con las
+ *          tarjetas iniciados desde simMfrc522_reset().
+ */
+uint32_t simMfrc522_cantidadIntercambios(uint8_t lector);
+
+#endif /* HOST_INC_SIM_MFRC522_H_ */
@@ -0,0 +1,20 @@
+/**
+ * @file API_instrumentacion_port_host.c
+ * @brief Contador de ciclos para PC, derivado del tiempo
+ *        virtual de host_plataforma a HOST_FRECUENCIA_CPU.
+ */
+
+#include "API_instrumentacion.h"
+
+#if INSTR_HABILITADA
+
+#include "host_plataforma.h"
+
+void instr_iniciarContador() {
+}
+
+uint32_t instr_leerCiclos() {
+	return (uint32_t) (host_tiempoNs() * HOST_FRECUENCIA_CPU / 1000000000ULL);
+}
+
+#endif /* INSTR_HABILITADA */
@@ -0,0 +1,163 @@
+/**
+ * @file API_lcd_port_host.c
+ * @brief Implementación del módulo API_lcd_port para PC,
+ *        conectada al modelo sim_hd44780. Cada byte llega al
+ *        modelo en el instante en que termina en el bus I2C,
+ *        por lo que el modelo verifica los tiempos reales del
+ *        driver. Las transferencias asíncronas finalizan cuando
+ *        el tiempo virtual alcanza el final de la transacción, y
+ *        su callback se llama en la siguiente consulta del bus o
+ *        del tiempo, como la interrupción que llega mientras el
+ *        driver espera.
+ *        Cada bus tiene su transferencia asíncrona, y todos
+ *        los buses se contabilizan juntos en HOST_BUS_I2C.
+ */
+
+#include "API_lcd_port.h"
+#include "sim_hd44780.h"
+#include "host_plataforma.h"
+#include "API_instrumentacion.h"
+#include "API_traza.h"
+
+#define NS_POR_BIT_I2C				(1000000000ULL / I2C_CLOCK_SPEED)
+#define BITS_POR_BYTE_I2C			9		//8 bits de datos + ACK
+
+/**
+ *	@brief Transferencia asíncrona en curso de cada bus.
+ */
+typedef struct {
+	port_callbackTypedef callbackTransferencia;
+	bool_t transferenciaEnCurso;
+	bool_t exito;
+	uint64_t finTransferenciaNs;
+} bus_host_t;
+
+static bus_host_t busesI2C[I2C_CANTIDAD_BUSES];
+
+static uint64_t port_transferir(uint8_t, const uint8_t*, size_t, bool_t*);
+static void port_verificarFin();
+
+bool_t port_init(uint8_t bus) {
+	if (bus >= I2C_CANTIDAD_BUSES)
+		return false;
+	busesI2C[bus].transferenciaEnCurso = false;
+	return true;
+}
+
+bool_t port_i2cWriteByte(uint8_t bus, uint8_t direccion, uint8_t valor) {
+	return port_i2cWriteBuffer(bus, direccion, &valor, 1);
+}
+
+bool_t port_i2cWriteBuffer(uint8_t bus, uint8_t direccion,
+		const uint8_t *datos, size_t largo) {
+	if (bus >= I2C_CANTIDAD_BUSES || datos == NULL || largo == 0
+			|| busesI2C[bus].transferenciaEnCurso)
+		return false;
+	bool_t exito;
+	INSTR_INICIO(inicio);
+	host_avanzarNs(port_transferir(direccion, datos, largo, &exito));
+	INSTR_FIN(INSTR_I2C_WRITE, inicio, largo + 1, false);
+	TRAZA_REGISTRAR(TRAZA_I2C_ESCRITURA, bus, direccion, datos, largo, !exito);
+	return exito;
+}
+
+bool_t port_i2cWriteBufferAsync(uint8_t bus, uint8_t direccion,
+		const uint8_t *datos, size_t largo) {
+	if (bus >= I2C_CANTIDAD_BUSES || datos == NULL || largo == 0
+			|| busesI2C[bus].transferenciaEnCurso)
+		return false;
+	bus_host_t *estadoBus = &busesI2C[bus];
+	estadoBus->finTransferenciaNs = host_tiempoNs()
+			+ port_transferir(direccion, datos, largo, &estadoBus->exito);
+	estadoBus->transferenciaEnCurso = true;
+	TRAZA_REGISTRAR(TRAZA_I2C_ESCRITURA, bus, direccion, datos, largo,
+			!estadoBus->exito);
+	return true;
+}
+
+bool_t port_i2cOcupado(uint8_t bus) {
+	if (bus >= I2C_CANTIDAD_BUSES)
+		return false;
+	port_verificarFin();
+	if (busesI2C[bus].transferenciaEnCurso)
+		host_avanzarNs(HOST_NS_POR_CONSULTA);
+	return busesI2C[bus].transferenciaEnCurso;
+}
+
+void port_i2cSetCallback(uint8_t bus, port_callbackTypedef callback) {
+	if (bus < I2C_CANTIDAD_BUSES)
+		busesI2C[bus].callbackTransferencia = callback;
+}
+
+void port_delay(uint32_t ms) {
+	INSTR_INICIO(inicio);
+	host_avanzarNs(ms * 1000000ULL);
+	port_verificarFin();
+	INSTR_FIN(INSTR_DELAY, inicio, 0, false);
+}
+
+void port_delayUs(uint32_t us) {
+	INSTR_INICIO(inicio);
+	host_avanzarNs(us * 1000ULL);
+	port_verificarFin();
+	INSTR_FIN(INSTR_DELAY, inicio, 0, false);
+}
+
+uint32_t port_marcaTiempo() {
+	return (uint32_t) (host_tiempoNs() / 1000);
+}
+
+bool_t port_transcurrioUs(uint32_t marca, uint32_t us) {
+	port_verificarFin();
+	if ((uint32_t) (host_tiempoNs() / 1000) - marca >= us)
+		return true;
+	host_avanzarNs(HOST_NS_POR_CONSULTA);
+	return false;
+}
+
+bool_t port_reinicioEnCaliente() {
+	return host_reinicioEnCaliente();
+}
+
+/**
+ *	@brief Entrega los bytes al modelo con el instante en
+ *		   que termina cada uno (condición de start, dirección
+ *		   y datos) y registra la transacción en el bus I2C.
+ *		   Si ningún display responde en la dirección, la
+ *		   transacción termina luego del byte de dirección.
+ *	@retval Duración de la transacción en nS.
+ */
+static uint64_t port_transferir(uint8_t direccion, const uint8_t *datos,
+		size_t largo, bool_t *exito) {
+	uint64_t inicio = host_tiempoNs();
+	uint64_t bits = 1 + BITS_POR_BYTE_I2C;			//start + dirección
+	*exito = simHd44780_presente(direccion);
+	if (!*exito)
+		largo = 0;
+	for (size_t i = 0; i < largo; i++) {
+		bits += BITS_POR_BYTE_I2C;
+		simHd44780_escribirExpansor(direccion, datos[i],
+				inicio + bits * NS_POR_BIT_I2C);
+	}
+	bits++;											//stop
+	uint64_t duracion = bits * NS_POR_BIT_I2C;
+	host_registrarTransaccion(HOST_BUS_I2C, largo + 1, duracion);
+	return duracion;
+}
+
+/**
+ *	@brief Finaliza las transferencias asíncronas cuyo final
+ *		   alcanzó el tiempo virtual, y llama al callback como
+ *		   lo haría la interrupción del I2C.
+ */
+static void port_verificarFin() {
+	for (uint8_t bus = 0; bus < I2C_CANTIDAD_BUSES; bus++) {
+		bus_host_t *estadoBus = &busesI2C[bus];
+		if (estadoBus->transferenciaEnCurso
+				&& host_tiempoNs() >= estadoBus->finTransferenciaNs) {
+			estadoBus->transferenciaEnCurso = false;
+			if (estadoBus->callbackTransferencia != NULL)
+				estadoBus->callbackTransferencia(bus, estadoBus->exito);
+		}
+	}
+}
@@ -0,0 +1,167 @@
+/**
+ * @file API_mfrc522_port_host.c
+ * @brief Implementación del módulo API_mfrc522_port
+ *        para PC, conectada al modelo sim_mfrc522.
+ *        Cada transferencia se contabiliza en el bus SPI
+ *        y avanza el tiempo virtual lo que dura en el bus.
+ *        Las cadenas se ejecutan en forma sincrónica.
+ *        Todos los lectores comparten un único bus SPI.
+ */
+
+#include "API_mfrc522_port.h"
+#include "sim_mfrc522.h"
+#include "host_plataforma.h"
+#include "API_instrumentacion.h"
+#include "API_traza.h"
+
+#define NS_POR_MS					1000000ULL
+#define NS_POR_CONSULTA_IRQ			1000ULL
+
+//momento en que termina el intercambio en curso de cada lector
+static uint64_t finIntercambioNs[MFRC522_CANTIDAD_LECTORES];
+static uint32_t ultimoIntercambio[MFRC522_CANTIDAD_LECTORES];
+
+static void spiTransferir(uint8_t, const uint8_t*, uint8_t*, uint16_t);
+
+bool_t portInit(uint8_t lector) {
+	if (lector >= MFRC522_CANTIDAD_LECTORES || lector >= SIM_MAX_LECTORES)
+		return false;
+	finIntercambioNs[lector] = 0;
+	ultimoIntercambio[lector] = simMfrc522_cantidadIntercambios(lector);
+	return true;
+}
+
+void spiWrite(uint8_t lector, uint8_t reg_addr, const uint8_t *txData,
+		uint16_t size) {
+	uint8_t tx[SPI_MAX_BURST + 1];
+	if (size > SPI_MAX_BURST)
+		size = SPI_MAX_BURST;
+	INSTR_INICIO(inicio);
+	tx[0] = reg_addr;
+	for (uint16_t i = 0; i < size; i++)
+		tx[i + 1] = txData[i];
+	spiTransferir(lector, tx, NULL, size + 1);
+	INSTR_FIN(INSTR_SPI_WRITE, inicio, size + 1, false);
+	TRAZA_REGISTRAR(TRAZA_SPI_ESCRITURA, lector, reg_addr, txData, size, false);
+}
+
+void spiRead(uint8_t lector, uint8_t reg_addr, uint8_t *rxData, uint16_t size) {
+	uint8_t tx[SPI_MAX_BURST + 1], rx[SPI_MAX_BURST + 1];
+	if (size > SPI_MAX_BURST)
+		size = SPI_MAX_BURST;
+	INSTR_INICIO(inicio);
+	for (uint16_t i = 0; i < size; i++)
+		tx[i] = reg_addr;
+	tx[size] = 0;
+	spiTransferir(lector, tx, rx, size + 1);
+	for (uint16_t i = 0; i < size; i++)
+		rxData[i] = rx[i + 1];
+	INSTR_FIN(INSTR_SPI_READ, inicio, size + 1, false);
+	TRAZA_REGISTRAR(TRAZA_SPI_LECTURA, lector, reg_addr, rxData, size, false);
+}
+
+void spiTransfer(uint8_t lector, const uint8_t *txData, uint8_t *rxData,
+		uint16_t size) {
+	spiTransferir(lector, txData, rxData, size);
+	TRAZA_TRANSFERENCIA(lector, txData, rxData, size, false);
+}
+
+/**
+ *	@brief Transfiere los bytes al modelo y registra
+ *		   la transacción. Si la transferencia inicia un
+ *		   intercambio con las tarjetas, se guarda el
+ *		   momento en que termina.
+ */
+static void spiTransferir(uint8_t lector, const uint8_t *txData,
+		uint8_t *rxData, uint16_t size) {
+	uint64_t duracionNs = size * 8 * 1000000000ULL / HOST_SPI_CLOCK;
+	simMfrc522_transferencia(lector, txData, rxData, size);
+	host_registrarTransaccion(HOST_BUS_SPI, size, duracionNs);
+	host_avanzarNs(duracionNs);
+
+	uint32_t intercambios = simMfrc522_cantidadIntercambios(lector);
+	if (intercambios != ultimoIntercambio[lector]) {
+		ultimoIntercambio[lector] = intercambios;
+		finIntercambioNs[lector] = host_tiempoNs()
+				+ simMfrc522_duracionIntercambioUs(lector) * 1000ULL;
+	}
+}
+
+uint32_t portGetTick() {
+	return (uint32_t) (host_tiempoNs() / NS_POR_MS);
+}
+
+void portDelay(uint32_t ms) {
+	host_avanzarNs(ms * NS_POR_MS);
+}
+
+void irqClearEvent(uint8_t lector) {
+}
+
+/**
+ *	@brief El pin IRQ se considera activado cuando termina
+ *		   el intercambio. Si todavía no terminó, la consulta
+ *		   avanza el tiempo virtual, para que los loops que
+ *		   consultan el evento no queden bloqueados.
+ */
+bool_t irqEvento(uint8_t lector) {
+	if (simMfrc522_irqActivo(lector)
+			&& finIntercambioNs[lector] <= host_tiempoNs())
+		return true;
+	host_avanzarNs(NS_POR_CONSULTA_IRQ);
+	return false;
+}
+
+bool_t irqWaitEvent(uint8_t lector, uint32_t timeout) {
+	return irqWaitAnyEvent(1UL << lector, timeout);
+}
+
+/**
+ *	@brief El modelo calcula el resultado del intercambio
+ *		   al iniciarlo, por lo que el pin IRQ ya está activo.
+ *		   La espera avanza el tiempo virtual hasta el primer
+ *		   final de intercambio de los lectores indicados, o
+ *		   hasta el timeout si no hay evento.
+ */
+bool_t irqWaitAnyEvent(uint32_t mascara, uint32_t timeout) {
+	uint64_t ahora = host_tiempoNs();
+	uint64_t limite = ahora + timeout * NS_POR_MS;
+	uint64_t evento = UINT64_MAX;
+
+	for (uint8_t i = 0; i < MFRC522_CANTIDAD_LECTORES; i++) {
+		if ((mascara & (1UL << i)) && simMfrc522_irqActivo(i)
+				&& finIntercambioNs[i] < evento)
+			evento = finIntercambioNs[i];
+	}
+
+	if (evento > limite) {
+		host_avanzarNs(limite - ahora);
+		return false;
+	}
+	if (evento > ahora)
+		host_avanzarNs(evento - ahora);
+	return true;
+}
+
+bool_t spiStartChain(uint8_t lector, const spi_descriptor_t *descriptores,
+		uint8_t cantidad, spi_callback_t callback) {
+	if (descriptores == NULL || cantidad == 0
+			|| cantidad > SPI_MAX_DESCRIPTORES)
+		return false;
+
+	for (uint8_t i = 0; i < cantidad; i++) {
+		if (descriptores[i].reg_addr & SPI_READ_MASK)
+			spiRead(lector, descriptores[i].reg_addr, descriptores[i].datos,
+					descriptores[i].largo);
+		else
+			spiWrite(lector, descriptores[i].reg_addr, descriptores[i].datos,
+					descriptores[i].largo);
+	}
+	if (callback != NULL)
+		callback(true);
+	return true;
+}
+
+bool_t spiChainBusy(uint8_t lector) {
+	return false;
+}
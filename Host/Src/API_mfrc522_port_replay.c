@@ -0,0 +1,236 @@
+/**
+ * @file API_mfrc522_port_replay.c
+ * @brief Implementación del módulo API_mfrc522_port para PC
+ *        que reproduce una traza (replay_traza.h) en lugar de
+ *        simular el lector. Cada transacción del driver se busca
+ *        en la traza del lector, dentro de las REPLAY_VENTANA
+ *        siguientes a la posición actual (ver replay_coincide):
+ *        si se encuentra, las anteriores se cuentan como omitidas
+ *        y una lectura devuelve los datos grabados. Si no, se
+ *        cuenta como agregada y una lectura devuelve el último
+ *        valor grabado o escrito de cada registro. Como en
+ *        API_mfrc522_port_host.c, cada transferencia se contabiliza
+ *        en el bus SPI y avanza el tiempo virtual, y las cadenas se
+ *        ejecutan en forma sincrónica. El pin IRQ se considera
+ *        siempre activo, ya que las lecturas de ComIrqReg grabadas
+ *        indican el resultado.
+ */
+
+#include <string.h>
+#include "API_mfrc522_port.h"
+#include "replay_traza.h"
+
+#define NS_POR_MS					1000000ULL
+#define CANTIDAD_REGISTROS			64
+#define REGISTRO(direccion)			(((direccion) >> 1) & (CANTIDAD_REGISTROS - 1))
+
+/**
+ *	@brief Estado de la reproducción de un lector.
+ */
+typedef struct {
+	uint32_t posicion;			//próxima transacción de la traza a comparar
+	replay_resultado_t resultado;
+	uint8_t registros[CANTIDAD_REGISTROS];
+} lector_replay_t;
+
+static const replay_traza_t *traza;
+static lector_replay_t lectores[MFRC522_CANTIDAD_LECTORES];
+
+static const traza_transaccion_t* replay_buscar(uint8_t, traza_tipo_enum,
+		uint8_t, const uint8_t*, uint16_t);
+static bool_t replay_coincide(const traza_transaccion_t*, traza_tipo_enum,
+		uint8_t, const uint8_t*, uint16_t);
+static void replay_registrarTransferencia(uint16_t);
+
+void replay_iniciar(const replay_traza_t *nueva) {
+	lector_replay_t vacio = { 0 };
+	traza = nueva;
+	for (uint8_t i = 0; i < MFRC522_CANTIDAD_LECTORES; i++)
+		lectores[i] = vacio;
+}
+
+bool_t replay_pendiente(uint8_t lector) {
+	if (traza == NULL || lector >= MFRC522_CANTIDAD_LECTORES)
+		return false;
+	for (uint32_t i = lectores[lector].posicion; i < traza->cantidad; i++) {
+		const traza_transaccion_t *t = &traza->transacciones[i];
+		if (t->tipo != TRAZA_I2C_ESCRITURA && t->dispositivo == lector)
+			return true;
+	}
+	return false;
+}
+
+replay_resultado_t replay_resultado(uint8_t lector) {
+	replay_resultado_t resultado = { 0 };
+	if (traza == NULL || lector >= MFRC522_CANTIDAD_LECTORES)
+		return resultado;
+	resultado = lectores[lector].resultado;
+	for (uint32_t i = lectores[lector].posicion; i < traza->cantidad; i++) {
+		const traza_transaccion_t *t = &traza->transacciones[i];
+		if (t->tipo != TRAZA_I2C_ESCRITURA && t->dispositivo == lector)
+			resultado.pendientes++;
+	}
+	return resultado;
+}
+
+bool_t portInit(uint8_t lector) {
+	return lector < MFRC522_CANTIDAD_LECTORES;
+}
+
+void spiWrite(uint8_t lector, uint8_t reg_addr, const uint8_t *txData,
+		uint16_t size) {
+	if (size > SPI_MAX_BURST)
+		size = SPI_MAX_BURST;
+	replay_buscar(lector, TRAZA_SPI_ESCRITURA, reg_addr, txData, size);
+	if (size > 0)
+		lectores[lector].registros[REGISTRO(reg_addr)] = txData[size - 1];
+	replay_registrarTransferencia(size + 1);
+}
+
+void spiRead(uint8_t lector, uint8_t reg_addr, uint8_t *rxData, uint16_t size) {
+	if (size > SPI_MAX_BURST)
+		size = SPI_MAX_BURST;
+	const traza_transaccion_t *t = replay_buscar(lector, TRAZA_SPI_LECTURA,
+			reg_addr, NULL, size);
+	uint8_t *registro = &lectores[lector].registros[REGISTRO(reg_addr)];
+	for (uint16_t i = 0; i < size; i++) {
+		if (t != NULL && i < t->guardados)
+			*registro = t->datos[i];
+		rxData[i] = *registro;
+	}
+	replay_registrarTransferencia(size + 1);
+}
+
+/**
+ *	@brief La transferencia se busca por los bytes transmitidos.
+ *		   Si no está en la traza, cada byte recibido es el último
+ *		   valor del registro enviado en el byte anterior.
+ */
+void spiTransfer(uint8_t lector, const uint8_t *txData, uint8_t *rxData,
+		uint16_t size) {
+	const traza_transaccion_t *t = replay_buscar(lector,
+			TRAZA_SPI_TRANSFERENCIA, 0, txData, size);
+	uint8_t *registros = lectores[lector].registros;
+	for (uint16_t i = 0; rxData != NULL && i < size; i++) {
+		uint16_t recibidos = t != NULL ? t->guardados / 2 : 0;
+		if (i < recibidos)
+			rxData[i] = t->datos[recibidos + i];
+		else
+			rxData[i] = i > 0 ? registros[REGISTRO(txData[i - 1])] : 0;
+		if (i > 0 && (txData[i - 1] & SPI_READ_MASK))
+			registros[REGISTRO(txData[i - 1])] = rxData[i];
+	}
+	replay_registrarTransferencia(size);
+}
+
+uint32_t portGetTick() {
+	return (uint32_t) (host_tiempoNs() / NS_POR_MS);
+}
+
+void portDelay(uint32_t ms) {
+	host_avanzarNs(ms * NS_POR_MS);
+}
+
+void irqClearEvent(uint8_t lector) {
+}
+
+bool_t irqEvento(uint8_t lector) {
+	return true;
+}
+
+bool_t irqWaitEvent(uint8_t lector, uint32_t timeout) {
+	return true;
+}
+
+bool_t irqWaitAnyEvent(uint32_t mascara, uint32_t timeout) {
+	return true;
+}
+
+bool_t spiStartChain(uint8_t lector, const spi_descriptor_t *descriptores,
+		uint8_t cantidad, spi_callback_t callback) {
+	if (descriptores == NULL || cantidad == 0
+			|| cantidad > SPI_MAX_DESCRIPTORES)
+		return false;
+
+	for (uint8_t i = 0; i < cantidad; i++) {
+		if (descriptores[i].reg_addr & SPI_READ_MASK)
+			spiRead(lector, descriptores[i].reg_addr, descriptores[i].datos,
+					descriptores[i].largo);
+		else
+			spiWrite(lector, descriptores[i].reg_addr, descriptores[i].datos,
+					descriptores[i].largo);
+	}
+	if (callback != NULL)
+		callback(true);
+	return true;
+}
+
+bool_t spiChainBusy(uint8_t lector) {
+	return false;
+}
+
+/**
+ *	@brief Busca la transacción del driver en la traza del lector.
+ *	@retval Transacción encontrada, o NULL si no está en la ventana.
+ */
+static const traza_transaccion_t* replay_buscar(uint8_t lector,
+		traza_tipo_enum tipo, uint8_t direccion, const uint8_t *datos,
+		uint16_t largo) {
+	lector_replay_t *estado = &lectores[lector];
+	if (traza == NULL) {
+		estado->resultado.agregadas++;
+		return NULL;
+	}
+
+	uint32_t revisadas = 0;
+	for (uint32_t i = estado->posicion;
+			i < traza->cantidad && revisadas < REPLAY_VENTANA; i++) {
+		const traza_transaccion_t *t = &traza->transacciones[i];
+		if (t->tipo == TRAZA_I2C_ESCRITURA || t->dispositivo != lector)
+			continue;
+		revisadas++;
+		if (!replay_coincide(t, tipo, direccion, datos, largo))
+			continue;
+
+		//las transacciones del lector anteriores a la encontrada se omitieron
+		for (uint32_t j = estado->posicion; j < i; j++) {
+			const traza_transaccion_t *o = &traza->transacciones[j];
+			if (o->tipo != TRAZA_I2C_ESCRITURA && o->dispositivo == lector)
+				estado->resultado.omitidas++;
+		}
+		estado->posicion = i + 1;
+		estado->resultado.coincidentes++;
+		return t;
+	}
+	estado->resultado.agregadas++;
+	return NULL;
+}
+
+/**
+ *	@brief Una escritura coincide con la grabada si tiene el mismo
+ *		   registro y los mismos datos, y una transferencia si
+ *		   transmite los mismos bytes. En una lectura basta el
+ *		   registro, ya que el largo puede depender de lo leído.
+ */
+static bool_t replay_coincide(const traza_transaccion_t *t,
+		traza_tipo_enum tipo, uint8_t direccion, const uint8_t *datos,
+		uint16_t largo) {
+	if (t->tipo != tipo)
+		return false;
+	switch (tipo) {
+	case TRAZA_SPI_ESCRITURA:
+		return t->direccion == direccion && t->largo == largo
+				&& memcmp(t->datos, datos, t->guardados) == 0;
+	case TRAZA_SPI_LECTURA:
+		return t->direccion == direccion;
+	default:
+		return t->largo == largo
+				&& memcmp(t->datos, datos, t->guardados / 2) == 0;
+	}
+}
+
+static void replay_registrarTransferencia(uint16_t bytes) {
+	uint64_t duracionNs = bytes * 8 * 1000000000ULL / HOST_SPI_CLOCK;
+	host_registrarTransaccion(HOST_BUS_SPI, bytes, duracionNs);
+	host_avanzarNs(duracionNs);
+}
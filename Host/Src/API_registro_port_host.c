@@ -0,0 +1,48 @@
+/**
+ * @file API_registro_port_host.c
+ * @brief Implementación del módulo API_registro_port para
+ *        PC, conectada al modelo sim_flash. El archivo de la
+ *        flash se indica con REGISTRO_ARCHIVO_HOST. La
+ *        programación avanza el tiempo virtual lo que dura, y
+ *        cada consulta de un borrado en curso avanza el tiempo
+ *        que consume la consulta.
+ */
+
+#include "API_registro_port.h"
+#include "sim_flash.h"
+#include "host_plataforma.h"
+
+#ifndef REGISTRO_ARCHIVO_HOST
+#define REGISTRO_ARCHIVO_HOST		"registro_flash.bin"
+#endif
+
+bool_t flashInit() {
+	return simFlash_abrir(REGISTRO_ARCHIVO_HOST, REGISTRO_CANTIDAD_SECTORES,
+			REGISTRO_TAMANO_SECTOR);
+}
+
+void flashLeer(uint32_t direccion, void *datos, uint32_t largo) {
+	simFlash_leer(direccion, datos, largo);
+}
+
+bool_t flashProgramar(uint32_t direccion, const void *datos, uint32_t largo) {
+	if (flashOcupada() || (direccion % 4) != 0 || (largo % 4) != 0)
+		return false;
+	uint64_t duracion = simFlash_programar(direccion, datos, largo);
+	host_avanzarNs(duracion);
+	return duracion != 0;
+}
+
+bool_t flashBorrarSector(uint8_t sector) {
+	if (flashOcupada() || sector >= REGISTRO_CANTIDAD_SECTORES)
+		return false;
+	simFlash_borrar(sector, host_tiempoNs());
+	return true;
+}
+
+bool_t flashOcupada() {
+	if (!simFlash_ocupada(host_tiempoNs()))
+		return false;
+	host_avanzarNs(HOST_NS_POR_CONSULTA);
+	return true;
+}
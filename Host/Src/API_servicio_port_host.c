@@ -0,0 +1,87 @@
+/**
+ * @file API_servicio_port_host.c
+ * @brief Implementación del módulo API_servicio_port para PC,
+ *        con un hilo de POSIX en lugar de la interrupción del
+ *        timer. Cada pasada avanza el tiempo virtual lo que duran
+ *        sus transferencias y esperas, y luego hasta el inicio del
+ *        período siguiente; si la pasada dura más que el período,
+ *        la siguiente empieza enseguida, como con la interrupción
+ *        pendiente del timer. Entre pasadas el hilo cede el
+ *        procesador HOST_SERVICIO_ESPERA_US de tiempo real.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "API_servicio_port.h"
+#include "API_servicio.h"
+#include "host_servicio.h"
+#include "host_plataforma.h"
+
+#define NS_POR_MS					1000000ULL
+
+static pthread_t hilo;
+static atomic_bool corriendo;
+static uint64_t periodoNs;
+static host_escenario_t escenario;
+static uint32_t pasadas;
+static uint64_t ocupadoNs;
+
+static void* host_hiloServicio(void*);
+
+void host_servicioEscenario(host_escenario_t nuevo) {
+	escenario = nuevo;
+}
+
+uint32_t host_servicioPasadas() {
+	return pasadas;
+}
+
+uint64_t host_servicioOcupadoNs() {
+	return ocupadoNs;
+}
+
+bool_t temporizadorIniciar(uint32_t periodoMs) {
+	if (periodoMs == 0)
+		return false;
+	periodoNs = periodoMs * NS_POR_MS;
+	pasadas = 0;
+	ocupadoNs = 0;
+	atomic_store(&corriendo, true);
+	if (pthread_create(&hilo, NULL, host_hiloServicio, NULL) != 0) {
+		atomic_store(&corriendo, false);
+		return false;
+	}
+	return true;
+}
+
+/**
+ *   @brief Espera a que el hilo termine la pasada en curso.
+ */
+void temporizadorDetener() {
+	atomic_store(&corriendo, false);
+	pthread_join(hilo, NULL);
+}
+
+static void* host_hiloServicio(void *argumento) {
+	const struct timespec espera = { 0, HOST_SERVICIO_ESPERA_US * 1000L };
+	uint64_t proxima = host_tiempoNs();
+
+	while (atomic_load(&corriendo)) {
+		uint64_t inicio = host_tiempoNs();
+		if (escenario != NULL)
+			escenario(inicio);
+		servicio_ejecutar();
+		pasadas++;
+		ocupadoNs += host_tiempoNs() - inicio;
+
+		proxima += periodoNs;
+		if (host_tiempoNs() < proxima)
+			host_avanzarNs(proxima - host_tiempoNs());
+		else
+			proxima = host_tiempoNs();
+		nanosleep(&espera, NULL);
+	}
+	return NULL;
+}
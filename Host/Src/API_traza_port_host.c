@@ -0,0 +1,25 @@
+/**
+ * @file API_traza_port_host.c
+ * @brief Tiempo en uS para el módulo de traza en PC, derivado
+ *        del tiempo virtual de host_plataforma. Como los ports de
+ *        PC no tienen interrupciones, la sección crítica no hace nada.
+ */
+
+#include "API_traza.h"
+
+#if TRAZA_HABILITADA
+
+#include "host_plataforma.h"
+
+uint32_t traza_leerUs() {
+	return (uint32_t) (host_tiempoNs() / 1000);
+}
+
+uint32_t traza_bloquear() {
+	return 0;
+}
+
+void traza_desbloquear(uint32_t estado) {
+}
+
+#endif /* TRAZA_HABILITADA */
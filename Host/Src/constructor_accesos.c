@@ -0,0 +1,195 @@
+/**
+ * @file constructor_accesos.c
+ * @brief Implementación del constructor de tablas
+ * 		  estáticas de accesos (hash y desplazamiento).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "constructor_accesos.h"
+
+#define MAX_DESPLAZAMIENTO			0xFFFF
+
+/**
+ *	@brief Grupo de UIDs que comparten el mismo
+ *		   desplazamiento.
+ */
+typedef struct {
+	uint32_t grupo;
+	uint32_t inicio;
+	uint32_t cantidad;
+} grupo_t;
+
+/**
+ *	@brief Resultado de intentar construir la tabla
+ *		   con una semilla.
+ */
+typedef enum {
+	INTENTO_OK, INTENTO_FALLIDO, INTENTO_REPETIDOS
+} resultado_intento_enum;
+
+static resultado_intento_enum constructor_intentar(accesos_tablaEstatica_t*,
+		const accesos_entrada_t*, uint32_t, uint16_t*, accesos_entrada_t*);
+static int constructor_compararGrupos(const void*, const void*);
+
+/**
+ *	@brief Construye la tabla probando semillas
+ *		   hasta que todos los grupos encuentren un
+ *		   desplazamiento sin colisiones.
+ *	@retval Falso si no hay memoria, hay UIDs repetidos
+ *			o se agotaron las semillas.
+ */
+bool_t constructor_construir(accesos_tablaEstatica_t *tabla,
+		const accesos_entrada_t *uids, uint32_t cantidad) {
+	if (tabla == NULL || uids == NULL || cantidad == 0)
+		return false;
+
+	tabla->cantidadGrupos = (cantidad + CONSTRUCTOR_UIDS_POR_GRUPO - 1)
+			/ CONSTRUCTOR_UIDS_POR_GRUPO;
+	tabla->tamano = cantidad * CONSTRUCTOR_FACTOR_TAMANO / 4 + 1;
+
+	uint16_t *desplazamientos = calloc(tabla->cantidadGrupos,
+			sizeof(uint16_t));
+	accesos_entrada_t *entradas = calloc(tabla->tamano,
+			sizeof(accesos_entrada_t));
+	if (desplazamientos == NULL || entradas == NULL) {
+		free(desplazamientos);
+		free(entradas);
+		return false;
+	}
+
+	for (uint32_t semilla = 0; semilla < CONSTRUCTOR_MAX_SEMILLAS; semilla++) {
+		tabla->semilla = semilla;
+		resultado_intento_enum resultado = constructor_intentar(tabla, uids,
+				cantidad, desplazamientos, entradas);
+		if (resultado == INTENTO_OK) {
+			tabla->desplazamientos = desplazamientos;
+			tabla->entradas = entradas;
+			return true;
+		}
+		if (resultado == INTENTO_REPETIDOS)
+			break;
+	}
+
+	free(desplazamientos);
+	free(entradas);
+	return false;
+}
+
+void constructor_liberar(accesos_tablaEstatica_t *tabla) {
+	free((void*) tabla->desplazamientos);
+	free((void*) tabla->entradas);
+	tabla->desplazamientos = NULL;
+	tabla->entradas = NULL;
+}
+
+/**
+ *	@brief Intenta construir la tabla con la semilla actual.
+ *		   Los grupos se procesan del más grande al más chico,
+ *		   buscando para cada uno el primer desplazamiento que
+ *		   ubique todos sus UIDs en posiciones libres.
+ *		   Dos UIDs iguales caen siempre en la misma posición,
+ *		   por lo que se detectan antes de buscar desplazamientos.
+ *	@retval INTENTO_OK si todos los grupos se ubicaron.
+ */
+static resultado_intento_enum constructor_intentar(accesos_tablaEstatica_t *tabla,
+		const accesos_entrada_t *uids, uint32_t cantidad,
+		uint16_t *desplazamientos, accesos_entrada_t *entradas) {
+	uint32_t *hashes = malloc(cantidad * sizeof(uint32_t));
+	uint32_t *orden = malloc(cantidad * sizeof(uint32_t));
+	uint32_t *posiciones = malloc(cantidad * sizeof(uint32_t));
+	grupo_t *grupos = calloc(tabla->cantidadGrupos, sizeof(grupo_t));
+	uint8_t *ocupado = calloc(tabla->tamano, 1);
+	bool_t exito = hashes != NULL && orden != NULL && posiciones != NULL
+			&& grupos != NULL && ocupado != NULL;
+	bool_t repetidos = false;
+
+	memset(desplazamientos, 0, tabla->cantidadGrupos * sizeof(uint16_t));
+	memset(entradas, 0, tabla->tamano * sizeof(accesos_entrada_t));
+
+	// Se agrupan los UIDs por grupo con un conteo
+	for (uint32_t i = 0; exito && i < cantidad; i++) {
+		hashes[i] = accesos_hash(uids[i].uid, uids[i].largo, tabla->semilla);
+		grupos[hashes[i] % tabla->cantidadGrupos].cantidad++;
+	}
+	uint32_t inicio = 0;
+	for (uint32_t g = 0; exito && g < tabla->cantidadGrupos; g++) {
+		grupos[g].grupo = g;
+		grupos[g].inicio = inicio;
+		inicio += grupos[g].cantidad;
+		grupos[g].cantidad = 0;
+	}
+	for (uint32_t i = 0; exito && i < cantidad; i++) {
+		grupo_t *grupo = &grupos[hashes[i] % tabla->cantidadGrupos];
+		orden[grupo->inicio + grupo->cantidad++] = i;
+	}
+	if (exito)
+		qsort(grupos, tabla->cantidadGrupos, sizeof(grupo_t),
+				constructor_compararGrupos);
+
+	for (uint32_t g = 0; exito && g < tabla->cantidadGrupos; g++) {
+		grupo_t *grupo = &grupos[g];
+		if (grupo->cantidad == 0)
+			break;
+
+		for (uint32_t k = 0; k < grupo->cantidad; k++) {
+			const accesos_entrada_t *a = &uids[orden[grupo->inicio + k]];
+			for (uint32_t j = 0; j < k; j++) {
+				const accesos_entrada_t *b = &uids[orden[grupo->inicio + j]];
+				if (a->largo == b->largo
+						&& memcmp(a->uid, b->uid, a->largo) == 0)
+					repetidos = true;
+			}
+		}
+		if (repetidos) {
+			exito = false;
+			break;
+		}
+
+		bool_t ubicado = false;
+		for (uint32_t d = 0; !ubicado && d <= MAX_DESPLAZAMIENTO; d++) {
+			ubicado = true;
+			for (uint32_t k = 0; ubicado && k < grupo->cantidad; k++) {
+				uint32_t p = accesos_posicionEstatica(
+						hashes[orden[grupo->inicio + k]], (uint16_t) d,
+						tabla->tamano);
+				if (ocupado[p]) {
+					ubicado = false;
+					break;
+				}
+				for (uint32_t j = 0; j < k; j++) {
+					if (posiciones[j] == p)
+						ubicado = false;
+				}
+				posiciones[k] = p;
+			}
+			if (ubicado) {
+				desplazamientos[grupo->grupo] = (uint16_t) d;
+				for (uint32_t k = 0; k < grupo->cantidad; k++) {
+					ocupado[posiciones[k]] = 1;
+					entradas[posiciones[k]] = uids[orden[grupo->inicio + k]];
+				}
+			}
+		}
+		exito = ubicado;
+	}
+
+	free(hashes);
+	free(orden);
+	free(posiciones);
+	free(grupos);
+	free(ocupado);
+	if (repetidos)
+		return INTENTO_REPETIDOS;
+	return exito ? INTENTO_OK : INTENTO_FALLIDO;
+}
+
+/**
+ *	@brief Ordena los grupos de mayor a menor cantidad de UIDs.
+ */
+static int constructor_compararGrupos(const void *a, const void *b) {
+	const grupo_t *ga = a, *gb = b;
+	if (ga->cantidad != gb->cantidad)
+		return ga->cantidad < gb->cantidad ? 1 : -1;
+	return ga->grupo < gb->grupo ? -1 : (ga->grupo > gb->grupo);
+}
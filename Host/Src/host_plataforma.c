@@ -0,0 +1,72 @@
+/**
+ * @file host_plataforma.c
+ * @brief Implementación del tiempo virtual y
+ *        los contadores de bus de los ports de PC.
+ */
+
+#include <stdio.h>
+#include "host_plataforma.h"
+
+const uint8_t HOST_UID_PRUEBA[4] = { 0x04, 0xA1, 0xB2, 0xC3 };
+
+static uint64_t tiempoNs = 0;
+static host_estadisticasBus_t buses[HOST_CANTIDAD_BUSES];
+static bool_t reinicioEnCaliente = false;
+static uint32_t errores = 0;
+
+void host_reiniciar() {
+	tiempoNs = 0;
+	reinicioEnCaliente = false;
+	host_borrarContadores();
+}
+
+void host_simularReinicio(bool_t enCaliente) {
+	reinicioEnCaliente = enCaliente;
+}
+
+bool_t host_reinicioEnCaliente() {
+	return reinicioEnCaliente;
+}
+
+uint64_t host_tiempoNs() {
+	return tiempoNs;
+}
+
+void host_avanzarNs(uint64_t ns) {
+	tiempoNs += ns;
+}
+
+void host_registrarTransaccion(host_bus_enum bus, uint32_t bytes,
+		uint64_t duracionNs) {
+	if (bus >= HOST_CANTIDAD_BUSES)
+		return;
+	buses[bus].transacciones++;
+	buses[bus].bytes += bytes;
+	buses[bus].tiempoNs += duracionNs;
+}
+
+host_estadisticasBus_t host_leerBus(host_bus_enum bus) {
+	host_estadisticasBus_t vacio = { 0 };
+	if (bus >= HOST_CANTIDAD_BUSES)
+		return vacio;
+	return buses[bus];
+}
+
+void host_borrarContadores() {
+	for (uint8_t i = 0; i < HOST_CANTIDAD_BUSES; i++) {
+		buses[i].transacciones = 0;
+		buses[i].bytes = 0;
+		buses[i].tiempoNs = 0;
+	}
+}
+
+void host_verificar(bool_t condicion, const char *mensaje) {
+	if (!condicion) {
+		fprintf(stderr, "error: %s\n", mensaje);
+		errores++;
+	}
+}
+
+uint32_t host_errores() {
+	return errores;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file replay_traza.c
+ * @brief Carga de trazas de texto y cálculo de su costo
+ *        en el bus. La reproducción está en el port
+ *        API_mfrc522_port_replay.c.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "replay_traza.h"
+#include "API_lcd_port.h"
+
+#define LARGO_LINEA					(64 + 4 * TRAZA_MAX_DATOS)
+#define NS_POR_BIT_I2C				(1000000000ULL / I2C_CLOCK_SPEED)
+#define BITS_POR_BYTE_I2C			9
+
+static const char *const TIPOS[TRAZA_CANTIDAD_TIPOS] = { "SW", "SR", "ST",
+		"IW" };
+
+static bool_t replay_leerLinea(const char*, traza_transaccion_t*);
+static const char* replay_leerHex(const char*, uint8_t*, uint16_t*);
+static int valorHex(char);
+
+bool_t replay_cargar(const char *archivo, replay_traza_t *traza) {
+	FILE *entrada = fopen(archivo, "r");
+	if (entrada == NULL) {
+		fprintf(stderr, "%s: no se puede abrir\n", archivo);
+		return false;
+	}
+
+	uint32_t capacidad = 0, numeroLinea = 0;
+	char linea[LARGO_LINEA];
+	traza->transacciones = NULL;
+	traza->cantidad = 0;
+	traza->descartadas = 0;
+
+	while (fgets(linea, sizeof(linea), entrada) != NULL) {
+		numeroLinea++;
+		char *c = linea;
+		while (isspace((unsigned char) *c))
+			c++;
+		if (*c == '#') {
+			unsigned long descartadas;
+			if (sscanf(c, "# descartadas=%lu", &descartadas) == 1)
+				traza->descartadas = (uint32_t) descartadas;
+			continue;
+		}
+		if (*c == '\0')
+			continue;
+
+		if (traza->cantidad == capacidad) {
+			capacidad = capacidad ? capacidad * 2 : 1024;
+			traza->transacciones = realloc(traza->transacciones,
+					capacidad * sizeof(traza_transaccion_t));
+		}
+		if (!replay_leerLinea(c, &traza->transacciones[traza->cantidad])) {
+			fprintf(stderr, "%s:%lu: transaccion invalida\n", archivo,
+					(unsigned long) numeroLinea);
+			fclose(entrada);
+			replay_liberar(traza);
+			return false;
+		}
+		traza->cantidad++;
+	}
+	fclose(entrada);
+	return true;
+}
+
+void replay_liberar(replay_traza_t *traza) {
+	free(traza->transacciones);
+	traza->transacciones = NULL;
+	traza->cantidad = 0;
+}
+
+host_estadisticasBus_t replay_costo(const replay_traza_t *traza,
+		host_bus_enum bus, int dispositivo) {
+	host_estadisticasBus_t costo = { 0 };
+	for (uint32_t i = 0; i < traza->cantidad; i++) {
+		const traza_transaccion_t *t = &traza->transacciones[i];
+		bool_t esI2C = (t->tipo == TRAZA_I2C_ESCRITURA);
+		if (esI2C != (bus == HOST_BUS_I2C)
+				|| (dispositivo != REPLAY_TODOS && t->dispositivo != dispositivo))
+			continue;
+
+		costo.transacciones++;
+		if (esI2C) {
+			//sin ACK la transacción termina luego del byte de dirección
+			uint32_t bytes = t->error ? 1 : t->largo + 1;
+			costo.bytes += bytes;
+			costo.tiempoNs += (2 + bytes * BITS_POR_BYTE_I2C) * NS_POR_BIT_I2C;
+		} else {
+			//la dirección del registro va en el primer byte
+			uint32_t bytes = (t->tipo == TRAZA_SPI_TRANSFERENCIA) ?
+					t->largo : t->largo + 1u;
+			costo.bytes += bytes;
+			costo.tiempoNs += bytes * 8 * 1000000000ULL / HOST_SPI_CLOCK;
+		}
+	}
+	return costo;
+}
+
+uint32_t replay_lectores(const replay_traza_t *traza) {
+	uint32_t lectores = 0;
+	for (uint32_t i = 0; i < traza->cantidad; i++) {
+		if (traza->transacciones[i].tipo != TRAZA_I2C_ESCRITURA)
+			lectores |= 1UL << traza->transacciones[i].dispositivo;
+	}
+	return lectores;
+}
+
+/**
+ *	@brief Lee una línea con el formato de traza_volcar:
+ *		   tiempoUs tipo dispositivo direccion largo error datos
+ */
+static bool_t replay_leerLinea(const char *linea, traza_transaccion_t *t) {
+	unsigned long tiempo;
+	unsigned dispositivo, direccion, largo;
+	char tipo[3], error;
+	int leidos = 0;
+
+	memset(t, 0, sizeof(*t));
+	if (sscanf(linea, "%lu %2s %u %x %u %c %n", &tiempo, tipo, &dispositivo,
+			&direccion, &largo, &error, &leidos) != 6
+			|| dispositivo >= TRAZA_MAX_DISPOSITIVOS || direccion > 0xFF
+			|| largo > UINT8_MAX || (error != 'E' && error != '-'))
+		return false;
+
+	t->tipo = TRAZA_CANTIDAD_TIPOS;
+	for (uint8_t i = 0; i < TRAZA_CANTIDAD_TIPOS; i++) {
+		if (strcmp(tipo, TIPOS[i]) == 0)
+			t->tipo = (traza_tipo_enum) i;
+	}
+	if (t->tipo == TRAZA_CANTIDAD_TIPOS)
+		return false;
+	t->tiempoUs = (uint32_t) tiempo;
+	t->dispositivo = (uint8_t) dispositivo;
+	t->direccion = (uint8_t) direccion;
+	t->largo = (uint16_t) largo;
+	t->error = (error == 'E');
+
+	const char *c = linea + leidos;
+	uint16_t maximo = largo < TRAZA_MAX_DATOS ? largo : TRAZA_MAX_DATOS;
+	if (*c == '-')
+		return maximo == 0;
+	if (t->tipo != TRAZA_SPI_TRANSFERENCIA) {
+		c = replay_leerHex(c, t->datos, &t->guardados);
+		return c != NULL && t->guardados == maximo;
+	}
+
+	uint16_t transmitidos, recibidos;
+	c = replay_leerHex(c, t->datos, &transmitidos);
+	if (c == NULL || *c != '/' || transmitidos != maximo)
+		return false;
+	c = replay_leerHex(c + 1, t->datos + transmitidos, &recibidos);
+	t->guardados = transmitidos + recibidos;
+	return c != NULL && recibidos == maximo;
+}
+
+/**
+ *	@brief Lee bytes en hexadecimal hasta un caracter que
+ *		   no lo sea, sin superar TRAZA_MAX_DATOS.
+ *	@retval Puntero al caracter siguiente, o NULL si hay
+ *			una cantidad impar de dígitos o demasiados bytes.
+ */
+static const char* replay_leerHex(const char *c, uint8_t *datos,
+		uint16_t *cantidad) {
+	*cantidad = 0;
+	while (valorHex(c[0]) >= 0) {
+		if (valorHex(c[1]) < 0 || *cantidad == TRAZA_MAX_DATOS)
+			return NULL;
+		datos[(*cantidad)++] = (uint8_t) (valorHex(c[0]) << 4 | valorHex(c[1]));
+		c += 2;
+	}
+	return c;
+}
+
+static int valorHex(char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
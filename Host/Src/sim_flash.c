@@ -0,0 +1,143 @@
+/**
+ * @file sim_flash.c
+ * @brief Implementación del modelo de la flash. El contenido
+ *        se mantiene en memoria y cada programación o borrado
+ *        se escribe también en el archivo.
+ */
+
+#include "sim_flash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static FILE *archivoFlash = NULL;
+static uint8_t *memoria = NULL;
+static uint8_t cantidadSectores;
+static uint32_t tamanoSector;
+static uint64_t finBorradoNs;
+static uint32_t limiteCorte = UINT32_MAX;
+static bool_t fallaProgramacion = false;
+static uint32_t bytesLeidos;
+static uint32_t bytesProgramados;
+static uint32_t programaciones;
+static uint32_t borrados[SIM_FLASH_MAX_SECTORES];
+
+static void guardar(uint32_t direccion, uint32_t largo);
+
+bool_t simFlash_abrir(const char *archivo, uint8_t sectores,
+		uint32_t tamano) {
+	simFlash_cerrar();
+	if (sectores == 0 || sectores > SIM_FLASH_MAX_SECTORES)
+		return false;
+
+	uint32_t total = sectores * tamano;
+	memoria = malloc(total);
+	if (memoria == NULL)
+		return false;
+	cantidadSectores = sectores;
+	tamanoSector = tamano;
+
+	archivoFlash = fopen(archivo, "r+b");
+	if (archivoFlash == NULL
+			|| fread(memoria, 1, total, archivoFlash) != total) {
+		if (archivoFlash != NULL)
+			fclose(archivoFlash);
+		archivoFlash = fopen(archivo, "w+b");
+		if (archivoFlash == NULL) {
+			free(memoria);
+			memoria = NULL;
+			return false;
+		}
+		memset(memoria, 0xFF, total);
+		guardar(0, total);
+	}
+
+	finBorradoNs = 0;
+	limiteCorte = UINT32_MAX;
+	fallaProgramacion = false;
+	return true;
+}
+
+void simFlash_cerrar() {
+	if (archivoFlash != NULL)
+		fclose(archivoFlash);
+	free(memoria);
+	archivoFlash = NULL;
+	memoria = NULL;
+}
+
+void simFlash_leer(uint32_t direccion, void *datos, uint32_t largo) {
+	if (memoria == NULL
+			|| (uint64_t) direccion + largo > cantidadSectores * tamanoSector) {
+		memset(datos, 0xFF, largo);
+		return;
+	}
+	memcpy(datos, &memoria[direccion], largo);
+	bytesLeidos += largo;
+}
+
+uint64_t simFlash_programar(uint32_t direccion, const void *datos,
+		uint32_t largo) {
+	const uint8_t *bytes = datos;
+	if (memoria == NULL
+			|| (uint64_t) direccion + largo > cantidadSectores * tamanoSector)
+		return 0;
+
+	uint32_t programados = largo < limiteCorte ? largo : limiteCorte;
+	bool_t falla = fallaProgramacion;
+	limiteCorte = UINT32_MAX;
+	fallaProgramacion = false;
+	for (uint32_t i = 0; i < programados; i++) {
+		memoria[direccion + i] &= bytes[i];
+	}
+	guardar(direccion, programados);
+	bytesProgramados += programados;
+	programaciones++;
+	return falla ? 0 : ((largo + 3) / 4) * SIM_FLASH_NS_POR_PALABRA;
+}
+
+void simFlash_borrar(uint8_t sector, uint64_t tiempoNs) {
+	if (memoria == NULL || sector >= cantidadSectores)
+		return;
+	memset(&memoria[sector * tamanoSector], 0xFF, tamanoSector);
+	guardar(sector * tamanoSector, tamanoSector);
+	borrados[sector]++;
+	finBorradoNs = tiempoNs + SIM_FLASH_NS_BORRADO;
+}
+
+bool_t simFlash_ocupada(uint64_t tiempoNs) {
+	return tiempoNs < finBorradoNs;
+}
+
+void simFlash_cortarProgramacion(uint32_t bytes) {
+	limiteCorte = bytes;
+}
+
+void simFlash_fallarProgramacion(uint32_t bytes) {
+	limiteCorte = bytes;
+	fallaProgramacion = true;
+}
+
+uint32_t simFlash_bytesLeidos() {
+	return bytesLeidos;
+}
+
+uint32_t simFlash_bytesProgramados() {
+	return bytesProgramados;
+}
+
+uint32_t simFlash_programaciones() {
+	return programaciones;
+}
+
+uint32_t simFlash_borrados(uint8_t sector) {
+	return sector < SIM_FLASH_MAX_SECTORES ? borrados[sector] : 0;
+}
+
+static void guardar(uint32_t direccion, uint32_t largo) {
+	if (archivoFlash == NULL || largo == 0)
+		return;
+	fseek(archivoFlash, direccion, SEEK_SET);
+	fwrite(&memoria[direccion], 1, largo, archivoFlash);
+	fflush(archivoFlash);
+}
@@ -0,0 +1,298 @@
+/**
+ * @file sim_hd44780.c
+ * @brief Implementación del modelo HD44780 + PCF8574.
+ *        Cada display tiene su propio estado y responde
+ *        en la dirección I2C con la que se agregó.
+ *        Las instrucciones y sus tiempos de ejecución
+ *        siguen la Tabla 6 de la hoja de datos del HD44780
+ *        (fosc = 270 kHz).
+ */
+
+#include <string.h>
+#include "sim_hd44780.h"
+
+#define TAMANO_DDRAM				0x68
+#define TAMANO_CGRAM				64
+#define DIRECCION_FILA_2			0x40
+
+//tiempos de ejecución en nS
+#define NS_ENCENDIDO				15000000ULL		//espera luego de encender
+#define NS_INIT_1					4100000ULL		//primer function set en 8 bits
+#define NS_INIT_2					100000ULL		//segundo function set en 8 bits
+#define NS_LARGO					1520000ULL		//clear display y return home
+#define NS_CORTO					37000ULL		//resto de instrucciones
+#define NS_DATO						41000ULL		//escritura en DDRAM/CGRAM
+
+/**
+ *	@brief Estado de un display con su expansor.
+ */
+typedef struct {
+	bool_t presente;
+	uint8_t direccionI2C;
+	uint8_t ddram[TAMANO_DDRAM];
+	uint8_t cgram[TAMANO_CGRAM];
+	uint8_t expansor;
+	bool_t modo4Bits;
+	bool_t esperandoNibbleBajo;
+	bool_t descartarNibbleBajo;
+	uint8_t nibbleAlto;
+	uint8_t functionSets8Bits;
+	uint64_t ocupadoHastaNs;
+
+	uint8_t contador;
+	bool_t enCgram;
+	bool_t incrementar;
+	bool_t desplazarConEscritura;
+	bool_t displayEncendido;
+	uint8_t desplazamiento;
+	uint32_t instrucciones;
+	uint32_t violaciones;
+} sim_display_t;
+
+static sim_display_t displays[SIM_MAX_DISPLAYS];
+
+static sim_display_t* buscarDisplay(uint8_t direccionI2C);
+static void capturarNibble(sim_display_t*, uint8_t valor, uint64_t tiempoNs);
+static uint64_t ejecutar(sim_display_t*, uint8_t dato, bool_t rs);
+static void moverContador(sim_display_t*, bool_t adelante);
+static void desplazarDisplay(sim_display_t*, bool_t izquierda);
+
+void simHd44780_reset() {
+	memset(displays, 0, sizeof(displays));
+}
+
+int simHd44780_agregar(uint8_t direccionI2C, uint64_t tiempoNs) {
+	if (buscarDisplay(direccionI2C) != NULL)
+		return -1;
+	for (int indice = 0; indice < SIM_MAX_DISPLAYS; indice++) {
+		sim_display_t *d = &displays[indice];
+		if (d->presente)
+			continue;
+		memset(d, 0, sizeof(*d));
+		d->presente = true;
+		d->direccionI2C = direccionI2C;
+		memset(d->ddram, ' ', sizeof(d->ddram));
+		d->ocupadoHastaNs = tiempoNs + NS_ENCENDIDO;
+		d->incrementar = true;
+		return indice;
+	}
+	return -1;
+}
+
+bool_t simHd44780_presente(uint8_t direccionI2C) {
+	return buscarDisplay(direccionI2C) != NULL;
+}
+
+bool_t simHd44780_escribirExpansor(uint8_t direccionI2C, uint8_t valor,
+		uint64_t tiempoNs) {
+	sim_display_t *d = buscarDisplay(direccionI2C);
+	if (d == NULL)
+		return false;
+	bool_t flancoDescendente = (d->expansor & SIM_PCF8574_E)
+			&& !(valor & SIM_PCF8574_E);
+	d->expansor = valor;
+	if (flancoDescendente && !(valor & SIM_PCF8574_RW))
+		capturarNibble(d, valor, tiempoNs);
+	return true;
+}
+
+uint8_t simHd44780_caracter(uint8_t display, uint8_t fila, uint8_t columna) {
+	sim_display_t *d = &displays[display % SIM_MAX_DISPLAYS];
+	uint8_t posicion = (columna + d->desplazamiento)
+			% SIM_HD44780_COLUMNAS_DDRAM;
+	return d->ddram[(fila ? DIRECCION_FILA_2 : 0) + posicion];
+}
+
+uint8_t simHd44780_ddram(uint8_t display, uint8_t direccion) {
+	return direccion < TAMANO_DDRAM ?
+			displays[display % SIM_MAX_DISPLAYS].ddram[direccion] : 0;
+}
+
+uint8_t simHd44780_cgram(uint8_t display, uint8_t direccion) {
+	return displays[display % SIM_MAX_DISPLAYS].cgram[direccion % TAMANO_CGRAM];
+}
+
+uint8_t simHd44780_contadorDirecciones(uint8_t display) {
+	return displays[display % SIM_MAX_DISPLAYS].contador;
+}
+
+uint8_t simHd44780_desplazamiento(uint8_t display) {
+	return displays[display % SIM_MAX_DISPLAYS].desplazamiento;
+}
+
+bool_t simHd44780_displayEncendido(uint8_t display) {
+	return displays[display % SIM_MAX_DISPLAYS].displayEncendido;
+}
+
+bool_t simHd44780_backlight(uint8_t display) {
+	return (displays[display % SIM_MAX_DISPLAYS].expansor
+			& SIM_PCF8574_BACKLIGHT) != 0;
+}
+
+uint32_t simHd44780_instrucciones(uint8_t display) {
+	return displays[display % SIM_MAX_DISPLAYS].instrucciones;
+}
+
+uint32_t simHd44780_violacionesTiempo(uint8_t display) {
+	return displays[display % SIM_MAX_DISPLAYS].violaciones;
+}
+
+/**
+ *	@brief Busca el display conectado en la dirección I2C.
+ *	@retval Display, o NULL si ningún expansor responde.
+ */
+static sim_display_t* buscarDisplay(uint8_t direccionI2C) {
+	for (uint8_t indice = 0; indice < SIM_MAX_DISPLAYS; indice++) {
+		if (displays[indice].presente
+				&& displays[indice].direccionI2C == direccionI2C)
+			return &displays[indice];
+	}
+	return NULL;
+}
+
+/**
+ *	@brief Captura un nibble de D4-D7. En modo de 8 bits
+ *		   (luego del encendido) cada nibble es una instrucción
+ *		   completa con D0-D3 en 0. En modo de 4 bits se
+ *		   necesitan dos nibbles, y el tiempo de ocupado se
+ *		   verifica al capturar el primero.
+ */
+static void capturarNibble(sim_display_t *d, uint8_t valor,
+		uint64_t tiempoNs) {
+	uint8_t nibble = valor & 0xF0;
+	bool_t rs = (valor & SIM_PCF8574_RS) != 0;
+
+	if (d->modo4Bits && d->esperandoNibbleBajo) {
+		d->esperandoNibbleBajo = false;
+		if (d->descartarNibbleBajo)
+			return;
+		d->ocupadoHastaNs = tiempoNs
+				+ ejecutar(d, d->nibbleAlto | (nibble >> 4), rs);
+		return;
+	}
+
+	bool_t ocupado = tiempoNs < d->ocupadoHastaNs;
+	if (ocupado)
+		d->violaciones++;
+
+	if (d->modo4Bits) {
+		d->nibbleAlto = nibble;
+		d->esperandoNibbleBajo = true;
+		d->descartarNibbleBajo = ocupado;
+		return;
+	}
+
+	if (ocupado)
+		return;
+	d->ocupadoHastaNs = tiempoNs + ejecutar(d, nibble, rs);
+}
+
+/**
+ *	@brief Ejecuta una instrucción o escritura de dato.
+ *	@retval Tiempo de ejecución en nS.
+ */
+static uint64_t ejecutar(sim_display_t *d, uint8_t dato, bool_t rs) {
+	d->instrucciones++;
+
+	if (rs) {
+		if (d->enCgram) {
+			d->cgram[d->contador % TAMANO_CGRAM] = dato;
+		} else {
+			d->ddram[d->contador] = dato;
+			if (d->desplazarConEscritura)
+				desplazarDisplay(d, d->incrementar);
+		}
+		moverContador(d, d->incrementar);
+		return NS_DATO;
+	}
+
+	if (dato & 0x80) {							//set DDRAM address
+		uint8_t direccion = dato & 0x7F;
+		if (direccion >= 0x28 && direccion < DIRECCION_FILA_2)
+			direccion = DIRECCION_FILA_2;
+		if (direccion >= TAMANO_DDRAM)
+			direccion = 0;
+		d->contador = direccion;
+		d->enCgram = false;
+	} else if (dato & 0x40) {					//set CGRAM address
+		d->contador = dato & 0x3F;
+		d->enCgram = true;
+	} else if (dato & 0x20) {					//function set
+		if (!d->modo4Bits) {
+			d->functionSets8Bits++;
+			if (!(dato & 0x10))
+				d->modo4Bits = true;
+			if (d->functionSets8Bits == 1)
+				return NS_INIT_1;
+			if (d->functionSets8Bits == 2)
+				return NS_INIT_2;
+		} else if (dato & 0x10) {
+			d->modo4Bits = false;				//DL = 1 vuelve al modo de 8 bits
+		}
+	} else if (dato & 0x10) {					//cursor o display shift
+		bool_t derecha = (dato & 0x04) != 0;
+		if (dato & 0x08)
+			desplazarDisplay(d, !derecha);
+		else
+			moverContador(d, derecha);
+	} else if (dato & 0x08) {					//display control
+		d->displayEncendido = (dato & 0x04) != 0;
+	} else if (dato & 0x04) {					//entry mode set
+		d->incrementar = (dato & 0x02) != 0;
+		d->desplazarConEscritura = (dato & 0x01) != 0;
+	} else if (dato & 0x02) {					//return home
+		d->contador = 0;
+		d->enCgram = false;
+		d->desplazamiento = 0;
+		return NS_LARGO;
+	} else if (dato & 0x01) {					//clear display
+		memset(d->ddram, ' ', sizeof(d->ddram));
+		d->contador = 0;
+		d->enCgram = false;
+		d->incrementar = true;
+		d->desplazamiento = 0;
+		return NS_LARGO;
+	}
+	return NS_CORTO;
+}
+
+/**
+ *	@brief Mueve el contador de direcciones. En DDRAM
+ *		   pasa de 0x27 a 0x40 y de 0x67 a 0x00.
+ */
+static void moverContador(sim_display_t *d, bool_t adelante) {
+	if (d->enCgram) {
+		d->contador = (d->contador + (adelante ? 1 : TAMANO_CGRAM - 1))
+				% TAMANO_CGRAM;
+		return;
+	}
+	if (adelante) {
+		if (d->contador == 0x27)
+			d->contador = DIRECCION_FILA_2;
+		else if (d->contador == 0x67)
+			d->contador = 0;
+		else
+			d->contador++;
+	} else {
+		if (d->contador == 0)
+			d->contador = 0x67;
+		else if (d->contador == DIRECCION_FILA_2)
+			d->contador = 0x27;
+		else
+			d->contador--;
+	}
+}
+
+/**
+ *	@brief Desplaza el display una columna. Desplazar a
+ *		   la izquierda muestra las columnas siguientes de
+ *		   la DDRAM.
+ */
+static void desplazarDisplay(sim_display_t *d, bool_t izquierda) {
+	if (izquierda)
+		d->desplazamiento = (d->desplazamiento + 1)
+				% SIM_HD44780_COLUMNAS_DDRAM;
+	else
+		d->desplazamiento = (d->desplazamiento + SIM_HD44780_COLUMNAS_DDRAM
+				- 1) % SIM_HD44780_COLUMNAS_DDRAM;
+}
@@ -0,0 +1,570 @@
+/**
+ * @file sim_mfrc522.c
+ * @brief Implementación del modelo del MFRC522 y
+ *        de las tarjetas ISO/IEC 14443-3.
+ * @note  El modelo procesa cada intercambio con las tarjetas
+ *        en forma instantánea al escribir StartSend, y calcula
+ *        la duración que tendría en el aire para que el puerto
+ *        la sume al tiempo virtual.
+ */
+
+#include "sim_mfrc522.h"
+#include <string.h>
+
+// Registros utilizados por el modelo (sección 9.2 de la hoja de datos)
+#define REG_COMMAND					0x01
+#define REG_COMIEN					0x02
+#define REG_DIVIEN					0x03
+#define REG_COMIRQ					0x04
+#define REG_DIVIRQ					0x05
+#define REG_ERROR					0x06
+#define REG_FIFODATA				0x09
+#define REG_FIFOLEVEL				0x0A
+#define REG_CONTROL					0x0C
+#define REG_BITFRAMING				0x0D
+#define REG_COLL					0x0E
+#define REG_TXCONTROL				0x14
+#define REG_RXTHRESHOLD				0x18
+#define REG_RFCFG					0x26
+#define REG_GSN						0x27
+#define REG_CWGSP					0x28
+#define REG_TMODE					0x2A
+#define REG_TPRESCALER				0x2B
+#define REG_TRELOADH				0x2C
+#define REG_TRELOADL				0x2D
+#define REG_VERSION					0x37
+
+#define CMD_IDLE					0x00
+#define CMD_TRANSCEIVE				0x0C
+#define CMD_SOFTRESET				0x0F
+#define COMMAND_POWERDOWN			(1<<4)
+
+#define IRQ_RX						(1<<5)
+#define IRQ_IDLE					(1<<4)
+#define IRQ_TIMER					(1<<0)
+#define ERROR_PARITY				(1<<1)
+#define ERROR_COLL					(1<<3)
+#define COLL_POS_NOT_VALID			(1<<5)
+
+#define TAMANO_FIFO					64
+#define MAX_BITS_TRAMA				(TAMANO_FIFO * 8)
+
+// Tiempos de ISO/IEC 14443-2 a 106 kbit/s
+#define FC_HZ						13560000UL
+#define NS_POR_BIT					9440		//128 / fc
+#define FDT_US						86			//tiempo entre el fin del comando y la respuesta
+
+// Modelo del enlace de RF, en dB relativos. La respuesta llega al
+// demodulador con SENAL_BASE_DB + potencia - 2 * atenuación + ganancia,
+// el ruido con RUIDO_BASE_DB + ruido + ganancia, y el umbral es
+// UMBRAL_BASE_DB + 2 dB por cada paso de MinLevel. La potencia va de
+// -12 dB (CWGsP y CWGsN en 0) a 0 dB (máximos), con -6 dB por defecto.
+#define SENAL_BASE_DB				50
+#define RUIDO_BASE_DB				20
+#define UMBRAL_BASE_DB				50
+#define MARGEN_MAX_DB				8			//a partir de este margen el enlace no falla
+#define SEMILLA_ENLACE				0x2545F491UL
+
+// Probabilidad en milésimos de superar un margen de -8 a 8 dB
+static const uint16_t PROBABILIDAD_MARGEN[2 * MARGEN_MAX_DB + 1] = { 0, 3, 8,
+		18, 40, 80, 150, 270, 500, 730, 850, 920, 960, 982, 992, 997, 1000 };
+// Ganancia del receptor en dB según RxGain (sección 9.3.3.6 del manual)
+static const uint8_t GANANCIA_DB[8] = { 18, 23, 18, 23, 33, 38, 43, 48 };
+
+typedef enum {
+	ESTADO_IDLE, ESTADO_READY, ESTADO_ACTIVE, ESTADO_HALT
+} estado_tarjeta_enum;
+
+typedef struct {
+	bool_t presente;
+	uint8_t uid[10];
+	uint8_t largo;
+	estado_tarjeta_enum estado;
+	uint8_t nivel;			//nivel de cascada actual (0 a 2)
+} sim_tarjeta_t;
+
+typedef struct {
+	uint16_t bits;
+	uint8_t datos[TAMANO_FIFO];
+} trama_t;
+
+// Estado de cada MFRC522 simulado, con su propio campo RF
+typedef struct {
+	uint8_t registros[64];
+	uint8_t fifo[TAMANO_FIFO];
+	uint8_t nivelFifo;
+	sim_tarjeta_t tarjetas[SIM_MAX_TARJETAS];
+	uint32_t duracionIntercambio;
+	uint32_t cantidadIntercambios;
+	uint8_t atenuacionDb;
+	uint8_t ruidoDb;
+} sim_lector_t;
+
+static sim_lector_t lectores[SIM_MAX_LECTORES];
+static uint32_t estadoAleatorio = SEMILLA_ENLACE;
+
+static void reiniciarRegistros(sim_lector_t *l);
+static void escribirRegistro(sim_lector_t *l, uint8_t reg, uint8_t valor);
+static uint8_t leerRegistro(sim_lector_t *l, uint8_t reg);
+static void ejecutarIntercambio(sim_lector_t *l);
+static bool_t procesarTarjeta(sim_tarjeta_t *tarjeta, const trama_t *comando,
+		trama_t *respuesta);
+static void bytesNivel(const sim_tarjeta_t *tarjeta, uint8_t nivel,
+		uint8_t *destino);
+static uint16_t crcA(const uint8_t *datos, uint8_t largo);
+static uint8_t leerBit(const uint8_t *datos, uint16_t bit);
+static void escribirBit(uint8_t *datos, uint16_t bit, uint8_t valor);
+static void responderBytes(trama_t *respuesta, const uint8_t *datos,
+		uint8_t largo, bool_t agregarCrc);
+static uint32_t periodoTimerUs(sim_lector_t *l);
+static bool_t aplicarEnlace(sim_lector_t *l, uint8_t *datos, uint16_t bits);
+static bool_t sucede(uint16_t probabilidadMil);
+static uint16_t probabilidadMargen(int margenDb);
+
+void simMfrc522_reset() {
+	memset(lectores, 0, sizeof(lectores));
+	for (uint8_t i = 0; i < SIM_MAX_LECTORES; i++) {
+		reiniciarRegistros(&lectores[i]);
+	}
+	estadoAleatorio = SEMILLA_ENLACE;
+}
+
+void simMfrc522_configurarEnlace(uint8_t lector, uint8_t atenuacionDb,
+		uint8_t ruidoDb) {
+	if (lector >= SIM_MAX_LECTORES)
+		return;
+	lectores[lector].atenuacionDb = atenuacionDb;
+	lectores[lector].ruidoDb = ruidoDb;
+}
+
+int simMfrc522_agregarTarjeta(uint8_t lector, const uint8_t *uid,
+		uint8_t largo) {
+	if (lector >= SIM_MAX_LECTORES)
+		return -1;
+	sim_lector_t *l = &lectores[lector];
+	if (largo != 4 && largo != 7 && largo != 10)
+		return -1;
+	for (int i = 0; i < SIM_MAX_TARJETAS; i++) {
+		if (!l->tarjetas[i].presente) {
+			memset(&l->tarjetas[i], 0, sizeof(l->tarjetas[i]));
+			memcpy(l->tarjetas[i].uid, uid, largo);
+			l->tarjetas[i].largo = largo;
+			l->tarjetas[i].presente = true;
+			l->tarjetas[i].estado = ESTADO_IDLE;
+			return i;
+		}
+	}
+	return -1;
+}
+
+void simMfrc522_quitarTarjeta(uint8_t lector, int indice) {
+	if (lector < SIM_MAX_LECTORES && indice >= 0 && indice < SIM_MAX_TARJETAS)
+		lectores[lector].tarjetas[indice].presente = false;
+}
+
+/**
+ *	@brief Interpreta una transferencia SPI según la sección
+ *		   8.1.2 de la hoja de datos: en una lectura cada byte
+ *		   enviado es la dirección del siguiente byte a leer, y
+ *		   en una escritura todos los bytes van al mismo registro.
+ */
+void simMfrc522_transferencia(uint8_t lector, const uint8_t *tx, uint8_t *rx,
+		uint16_t largo) {
+	if (largo == 0 || lector >= SIM_MAX_LECTORES)
+		return;
+	sim_lector_t *l = &lectores[lector];
+
+	uint8_t direccion = tx[0];
+	if (rx != NULL)
+		rx[0] = 0;
+
+	if (direccion & 0x80) {
+		for (uint16_t i = 1; i < largo; i++) {
+			uint8_t valor = leerRegistro(l, (direccion >> 1) & 0x3F);
+			if (rx != NULL)
+				rx[i] = valor;
+			direccion = tx[i];
+			if (!(direccion & 0x80))
+				break;				//el 0 final termina la lectura
+		}
+	} else {
+		for (uint16_t i = 1; i < largo; i++) {
+			escribirRegistro(l, (direccion >> 1) & 0x3F, tx[i]);
+			if (rx != NULL)
+				rx[i] = 0;
+		}
+	}
+}
+
+bool_t simMfrc522_irqActivo(uint8_t lector) {
+	const sim_lector_t *l = &lectores[lector];
+	return (l->registros[REG_COMIRQ] & l->registros[REG_COMIEN] & 0x7F) != 0;
+}
+
+uint32_t simMfrc522_duracionIntercambioUs(uint8_t lector) {
+	return lectores[lector].duracionIntercambio;
+}
+
+uint32_t simMfrc522_cantidadIntercambios(uint8_t lector) {
+	return lectores[lector].cantidadIntercambios;
+}
+
+static void reiniciarRegistros(sim_lector_t *l) {
+	memset(l->registros, 0, sizeof(l->registros));
+	l->registros[REG_COMMAND] = 0x20;
+	l->registros[REG_COMIEN] = 0x80;
+	l->registros[REG_COMIRQ] = 0x14;
+	l->registros[0x07] = 0x21;			//Status1Reg
+	l->registros[0x0B] = 0x08;			//WaterLevelReg
+	l->registros[REG_CONTROL] = 0x10;
+	l->registros[REG_COLL] = 0xA0;
+	l->registros[0x11] = 0x3F;			//ModeReg
+	l->registros[REG_TXCONTROL] = 0x80;
+	l->registros[0x16] = 0x10;			//TxSelReg
+	l->registros[0x17] = 0x84;			//RxSelReg
+	l->registros[0x18] = 0x84;			//RxThresholdReg
+	l->registros[0x19] = 0x4D;			//DemodReg
+	l->registros[0x26] = 0x48;			//RFCfgReg
+	l->registros[0x27] = 0x88;			//GsNReg
+	l->registros[0x28] = 0x20;			//CWGsPReg
+	l->registros[0x29] = 0x20;			//ModGsPReg
+	l->registros[REG_VERSION] = 0x92;
+	l->nivelFifo = 0;
+}
+
+static void escribirRegistro(sim_lector_t *l, uint8_t reg, uint8_t valor) {
+	switch (reg) {
+	case REG_COMMAND:
+		if ((valor & 0x0F) == CMD_SOFTRESET) {
+			reiniciarRegistros(l);
+			return;
+		}
+		l->registros[REG_COMMAND] = (l->registros[REG_COMMAND] & 0x20)
+				| (valor & 0x1F);
+		break;
+	case REG_COMIRQ:
+	case REG_DIVIRQ:
+		if (valor & 0x80)
+			l->registros[reg] |= valor & 0x7F;		//Set1 = 1: activa los bits
+		else
+			l->registros[reg] &= ~(valor & 0x7F);	//Set1 = 0: borra los bits
+		break;
+	case REG_FIFODATA:
+		if (l->nivelFifo < TAMANO_FIFO)
+			l->fifo[l->nivelFifo++] = valor;
+		break;
+	case REG_FIFOLEVEL:
+		if (valor & 0x80)
+			l->nivelFifo = 0;
+		break;
+	case REG_ERROR:
+	case REG_VERSION:
+		break;								//l->registros de solo lectura
+	case REG_COLL:
+		l->registros[REG_COLL] = (l->registros[REG_COLL] & 0x7F) | (valor & 0x80);
+		break;
+	case REG_BITFRAMING:
+		l->registros[REG_BITFRAMING] = valor & 0x7F;
+		if ((valor & 0x80)
+				&& (l->registros[REG_COMMAND] & 0x0F) == CMD_TRANSCEIVE)
+			ejecutarIntercambio(l);
+		break;
+	default:
+		l->registros[reg] = valor;
+		break;
+	}
+}
+
+static uint8_t leerRegistro(sim_lector_t *l, uint8_t reg) {
+	switch (reg) {
+	case REG_FIFODATA: {
+		if (l->nivelFifo == 0)
+			return 0;
+		uint8_t valor = l->fifo[0];
+		memmove(l->fifo, l->fifo + 1, --l->nivelFifo);
+		return valor;
+	}
+	case REG_FIFOLEVEL:
+		return l->nivelFifo;
+	default:
+		return l->registros[reg];
+	}
+}
+
+/**
+ *	@brief Transmite el contenido de la FIFO a las tarjetas
+ *		   presentes, combina sus respuestas bit a bit
+ *		   detectando colisiones, y carga la respuesta en la
+ *		   FIFO respetando RxAlign.
+ */
+static void ejecutarIntercambio(sim_lector_t *l) {
+	uint8_t txLastBits = l->registros[REG_BITFRAMING] & 0x07;
+	uint8_t rxAlign = (l->registros[REG_BITFRAMING] >> 4) & 0x07;
+	l->cantidadIntercambios++;
+
+	trama_t comando = { 0 };
+	if (l->nivelFifo > 0) {
+		memcpy(comando.datos, l->fifo, l->nivelFifo);
+		comando.bits = (l->nivelFifo - 1) * 8 + (txLastBits ? txLastBits : 8);
+	}
+	l->nivelFifo = 0;
+
+	l->registros[REG_ERROR] = 0;
+	l->registros[REG_COLL] = (l->registros[REG_COLL] & 0x80) | COLL_POS_NOT_VALID;
+	l->registros[REG_CONTROL] &= ~0x07;
+
+	bool_t antenaEncendida = (l->registros[REG_TXCONTROL] & 0x03) != 0
+			&& !(l->registros[REG_COMMAND] & COMMAND_POWERDOWN);
+
+	trama_t respuestas[SIM_MAX_TARJETAS];
+	uint8_t cantidad = 0;
+	for (int i = 0; i < SIM_MAX_TARJETAS && antenaEncendida; i++) {
+		if (!l->tarjetas[i].presente)
+			continue;
+		if (procesarTarjeta(&l->tarjetas[i], &comando, &respuestas[cantidad]))
+			cantidad++;
+	}
+
+	uint32_t duracionTx = (comando.bits * 9 / 8 + 2) * NS_POR_BIT / 1000;
+	if (cantidad == 0) {
+		l->registros[REG_COMIRQ] |= IRQ_TIMER;
+		l->duracionIntercambio = duracionTx + periodoTimerUs(l);
+		return;
+	}
+
+	uint16_t bits = respuestas[0].bits;
+	for (uint8_t i = 1; i < cantidad; i++) {
+		if (respuestas[i].bits < bits)
+			bits = respuestas[i].bits;
+	}
+
+	uint8_t recibido[TAMANO_FIFO + 1] = { 0 };
+	int16_t colision = -1;
+	for (uint16_t bit = 0; bit < bits; bit++) {
+		uint8_t valor = leerBit(respuestas[0].datos, bit);
+		for (uint8_t i = 1; i < cantidad && colision < 0; i++) {
+			if (leerBit(respuestas[i].datos, bit) != valor)
+				colision = bit;
+		}
+		if (colision >= 0)
+			break;				//ValuesAfterColl = 0: el resto queda en 0
+		escribirBit(recibido, rxAlign + bit, valor);
+	}
+
+	if (!aplicarEnlace(l, recibido, bits)) {
+		l->registros[REG_COMIRQ] |= IRQ_TIMER;		//el receptor no detectó la respuesta
+		l->duracionIntercambio = duracionTx + periodoTimerUs(l);
+		return;
+	}
+
+	uint16_t bitsFifo = rxAlign + bits;
+	l->nivelFifo = (bitsFifo + 7) / 8;
+	memcpy(l->fifo, recibido, l->nivelFifo);
+	l->registros[REG_CONTROL] |= bitsFifo % 8;
+
+	if (colision >= 0) {
+		l->registros[REG_ERROR] |= ERROR_COLL;
+		uint16_t posicion = rxAlign + colision + 1;
+		if (posicion <= 32)
+			l->registros[REG_COLL] = (l->registros[REG_COLL] & 0x80)
+					| (posicion & 0x1F);
+	}
+
+	l->registros[REG_COMIRQ] |= IRQ_RX | IRQ_IDLE;
+	l->duracionIntercambio = duracionTx + FDT_US
+			+ (bits * 9 / 8 + 2) * NS_POR_BIT / 1000;
+}
+
+/**
+ *	@brief Máquina de estados de una tarjeta según
+ *		   ISO/IEC 14443-3, sección 6.
+ *	@retval Verdadero si la tarjeta responde.
+ */
+static bool_t procesarTarjeta(sim_tarjeta_t *tarjeta, const trama_t *comando,
+		trama_t *respuesta) {
+	const uint8_t *d = comando->datos;
+	uint8_t atqa[2] = { tarjeta->largo == 4 ? 0x04 : (tarjeta->largo == 7 ? 0x44 : 0x84), 0x00 };
+
+	if (comando->bits == 7 && (d[0] == 0x26 || d[0] == 0x52)) {
+		bool_t wupa = (d[0] == 0x52);
+		if (tarjeta->estado == ESTADO_IDLE
+				|| (wupa && tarjeta->estado == ESTADO_HALT)) {
+			tarjeta->estado = ESTADO_READY;
+			tarjeta->nivel = 0;
+			responderBytes(respuesta, atqa, sizeof(atqa), false);
+			return true;
+		}
+		if (tarjeta->estado != ESTADO_HALT)
+			tarjeta->estado = ESTADO_IDLE;
+		return false;
+	}
+
+	if (comando->bits == 32 && d[0] == 0x50 && d[1] == 0x00
+			&& crcA(d, 4) == 0) {
+		if (tarjeta->estado == ESTADO_ACTIVE)
+			tarjeta->estado = ESTADO_HALT;
+		else if (tarjeta->estado != ESTADO_HALT)
+			tarjeta->estado = ESTADO_IDLE;
+		return false;
+	}
+
+	uint8_t nivelComando = (d[0] - 0x93) / 2;
+	if (comando->bits >= 16 && (d[0] == 0x93 || d[0] == 0x95 || d[0] == 0x97)
+			&& tarjeta->estado == ESTADO_READY
+			&& nivelComando == tarjeta->nivel) {
+		uint8_t nivel[5];
+		bytesNivel(tarjeta, tarjeta->nivel, nivel);
+		uint8_t nvb = d[1];
+
+		if (nvb == 0x70) {
+			if (comando->bits != 72 || crcA(d, 9) != 0
+					|| memcmp(&d[2], nivel, 5) != 0)
+				return false;
+			uint8_t ultimoNivel = (tarjeta->largo - 4) / 3;
+			uint8_t sak = 0x08;
+			if (tarjeta->nivel < ultimoNivel) {
+				sak = 0x04;
+				tarjeta->nivel++;
+			} else {
+				tarjeta->estado = ESTADO_ACTIVE;
+			}
+			responderBytes(respuesta, &sak, 1, true);
+			return true;
+		}
+
+		uint16_t conocidos = ((nvb >> 4) - 2) * 8 + (nvb & 0x0F);
+		if (conocidos > 40 || comando->bits != 16 + conocidos)
+			return false;
+		for (uint16_t bit = 0; bit < conocidos; bit++) {
+			if (leerBit(&d[2], bit) != leerBit(nivel, bit))
+				return false;		//el UID no comienza con los bits enviados
+		}
+		memset(respuesta, 0, sizeof(*respuesta));
+		for (uint16_t bit = conocidos; bit < 40; bit++) {
+			escribirBit(respuesta->datos, bit - conocidos, leerBit(nivel, bit));
+		}
+		respuesta->bits = 40 - conocidos;
+		return true;
+	}
+
+	if (tarjeta->estado != ESTADO_HALT)
+		tarjeta->estado = ESTADO_IDLE;
+	return false;
+}
+
+/**
+ *	@brief Arma los 5 bytes (UID + BCC) de un nivel de cascada.
+ */
+static void bytesNivel(const sim_tarjeta_t *tarjeta, uint8_t nivel,
+		uint8_t *destino) {
+	uint8_t ultimoNivel = (tarjeta->largo - 4) / 3;
+	if (nivel < ultimoNivel) {
+		destino[0] = 0x88;
+		memcpy(&destino[1], &tarjeta->uid[nivel * 3], 3);
+	} else {
+		memcpy(destino, &tarjeta->uid[nivel * 3], 4);
+	}
+	destino[4] = destino[0] ^ destino[1] ^ destino[2] ^ destino[3];
+}
+
+static void responderBytes(trama_t *respuesta, const uint8_t *datos,
+		uint8_t largo, bool_t agregarCrc) {
+	memset(respuesta, 0, sizeof(*respuesta));
+	memcpy(respuesta->datos, datos, largo);
+	if (agregarCrc) {
+		uint16_t crc = crcA(datos, largo);
+		respuesta->datos[largo++] = crc & 0xFF;
+		respuesta->datos[largo++] = crc >> 8;
+	}
+	respuesta->bits = largo * 8;
+}
+
+static uint16_t crcA(const uint8_t *datos, uint8_t largo) {
+	uint16_t crc = 0x6363;
+	for (uint8_t i = 0; i < largo; i++) {
+		uint8_t byte = datos[i] ^ (uint8_t) (crc & 0xFF);
+		byte ^= byte << 4;
+		crc = (crc >> 8) ^ ((uint16_t) byte << 8) ^ ((uint16_t) byte << 3)
+				^ (byte >> 4);
+	}
+	return crc;
+}
+
+static uint8_t leerBit(const uint8_t *datos, uint16_t bit) {
+	return (datos[bit / 8] >> (bit % 8)) & 1;
+}
+
+static void escribirBit(uint8_t *datos, uint16_t bit, uint8_t valor) {
+	if (valor)
+		datos[bit / 8] |= (1 << (bit % 8));
+	else
+		datos[bit / 8] &= ~(1 << (bit % 8));
+}
+
+/**
+ *	@brief Período del timer en uS según TModeReg,
+ *		   TPrescalerReg y TReloadReg (sección 8.5).
+ */
+static uint32_t periodoTimerUs(sim_lector_t *l) {
+	uint32_t prescaler = ((l->registros[REG_TMODE] & 0x0F) << 8)
+			| l->registros[REG_TPRESCALER];
+	uint32_t reload = (l->registros[REG_TRELOADH] << 8) | l->registros[REG_TRELOADL];
+	return (uint32_t) (((uint64_t) (prescaler * 2 + 1) * (reload + 1)
+			* 1000000ULL) / FC_HZ);
+}
+
+/**
+ *	@brief Aplica el modelo del enlace de RF a una respuesta
+ *		   de las tarjetas. Los errores se agregan en los bytes
+ *		   completos de la respuesta: con ErrorReg.ParityErr, o
+ *		   uno de cada cuatro invirtiendo dos bits del byte.
+ *	@retval Falso si el receptor no detecta la respuesta.
+ */
+static bool_t aplicarEnlace(sim_lector_t *l, uint8_t *datos, uint16_t bits) {
+	if (l->atenuacionDb == 0 && l->ruidoDb == 0)
+		return true;
+
+	const uint8_t *r = l->registros;
+	int ganancia = GANANCIA_DB[(r[REG_RFCFG] >> 4) & 0x07];
+	int umbral = UMBRAL_BASE_DB + 2 * (r[REG_RXTHRESHOLD] >> 4);
+	int potencia = (r[REG_CWGSP] & 0x3F) * 6 / 63 + (r[REG_GSN] >> 4) * 6 / 15
+			- 12;
+	int senal = SENAL_BASE_DB + potencia - 2 * l->atenuacionDb + ganancia;
+	int ruido = RUIDO_BASE_DB + l->ruidoDb + ganancia;
+
+	if (!sucede(probabilidadMargen(senal - umbral)))
+		return false;
+
+	uint16_t errorByte = (1000 - probabilidadMargen(umbral - ruido)) / 2;
+	for (uint16_t i = 0; i < bits / 8; i++) {
+		if (!sucede(errorByte))
+			continue;
+		if (sucede(250))
+			datos[i] ^= 0x81;
+		else
+			l->registros[REG_ERROR] |= ERROR_PARITY;
+	}
+	return true;
+}
+
+/**
+ *	@brief Sorteo con un generador xorshift de 32 bits.
+ */
+static bool_t sucede(uint16_t probabilidadMil) {
+	if (probabilidadMil >= 1000)
+		return true;
+	if (probabilidadMil == 0)
+		return false;
+	estadoAleatorio ^= estadoAleatorio << 13;
+	estadoAleatorio ^= estadoAleatorio >> 17;
+	estadoAleatorio ^= estadoAleatorio << 5;
+	return estadoAleatorio % 1000 < probabilidadMil;
+}
+
+static uint16_t probabilidadMargen(int margenDb) {
+	if (margenDb <= -MARGEN_MAX_DB)
+		return 0;
+	if (margenDb >= MARGEN_MAX_DB)
+		return 1000;
+	return PROBABILIDAD_MARGEN[margenDb + MARGEN_MAX_DB];
+}
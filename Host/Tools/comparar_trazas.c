@@ -0,0 +1,182 @@
+/**
+ * @file comparar_trazas.c
+ * @brief Herramienta de PC que compara el costo en el bus de
+ * 		  trazas volcadas con traza_volcar (API_traza.h), para
+ * 		  detectar regresiones de rendimiento con transacciones
+ * 		  reales de un equipo.
+ *
+ * 		  Con un archivo, reproduce las transacciones SPI de cada
+ * 		  lector en el driver del MFRC522 de este árbol, mediante
+ * 		  el port API_mfrc522_port_replay.c: inicializa el lector y
+ * 		  lee UIDs con mfrc522_lectorLeerUID mientras el driver
+ * 		  avance en la traza, y compara las transacciones, los bytes
+ * 		  y el tiempo de bus con los grabados. El LCD no lee del bus,
+ * 		  por lo que de su traza solo se informa el costo grabado.
+ *
+ * 		  Con dos archivos, compara el costo grabado de ambos en
+ * 		  cada bus (por ejemplo, de dos versiones del firmware).
+ *
+ * 		  Termina con 1 si el tiempo de bus nuevo supera al grabado
+ * 		  en más de TOLERANCIA_PORCIENTO.
+ *
+ * 		  Compilación:
+ * 		  gcc -std=c11 -O2 -DAPI_PORT_HOST -IRC522_driver/Inc
+ * 		      -ILCD16x2_driver/Inc -IHost/Inc -ICommon/Inc
+ * 		      Host/Tools/comparar_trazas.c Host/Src/replay_traza.c
+ * 		      Host/Src/API_mfrc522_port_replay.c
+ * 		      Host/Src/host_plataforma.c RC522_driver/Src/API_mfrc522.c
+ * 		      -o comparar_trazas
+ *
+ * 		  Uso:
+ * 		  comparar_trazas traza.txt
+ * 		  comparar_trazas traza_anterior.txt traza_nueva.txt
+ */
+
+#include <stdio.h>
+#include "API_mfrc522.h"
+#include "API_mfrc522_port.h"
+#include "replay_traza.h"
+
+#define TOLERANCIA_PORCIENTO	1
+//máximo de lecturas por lector, por si el driver nunca termina la traza
+#define MAX_LECTURAS			100000
+
+static bool_t reproducir(const replay_traza_t*);
+static uint32_t reproducirLector(uint8_t);
+static bool_t compararTrazas(const replay_traza_t*, const replay_traza_t*);
+static void imprimirCosto(const char*, host_estadisticasBus_t);
+static bool_t imprimirDiferencia(host_estadisticasBus_t, host_estadisticasBus_t);
+
+int main(int argc, char *argv[]) {
+	if (argc != 2 && argc != 3) {
+		fprintf(stderr, "uso: %s <traza> [<traza_nueva>]\n", argv[0]);
+		return 2;
+	}
+
+	replay_traza_t trazas[2];
+	for (int i = 0; i < argc - 1; i++) {
+		if (!replay_cargar(argv[i + 1], &trazas[i]))
+			return 2;
+		printf("%s: %lu transacciones", argv[i + 1],
+				(unsigned long) trazas[i].cantidad);
+		if (trazas[i].descartadas > 0)
+			printf(" (el equipo descarto %lu por falta de lugar)",
+					(unsigned long) trazas[i].descartadas);
+		printf("\n");
+	}
+	printf("\n%-24s %8s %9s %12s\n", "", "trans", "bytes", "bus[us]");
+
+	bool_t regresion = (argc == 2) ?
+			reproducir(&trazas[0]) : compararTrazas(&trazas[0], &trazas[1]);
+	for (int i = 0; i < argc - 1; i++)
+		replay_liberar(&trazas[i]);
+	return regresion ? 1 : 0;
+}
+
+/**
+ *	@brief Reproduce la traza de cada lector y compara el
+ *		   costo en el bus SPI con el grabado.
+ */
+static bool_t reproducir(const replay_traza_t *traza) {
+	uint32_t lectores = replay_lectores(traza);
+	bool_t regresion = false;
+
+	host_reiniciar();
+	replay_iniciar(traza);
+	for (uint8_t i = 0; i < MFRC522_CANTIDAD_LECTORES; i++) {
+		if (!(lectores & (1UL << i)))
+			continue;
+		host_borrarContadores();
+		uint32_t leidas = reproducirLector(i);
+		replay_resultado_t resultado = replay_resultado(i);
+
+		printf("lector %u (%lu UIDs leidos)\n", i, (unsigned long) leidas);
+		host_estadisticasBus_t grabado = replay_costo(traza, HOST_BUS_SPI, i);
+		host_estadisticasBus_t reproducido = host_leerBus(HOST_BUS_SPI);
+		imprimirCosto("  SPI grabado", grabado);
+		imprimirCosto("  SPI reproducido", reproducido);
+		regresion |= imprimirDiferencia(grabado, reproducido);
+		printf("  coincidentes %lu, agregadas %lu, omitidas %lu,"
+				" sin reproducir %lu\n",
+				(unsigned long) resultado.coincidentes,
+				(unsigned long) resultado.agregadas,
+				(unsigned long) resultado.omitidas,
+				(unsigned long) resultado.pendientes);
+	}
+	if (lectores >> MFRC522_CANTIDAD_LECTORES)
+		printf("la traza tiene lectores fuera de MFRC522_CANTIDAD_LECTORES\n");
+
+	host_estadisticasBus_t i2c = replay_costo(traza, HOST_BUS_I2C, REPLAY_TODOS);
+	if (i2c.transacciones > 0) {
+		printf("displays\n");
+		imprimirCosto("  I2C grabado", i2c);
+	}
+	return regresion;
+}
+
+/**
+ *	@brief Inicializa el lector y lee UIDs mientras queden
+ *		   transacciones del lector y el driver avance en la traza.
+ *	@retval Cantidad de UIDs leídos.
+ */
+static uint32_t reproducirLector(uint8_t indice) {
+	mfrc522_t lector;
+	mfrc522_uid_t uid;
+	uint32_t leidas = 0;
+
+	mfrc522_lectorInit(&lector, indice);
+	for (uint32_t i = 0; i < MAX_LECTURAS && replay_pendiente(indice); i++) {
+		uint32_t pendientes = replay_resultado(indice).pendientes;
+		if (mfrc522_lectorLeerUID(&lector, &uid))
+			leidas++;
+		if (replay_resultado(indice).pendientes == pendientes)
+			break;
+	}
+	return leidas;
+}
+
+static bool_t compararTrazas(const replay_traza_t *anterior,
+		const replay_traza_t *nueva) {
+	static const char *const NOMBRES[HOST_CANTIDAD_BUSES] = { "SPI", "I2C" };
+	bool_t regresion = false;
+	char nombre[32];
+
+	for (uint8_t bus = 0; bus < HOST_CANTIDAD_BUSES; bus++) {
+		host_estadisticasBus_t costoAnterior = replay_costo(anterior,
+				(host_bus_enum) bus, REPLAY_TODOS);
+		host_estadisticasBus_t costoNuevo = replay_costo(nueva,
+				(host_bus_enum) bus, REPLAY_TODOS);
+		snprintf(nombre, sizeof(nombre), "%s anterior", NOMBRES[bus]);
+		imprimirCosto(nombre, costoAnterior);
+		snprintf(nombre, sizeof(nombre), "%s nueva", NOMBRES[bus]);
+		imprimirCosto(nombre, costoNuevo);
+		regresion |= imprimirDiferencia(costoAnterior, costoNuevo);
+	}
+	return regresion;
+}
+
+static void imprimirCosto(const char *nombre, host_estadisticasBus_t costo) {
+	printf("%-24s %8lu %9lu %12.1f\n", nombre,
+			(unsigned long) costo.transacciones, (unsigned long) costo.bytes,
+			costo.tiempoNs / 1000.0);
+}
+
+/**
+ *	@brief Imprime la diferencia y la variación del tiempo de bus.
+ *	@retval Verdadero si el tiempo nuevo supera al grabado en
+ *			más de TOLERANCIA_PORCIENTO.
+ */
+static bool_t imprimirDiferencia(host_estadisticasBus_t grabado,
+		host_estadisticasBus_t nuevo) {
+	double variacion = grabado.tiempoNs == 0 ? 0 :
+			100.0 * ((double) nuevo.tiempoNs - grabado.tiempoNs)
+					/ grabado.tiempoNs;
+	bool_t regresion = variacion > TOLERANCIA_PORCIENTO
+			|| (grabado.tiempoNs == 0 && nuevo.tiempoNs > 0);
+	printf("%-24s %+8ld %+9ld %+12.1f (%+.1f%%)%s\n", "  diferencia",
+			(long) nuevo.transacciones - (long) grabado.transacciones,
+			(long) nuevo.bytes - (long) grabado.bytes,
+			((double) nuevo.tiempoNs - grabado.tiempoNs) / 1000.0, variacion,
+			regresion ? " REGRESION" : "");
+	return regresion;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file gen_tabla_accesos.c
+ * @brief Herramienta de PC que genera, a partir de una
+ * 		  lista de UIDs, un archivo .c con una tabla estática
+ * 		  de accesos (accesos_tablaEstatica_t) para guardar
+ * 		  en flash.
+ *
+ * 		  Cada línea de la entrada es un UID en hexadecimal
+ * 		  (4, 7 o 10 bytes), con o sin separadores ':' o ' '.
+ * 		  Las líneas vacías y las que empiezan con '#' se ignoran.
+ *
+ * 		  Compilación:
+ * 		  gcc -std=c11 -O2 -IRC522_driver/Inc -IHost/Inc
+ * 		      Host/Tools/gen_tabla_accesos.c
+ * 		      Host/Src/constructor_accesos.c
+ * 		      RC522_driver/Src/API_accesos.c -o gen_tabla_accesos
+ *
+ * 		  Uso:
+ * 		  gen_tabla_accesos <nombre> < uids.txt > tabla_nombre.c
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "constructor_accesos.h"
+
+#define LARGO_LINEA				128
+
+static bool_t leerUID(const char*, accesos_entrada_t*);
+static int valorHex(char);
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fprintf(stderr, "uso: %s <nombre> < uids.txt > tabla.c\n", argv[0]);
+		return 1;
+	}
+	const char *nombre = argv[1];
+
+	accesos_entrada_t *uids = NULL;
+	uint32_t cantidad = 0, capacidad = 0;
+	char linea[LARGO_LINEA];
+	uint32_t numeroLinea = 0;
+
+	while (fgets(linea, sizeof(linea), stdin) != NULL) {
+		numeroLinea++;
+		char *c = linea;
+		while (isspace((unsigned char) *c))
+			c++;
+		if (*c == '\0' || *c == '#')
+			continue;
+
+		accesos_entrada_t uid = { 0 };
+		if (!leerUID(c, &uid)) {
+			fprintf(stderr, "linea %lu: UID invalido\n",
+					(unsigned long) numeroLinea);
+			return 1;
+		}
+		if (cantidad == capacidad) {
+			capacidad = capacidad ? capacidad * 2 : 64;
+			uids = realloc(uids, capacidad * sizeof(accesos_entrada_t));
+			if (uids == NULL) {
+				fprintf(stderr, "sin memoria\n");
+				return 1;
+			}
+		}
+		uids[cantidad++] = uid;
+	}
+	if (cantidad == 0) {
+		fprintf(stderr, "la lista de UIDs esta vacia\n");
+		return 1;
+	}
+
+	// Se descartan los repetidos con una tabla dinámica auxiliar
+	uint32_t capacidadAux = 1;
+	while (capacidadAux * ACCESOS_CARGA_MAXIMA < (cantidad + 1) * 100)
+		capacidadAux <<= 1;
+	accesos_entrada_t *almacenamiento = malloc(
+			capacidadAux * sizeof(accesos_entrada_t));
+	accesos_tabla_t unicos;
+	if (almacenamiento == NULL
+			|| !accesos_tablaInit(&unicos, almacenamiento, capacidadAux)) {
+		fprintf(stderr, "sin memoria\n");
+		return 1;
+	}
+	uint32_t distintos = 0;
+	for (uint32_t i = 0; i < cantidad; i++) {
+		if (accesos_tablaBuscar(&unicos, uids[i].uid, uids[i].largo))
+			continue;
+		accesos_tablaAgregar(&unicos, uids[i].uid, uids[i].largo);
+		uids[distintos++] = uids[i];
+	}
+	free(almacenamiento);
+
+	accesos_tablaEstatica_t tabla;
+	if (!constructor_construir(&tabla, uids, distintos)) {
+		fprintf(stderr, "no se pudo construir la tabla\n");
+		return 1;
+	}
+
+	printf("/**\n * @file tabla_%s.c\n", nombre);
+	printf(" * @brief Tabla de accesos generada por gen_tabla_accesos.\n");
+	printf(" * 		  %lu UIDs. No editar.\n */\n\n",
+			(unsigned long) distintos);
+	printf("#include \"API_accesos.h\"\n\n");
+
+	printf("static const uint16_t desplazamientos_%s[%lu] = {", nombre,
+			(unsigned long) tabla.cantidadGrupos);
+	for (uint32_t g = 0; g < tabla.cantidadGrupos; g++) {
+		printf("%s%u,", (g % 12) ? " " : "\n\t", tabla.desplazamientos[g]);
+	}
+	printf("\n};\n\n");
+
+	printf("static const accesos_entrada_t entradas_%s[%lu] = {", nombre,
+			(unsigned long) tabla.tamano);
+	for (uint32_t p = 0; p < tabla.tamano; p++) {
+		const accesos_entrada_t *e = &tabla.entradas[p];
+		printf("\n\t{ %u, {", e->largo);
+		if (e->largo == 0)
+			printf(" 0");
+		for (uint8_t i = 0; i < e->largo; i++)
+			printf("%s0x%02X", i ? ", " : " ", e->uid[i]);
+		printf(" } },");
+	}
+	printf("\n};\n\n");
+
+	printf("const accesos_tablaEstatica_t %s = {\n", nombre);
+	printf("\t.semilla = %luUL,\n", (unsigned long) tabla.semilla);
+	printf("\t.cantidadGrupos = %luUL,\n",
+			(unsigned long) tabla.cantidadGrupos);
+	printf("\t.tamano = %luUL,\n", (unsigned long) tabla.tamano);
+	printf("\t.desplazamientos = desplazamientos_%s,\n", nombre);
+	printf("\t.entradas = entradas_%s,\n};\n", nombre);
+
+	constructor_liberar(&tabla);
+	free(uids);
+	return 0;
+}
+
+/**
+ *	@brief Interpreta un UID en hexadecimal.
+ *	@retval Falso si el UID no tiene 4, 7 o 10 bytes.
+ */
+static bool_t leerUID(const char *texto, accesos_entrada_t *uid) {
+	int alto = -1;
+	for (const char *c = texto; *c != '\0' && *c != '#'; c++) {
+		if (*c == ':' || isspace((unsigned char) *c))
+			continue;
+		int valor = valorHex(*c);
+		if (valor < 0)
+			return false;
+		if (alto < 0) {
+			alto = valor;
+			continue;
+		}
+		if (uid->largo == MFRC522_UID_MAX)
+			return false;
+		uid->uid[uid->largo++] = (uint8_t) ((alto << 4) | valor);
+		alto = -1;
+	}
+	return alto < 0
+			&& (uid->largo == 4 || uid->largo == 7 || uid->largo == 10);
+}
+
+static int valorHex(char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	c = (char) toupper((unsigned char) c);
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
@@ -9,22 +9,124 @@
 #define API_INC_API_LCD_H_
 
 #include "API_lcd_port.h"
+#include "API_lcd_glifos.h"
+#include "API_lcd_formato.h"
 
-//constantes para cantidad de filas y columnas de un lcd 16x2
+//constantes para cantidad de filas y columnas de un lcd 16x2 (display por defecto)
 #define LCD_CANTIDAD_COLUMNAS			16
 #define LCD_CANTIDAD_FILAS				2
 
-//constantes para la posición inicial de cada fila
+//dirección I2C de 7 bits y bus del display por defecto
+#define LCD_ADDRESS						0x27
+#define LCD_BUS							0
+
+//geometría máxima de un display (el HD44780 maneja hasta 80 caracteres)
+#define LCD_MAX_COLUMNAS				20
+#define LCD_MAX_FILAS					4
+
+//constantes para la posición inicial de cada fila. En los displays de
+//4 filas la fila 3 continúa a la fila 1 y la fila 4 a la fila 2.
 #define LCD_FILA_1						0x00
 #define LCD_FILA_2						0x40
+#define LCD_FILA_3(columnas)			(LCD_FILA_1 + (columnas))
+#define LCD_FILA_4(columnas)			(LCD_FILA_2 + (columnas))
+
+//cantidad de posiciones de DDRAM de cada fila (modo de 2 lineas). Es el
+//largo máximo del texto de una marquesina.
+#define LCD_COLUMNAS_DDRAM				40
+
+//período máximo de la marquesina: la marca de tiempo del port es el contador
+//de ciclos, que da la vuelta cada ~51 S a 84 MHz
+#define LCD_MAX_PERIODO_MARQUESINA_MS	10000
+
+//cantidad de mensajes (comandos o caracteres) que admite la cola asíncrona
+#define LCD_TAMANO_COLA					64
+
+//con 1, al finalizar cada transferencia asíncrona se inicia la siguiente
+//desde la interrupción del I2C, sin esperar al próximo LCD_process
+#define LCD_ENCADENAR_IRQ				1
+
+//cantidad máxima de displays que comparten un bus I2C
+#define LCD_MAX_DISPLAYS_BUS			4
+
+//cantidad máxima de mensajes que se envían a un display en cada turno
+//del bus. Con varios displays en el bus, limita lo que un display
+//demora a los demás.
+#define LCD_MENSAJES_POR_TURNO			16
 
 /**
  * @brief Enum para devolver resultado de acciones del LCD.
+ * 		  LCD_BUSY indica que hay operaciones asíncronas pendientes.
  */
 typedef enum {
-	LCD_OK, LCD_ERROR
+	LCD_OK, LCD_ERROR, LCD_BUSY
 } LCD_StatusTypedef;
 
+/**
+ * @brief Tipo de función que se llama cuando se vacía la
+ * 		  cola asíncrona (LCD_OK) o falla una transferencia
+ * 		  (LCD_ERROR). Puede llamarse desde una interrupción.
+ */
+typedef void (*LCD_CallbackTypedef)(LCD_StatusTypedef);
+
+/**
+ * @brief Mensaje de la cola asíncrona: comando (rs = 0)
+ * 		  o dato (rs = 1).
+ */
+typedef struct {
+	uint8_t dato;
+	uint8_t rs;
+} LCD_MensajeTypedef;
+
+/**
+ * @brief Estado de un display. Cada display tiene su dirección,
+ * 		  bus, geometría y backlight, sus buffers de pantalla y
+ * 		  su cola asíncrona. Se inicializa con LCD_displayInit y
+ * 		  no debe modificarse directamente.
+ *
+ * 		  bufferPantalla guarda lo que se quiere mostrar y
+ * 		  contenidoLCD lo que efectivamente muestra el display;
+ * 		  LCD_flush envía únicamente las diferencias entre ambos.
+ * 		  La cola circular de mensajes la llenan las funciones
+ * 		  *Async (productor) y la vacía el bus (consumidor), por
+ * 		  lo que cada índice es modificado por un solo lado. Si un
+ * 		  lote termina con un comando lento, el display no vuelve
+ * 		  a recibir el bus hasta que pasan tiempoEspera uS desde
+ * 		  marcaEspera.
+ *
+ * 		  glifoCgram indica el glifo propio cargado en cada
+ * 		  posición de la CGRAM y usoCgram el valor de relojCgram
+ * 		  en su último uso, para reemplazar el menos usado.
+ */
+typedef struct {
+	uint8_t bus;
+	uint8_t direccion;				//dirección I2C de 7 bits del PCF8574
+	uint8_t columnas;
+	uint8_t filas;
+	uint8_t backLight;				//1 = encendido, 0 = apagado
+	uint8_t direccionFila[LCD_MAX_FILAS];
+	char bufferPantalla[LCD_MAX_FILAS][LCD_MAX_COLUMNAS];
+	char contenidoLCD[LCD_MAX_FILAS][LCD_MAX_COLUMNAS];
+	uint8_t cursorFila;
+	uint8_t cursorColumna;
+	LCD_MensajeTypedef colaMensajes[LCD_TAMANO_COLA];
+	volatile uint16_t inicioCola;	//próximo mensaje a enviar
+	volatile uint16_t finCola;		//próxima posición libre
+	volatile uint32_t marcaEspera;
+	volatile uint16_t tiempoEspera;
+	volatile bool_t errorAsync;
+	volatile bool_t contenidoInvalido;
+	volatile bool_t envioPendiente;
+	LCD_CallbackTypedef callback;
+	uint8_t glifoCgram[LCD_CANTIDAD_CGRAM];
+	uint16_t usoCgram[LCD_CANTIDAD_CGRAM];
+	uint16_t relojCgram;
+	bool_t marquesinaActiva;
+	uint32_t periodoMarquesinaMs;
+	uint32_t marcaMarquesina;
+	uint32_t glifosMarquesina;
+} LCD_HandleTypedef;
+
 /**
  *	@brief Realiza la inicialización del LCD para
  *		   que quede listo para ser utilizado.
@@ -41,7 +143,8 @@ LCD_StatusTypedef LCD_clear();
 
 /**
  *	@brief Coloca un único caracter en
- *		   la pantalla del LCD.
+ *		   la pantalla del LCD. Los caracteres
+ *		   0x80 a 0xFF se toman como Latin-1.
  *	@retval Estado de ejecución.
  */
 LCD_StatusTypedef LCD_printChar(char);
@@ -49,20 +152,119 @@ LCD_StatusTypedef LCD_printChar(char);
 /**
  *	@brief Escribe un texto en la pantalla del LCD,
  *		   comenzando desde la FILA 1 y posición 0.
+ *		   Los textos pueden estar en UTF-8 o Latin-1 (ver
+ *		   LCD_bufferWrite).
  *		   Si detecta el caracter '\n', pasa a la
- *		   siguiente linea.
+ *		   siguiente linea. Solo envía al LCD
+ *		   los caracteres que cambiaron respecto
+ *		   de lo que ya se muestra.
  *	@retval Estado de ejecución.
  */
-LCD_StatusTypedef LCD_printText(char*);
+LCD_StatusTypedef LCD_printText(const char*);
+
+/**
+ *	@brief Versión de LCD_printText con formato (ver
+ *		   API_lcd_formato.h). El texto se genera directamente
+ *		   en el buffer de pantalla, sin buffers intermedios.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_printf(const char*, ...);
+
+/**
+ *	@brief Escribe un texto con formato en (fila, posición),
+ *		   sin borrar el resto de la pantalla. El texto queda
+ *		   dentro de la fila: lo que no entra se descarta y
+ *		   el caracter '\n' termina la escritura. Solo envía
+ *		   los caracteres que cambiaron.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_printAt(uint8_t, uint8_t, const char*, ...);
+
+/**
+ *	@brief Escribe en (fila, posición) los caracteres indicados
+ *		   del texto, que no necesita terminar en NULL_CHAR. Sigue
+ *		   las reglas de LCD_printAt.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_writeSpan(uint8_t, uint8_t, const char*, size_t);
 
 /**
  *	@brief Posiciona el cursor del LCD
  *		   en la posición indica por los
- *		   argumentos de la función.
+ *		   argumentos de la función: fila
+ *		   (LCD_FILA_1 o LCD_FILA_2) y posición
+ *		   dentro de la fila.
  *	@retval Estado de ejecución.
  */
 LCD_StatusTypedef LCD_setCursor(uint8_t, uint8_t);
 
+/**
+ *	@brief Borra el buffer de pantalla en RAM
+ *		   (lo llena con espacios). No envía nada
+ *		   al LCD hasta que se llame a LCD_flush.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_bufferClear();
+
+/**
+ *	@brief Escribe un texto en el buffer de pantalla
+ *		   en RAM, comenzando en (fila, posición). Sigue
+ *		   las mismas reglas que LCD_printText para el
+ *		   caracter '\n' y el salto de linea. No envía
+ *		   nada al LCD hasta que se llame a LCD_flush.
+ *		   Las secuencias UTF-8 de los caracteres Latin-1
+ *		   se convierten a Latin-1. Al enviarlos, los que no
+ *		   están en la ROM del display se muestran con glifos
+ *		   propios cargados en la CGRAM (ver API_lcd_glifos.h).
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_bufferWrite(uint8_t, uint8_t, const char*);
+
+/**
+ *	@brief Compara el buffer de pantalla con lo que
+ *		   muestra el LCD y envía solo los caracteres
+ *		   que cambiaron.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_flush();
+
+/**
+ *	@brief Versión asíncrona de LCD_flush. Agrega a la cola
+ *		   los mensajes necesarios para actualizar el LCD y
+ *		   retorna sin esperar a que se envíen.
+ *	@retval LCD_OK si se encolaron todos los cambios, LCD_BUSY
+ *			si la cola se llenó (los cambios restantes se
+ *			encolan en la próxima llamada) o LCD_ERROR.
+ */
+LCD_StatusTypedef LCD_flushAsync();
+
+/**
+ *	@brief Versión asíncrona de LCD_printText.
+ *	@retval Igual que LCD_flushAsync.
+ */
+LCD_StatusTypedef LCD_printTextAsync(const char*);
+
+/**
+ *	@brief Versión asíncrona de LCD_clear.
+ *	@retval LCD_OK si se encoló el comando, LCD_BUSY si
+ *			la cola está llena.
+ */
+LCD_StatusTypedef LCD_clearAsync();
+
+/**
+ *	@brief Avanza el envío de la cola asíncrona. Debe llamarse
+ *		   periódicamente desde el loop principal. Nunca bloquea.
+ *	@retval LCD_OK si la cola está vacía, LCD_BUSY si quedan
+ *			mensajes pendientes o LCD_ERROR si falló una transferencia.
+ */
+LCD_StatusTypedef LCD_process();
+
+/**
+ *	@brief Configura la función que se llama cuando se
+ *		   completa la cola asíncrona o falla una transferencia.
+ */
+void LCD_setCallback(LCD_CallbackTypedef);
+
 /**
  *	@brief Muestra un cursor que parpadea en
  *		   la pantalla del LCD.
@@ -76,4 +278,113 @@ LCD_StatusTypedef LCD_cursorOn();
  */
 LCD_StatusTypedef LCD_cursorOff();
 
+/**
+ *	@brief Enciende (verdadero) o apaga el
+ *		   backlight del LCD.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_backlight(bool_t);
+
+/**
+ *	@brief Escribe un texto de hasta LCD_COLUMNAS_DDRAM caracteres
+ *		   en toda la linea de DDRAM de la fila (LCD_FILA_1 o
+ *		   LCD_FILA_2), completando con espacios. Solo se ven las
+ *		   primeras columnas hasta que se inicia la marquesina.
+ *		   Solo para displays de hasta 2 filas.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_marquesinaEscribir(uint8_t, const char*);
+
+/**
+ *	@brief Inicia el desplazamiento del display, un paso
+ *		   cada el período indicado en mS. El desplazamiento
+ *		   lo hace el controlador y mueve todas las filas a la
+ *		   vez, por lo que las filas que deban desplazarse se
+ *		   escriben con LCD_marquesinaEscribir. Como la linea de
+ *		   DDRAM es circular, el texto se repite cada
+ *		   LCD_COLUMNAS_DDRAM pasos.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_marquesinaIniciar(uint32_t);
+
+/**
+ *	@brief Si pasó el período desde el paso anterior, encola
+ *		   un único comando de desplazamiento, que se envía con
+ *		   LCD_process. Debe llamarse periódicamente desde el loop
+ *		   principal. Nunca bloquea.
+ *	@retval LCD_OK si se encoló un paso, LCD_BUSY si todavía no
+ *			corresponde o la cola está llena, o LCD_ERROR si no
+ *			hay una marquesina activa.
+ */
+LCD_StatusTypedef LCD_marquesinaTick();
+
+/**
+ *	@brief Detiene la marquesina y vuelve el display a su
+ *		   posición original (comando RETURN_HOME).
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_marquesinaDetener();
+
+/**
+ *	@brief Funciones para manejar varios displays. Las funciones
+ *		   anteriores operan sobre el display por defecto (LCD_BUS,
+ *		   LCD_ADDRESS, 16x2) y cada una tiene su versión LCD_display*
+ *		   que recibe el display como primer argumento.
+ *
+ *		   Los displays de un mismo bus comparten la transferencia
+ *		   asíncrona: el bus atiende por turnos a los displays con
+ *		   mensajes pendientes, enviando en cada turno un lote de
+ *		   hasta LCD_MENSAJES_POR_TURNO mensajes. Mientras un display
+ *		   ejecuta un comando lento, el bus atiende a los demás.
+ */
+
+/**
+ *	@brief Inicializa un display con su bus, su dirección I2C
+ *		   de 7 bits y su geometría (columnas, filas), y lo agrega
+ *		   a los displays atendidos por el bus.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayInit(LCD_HandleTypedef*, uint8_t, uint8_t,
+		uint8_t, uint8_t);
+LCD_StatusTypedef LCD_displayClear(LCD_HandleTypedef*);
+LCD_StatusTypedef LCD_displayPrintChar(LCD_HandleTypedef*, char);
+LCD_StatusTypedef LCD_displayPrintText(LCD_HandleTypedef*, const char*);
+LCD_StatusTypedef LCD_displayPrintf(LCD_HandleTypedef*, const char*, ...);
+LCD_StatusTypedef LCD_displayPrintAt(LCD_HandleTypedef*, uint8_t, uint8_t,
+		const char*, ...);
+LCD_StatusTypedef LCD_displayWriteSpan(LCD_HandleTypedef*, uint8_t, uint8_t,
+		const char*, size_t);
+
+/**
+ *	@brief La fila es la dirección de inicio de la fila:
+ *		   LCD_FILA_1, LCD_FILA_2, LCD_FILA_3(columnas)
+ *		   o LCD_FILA_4(columnas).
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displaySetCursor(LCD_HandleTypedef*, uint8_t, uint8_t);
+LCD_StatusTypedef LCD_displayBufferClear(LCD_HandleTypedef*);
+LCD_StatusTypedef LCD_displayBufferWrite(LCD_HandleTypedef*, uint8_t,
+		uint8_t, const char*);
+LCD_StatusTypedef LCD_displayFlush(LCD_HandleTypedef*);
+LCD_StatusTypedef LCD_displayFlushAsync(LCD_HandleTypedef*);
+LCD_StatusTypedef LCD_displayPrintTextAsync(LCD_HandleTypedef*, const char*);
+LCD_StatusTypedef LCD_displayClearAsync(LCD_HandleTypedef*);
+
+/**
+ *	@brief Avanza la cola asíncrona de todos los displays del
+ *		   bus del display indicado, e informa el estado de la
+ *		   cola de ese display. Nunca bloquea.
+ *	@retval Igual que LCD_process.
+ */
+LCD_StatusTypedef LCD_displayProcess(LCD_HandleTypedef*);
+void LCD_displaySetCallback(LCD_HandleTypedef*, LCD_CallbackTypedef);
+LCD_StatusTypedef LCD_displayCursorOn(LCD_HandleTypedef*);
+LCD_StatusTypedef LCD_displayCursorOff(LCD_HandleTypedef*);
+LCD_StatusTypedef LCD_displayBacklight(LCD_HandleTypedef*, bool_t);
+LCD_StatusTypedef LCD_displayMarquesinaEscribir(LCD_HandleTypedef*, uint8_t,
+		const char*);
+LCD_StatusTypedef LCD_displayMarquesinaIniciar(LCD_HandleTypedef*, uint32_t);
+LCD_StatusTypedef LCD_displayMarquesinaTick(LCD_HandleTypedef*);
+LCD_StatusTypedef LCD_displayMarquesinaDetener(LCD_HandleTypedef*);
+
 #endif /* API_INC_API_LCD_H_ */
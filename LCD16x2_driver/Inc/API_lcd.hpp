@@ -0,0 +1,218 @@
+/**
+ * @file API_lcd.hpp
+ * @brief Interfaz en C++, solo de encabezado, para escribir en
+ * 		  un display HD44780 con adaptador PCF8574. Cada display
+ * 		  es un tipo Lcd<Bus, Address, Cols, Rows>: el bus, la
+ * 		  dirección I2C y la geometría son parámetros del template,
+ * 		  por lo que la secuencia de inicialización ya codificada
+ * 		  para el PCF8574, las direcciones de DDRAM de cada fila y
+ * 		  los límites del cursor se calculan al compilar. Varios
+ * 		  displays son tipos distintos, sin handle ni punteros a
+ * 		  funciones; el único estado es el del backlight.
+ *
+ * 		  Las funciones son bloqueantes y escriben el texto sin
+ * 		  traducir (ASCII y los códigos de la ROM del display). El
+ * 		  buffer de pantalla, la cola asíncrona, los glifos Latin-1,
+ * 		  la marquesina y LCD_printf están en el driver en C
+ * 		  (API_lcd.h).
+ *
+ * 		  Bus debe proveer:
+ * 		  - static bool iniciar();
+ * 		  - static bool escribir(uint8_t direccion, const uint8_t *datos,
+ * 		    uint16_t largo); en una única transacción I2C.
+ * 		  - static void esperarUs(uint32_t us);
+ *
+ * 		  En API_lcd_port.hpp está el del STM32F4.
+ */
+
+#ifndef API_INC_API_LCD_HPP_
+#define API_INC_API_LCD_HPP_
+
+extern "C" {
+#include "API_lcd.h"
+}
+
+namespace lcd {
+
+//comandos del HD44780 (Tabla 6 de la hoja de datos)
+constexpr uint8_t CLR_LCD = 0x01;
+constexpr uint8_t ENTRY_MODE_INCREMENTO = 0x06;
+constexpr uint8_t DISPLAY_CONTROL = 0x08;
+constexpr uint8_t DISPLAY_ON = 0x04;
+constexpr uint8_t MODO_4_BITS = 0x28;			//4 bits, 2 filas, 5x8
+constexpr uint8_t SET_CURSOR = 0x80;
+
+//bits del PCF8574 conectados al display
+constexpr uint8_t RS = 1 << 0;
+constexpr uint8_t ENABLE = 1 << 2;
+constexpr uint8_t BACKLIGHT = 1 << 3;
+
+constexpr uint8_t BYTES_POR_MSG = 4;	//2 nibbles con flanco de ENABLE
+
+//tiempos de la hoja de datos (Figura 24 y Tabla 6)
+constexpr uint32_t DELAY_ENCENDIDO_US = 20000;
+constexpr uint32_t DELAY_INIT_1_US = 4100;
+constexpr uint32_t DELAY_INIT_2_US = 100;
+constexpr uint32_t TIEMPO_CLEAR_US = 1520;
+
+/**
+ *   @brief Secuencia de bytes del PCF8574. Como es un tipo
+ *          literal, una secuencia constante se arma al compilar.
+ */
+template<uint16_t Largo>
+struct Secuencia {
+	uint8_t bytes[Largo];
+	uint16_t largo;
+
+	constexpr void agregarNibble(uint8_t nibble, uint8_t control) {
+		uint8_t valor = control | (uint8_t) (nibble << 4);
+		bytes[largo++] = valor | ENABLE;
+		bytes[largo++] = valor;
+	}
+
+	constexpr void agregarMsg(uint8_t dato, uint8_t control) {
+		agregarNibble(dato >> 4, control);
+		agregarNibble(dato & 0x0F, control);
+	}
+};
+
+/**
+ *   @brief Comandos de configuración que se envían luego de
+ *          pasar al modo de 4 bits, con el backlight encendido.
+ *          El CLR_LCD final requiere TIEMPO_CLEAR_US.
+ */
+constexpr uint8_t COMANDOS_INIT[] = { MODO_4_BITS, DISPLAY_CONTROL,
+		ENTRY_MODE_INCREMENTO, DISPLAY_CONTROL | DISPLAY_ON, CLR_LCD };
+
+constexpr Secuencia<sizeof(COMANDOS_INIT) * BYTES_POR_MSG> secuenciaInit() {
+	Secuencia<sizeof(COMANDOS_INIT) * BYTES_POR_MSG> secuencia { };
+	for (uint8_t comando : COMANDOS_INIT)
+		secuencia.agregarMsg(comando, BACKLIGHT);
+	return secuencia;
+}
+
+constexpr auto SECUENCIA_INIT = secuenciaInit();
+
+} /* namespace lcd */
+
+/**
+ *   @brief Display conectado al bus Bus en la dirección de
+ *          7 bits Address, con Cols columnas y Rows filas.
+ */
+template<class Bus, uint8_t Address, uint8_t Cols, uint8_t Rows>
+class Lcd {
+	static_assert(Cols > 0 && Cols <= LCD_MAX_COLUMNAS,
+			"cantidad de columnas no soportada");
+	static_assert(Rows > 0 && Rows <= LCD_MAX_FILAS,
+			"cantidad de filas no soportada");
+	static_assert(Address < 0x80, "la dirección I2C es de 7 bits");
+
+public:
+	Lcd() = delete;
+
+	/**
+	 *   @brief Inicializa el bus y el display en modo de 4 bits
+	 *          (Figura 24 de la hoja de datos) y limpia la pantalla.
+	 */
+	static bool init() {
+		if (!Bus::iniciar())
+			return false;
+		luz = true;
+		Bus::esperarUs(lcd::DELAY_ENCENDIDO_US);
+		if (!enviarNibble(0x03))
+			return false;
+		Bus::esperarUs(lcd::DELAY_INIT_1_US);
+		if (!enviarNibble(0x03))
+			return false;
+		Bus::esperarUs(lcd::DELAY_INIT_2_US);
+		if (!enviarNibble(0x02))
+			return false;
+		if (!Bus::escribir(Address, lcd::SECUENCIA_INIT.bytes,
+				lcd::SECUENCIA_INIT.largo))
+			return false;
+		Bus::esperarUs(lcd::TIEMPO_CLEAR_US);
+		return true;
+	}
+
+	static bool clear() {
+		if (!enviar(lcd::CLR_LCD, 0))
+			return false;
+		Bus::esperarUs(lcd::TIEMPO_CLEAR_US);
+		return true;
+	}
+
+	/**
+	 *   @brief Ubica el cursor. La dirección de DDRAM de cada
+	 *          fila depende de Cols y se calcula al compilar.
+	 */
+	static bool setCursor(uint8_t fila, uint8_t columna) {
+		if (fila >= Rows || columna >= Cols)
+			return false;
+		return enviar(lcd::SET_CURSOR | (DIRECCION_FILA[fila] + columna), 0);
+	}
+
+	static bool printChar(char caracter) {
+		return enviar((uint8_t) caracter, lcd::RS);
+	}
+
+	/**
+	 *   @brief Escribe el texto desde la posición del cursor,
+	 *          hasta Cols caracteres, en una única transacción.
+	 */
+	static bool printText(const char *texto) {
+		lcd::Secuencia<Cols * lcd::BYTES_POR_MSG> secuencia { };
+		for (uint8_t i = 0; i < Cols && texto[i] != '\0'; i++)
+			secuencia.agregarMsg((uint8_t) texto[i], lcd::RS | control());
+		if (secuencia.largo == 0)
+			return true;
+		return Bus::escribir(Address, secuencia.bytes, secuencia.largo);
+	}
+
+	/**
+	 *   @brief Escribe hasta largo caracteres del texto desde
+	 *          la posición indicada, sin pasar del fin de la fila.
+	 *          El cursor y el texto van en una única transacción.
+	 */
+	static bool writeSpan(uint8_t fila, uint8_t columna, const char *texto,
+			size_t largo) {
+		if (fila >= Rows || columna >= Cols)
+			return false;
+		lcd::Secuencia<(Cols + 1) * lcd::BYTES_POR_MSG> secuencia { };
+		secuencia.agregarMsg(lcd::SET_CURSOR | (DIRECCION_FILA[fila] + columna),
+				control());
+		for (uint8_t i = 0; i < largo && columna + i < Cols && texto[i] != '\0';
+				i++)
+			secuencia.agregarMsg((uint8_t) texto[i], lcd::RS | control());
+		return Bus::escribir(Address, secuencia.bytes, secuencia.largo);
+	}
+
+	static bool backlight(bool encendido) {
+		luz = encendido;
+		const uint8_t valor = control();
+		return Bus::escribir(Address, &valor, 1);
+	}
+
+private:
+	static constexpr uint8_t DIRECCION_FILA[LCD_MAX_FILAS] = { LCD_FILA_1,
+			LCD_FILA_2, LCD_FILA_3(Cols), LCD_FILA_4(Cols) };
+
+	static inline bool luz = true;
+
+	static uint8_t control() {
+		return luz ? lcd::BACKLIGHT : 0;
+	}
+
+	static bool enviar(uint8_t dato, uint8_t rs) {
+		lcd::Secuencia<lcd::BYTES_POR_MSG> secuencia { };
+		secuencia.agregarMsg(dato, rs | control());
+		return Bus::escribir(Address, secuencia.bytes, secuencia.largo);
+	}
+
+	static bool enviarNibble(uint8_t nibble) {
+		lcd::Secuencia<2> secuencia { };
+		secuencia.agregarNibble(nibble, control());
+		return Bus::escribir(Address, secuencia.bytes, secuencia.largo);
+	}
+};
+
+#endif /* API_INC_API_LCD_HPP_ */
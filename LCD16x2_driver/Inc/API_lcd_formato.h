@@ -0,0 +1,45 @@
+/**
+ * @file API_lcd_formato.h
+ * @brief Formateador de texto reducido para el LCD. Genera
+ * 		  los caracteres de a uno y los entrega a una función
+ * 		  de salida, sin buffers intermedios, sin memoria
+ * 		  dinámica y sin utilizar printf de la biblioteca C.
+ *
+ * 		  Especificaciones: %[-][0][ancho][.precisión][l]conversión
+ * 		  - d, i: entero con signo (int, o long con l).
+ * 		  - u, x, X: entero sin signo en decimal o hexadecimal.
+ * 		  - q: entero con signo en punto fijo, con tantos
+ * 		    decimales implícitos como indica la precisión
+ * 		    (%.2q con 2350 muestra 23.50).
+ * 		  - c: caracter. s: texto (la precisión limita el largo).
+ * 		  - h: bytes en hexadecimal separados por espacios. El
+ * 		    ancho es la cantidad de bytes y el argumento un
+ * 		    const uint8_t* (%*h con 4 y el UID muestra DE AD BE EF).
+ * 		  - %: el caracter %.
+ * 		  El ancho puede indicarse con * (argumento int). Con -
+ * 		  se alinea a la izquierda y con 0 se completa con ceros.
+ */
+
+#ifndef API_INC_API_LCD_FORMATO_H_
+#define API_INC_API_LCD_FORMATO_H_
+
+#include "API_types.h"
+#include <stdarg.h>
+
+//cantidad máxima de decimales de la conversión q
+#define LCD_MAX_DECIMALES				9
+
+/**
+ * @brief Función que recibe cada caracter generado.
+ * 		  El primer argumento es el contexto del llamador.
+ */
+typedef void (*LCD_SalidaTypedef)(void*, char);
+
+/**
+ *	@brief Genera el texto indicado por el formato y los
+ *		   argumentos, entregando cada caracter a la salida.
+ *	@retval Cantidad de caracteres generados.
+ */
+uint16_t LCD_formatear(LCD_SalidaTypedef, void*, const char*, va_list);
+
+#endif /* API_INC_API_LCD_FORMATO_H_ */
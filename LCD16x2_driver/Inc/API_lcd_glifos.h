@@ -0,0 +1,48 @@
+/**
+ * @file API_lcd_glifos.h
+ * @brief Tablas para mostrar texto Latin-1 (español) en un
+ * 		  HD44780 con la ROM A00. Cada caracter se traduce a
+ * 		  un código de la ROM, a un glifo propio para cargar
+ * 		  en la CGRAM o a un caracter ASCII de reemplazo.
+ * 		  Las tablas son constantes y se guardan en flash.
+ */
+
+#ifndef API_INC_API_LCD_GLIFOS_H_
+#define API_INC_API_LCD_GLIFOS_H_
+
+#include "API_types.h"
+
+//cantidad de caracteres propios que admite la CGRAM del HD44780
+#define LCD_CANTIDAD_CGRAM				8
+//filas de cada caracter propio (5x8)
+#define LCD_FILAS_GLIFO					8
+//indica que un caracter no tiene glifo propio
+#define LCD_SIN_GLIFO					0xFF
+
+/**
+ * @brief Traducción de un caracter Latin-1. Si rom no es 0
+ * 		  se muestra ese código de la ROM. Si no, y glifo no es
+ * 		  LCD_SIN_GLIFO, se muestra el glifo propio cargado en la
+ * 		  CGRAM. ascii se usa cuando no hay lugar en la CGRAM.
+ */
+typedef struct {
+	uint8_t rom;
+	uint8_t glifo;
+	char ascii;
+} LCD_TraduccionTypedef;
+
+/**
+ *	@brief Traduce un caracter Latin-1 (0x80 a 0xFF).
+ *		   Los caracteres ASCII se muestran sin traducir.
+ *	@retval Traducción del caracter.
+ */
+LCD_TraduccionTypedef LCD_traducirLatin1(uint8_t);
+
+/**
+ *	@brief Patrón de LCD_FILAS_GLIFO filas de un glifo
+ *		   propio (5 bits menos significativos de cada fila).
+ *	@retval Puntero al patrón, o NULL si el glifo no existe.
+ */
+const uint8_t* LCD_patronGlifo(uint8_t);
+
+#endif /* API_INC_API_LCD_GLIFOS_H_ */
@@ -8,30 +8,158 @@
 #ifndef API_INC_API_LCD_PORT_H_
 #define API_INC_API_LCD_PORT_H_
 
+//con API_PORT_HOST definido el port se compila para PC (carpeta Host)
+#ifndef API_PORT_HOST
 #include "stm32f4xx.h"
+#endif
 #include "API_types.h"
 
-//constantes para la comunicación I2C
+//cantidad de buses I2C utilizados por los displays (1 o 2). Cada display
+//indica su bus y su dirección al inicializarse, y varios displays pueden
+//compartir un bus con direcciones distintas.
+#ifndef I2C_CANTIDAD_BUSES
+#define I2C_CANTIDAD_BUSES			1
+#endif
+
+//constantes para la comunicación I2C. Ambos buses usan la misma velocidad.
 #define I2C_INSTANCE				I2C1
 #define I2C_CLOCK_SPEED				100000
 #define I2C_TIMEOUT					10
-#define LCD_ADDRESS					0x27
+
+//constantes para las transferencias asíncronas. Con I2C_USAR_DMA = 1 se utiliza
+//el DMA para transmitir, y con I2C_USAR_DMA = 0 la interrupción del I2C.
+#define I2C_USAR_DMA				0
+#define I2C_PRIORIDAD_IRQ			5
+//con LCD_DEFINIR_IRQ = 1 el port define las rutinas de atención de las
+//interrupciones del I2C y del DMA y los callbacks de la HAL del I2C. Con 0
+//los define la aplicación (por ejemplo, en el stm32f4xx_it.c de CubeMX) y
+//llama desde ellos a las funciones port_i2c*IrqHandler y port_i2c*Callback.
+#ifndef LCD_DEFINIR_IRQ
+#define LCD_DEFINIR_IRQ				1
+#endif
+#define I2C_EV_IRQN					I2C1_EV_IRQn
+#define I2C_ER_IRQN					I2C1_ER_IRQn
+#define I2C_EV_IRQ_HANDLER			I2C1_EV_IRQHandler
+#define I2C_ER_IRQ_HANDLER			I2C1_ER_IRQHandler
+#define I2C_DMA_STREAM				DMA1_Stream6
+#define I2C_DMA_CHANNEL				DMA_CHANNEL_1
+#define I2C_DMA_IRQN				DMA1_Stream6_IRQn
+#define I2C_DMA_IRQ_HANDLER			DMA1_Stream6_IRQHandler
+
+//bus 1: I2C2 con el stream 7 del DMA1
+#define I2C_BUS1_INSTANCE			I2C2
+#define I2C_BUS1_EV_IRQN			I2C2_EV_IRQn
+#define I2C_BUS1_ER_IRQN			I2C2_ER_IRQn
+#define I2C_BUS1_EV_IRQ_HANDLER		I2C2_EV_IRQHandler
+#define I2C_BUS1_ER_IRQ_HANDLER		I2C2_ER_IRQHandler
+#define I2C_BUS1_DMA_STREAM			DMA1_Stream7
+#define I2C_BUS1_DMA_CHANNEL		DMA_CHANNEL_7
+#define I2C_BUS1_DMA_IRQN			DMA1_Stream7_IRQn
+#define I2C_BUS1_DMA_IRQ_HANDLER	DMA1_Stream7_IRQHandler
+
+//tiempo en uS que demora un byte en el bus I2C (8 bits de datos + ACK)
+#define I2C_TIEMPO_BYTE_US			((9 * 1000000UL) / I2C_CLOCK_SPEED)
+
+/**
+ *   @brief Tipo de función que se llama al finalizar una
+ *          transferencia asíncrona. Los argumentos indican el
+ *          bus y si la transferencia fue exitosa.
+ */
+typedef void (*port_callbackTypedef)(uint8_t, bool_t);
 
 /**
- *   @brief Inicializa el periférico I2C.
+ *   @brief Inicializa un bus I2C. Si el bus ya estaba
+ *          inicializado no vuelve a configurarlo.
  *	@retval Estado de ejecución.
  **/
-bool_t port_init();
+bool_t port_init(uint8_t);
 
 /**
- *   @brief Escribe un byte por I2C.
+ *   @brief Escribe un byte por I2C en el bus
+ *          y la dirección de 7 bits indicados.
  *	@retval Estado de ejecución.
  */
-bool_t port_i2cWriteByte(uint8_t);
+bool_t port_i2cWriteByte(uint8_t, uint8_t, uint8_t);
+
+/**
+ *   @brief Escribe una secuencia de bytes por I2C en el
+ *          bus y la dirección de 7 bits indicados, en una
+ *          única transacción.
+ *	@retval Estado de ejecución.
+ */
+bool_t port_i2cWriteBuffer(uint8_t, uint8_t, const uint8_t*, size_t);
+
+/**
+ *   @brief Inicia la escritura de una secuencia de bytes por
+ *          I2C sin bloquear. El buffer debe permanecer válido
+ *          hasta que finalice la transferencia.
+ *	@retval Verdadero si se pudo iniciar la transferencia.
+ */
+bool_t port_i2cWriteBufferAsync(uint8_t, uint8_t, const uint8_t*, size_t);
+
+/**
+ *   @brief Indica si hay una transferencia asíncrona
+ *          en curso en el bus.
+ */
+bool_t port_i2cOcupado(uint8_t);
+
+/**
+ *   @brief Configura la función que se llama (desde la
+ *          interrupción) al finalizar una transferencia
+ *          asíncrona en el bus.
+ */
+void port_i2cSetCallback(uint8_t, port_callbackTypedef);
 
 /**
  *   @brief Implementa un delay bloqueante.
  */
 void port_delay(uint32_t);
 
+/**
+ *   @brief Implementa un delay bloqueante
+ *          con resolución de microsegundos.
+ */
+void port_delayUs(uint32_t);
+
+/**
+ *   @brief Devuelve una marca de tiempo para usar
+ *          con port_transcurrioUs.
+ */
+uint32_t port_marcaTiempo();
+
+/**
+ *   @brief Indica si transcurrieron al menos los uS
+ *          indicados desde la marca de tiempo.
+ */
+bool_t port_transcurrioUs(uint32_t, uint32_t);
+
+/**
+ *   @brief Indica si el último reinicio del procesador fue
+ *          en caliente, sin cortar la alimentación, por lo que
+ *          los displays conservan su configuración.
+ */
+bool_t port_reinicioEnCaliente();
+
+#ifndef API_PORT_HOST
+/**
+ *   @brief Atienden las interrupciones de eventos y de errores
+ *          del I2C y del stream de DMA del bus. Con
+ *          LCD_DEFINIR_IRQ = 0, la aplicación las llama desde
+ *          las rutinas de atención correspondientes.
+ */
+void port_i2cEvIrqHandler(uint8_t);
+void port_i2cErIrqHandler(uint8_t);
+void port_i2cDmaIrqHandler(uint8_t);
+
+/**
+ *   @brief Finalizan la transferencia asíncrona del bus al que
+ *          pertenece el handle; los handles de otros módulos se
+ *          ignoran. Con LCD_DEFINIR_IRQ = 0, la aplicación las
+ *          llama desde HAL_I2C_MasterTxCpltCallback y
+ *          HAL_I2C_ErrorCallback.
+ */
+void port_i2cTxCpltCallback(I2C_HandleTypeDef*);
+void port_i2cErrorCallback(I2C_HandleTypeDef*);
+#endif
+
 #endif /* API_INC_API_LCD_PORT_H_ */
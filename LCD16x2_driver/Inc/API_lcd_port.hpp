@@ -0,0 +1,74 @@
+/**
+ * @file API_lcd_port.hpp
+ * @brief Bus I2C del STM32F4 para Lcd<Bus, Address, Cols, Rows>
+ * 		  (API_lcd.hpp). La instancia del I2C se indica con su
+ * 		  dirección base (I2C1_BASE), y la inicialización y las
+ * 		  transferencias usan la HAL con la misma configuración
+ * 		  que API_lcd_port.c. Las esperas usan el contador de
+ * 		  ciclos del DWT.
+ *
+ * 		  Ejemplo con dos displays en I2C1:
+ * 		  using Display0 = Lcd<lcd::BusI2c<I2C1_BASE>, 0x27, 16, 2>;
+ * 		  using Display1 = Lcd<lcd::BusI2c<I2C1_BASE>, 0x26, 20, 4>;
+ */
+
+#ifndef API_INC_API_LCD_PORT_HPP_
+#define API_INC_API_LCD_PORT_HPP_
+
+#ifndef API_PORT_HOST
+
+extern "C" {
+#include "API_lcd_port.h"
+}
+
+namespace lcd {
+
+/**
+ *   @brief Bus I2C maestro compartido por todos los
+ *          displays que lo usan.
+ */
+template<uintptr_t Instancia, uint32_t Velocidad = I2C_CLOCK_SPEED>
+struct BusI2c {
+	static bool iniciar() {
+		I2C_HandleTypeDef &I2C = handle();
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+		if (I2C.State != HAL_I2C_STATE_RESET)
+			return true;					//lo inicializó otro display
+		I2C.Instance = reinterpret_cast<I2C_TypeDef*>(Instancia);
+		I2C.Init.ClockSpeed = Velocidad;
+		I2C.Init.DutyCycle = I2C_DUTYCYCLE_2;
+		I2C.Init.OwnAddress1 = 0;
+		I2C.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+		I2C.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
+		I2C.Init.OwnAddress2 = 0;
+		I2C.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
+		I2C.Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
+		return HAL_I2C_Init(&I2C) == HAL_OK;
+	}
+
+	static bool escribir(uint8_t direccion, const uint8_t *datos,
+			uint16_t largo) {
+		return HAL_I2C_Master_Transmit(&handle(), direccion << 1,
+				const_cast<uint8_t*>(datos), largo, I2C_TIMEOUT) == HAL_OK;
+	}
+
+	static void esperarUs(uint32_t us) {
+		uint32_t inicio = DWT->CYCCNT;
+		uint32_t ciclos = us * (SystemCoreClock / 1000000);
+		while (DWT->CYCCNT - inicio < ciclos)
+			;
+	}
+
+private:
+	static I2C_HandleTypeDef& handle() {
+		static I2C_HandleTypeDef I2C;
+		return I2C;
+	}
+};
+
+} /* namespace lcd */
+
+#endif /* API_PORT_HOST */
+
+#endif /* API_INC_API_LCD_PORT_HPP_ */
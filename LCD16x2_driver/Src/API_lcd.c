@@ -1,11 +1,22 @@
 /**
  * @file API_lcd.c
  * @brief  Implementación de funciones del
- * 		   módulo lcd.
+ * 		   módulo lcd. El estado de cada display se guarda
+ * 		   en su LCD_HandleTypedef, y el estado de cada bus
+ * 		   I2C (displays conectados, turno y transferencia
+ * 		   asíncrona en curso) en este módulo.
  */
 
 #include "API_lcd.h"
 #include "API_types.h"
+#include <string.h>
+#if INSTR_HABILITADA
+#include "API_instrumentacion.h"
+#else
+//sin instrumentación no se necesita la carpeta Common
+#define INSTR_INICIO(marca)
+#define INSTR_FIN(op, marca, bytes, timeout)
+#endif
 
 //constantes utilizadas para controlar el LCD
 #define _4BIT_MODE					0x28
@@ -20,178 +31,1371 @@
 #define ENABLE						(1<<2)
 #define POS_BACKLIGHT				(3)
 #define SET_CURSOR					(1<<7)
+#define SET_CGRAM					(1<<6)
 #define CURSOR_ON					1<<1
 #define CURSOR_BLINK				1
+#define CURSOR_SHIFT				(1<<4)
+#define SHIFT_DISPLAY				(1<<3)			//desplaza el display en lugar del cursor
 
 #define NULL_CHAR					'\0'			//caracter nulo
 
-static uint8_t back_light = 1;//variable global privada para guardar el estado del backlight. 1 = encendido, 0 = apagado
+//los códigos 0x08 a 0x0F muestran las posiciones 0 a 7 de la CGRAM (los
+//códigos 0x00 a 0x07 también, pero 0x00 es el caracter nulo)
+#define PRIMER_CODIGO_CGRAM			0x08
+#define PRIMER_LATIN1				0x80
+#define SIN_CARGA					0xFF			//no hay que cargar un glifo
+#define CURSOR_DESCONOCIDO			0xFF			//la DDRAM no está direccionada
+
+#define BYTES_POR_MSG				4	//bytes del PCF8574 por cada mensaje (2 nibbles con flanco de ENABLE)
+#define LCD_MAX_MSG_LOTE			(LCD_CANTIDAD_COLUMNAS * LCD_CANTIDAD_FILAS)
+
+//tiempos de la secuencia de inicialización del HD44780 (Figura 24 de la hoja de datos)
+#define LCD_DELAY_ENCENDIDO_US		20000
+#define LCD_DELAY_INIT_1_US			4100
+#define LCD_DELAY_INIT_2_US			100
+//en un reinicio en caliente, el primer nibble puede completar un comando
+//lento que quedó a medio enviar
+#define LCD_DELAY_RESINCRONIZAR_US	1520
+
+//tiempo de ejecución de la escritura de un dato en DDRAM/CGRAM
+#define LCD_TIEMPO_DATO_US			41
+
+/**
+ *	@brief Tiempo de ejecución en uS de cada comando del
+ *		   HD44780, indexado por la posición del bit más
+ *		   significativo en 1 del comando (Tabla 6 de la
+ *		   hoja de datos).
+ */
+static const uint16_t TIEMPO_COMANDO_US[8] = { 1520,	//clear display
+		1520,		//return home
+		37,			//entry mode set
+		37,			//display on/off control
+		37,			//cursor or display shift
+		37,			//function set
+		37,			//set CGRAM address
+		37			//set DDRAM address
+		};
+
+/**
+ *	@brief Lote de bytes a enviar al PCF8574 en una
+ *		   única transacción I2C. Se utiliza para
+ *		   enviar secuencias de caracteres y comandos
+ *		   rápidos (que no requieren delay) de una vez.
+ *		   Solo lo usan las funciones bloqueantes, por
+ *		   lo que lo comparten todos los displays.
+ */
+static uint8_t loteI2C[LCD_MAX_MSG_LOTE * BYTES_POR_MSG];
+static uint16_t largoLote = 0;
+
+/**
+ *	@brief Estado de un bus I2C. Los displays del bus se
+ *		   atienden por turnos (turno es el próximo a revisar).
+ *		   enCurso es el display de la transferencia asíncrona
+ *		   en curso, que se envía desde lote. Las funciones
+ *		   bloqueantes reservan el bus para que no se inicien
+ *		   transferencias asíncronas mientras lo usan.
+ */
+typedef struct {
+	LCD_HandleTypedef *displays[LCD_MAX_DISPLAYS_BUS];
+	uint8_t cantidad;
+	uint8_t turno;
+	LCD_HandleTypedef *volatile enCurso;
+	volatile bool_t reservado;
+	uint8_t lote[LCD_MENSAJES_POR_TURNO * BYTES_POR_MSG];
+} LCD_BusTypedef;
+
+static LCD_BusTypedef busesLCD[I2C_CANTIDAD_BUSES];
+
+/**
+ *	@brief Ventana del buffer de pantalla en la que se escribe
+ *		   un texto de a un caracter: posición actual y si al
+ *		   completar la fila se pasa a la siguiente o se descarta
+ *		   el resto. primerByte guarda el primer byte de una
+ *		   secuencia UTF-8 hasta recibir el segundo.
+ */
+typedef struct {
+	LCD_HandleTypedef *lcd;
+	uint8_t fila;
+	uint8_t columna;
+	bool_t envolver;
+	uint8_t primerByte;
+} LCD_VentanaTypedef;
+
+/**
+ *	@brief Display que utilizan las funciones sin handle.
+ */
+static LCD_HandleTypedef lcdPorDefecto;
 
 /**
  *	@brief Funciones privadas para
  *		   enviar datos al LCD.
  */
-static LCD_StatusTypedef LCD_sendMsg(uint8_t, uint8_t);
-static LCD_StatusTypedef LCD_sendByte(uint8_t);
-static LCD_StatusTypedef LCD_sendNibble(uint8_t, uint8_t);
+static LCD_StatusTypedef LCD_sendMsg(LCD_HandleTypedef*, uint8_t, uint8_t);
+static LCD_StatusTypedef LCD_sendByte(LCD_HandleTypedef*, uint8_t);
+static LCD_StatusTypedef LCD_sendNibble(LCD_HandleTypedef*, uint8_t, uint8_t);
+static bool_t LCD_escribirBus(LCD_HandleTypedef*, const uint8_t*, size_t);
+static void LCD_codificarMsg(LCD_HandleTypedef*, uint8_t, uint8_t, uint8_t*);
+static uint16_t LCD_tiempoEjecucionUs(uint8_t, uint8_t);
+static void LCD_esperarEjecucion(uint8_t, uint8_t);
+static LCD_StatusTypedef LCD_agregarMsgLote(LCD_HandleTypedef*, uint8_t,
+		uint8_t);
+static void LCD_agregarNibbleLote(LCD_HandleTypedef*, uint8_t);
+static LCD_StatusTypedef LCD_enviarLote(LCD_HandleTypedef*);
+static void LCD_llenarEspacios(LCD_HandleTypedef*,
+		char[LCD_MAX_FILAS][LCD_MAX_COLUMNAS]);
+static int8_t LCD_indiceFila(LCD_HandleTypedef*, uint8_t);
+static char LCD_leerCaracter(const char**);
+static bool_t LCD_abrirVentana(LCD_HandleTypedef*, uint8_t, uint8_t, bool_t,
+		LCD_VentanaTypedef*);
+static void LCD_escribirVentana(void*, char);
+static void LCD_ubicarCaracter(LCD_VentanaTypedef*, char);
+static void LCD_cerrarVentana(LCD_VentanaTypedef*);
+static LCD_StatusTypedef LCD_displayImprimir(LCD_HandleTypedef*, uint8_t,
+		uint8_t, bool_t, const char*, va_list);
+static uint32_t LCD_glifosEnPantalla(LCD_HandleTypedef*);
+static uint32_t LCD_glifosLinea(const char*, uint8_t);
+static uint8_t LCD_codigoCaracter(LCD_HandleTypedef*, char, uint32_t,
+		uint8_t*);
+static LCD_StatusTypedef LCD_agregarGlifoLote(LCD_HandleTypedef*, uint8_t);
+static void LCD_encolarGlifo(LCD_HandleTypedef*, uint8_t);
+static void LCD_invalidarContenido(LCD_HandleTypedef*);
+static void LCD_verificarContenido(LCD_HandleTypedef*);
+static bool_t LCD_encolarMsg(LCD_HandleTypedef*, uint8_t, uint8_t);
+static uint16_t LCD_espacioCola(LCD_HandleTypedef*);
+static void LCD_esperarCola(LCD_HandleTypedef*);
+static bool_t LCD_esperaCumplida(LCD_HandleTypedef*);
+static LCD_StatusTypedef LCD_estadoCola(LCD_HandleTypedef*);
+static bool_t LCD_agregarDisplayBus(LCD_HandleTypedef*);
+static void LCD_arbitrarBus(uint8_t);
+static void LCD_enviarTurno(LCD_BusTypedef*, LCD_HandleTypedef*);
+static void LCD_transferenciaFinalizada(uint8_t, bool_t);
 
 /**
- *	@brief Secuencia de comandos para
- *		   configurar el LCD.
+ *	@brief Secuencia de comandos para configurar el LCD. Se
+ *		   envía en un único lote: todos los comandos son rápidos
+ *		   salvo CLR_LCD, que es el último (también coloca el
+ *		   cursor en 0 y anula el desplazamiento).
  */
 static const uint8_t LCD_INIT_CMD[] = {
 _4BIT_MODE, 				//configura el LCD para trabajar en modo de 4bits
 		DISPLAY_CONTROL, 				//apaga el LCD momentaneamente
-		RETURN_HOME,					//TODO REVISAR //coloca el cursor en 0
 		ENTRY_MODE | AUTOINCREMENT,
 		DISPLAY_CONTROL | DISPLAY_ON, 	//enciende el LCD
 		CLR_LCD							//limpia la pantalla
 		};
-
 /**
  *	@brief Realiza la secuencia de inicialización
- *		   del LCD.
+ *		   del LCD. Inicializa el bus si todavía no
+ *		   lo estaba y agrega el display a los
+ *		   displays atendidos por el bus.
+ *
+ *		   Luego del encendido se respetan los tiempos de la
+ *		   hoja de datos. En un reinicio en caliente el display
+ *		   ya terminó su reset interno, por lo que solo se
+ *		   resincroniza el modo de 4 bits: el primer nibble
+ *		   completa un mensaje que pudo quedar a medio enviar,
+ *		   y los nibbles 0x3, 0x3, 0x2 pasan a 8 bits y vuelven
+ *		   a 4 bits desde cualquier estado. Estos nibbles van en
+ *		   el mismo lote que la secuencia de comandos.
  *	@retval Estado de ejecución.
  */
-LCD_StatusTypedef LCD_init() {
-	bool_t estadoI2C = port_init();				//inicializa el periférico I2C
-	if (estadoI2C == false)
+LCD_StatusTypedef LCD_displayInit(LCD_HandleTypedef *lcd, uint8_t bus,
+		uint8_t direccion, uint8_t columnas, uint8_t filas) {
+	if (lcd == NULL || bus >= I2C_CANTIDAD_BUSES)
 		return LCD_ERROR;
-
-	port_delay(20);
-	if (LCD_sendNibble(0x03, COMMAND) == LCD_ERROR)
+	if (columnas == 0 || columnas > LCD_MAX_COLUMNAS || filas == 0
+			|| filas > LCD_MAX_FILAS)
 		return LCD_ERROR;
 
-	port_delay(10);
+	memset(lcd, 0, sizeof(*lcd));
+	lcd->bus = bus;
+	lcd->direccion = direccion;
+	lcd->columnas = columnas;
+	lcd->filas = filas;
+	lcd->backLight = 1;
+	memset(lcd->glifoCgram, LCD_SIN_GLIFO, sizeof(lcd->glifoCgram));
+	lcd->direccionFila[0] = LCD_FILA_1;
+	if (filas > 1)
+		lcd->direccionFila[1] = LCD_FILA_2;
+	if (filas > 2)
+		lcd->direccionFila[2] = LCD_FILA_3(columnas);
+	if (filas > 3)
+		lcd->direccionFila[3] = LCD_FILA_4(columnas);
 
-	if (LCD_sendNibble(0x03, COMMAND) == LCD_ERROR)
+	bool_t estadoI2C = port_init(bus);			//inicializa el periférico I2C
+	if (estadoI2C == false)
+		return LCD_ERROR;
+	port_i2cSetCallback(bus, LCD_transferenciaFinalizada);
+	if (!LCD_agregarDisplayBus(lcd))
 		return LCD_ERROR;
 
-	port_delay(1);
+	if (port_reinicioEnCaliente()) {
+		if (LCD_sendNibble(lcd, 0x03, COMMAND) == LCD_ERROR)
+			return LCD_ERROR;
+		port_delayUs(LCD_DELAY_RESINCRONIZAR_US);
+		LCD_agregarNibbleLote(lcd, 0x03);
+		LCD_agregarNibbleLote(lcd, 0x03);
+		LCD_agregarNibbleLote(lcd, 0x02);
+	} else {
+		port_delayUs(LCD_DELAY_ENCENDIDO_US);
+		if (LCD_sendNibble(lcd, 0x03, COMMAND) == LCD_ERROR)
+			return LCD_ERROR;
 
-	if (LCD_sendNibble(0x02, COMMAND) == LCD_ERROR)
-		return LCD_ERROR;
+		port_delayUs(LCD_DELAY_INIT_1_US);
+
+		if (LCD_sendNibble(lcd, 0x03, COMMAND) == LCD_ERROR)
+			return LCD_ERROR;
+
+		port_delayUs(LCD_DELAY_INIT_2_US);
+
+		if (LCD_sendNibble(lcd, 0x02, COMMAND) == LCD_ERROR)
+			return LCD_ERROR;
+	}
 
 	for (uint8_t indice = 0; indice < sizeof(LCD_INIT_CMD); indice++) {
-		port_delay(1);
-		if (LCD_sendMsg(LCD_INIT_CMD[indice], COMMAND) == LCD_ERROR)
+		if (LCD_agregarMsgLote(lcd, LCD_INIT_CMD[indice], COMMAND)
+				== LCD_ERROR)
 			return LCD_ERROR;
 	}
+	if (LCD_enviarLote(lcd) == LCD_ERROR)
+		return LCD_ERROR;
+	LCD_esperarEjecucion(CLR_LCD, COMMAND);
+
+	//la secuencia de inicialización termina con CLR_LCD
+	LCD_llenarEspacios(lcd, lcd->contenidoLCD);
+	LCD_llenarEspacios(lcd, lcd->bufferPantalla);
+	lcd->cursorFila = 0;
+	lcd->cursorColumna = 0;
 	return LCD_OK;
 }
 
 /**
  *	@brief Limpia la pantalla del LCD.
  *		   Para esto envía el comando CLR_LCD.
+ *		   También limpia los buffers de pantalla
+ *		   y detiene la marquesina.
  *	@retval Estado de ejecución.
  */
-LCD_StatusTypedef LCD_clear() {
-	return LCD_sendMsg(CLR_LCD, COMMAND);
+LCD_StatusTypedef LCD_displayClear(LCD_HandleTypedef *lcd) {
+	if (LCD_sendMsg(lcd, CLR_LCD, COMMAND) == LCD_ERROR)
+		return LCD_ERROR;
+
+	LCD_llenarEspacios(lcd, lcd->contenidoLCD);
+	LCD_llenarEspacios(lcd, lcd->bufferPantalla);
+	lcd->cursorFila = 0;
+	lcd->cursorColumna = 0;
+	lcd->marquesinaActiva = false;			//CLR_LCD también anula el desplazamiento
+	lcd->glifosMarquesina = 0;
+	return LCD_OK;
 }
 
 /**
  *	@brief Coloca el cursor del LCD en (fila, posición).
+ *		   La dirección de DDRAM enviada es la
+ *		   dirección de inicio de la fila más la posición.
  *	@retval Estado de ejecución.
  */
-LCD_StatusTypedef LCD_setCursor(uint8_t fila, uint8_t posicion) {
-	if (fila != LCD_FILA_1 && fila != LCD_FILA_2)
+LCD_StatusTypedef LCD_displaySetCursor(LCD_HandleTypedef *lcd, uint8_t fila,
+		uint8_t posicion) {
+	int8_t indiceFila = LCD_indiceFila(lcd, fila);
+	if (indiceFila < 0)
+		return LCD_ERROR;
+	if (posicion >= lcd->columnas)
 		return LCD_ERROR;
 
-	return LCD_sendMsg(SET_CURSOR | fila, COMMAND);
+	if (LCD_sendMsg(lcd, SET_CURSOR | (fila + posicion), COMMAND) == LCD_ERROR)
+		return LCD_ERROR;
+
+	lcd->cursorFila = indiceFila;
+	lcd->cursorColumna = posicion;
+	return LCD_OK;
 }
 
 /**
- *	@brief Coloca una caracter en la pantalla del LCD
- *	@retval Estado de ejecución.
+ *	@brief Coloca una caracter en la pantalla del LCD.
+ *		   Actualiza los buffers de pantalla para que
+ *		   sigan reflejando el contenido del display.
+ *	@retval Estado de ejecución. LCD_ERROR si el caracter
+ *			necesita cargar un glifo y la posición del cursor
+ *			es desconocida (luego de LCD_displayMarquesinaEscribir),
+ *			porque no se podría volver a direccionar la DDRAM.
  */
-LCD_StatusTypedef LCD_printChar(char dato) {
-	return LCD_sendMsg(dato, DATA);
+LCD_StatusTypedef LCD_displayPrintChar(LCD_HandleTypedef *lcd, char dato) {
+	uint8_t posicionCarga;
+	uint8_t codigo = LCD_codigoCaracter(lcd, dato, LCD_glifosEnPantalla(lcd),
+			&posicionCarga);
+
+	//si se carga un glifo, el contador de direcciones queda en la CGRAM
+	if (posicionCarga != SIN_CARGA) {
+		if (lcd->cursorFila >= lcd->filas) {
+			lcd->glifoCgram[posicionCarga] = LCD_SIN_GLIFO;	//no se cargó
+			return LCD_ERROR;
+		}
+		if (LCD_agregarGlifoLote(lcd, posicionCarga) == LCD_ERROR)
+			return LCD_ERROR;
+		if (LCD_agregarMsgLote(lcd,
+				SET_CURSOR
+						| (lcd->direccionFila[lcd->cursorFila]
+								+ lcd->cursorColumna), COMMAND) == LCD_ERROR)
+			return LCD_ERROR;
+		if (LCD_enviarLote(lcd) == LCD_ERROR)
+			return LCD_ERROR;
+	}
+
+	if (LCD_sendMsg(lcd, codigo, DATA) == LCD_ERROR)
+		return LCD_ERROR;
+
+	if (lcd->cursorFila < lcd->filas && lcd->cursorColumna < lcd->columnas) {
+		lcd->contenidoLCD[lcd->cursorFila][lcd->cursorColumna] = dato;
+		lcd->bufferPantalla[lcd->cursorFila][lcd->cursorColumna] = dato;
+	}
+	lcd->cursorColumna++;
+	return LCD_OK;
 }
 
 /**
  *	@brief Escribe un texto en el LCD. Para esto
- *		   recorre el puntero de entrada y verifica
- *		   que el caracter no sea NULL_CHAR. Utiliza la función
- *		   LCD_printChar.
+ *		   borra el buffer de pantalla, escribe el
+ *		   texto en él con LCD_bufferWrite y luego
+ *		   envía solo los caracteres que cambiaron
+ *		   con LCD_flush.
  *	@retval Estado de ejecución.
  */
-LCD_StatusTypedef LCD_printText(char *ptrTexto) {
+LCD_StatusTypedef LCD_displayPrintText(LCD_HandleTypedef *lcd,
+		const char *ptrTexto) {
 	if (ptrTexto == NULL)
 		return LCD_ERROR;
 
-	LCD_clear();
+	INSTR_INICIO(inicio);
+	LCD_displayBufferClear(lcd);
+	LCD_displayBufferWrite(lcd, LCD_FILA_1, 0, ptrTexto);
 
-	uint8_t contadorPosicion = 0;
-	LCD_setCursor(LCD_FILA_1, 0);
-	while ((*ptrTexto) != NULL_CHAR) {
-		char caracter = *ptrTexto++;
-		if (caracter == '\n') {
-			LCD_setCursor(LCD_FILA_2, 0);
-			contadorPosicion = 0;
-			continue;
-		}
+	LCD_StatusTypedef estado = LCD_displayFlush(lcd);
+	INSTR_FIN(INSTR_LCD_PRINT_TEXT, inicio, strlen(ptrTexto),
+			estado == LCD_ERROR);
+	return estado;
+}
 
-		if (LCD_printChar(caracter) == LCD_ERROR)
-			return LCD_ERROR;
+/**
+ *	@brief Borra el buffer de pantalla, genera el texto con
+ *		   formato desde el inicio de la fila 1, pasando de fila
+ *		   como LCD_bufferWrite, y envía los cambios con LCD_flush.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayPrintf(LCD_HandleTypedef *lcd,
+		const char *formato, ...) {
+	va_list argumentos;
+	va_start(argumentos, formato);
+	LCD_displayBufferClear(lcd);
+	LCD_StatusTypedef estado = LCD_displayImprimir(lcd, LCD_FILA_1, 0, true,
+			formato, argumentos);
+	va_end(argumentos);
+	return estado;
+}
 
-		contadorPosicion++;
-		if (contadorPosicion == LCD_CANTIDAD_COLUMNAS)
-			LCD_setCursor(LCD_FILA_2, 0);
-		else if (contadorPosicion
-				== (LCD_CANTIDAD_COLUMNAS * LCD_CANTIDAD_FILAS))
-			break;						//CORTA EL TEXTO PERO NO DEVUELVE ERROR
-	}
+/**
+ *	@brief Genera el texto con formato en (fila, posición),
+ *		   dentro de la fila, y envía los cambios con LCD_flush.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayPrintAt(LCD_HandleTypedef *lcd, uint8_t fila,
+		uint8_t posicion, const char *formato, ...) {
+	va_list argumentos;
+	va_start(argumentos, formato);
+	LCD_StatusTypedef estado = LCD_displayImprimir(lcd, fila, posicion, false,
+			formato, argumentos);
+	va_end(argumentos);
+	return estado;
+}
+
+/**
+ *	@brief Escribe hasta largo caracteres del texto (o hasta
+ *		   NULL_CHAR) en (fila, posición), dentro de la fila, y
+ *		   envía los cambios con LCD_flush.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayWriteSpan(LCD_HandleTypedef *lcd, uint8_t fila,
+		uint8_t posicion, const char *texto, size_t largo) {
+	LCD_VentanaTypedef ventana;
+	if (texto == NULL || !LCD_abrirVentana(lcd, fila, posicion, false, &ventana))
+		return LCD_ERROR;
+
+	for (size_t indice = 0; indice < largo && texto[indice] != NULL_CHAR;
+			indice++)
+		LCD_escribirVentana(&ventana, texto[indice]);
+	LCD_cerrarVentana(&ventana);
+	return LCD_displayFlush(lcd);
+}
+
+/**
+ *	@brief Genera el texto con formato en una ventana del
+ *		   buffer de pantalla y envía los cambios.
+ *	@retval Estado de ejecución.
+ */
+static LCD_StatusTypedef LCD_displayImprimir(LCD_HandleTypedef *lcd,
+		uint8_t fila, uint8_t posicion, bool_t envolver, const char *formato,
+		va_list argumentos) {
+	LCD_VentanaTypedef ventana;
+	if (formato == NULL
+			|| !LCD_abrirVentana(lcd, fila, posicion, envolver, &ventana))
+		return LCD_ERROR;
+
+	LCD_formatear(LCD_escribirVentana, &ventana, formato, argumentos);
+	LCD_cerrarVentana(&ventana);
+	return LCD_displayFlush(lcd);
+}
+
+/**
+ *	@brief Llena el buffer de pantalla con espacios.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayBufferClear(LCD_HandleTypedef *lcd) {
+	LCD_llenarEspacios(lcd, lcd->bufferPantalla);
+	return LCD_OK;
+}
+
+/**
+ *	@brief Escribe un texto en el buffer de pantalla.
+ *		   Recorre el puntero de entrada hasta encontrar
+ *		   NULL_CHAR. Con '\n' o al completar una fila
+ *		   pasa a la siguiente, y al llegar al final de la
+ *		   pantalla corta el texto sin devolver error.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayBufferWrite(LCD_HandleTypedef *lcd, uint8_t fila,
+		uint8_t posicion, const char *ptrTexto) {
+	LCD_VentanaTypedef ventana;
+	if (ptrTexto == NULL
+			|| !LCD_abrirVentana(lcd, fila, posicion, true, &ventana))
+		return LCD_ERROR;
+
+	while ((*ptrTexto) != NULL_CHAR && ventana.fila < lcd->filas)
+		LCD_escribirVentana(&ventana, *ptrTexto++);
+	LCD_cerrarVentana(&ventana);
 
 	return LCD_OK;
 }
 
+/**
+ *	@brief Envía al LCD los caracteres del buffer de
+ *		   pantalla que difieren de lo que muestra el
+ *		   display. Los caracteres contiguos que cambiaron
+ *		   se envían como una secuencia, moviendo el cursor
+ *		   solo cuando el siguiente cambio no está en la
+ *		   posición actual del cursor. Todos los mensajes
+ *		   se agrupan en un lote que se envía en una
+ *		   única transacción I2C.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayFlush(LCD_HandleTypedef *lcd) {
+	LCD_esperarCola(lcd);
+	LCD_verificarContenido(lcd);
+	uint32_t enPantalla = LCD_glifosEnPantalla(lcd);
+
+	for (uint8_t fila = 0; fila < lcd->filas; fila++) {
+		for (uint8_t columna = 0; columna < lcd->columnas; columna++) {
+			char caracter = lcd->bufferPantalla[fila][columna];
+			if (caracter == lcd->contenidoLCD[fila][columna])
+				continue;
+
+			uint8_t posicionCarga;
+			uint8_t codigo = LCD_codigoCaracter(lcd, caracter, enPantalla,
+					&posicionCarga);
+			if (posicionCarga != SIN_CARGA) {
+				if (LCD_agregarGlifoLote(lcd, posicionCarga) == LCD_ERROR)
+					return LCD_ERROR;
+				lcd->cursorFila = CURSOR_DESCONOCIDO;
+			}
+
+			if (lcd->cursorFila != fila || lcd->cursorColumna != columna) {
+				if (LCD_agregarMsgLote(lcd,
+						SET_CURSOR | (lcd->direccionFila[fila] + columna),
+						COMMAND) == LCD_ERROR)
+					return LCD_ERROR;
+				lcd->cursorFila = fila;
+				lcd->cursorColumna = columna;
+			}
+
+			if (LCD_agregarMsgLote(lcd, codigo, DATA) == LCD_ERROR)
+				return LCD_ERROR;
+			lcd->contenidoLCD[fila][columna] = caracter;
+			lcd->cursorColumna++;
+		}
+	}
+
+	return LCD_enviarLote(lcd);
+}
+
 /**
  *	@brief Muestra un cursor que parpadea en
  *		   la pantalla del LCD.
  *	@retval Estado de ejecución.
  */
-LCD_StatusTypedef LCD_cursorOn() {
-	return LCD_sendMsg(DISPLAY_CONTROL | DISPLAY_ON | CURSOR_ON | CURSOR_BLINK,
-			COMMAND);
+LCD_StatusTypedef LCD_displayCursorOn(LCD_HandleTypedef *lcd) {
+	return LCD_sendMsg(lcd,
+			DISPLAY_CONTROL | DISPLAY_ON | CURSOR_ON | CURSOR_BLINK, COMMAND);
 }
 
 /**
  *	@brief Apaga el cursor.
  *	@retval Estado de ejecución.
  */
-LCD_StatusTypedef LCD_cursorOff() {
-	return LCD_sendMsg(DISPLAY_CONTROL | DISPLAY_ON, COMMAND);
+LCD_StatusTypedef LCD_displayCursorOff(LCD_HandleTypedef *lcd) {
+	return LCD_sendMsg(lcd, DISPLAY_CONTROL | DISPLAY_ON, COMMAND);
+}
+
+/**
+ *	@brief Cambia el estado del backlight. El bit de backlight
+ *		   se envía en cada byte al PCF8574, por lo que basta
+ *		   con escribir un byte sin flanco de ENABLE.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayBacklight(LCD_HandleTypedef *lcd,
+		bool_t encendido) {
+	LCD_esperarCola(lcd);
+	lcd->backLight = encendido ? 1 : 0;
+
+	uint8_t valor = lcd->backLight << POS_BACKLIGHT;
+	if (!LCD_escribirBus(lcd, &valor, sizeof(valor)))
+		return LCD_ERROR;
+	return LCD_OK;
+}
+
+/**
+ *	@brief Escribe el texto en la linea de DDRAM completa de
+ *		   la fila, con un único lote de mensajes. Primero se
+ *		   traducen los caracteres, porque la carga de glifos
+ *		   mueve el contador de direcciones a la CGRAM. Las
+ *		   primeras columnas del texto quedan en los buffers de
+ *		   pantalla, para que LCD_flush no las vuelva a enviar.
+ *		   En los displays de 4 filas la linea de DDRAM incluye
+ *		   otra fila, por lo que no se admite la marquesina.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayMarquesinaEscribir(LCD_HandleTypedef *lcd,
+		uint8_t fila, const char *ptrTexto) {
+	if (ptrTexto == NULL || lcd->filas > 2)
+		return LCD_ERROR;
+	int8_t indiceFila = LCD_indiceFila(lcd, fila);
+	if (indiceFila < 0)
+		return LCD_ERROR;
+
+	char linea[LCD_COLUMNAS_DDRAM];
+	uint8_t largo = 0;
+	while ((*ptrTexto) != NULL_CHAR && largo < LCD_COLUMNAS_DDRAM)
+		linea[largo++] = LCD_leerCaracter(&ptrTexto);
+	while (largo < LCD_COLUMNAS_DDRAM)
+		linea[largo++] = ' ';
+
+	LCD_esperarCola(lcd);
+	LCD_verificarContenido(lcd);
+	lcd->glifosMarquesina |= LCD_glifosLinea(linea, LCD_COLUMNAS_DDRAM);
+	uint32_t enPantalla = LCD_glifosEnPantalla(lcd);
+
+	uint8_t codigos[LCD_COLUMNAS_DDRAM];
+	for (uint8_t columna = 0; columna < LCD_COLUMNAS_DDRAM; columna++) {
+		uint8_t posicionCarga;
+		codigos[columna] = LCD_codigoCaracter(lcd, linea[columna], enPantalla,
+				&posicionCarga);
+		if (posicionCarga != SIN_CARGA
+				&& LCD_agregarGlifoLote(lcd, posicionCarga) == LCD_ERROR)
+			return LCD_ERROR;
+	}
+
+	if (LCD_agregarMsgLote(lcd, SET_CURSOR | fila, COMMAND) == LCD_ERROR)
+		return LCD_ERROR;
+	for (uint8_t columna = 0; columna < LCD_COLUMNAS_DDRAM; columna++) {
+		if (LCD_agregarMsgLote(lcd, codigos[columna], DATA) == LCD_ERROR)
+			return LCD_ERROR;
+	}
+
+	for (uint8_t columna = 0; columna < lcd->columnas; columna++) {
+		lcd->bufferPantalla[indiceFila][columna] = linea[columna];
+		lcd->contenidoLCD[indiceFila][columna] = linea[columna];
+	}
+	//al completar la linea el contador de direcciones pasa a otra fila
+	lcd->cursorFila = CURSOR_DESCONOCIDO;
+	return LCD_enviarLote(lcd);
+}
+
+/**
+ *	@brief Inicia la marquesina. El primer paso se
+ *		   da un período después de la llamada.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayMarquesinaIniciar(LCD_HandleTypedef *lcd,
+		uint32_t periodoMs) {
+	if (periodoMs == 0 || periodoMs > LCD_MAX_PERIODO_MARQUESINA_MS
+			|| lcd->filas > 2)
+		return LCD_ERROR;
+
+	lcd->periodoMarquesinaMs = periodoMs;
+	lcd->marcaMarquesina = port_marcaTiempo();
+	lcd->marquesinaActiva = true;
+	return LCD_OK;
+}
+
+/**
+ *	@brief Avanza la marquesina un paso si pasó el período.
+ *		   Cada paso es un comando de desplazamiento del display
+ *		   hacia la izquierda (4 bytes por I2C), en lugar de volver
+ *		   a escribir todos los caracteres de la pantalla. La marca
+ *		   se toma al encolar el paso, por lo que si el loop se
+ *		   atrasa no se acumulan pasos pendientes.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayMarquesinaTick(LCD_HandleTypedef *lcd) {
+	if (!lcd->marquesinaActiva)
+		return LCD_ERROR;
+	if (!port_transcurrioUs(lcd->marcaMarquesina,
+			lcd->periodoMarquesinaMs * 1000))
+		return LCD_BUSY;
+	if (!LCD_encolarMsg(lcd, CURSOR_SHIFT | SHIFT_DISPLAY, COMMAND))
+		return LCD_BUSY;
+
+	lcd->marcaMarquesina = port_marcaTiempo();
+	return LCD_OK;
+}
+
+/**
+ *	@brief Detiene la marquesina. RETURN_HOME anula el
+ *		   desplazamiento y lleva el cursor al inicio de la
+ *		   fila 1; el texto fuera de las columnas visibles
+ *		   queda en la DDRAM pero ya no se muestra.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayMarquesinaDetener(LCD_HandleTypedef *lcd) {
+	lcd->marquesinaActiva = false;
+	lcd->glifosMarquesina = 0;
+	if (LCD_sendMsg(lcd, RETURN_HOME, COMMAND) == LCD_ERROR)
+		return LCD_ERROR;
+
+	lcd->cursorFila = 0;
+	lcd->cursorColumna = 0;
+	return LCD_OK;
+}
+
+/**
+ *	@brief Llena un buffer de pantalla con espacios.
+ */
+static void LCD_llenarEspacios(LCD_HandleTypedef *lcd,
+		char buffer[LCD_MAX_FILAS][LCD_MAX_COLUMNAS]) {
+	for (uint8_t fila = 0; fila < lcd->filas; fila++) {
+		for (uint8_t columna = 0; columna < lcd->columnas; columna++) {
+			buffer[fila][columna] = ' ';
+		}
+	}
+}
+
+/**
+ *	@brief Busca la fila cuya dirección de inicio es
+ *		   la indicada (LCD_FILA_1, LCD_FILA_2, ...).
+ *	@retval Número de fila, o -1 si el display no la tiene.
+ */
+static int8_t LCD_indiceFila(LCD_HandleTypedef *lcd, uint8_t fila) {
+	for (uint8_t indice = 0; indice < lcd->filas; indice++) {
+		if (lcd->direccionFila[indice] == fila)
+			return indice;
+	}
+	return -1;
+}
+
+/**
+ *	@brief Lee un caracter del texto y avanza el puntero.
+ *		   Las secuencias UTF-8 de dos bytes del rango Latin-1
+ *		   (U+0080 a U+00FF) se convierten al código Latin-1,
+ *		   y el resto de los bytes se toman como Latin-1.
+ *	@retval Caracter Latin-1.
+ */
+static char LCD_leerCaracter(const char **ptrTexto) {
+	const uint8_t *texto = (const uint8_t*) *ptrTexto;
+	if ((texto[0] == 0xC2 || texto[0] == 0xC3) && (texto[1] & 0xC0) == 0x80) {
+		*ptrTexto += 2;
+		return (char) (((texto[0] & 0x1F) << 6) | (texto[1] & 0x3F));
+	}
+	(*ptrTexto)++;
+	return (char) texto[0];
+}
+
+/**
+ *	@brief Prepara una ventana que comienza en (fila, posición).
+ *	@retval Falso si la posición no existe en el display.
+ */
+static bool_t LCD_abrirVentana(LCD_HandleTypedef *lcd, uint8_t fila,
+		uint8_t posicion, bool_t envolver, LCD_VentanaTypedef *ventana) {
+	int8_t indiceFila = LCD_indiceFila(lcd, fila);
+	if (indiceFila < 0 || posicion >= lcd->columnas)
+		return false;
+
+	ventana->lcd = lcd;
+	ventana->fila = indiceFila;
+	ventana->columna = posicion;
+	ventana->envolver = envolver;
+	ventana->primerByte = 0;
+	return true;
+}
+
+/**
+ *	@brief Recibe un byte del texto. Las secuencias UTF-8 del
+ *		   rango Latin-1 se convierten como en LCD_leerCaracter;
+ *		   si el byte siguiente al primero no completa la
+ *		   secuencia, ambos se toman como Latin-1.
+ */
+static void LCD_escribirVentana(void *contexto, char caracter) {
+	LCD_VentanaTypedef *ventana = contexto;
+	uint8_t byte = (uint8_t) caracter;
+
+	if (ventana->primerByte != 0) {
+		uint8_t primerByte = ventana->primerByte;
+		ventana->primerByte = 0;
+		if ((byte & 0xC0) == 0x80) {
+			LCD_ubicarCaracter(ventana,
+					(char) (((primerByte & 0x1F) << 6) | (byte & 0x3F)));
+			return;
+		}
+		LCD_ubicarCaracter(ventana, (char) primerByte);
+	}
+
+	if (byte == 0xC2 || byte == 0xC3)
+		ventana->primerByte = byte;
+	else
+		LCD_ubicarCaracter(ventana, caracter);
+}
+
+/**
+ *	@brief Coloca un caracter en la posición actual de la
+ *		   ventana. Con '\n' o al completar la fila pasa a la
+ *		   siguiente, o descarta el resto si la ventana no
+ *		   envuelve. Al llegar al final de la pantalla los
+ *		   caracteres se descartan sin devolver error.
+ */
+static void LCD_ubicarCaracter(LCD_VentanaTypedef *ventana, char caracter) {
+	LCD_HandleTypedef *lcd = ventana->lcd;
+	if (ventana->fila >= lcd->filas || ventana->columna >= lcd->columnas)
+		return;
+
+	if (caracter != '\n')
+		lcd->bufferPantalla[ventana->fila][ventana->columna++] = caracter;
+	else
+		ventana->columna = lcd->columnas;
+
+	if (ventana->columna == lcd->columnas && ventana->envolver) {
+		ventana->fila++;
+		ventana->columna = 0;
+	}
+}
+
+/**
+ *	@brief Coloca el primer byte de una secuencia UTF-8
+ *		   que quedó incompleta al final del texto.
+ */
+static void LCD_cerrarVentana(LCD_VentanaTypedef *ventana) {
+	if (ventana->primerByte != 0)
+		LCD_ubicarCaracter(ventana, (char) ventana->primerByte);
+	ventana->primerByte = 0;
+}
+
+/**
+ *	@brief Marca los glifos propios que se usan en el buffer
+ *		   de pantalla y en los textos de la marquesina. Las
+ *		   posiciones de la CGRAM con estos glifos no se
+ *		   reemplazan, para no cambiar caracteres que van a
+ *		   quedar en pantalla.
+ *	@retval Máscara con un bit por glifo.
+ */
+static uint32_t LCD_glifosEnPantalla(LCD_HandleTypedef *lcd) {
+	uint32_t mascara = lcd->glifosMarquesina;
+	for (uint8_t fila = 0; fila < lcd->filas; fila++)
+		mascara |= LCD_glifosLinea(lcd->bufferPantalla[fila], lcd->columnas);
+	return mascara;
+}
+
+/**
+ *	@brief Marca los glifos propios que se usan en una linea.
+ *	@retval Máscara con un bit por glifo.
+ */
+static uint32_t LCD_glifosLinea(const char *linea, uint8_t largo) {
+	uint32_t mascara = 0;
+	for (uint8_t columna = 0; columna < largo; columna++) {
+		uint8_t caracter = (uint8_t) linea[columna];
+		if (caracter < PRIMER_LATIN1)
+			continue;
+		LCD_TraduccionTypedef traduccion = LCD_traducirLatin1(caracter);
+		if (traduccion.rom == 0 && traduccion.glifo != LCD_SIN_GLIFO)
+			mascara |= 1UL << traduccion.glifo;
+	}
+	return mascara;
+}
+
+/**
+ *	@brief Devuelve el código a enviar al LCD para un caracter.
+ *		   Los caracteres Latin-1 se traducen a un código de la
+ *		   ROM o a un glifo propio. Si el glifo no está en la CGRAM,
+ *		   se le asigna una posición vacía o la usada hace más
+ *		   tiempo entre las que no están en pantalla, y se indica
+ *		   en posicionCarga que hay que cargarlo. Si no hay lugar,
+ *		   se usa el caracter ASCII de reemplazo.
+ *	@retval Código del caracter.
+ */
+static uint8_t LCD_codigoCaracter(LCD_HandleTypedef *lcd, char caracter,
+		uint32_t enPantalla, uint8_t *posicionCarga) {
+	*posicionCarga = SIN_CARGA;
+	if ((uint8_t) caracter < PRIMER_LATIN1)
+		return (uint8_t) caracter;
+
+	LCD_TraduccionTypedef traduccion = LCD_traducirLatin1((uint8_t) caracter);
+	if (traduccion.rom != 0)
+		return traduccion.rom;
+	if (traduccion.glifo == LCD_SIN_GLIFO)
+		return (uint8_t) traduccion.ascii;
+
+	lcd->relojCgram++;
+	uint8_t elegida = SIN_CARGA;
+	uint16_t mayorEdad = 0;
+	for (uint8_t posicion = 0; posicion < LCD_CANTIDAD_CGRAM; posicion++) {
+		uint8_t glifo = lcd->glifoCgram[posicion];
+		if (glifo == traduccion.glifo) {
+			lcd->usoCgram[posicion] = lcd->relojCgram;
+			return PRIMER_CODIGO_CGRAM + posicion;
+		}
+		if (elegida != SIN_CARGA && lcd->glifoCgram[elegida] == LCD_SIN_GLIFO)
+			continue;
+		if (glifo == LCD_SIN_GLIFO) {
+			elegida = posicion;
+			continue;
+		}
+		if (enPantalla & (1UL << glifo))
+			continue;
+		uint16_t edad = lcd->relojCgram - lcd->usoCgram[posicion];
+		if (elegida == SIN_CARGA || edad > mayorEdad) {
+			elegida = posicion;
+			mayorEdad = edad;
+		}
+	}
+
+	if (elegida == SIN_CARGA)
+		return (uint8_t) traduccion.ascii;
+
+	lcd->glifoCgram[elegida] = traduccion.glifo;
+	lcd->usoCgram[elegida] = lcd->relojCgram;
+	*posicionCarga = elegida;
+	return PRIMER_CODIGO_CGRAM + elegida;
+}
+
+/**
+ *	@brief Agrega al lote la carga en la CGRAM del glifo
+ *		   asignado a la posición. Todos los mensajes son
+ *		   rápidos, por lo que pueden ir en el mismo lote.
+ *		   Luego el contador de direcciones queda en la CGRAM.
+ *	@retval Estado de ejecución.
+ */
+static LCD_StatusTypedef LCD_agregarGlifoLote(LCD_HandleTypedef *lcd,
+		uint8_t posicion) {
+	const uint8_t *patron = LCD_patronGlifo(lcd->glifoCgram[posicion]);
+	if (LCD_agregarMsgLote(lcd, SET_CGRAM | (posicion * LCD_FILAS_GLIFO),
+			COMMAND) == LCD_ERROR)
+		return LCD_ERROR;
+	for (uint8_t fila = 0; fila < LCD_FILAS_GLIFO; fila++) {
+		if (LCD_agregarMsgLote(lcd, patron[fila], DATA) == LCD_ERROR)
+			return LCD_ERROR;
+	}
+	return LCD_OK;
+}
+
+/**
+ *	@brief Versión asíncrona de LCD_agregarGlifoLote. El
+ *		   llamador verifica que haya lugar en la cola.
+ */
+static void LCD_encolarGlifo(LCD_HandleTypedef *lcd, uint8_t posicion) {
+	const uint8_t *patron = LCD_patronGlifo(lcd->glifoCgram[posicion]);
+	LCD_encolarMsg(lcd, SET_CGRAM | (posicion * LCD_FILAS_GLIFO), COMMAND);
+	for (uint8_t fila = 0; fila < LCD_FILAS_GLIFO; fila++)
+		LCD_encolarMsg(lcd, patron[fila], DATA);
 }
 
 /**
  *	@brief Envía un mensaje al LCD, que puede
  *		   ser un comando (rs=0) o un dato (rs=1).
- *		   El envío de mensajes se realiza primero
+ *		   Los 4 bytes del mensaje (ver LCD_codificarMsg)
+ *		   se envían en una única transacción I2C, y luego
+ *		   se espera el tiempo de ejecución del mensaje.
+ *	@retval Estado de ejecución.
+ */
+static LCD_StatusTypedef LCD_sendMsg(LCD_HandleTypedef *lcd, uint8_t dato,
+		uint8_t rs) {
+	uint8_t secuencia[BYTES_POR_MSG];
+
+	LCD_esperarCola(lcd);
+	LCD_codificarMsg(lcd, dato, rs, secuencia);
+
+	if (!LCD_escribirBus(lcd, secuencia, sizeof(secuencia)))
+		return LCD_ERROR;
+
+	LCD_esperarEjecucion(dato, rs);
+
+	return LCD_OK;
+}
+
+/**
+ *	@brief Escribe en el display con una transacción
+ *		   bloqueante. Reserva el bus para que no se inicien
+ *		   transferencias asíncronas de otros displays y
+ *		   espera a que finalice la que está en curso.
+ *	@retval Estado de ejecución.
+ */
+static bool_t LCD_escribirBus(LCD_HandleTypedef *lcd, const uint8_t *datos,
+		size_t largo) {
+	LCD_BusTypedef *estadoBus = &busesLCD[lcd->bus];
+
+	estadoBus->reservado = true;
+	while (port_i2cOcupado(lcd->bus))
+		;
+	bool_t estado = port_i2cWriteBuffer(lcd->bus, lcd->direccion, datos,
+			largo);
+	estadoBus->reservado = false;
+	return estado;
+}
+
+/**
+ *	@brief Devuelve el tiempo de ejecución en uS de
+ *		   un mensaje, según la tabla TIEMPO_COMANDO_US
+ *		   para comandos o LCD_TIEMPO_DATO_US para datos.
+ *	@retval Tiempo de ejecución en uS.
+ */
+static uint16_t LCD_tiempoEjecucionUs(uint8_t dato, uint8_t rs) {
+	if (rs == DATA || dato == 0)
+		return LCD_TIEMPO_DATO_US;
+
+	uint8_t bitMasSignificativo = 7;
+	while (!(dato & (1 << bitMasSignificativo)))
+		bitMasSignificativo--;
+
+	return TIEMPO_COMANDO_US[bitMasSignificativo];
+}
+
+/**
+ *	@brief Espera a que el controlador termine de ejecutar
+ *		   un mensaje recién enviado. El siguiente mensaje no
+ *		   se captura hasta que se transmiten al menos dos bytes
+ *		   por I2C (ENABLE en alto y en bajo), por lo que solo se
+ *		   espera el tiempo de ejecución que excede a ese envío.
+ */
+static void LCD_esperarEjecucion(uint8_t dato, uint8_t rs) {
+	uint32_t tiempo = LCD_tiempoEjecucionUs(dato, rs);
+	if (tiempo > 2 * I2C_TIEMPO_BYTE_US)
+		port_delayUs(tiempo - 2 * I2C_TIEMPO_BYTE_US);
+}
+
+/**
+ *	@brief Genera los bytes del PCF8574 para enviar
+ *		   un mensaje. El envío se realiza primero
  *		   con los 4 bits mas significativos del dato
  *		   y luego los 4 menos significativos (esto es así
- *		   porque se trabaja en modo 4BITS). También tiene
+ *		   porque se trabaja en modo 4BITS). Cada nibble se
+ *		   envía con ENABLE en alto y luego en bajo, lo que
+ *		   genera el flanco descendente. También tiene
  *		   en cuenta el bit de back_light en cada envío.
+ *		   Cada byte demora ~90 uS en el bus a 100 kHz, por
+ *		   lo que el pulso de ENABLE y el tiempo entre mensajes
+ *		   superan los mínimos del controlador HD44780.
+ */
+static void LCD_codificarMsg(LCD_HandleTypedef *lcd, uint8_t dato, uint8_t rs,
+		uint8_t *secuencia) {
+	uint8_t backLight = lcd->backLight << POS_BACKLIGHT;
+	uint8_t nibbleAlto = rs | backLight | (dato & 0xF0);
+	uint8_t nibbleBajo = rs | backLight | (dato & 0x0F) << 4;
+
+	secuencia[0] = nibbleAlto | ENABLE;
+	secuencia[1] = nibbleAlto;
+	secuencia[2] = nibbleBajo | ENABLE;
+	secuencia[3] = nibbleBajo;
+}
+
+/**
+ *	@brief Agrega un mensaje al lote de envío. Si el
+ *		   lote está lleno, lo envía antes de agregarlo.
+ *		   Dentro del lote cada mensaje queda separado
+ *		   del siguiente por dos bytes de I2C, por lo que
+ *		   no debe utilizarse para comandos con un tiempo
+ *		   de ejecución mayor (CLR_LCD, RETURN_HOME).
  *	@retval Estado de ejecución.
  */
-static LCD_StatusTypedef LCD_sendMsg(uint8_t dato, uint8_t rs) {
-	if (LCD_sendByte(rs | (back_light << POS_BACKLIGHT) | (dato & 0xF0))
-			== LCD_ERROR)
+static LCD_StatusTypedef LCD_agregarMsgLote(LCD_HandleTypedef *lcd,
+		uint8_t dato, uint8_t rs) {
+	if ((size_t) (largoLote + BYTES_POR_MSG) > sizeof(loteI2C)) {
+		if (LCD_enviarLote(lcd) == LCD_ERROR)
+			return LCD_ERROR;
+	}
+
+	LCD_codificarMsg(lcd, dato, rs, &loteI2C[largoLote]);
+	largoLote += BYTES_POR_MSG;
+	return LCD_OK;
+}
+
+/**
+ *	@brief Agrega al lote un nibble de comando con su flanco
+ *		   de ENABLE. Se usa en la inicialización, con el lote
+ *		   vacío, por lo que siempre hay lugar.
+ */
+static void LCD_agregarNibbleLote(LCD_HandleTypedef *lcd, uint8_t nibble) {
+	uint8_t valor = COMMAND | (lcd->backLight << POS_BACKLIGHT)
+			| (nibble & 0x0F) << 4;
+	loteI2C[largoLote++] = valor | ENABLE;
+	loteI2C[largoLote++] = valor;
+}
+
+/**
+ *	@brief Envía el lote de mensajes acumulado en una
+ *		   única transacción I2C. Si falla el envío, se
+ *		   invalida el contenido conocido del LCD para que
+ *		   el próximo LCD_flush vuelva a enviar toda la pantalla.
+ *	@retval Estado de ejecución.
+ */
+static LCD_StatusTypedef LCD_enviarLote(LCD_HandleTypedef *lcd) {
+	if (largoLote == 0)
+		return LCD_OK;
+
+	LCD_esperarCola(lcd);
+	bool_t estado = LCD_escribirBus(lcd, loteI2C, largoLote);
+	largoLote = 0;
+	if (!estado) {
+		LCD_invalidarContenido(lcd);
+		return LCD_ERROR;
+	}
+
+	return LCD_OK;
+}
+
+/**
+ *	@brief Marca el contenido del LCD como desconocido,
+ *		   para que el próximo flush envíe toda la pantalla.
+ */
+static void LCD_invalidarContenido(LCD_HandleTypedef *lcd) {
+	for (uint8_t fila = 0; fila < lcd->filas; fila++) {
+		for (uint8_t columna = 0; columna < lcd->columnas; columna++) {
+			lcd->contenidoLCD[fila][columna] = NULL_CHAR;
+		}
+	}
+}
+
+/**
+ *	@brief Si falló una transferencia asíncrona, el contenido
+ *		   del LCD es desconocido y se invalida.
+ */
+static void LCD_verificarContenido(LCD_HandleTypedef *lcd) {
+	if (lcd->contenidoInvalido) {
+		lcd->contenidoInvalido = false;
+		LCD_invalidarContenido(lcd);
+	}
+}
+
+/**
+ *	@brief Agrega los mensajes necesarios para actualizar
+ *		   el LCD a la cola asíncrona. Sigue el mismo algoritmo
+ *		   que LCD_flush. Si la cola se llena, los caracteres
+ *		   que no se encolaron siguen marcados como distintos
+ *		   y se encolan en la próxima llamada.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayFlushAsync(LCD_HandleTypedef *lcd) {
+	LCD_verificarContenido(lcd);
+	uint32_t enPantalla = LCD_glifosEnPantalla(lcd);
+
+	for (uint8_t fila = 0; fila < lcd->filas; fila++) {
+		for (uint8_t columna = 0; columna < lcd->columnas; columna++) {
+			char caracter = lcd->bufferPantalla[fila][columna];
+			if (caracter == lcd->contenidoLCD[fila][columna])
+				continue;
+
+			//un caracter Latin-1 puede necesitar la carga de un glifo
+			//(dirección de CGRAM y filas del patrón) y volver a mover el cursor
+			bool_t moverCursor = (lcd->cursorFila != fila
+					|| lcd->cursorColumna != columna);
+			uint16_t mensajes = (moverCursor ? 2 : 1);
+			if ((uint8_t) caracter >= PRIMER_LATIN1)
+				mensajes = 2 + 1 + LCD_FILAS_GLIFO;
+			if (LCD_espacioCola(lcd) < mensajes)
+				return LCD_BUSY;
+
+			uint8_t posicionCarga;
+			uint8_t codigo = LCD_codigoCaracter(lcd, caracter, enPantalla,
+					&posicionCarga);
+			if (posicionCarga != SIN_CARGA) {
+				LCD_encolarGlifo(lcd, posicionCarga);
+				moverCursor = true;
+			}
+
+			if (moverCursor) {
+				LCD_encolarMsg(lcd,
+						SET_CURSOR | (lcd->direccionFila[fila] + columna),
+						COMMAND);
+				lcd->cursorFila = fila;
+				lcd->cursorColumna = columna;
+			}
+
+			LCD_encolarMsg(lcd, codigo, DATA);
+			lcd->contenidoLCD[fila][columna] = caracter;
+			lcd->cursorColumna++;
+		}
+	}
+
+	return LCD_OK;
+}
+
+/**
+ *	@brief Escribe el texto en el buffer de pantalla y
+ *		   encola los cambios con LCD_flushAsync.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayPrintTextAsync(LCD_HandleTypedef *lcd,
+		const char *ptrTexto) {
+	if (ptrTexto == NULL)
 		return LCD_ERROR;
 
-	if (LCD_sendByte(rs | (back_light << POS_BACKLIGHT) | (dato & 0x0F) << 4)
-			== LCD_ERROR)
+	LCD_displayBufferClear(lcd);
+	LCD_displayBufferWrite(lcd, LCD_FILA_1, 0, ptrTexto);
+
+	return LCD_displayFlushAsync(lcd);
+}
+
+/**
+ *	@brief Encola el comando CLR_LCD, limpia los
+ *		   buffers de pantalla y detiene la marquesina.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayClearAsync(LCD_HandleTypedef *lcd) {
+	if (!LCD_encolarMsg(lcd, CLR_LCD, COMMAND))
+		return LCD_BUSY;
+
+	LCD_llenarEspacios(lcd, lcd->contenidoLCD);
+	LCD_llenarEspacios(lcd, lcd->bufferPantalla);
+	lcd->cursorFila = 0;
+	lcd->cursorColumna = 0;
+	lcd->marquesinaActiva = false;
+	lcd->glifosMarquesina = 0;
+	return LCD_OK;
+}
+
+/**
+ *	@brief Avanza el envío de las colas asíncronas del bus
+ *		   del display (ver LCD_arbitrarBus) e informa el
+ *		   estado de la cola del display.
+ *	@retval Estado de ejecución.
+ */
+LCD_StatusTypedef LCD_displayProcess(LCD_HandleTypedef *lcd) {
+	LCD_arbitrarBus(lcd->bus);
+	return LCD_estadoCola(lcd);
+}
+
+/**
+ *	@brief Estado de la cola asíncrona de un display. Si falló
+ *		   una transferencia, descarta los mensajes pendientes
+ *		   e invalida el contenido. Al vaciarse la cola llama
+ *		   al callback del display.
+ *	@retval LCD_OK si la cola está vacía, LCD_BUSY si quedan
+ *			mensajes o un comando lento en ejecución, o LCD_ERROR.
+ */
+static LCD_StatusTypedef LCD_estadoCola(LCD_HandleTypedef *lcd) {
+	//la cola se lee antes que enCurso: la interrupción de fin de otro
+	//display puede enviar los mensajes de éste entre ambas lecturas,
+	//pero con la cola vacía ya no puede iniciar otra transferencia
+	bool_t colaVacia = lcd->inicioCola == lcd->finCola;
+	if (busesLCD[lcd->bus].enCurso == lcd)
+		return LCD_BUSY;
+
+	if (!colaVacia && !lcd->errorAsync)
+		return LCD_BUSY;
+
+	if (!LCD_esperaCumplida(lcd))
+		return LCD_BUSY;
+
+	if (lcd->errorAsync) {
+		lcd->inicioCola = lcd->finCola;	//descarta los mensajes pendientes
+		lcd->envioPendiente = false;
+		lcd->errorAsync = false;
+		lcd->contenidoInvalido = true;
 		return LCD_ERROR;
+	}
 
+	if (lcd->envioPendiente) {
+		lcd->envioPendiente = false;
+		if (lcd->callback != NULL)
+			lcd->callback(LCD_OK);
+	}
 	return LCD_OK;
 }
 
+/**
+ *	@brief Indica si terminó el comando lento con el que
+ *		   finalizó el último lote asíncrono del display.
+ */
+static bool_t LCD_esperaCumplida(LCD_HandleTypedef *lcd) {
+	if (lcd->tiempoEspera == 0)
+		return true;
+	if (!port_transcurrioUs(lcd->marcaEspera, lcd->tiempoEspera))
+		return false;
+	lcd->tiempoEspera = 0;
+	return true;
+}
+
+/**
+ *	@brief Agrega el display a los displays del bus,
+ *		   si no estaba agregado.
+ *	@retval Falso si el bus no admite más displays.
+ */
+static bool_t LCD_agregarDisplayBus(LCD_HandleTypedef *lcd) {
+	LCD_BusTypedef *estadoBus = &busesLCD[lcd->bus];
+	for (uint8_t indice = 0; indice < estadoBus->cantidad; indice++) {
+		if (estadoBus->displays[indice] == lcd)
+			return true;
+	}
+	if (estadoBus->cantidad >= LCD_MAX_DISPLAYS_BUS)
+		return false;
+	estadoBus->displays[estadoBus->cantidad++] = lcd;
+	return true;
+}
+
+/**
+ *	@brief Árbitro del bus. Si el bus está libre, recorre los
+ *		   displays desde el turno actual y le da el bus al primero
+ *		   que tenga mensajes pendientes y no esté esperando un
+ *		   comando lento. El turno pasa al display siguiente, por
+ *		   lo que con varios displays ocupados el bus se reparte
+ *		   en forma equitativa.
+ */
+static void LCD_arbitrarBus(uint8_t bus) {
+	LCD_BusTypedef *estadoBus = &busesLCD[bus];
+
+	if (port_i2cOcupado(bus) || estadoBus->reservado
+			|| estadoBus->enCurso != NULL)
+		return;
+
+	for (uint8_t i = 0; i < estadoBus->cantidad; i++) {
+		uint8_t indice = (estadoBus->turno + i) % estadoBus->cantidad;
+		LCD_HandleTypedef *lcd = estadoBus->displays[indice];
+		if (lcd->errorAsync || lcd->inicioCola == lcd->finCola)
+			continue;
+		if (!LCD_esperaCumplida(lcd))
+			continue;
+
+		estadoBus->turno = (indice + 1) % estadoBus->cantidad;
+		LCD_enviarTurno(estadoBus, lcd);
+		return;
+	}
+}
+
+/**
+ *	@brief Arma un lote con los mensajes pendientes del display
+ *		   (hasta LCD_MENSAJES_POR_TURNO, o hasta el primer comando
+ *		   lento inclusive) y lo transmite sin bloquear.
+ */
+static void LCD_enviarTurno(LCD_BusTypedef *estadoBus, LCD_HandleTypedef *lcd) {
+	uint16_t largo = 0;
+	uint16_t espera = 0;
+	while (lcd->inicioCola != lcd->finCola && largo < sizeof(estadoBus->lote)) {
+		LCD_MensajeTypedef mensaje = lcd->colaMensajes[lcd->inicioCola];
+		lcd->inicioCola = (lcd->inicioCola + 1) % LCD_TAMANO_COLA;
+
+		LCD_codificarMsg(lcd, mensaje.dato, mensaje.rs, &estadoBus->lote[largo]);
+		largo += BYTES_POR_MSG;
+
+		uint16_t tiempo = LCD_tiempoEjecucionUs(mensaje.dato, mensaje.rs);
+		if (tiempo > 2 * I2C_TIEMPO_BYTE_US) {
+			espera = tiempo - 2 * I2C_TIEMPO_BYTE_US;
+			break;				//los comandos lentos cierran el lote
+		}
+	}
+
+	lcd->envioPendiente = true;
+	lcd->tiempoEspera = espera;
+	estadoBus->enCurso = lcd;
+	if (!port_i2cWriteBufferAsync(lcd->bus, lcd->direccion, estadoBus->lote,
+			largo)) {
+		estadoBus->enCurso = NULL;
+		lcd->tiempoEspera = 0;
+		lcd->errorAsync = true;
+	}
+}
+
+/**
+ *	@brief Configura la función que se llama cuando se
+ *		   completa la cola asíncrona o falla una transferencia.
+ */
+void LCD_displaySetCallback(LCD_HandleTypedef *lcd,
+		LCD_CallbackTypedef callback) {
+	lcd->callback = callback;
+}
+
+/**
+ *	@brief Se llama desde la interrupción del I2C al finalizar
+ *		   una transferencia asíncrona. Registra el inicio de la
+ *		   espera del último comando del display y, si
+ *		   LCD_ENCADENAR_IRQ está habilitado, le da el bus al
+ *		   siguiente display con mensajes pendientes.
+ */
+static void LCD_transferenciaFinalizada(uint8_t bus, bool_t exito) {
+	LCD_HandleTypedef *lcd = busesLCD[bus].enCurso;
+	busesLCD[bus].enCurso = NULL;
+	if (lcd == NULL)
+		return;
+
+	lcd->marcaEspera = port_marcaTiempo();
+	if (!exito) {
+		lcd->errorAsync = true;
+		if (lcd->callback != NULL)
+			lcd->callback(LCD_ERROR);
+	}
+
+#if LCD_ENCADENAR_IRQ
+	LCD_arbitrarBus(bus);
+	if (exito)
+		LCD_estadoCola(lcd);
+#endif
+}
+
+/**
+ *	@brief Agrega un mensaje a la cola asíncrona.
+ *	@retval Falso si la cola está llena.
+ */
+static bool_t LCD_encolarMsg(LCD_HandleTypedef *lcd, uint8_t dato, uint8_t rs) {
+	uint16_t siguiente = (lcd->finCola + 1) % LCD_TAMANO_COLA;
+	if (siguiente == lcd->inicioCola)
+		return false;
+
+	lcd->colaMensajes[lcd->finCola].dato = dato;
+	lcd->colaMensajes[lcd->finCola].rs = rs;
+	lcd->finCola = siguiente;
+	return true;
+}
+
+/**
+ *	@brief Devuelve la cantidad de mensajes que
+ *		   se pueden agregar a la cola asíncrona.
+ */
+static uint16_t LCD_espacioCola(LCD_HandleTypedef *lcd) {
+	return (lcd->inicioCola + LCD_TAMANO_COLA - lcd->finCola - 1)
+			% LCD_TAMANO_COLA;
+}
+
+/**
+ *	@brief Espera a que se envíen todos los mensajes de la
+ *		   cola asíncrona. Las funciones bloqueantes la llaman
+ *		   antes de transmitir para respetar el orden de envío.
+ */
+static void LCD_esperarCola(LCD_HandleTypedef *lcd) {
+	while (LCD_displayProcess(lcd) == LCD_BUSY)
+		;
+}
+
 /**
  * @brief Envía los 4 bits menos significativos de dato,
  * 		  junto con los bits de rs, backlight.
  *	@retval Estado de ejecución.
  */
-static LCD_StatusTypedef LCD_sendNibble(uint8_t dato, uint8_t rs) {
-	return LCD_sendByte(rs | (back_light << POS_BACKLIGHT) | (dato & 0x0F) << 4);
+static LCD_StatusTypedef LCD_sendNibble(LCD_HandleTypedef *lcd, uint8_t dato,
+		uint8_t rs) {
+	return LCD_sendByte(lcd,
+			rs | (lcd->backLight << POS_BACKLIGHT) | (dato & 0x0F) << 4);
 
 }
 
@@ -199,20 +1403,128 @@ static LCD_StatusTypedef LCD_sendNibble(uint8_t dato, uint8_t rs) {
  *	@brief Envía un byte al LCD.
  *		   El envío consiste en envíar
  *		   primero el byte con el bit de ENABLE
- *		   en alto, y luego de 1ms envíar el
- *		   byte sin el ENABLE. Esto genera el flanco
- *		   descendiente necesario para que el controlador
- *		   del LCD lea los datos.
+ *		   en alto, y luego el byte sin el ENABLE,
+ *		   ambos en una misma transacción I2C. Esto genera
+ *		   el flanco descendiente necesario para que el
+ *		   controlador del LCD lea los datos.
  *	@retval Estado de ejecución.
  */
-static LCD_StatusTypedef LCD_sendByte(uint8_t _byte) {
-	if (!port_i2cWriteByte(_byte | ENABLE))
-		return LCD_ERROR;
-
-	port_delay(1);
+static LCD_StatusTypedef LCD_sendByte(LCD_HandleTypedef *lcd, uint8_t _byte) {
+	const uint8_t secuencia[] = { _byte | ENABLE, _byte };
 
-	if (!port_i2cWriteByte(_byte))
+	if (!LCD_escribirBus(lcd, secuencia, sizeof(secuencia)))
 		return LCD_ERROR;
 
 	return LCD_OK;
 }
+
+/**
+ *	@brief Funciones sin handle, que operan sobre
+ *		   el display por defecto.
+ */
+LCD_StatusTypedef LCD_init() {
+	return LCD_displayInit(&lcdPorDefecto, LCD_BUS, LCD_ADDRESS,
+			LCD_CANTIDAD_COLUMNAS, LCD_CANTIDAD_FILAS);
+}
+
+LCD_StatusTypedef LCD_clear() {
+	return LCD_displayClear(&lcdPorDefecto);
+}
+
+LCD_StatusTypedef LCD_setCursor(uint8_t fila, uint8_t posicion) {
+	return LCD_displaySetCursor(&lcdPorDefecto, fila, posicion);
+}
+
+LCD_StatusTypedef LCD_printChar(char dato) {
+	return LCD_displayPrintChar(&lcdPorDefecto, dato);
+}
+
+LCD_StatusTypedef LCD_printText(const char *ptrTexto) {
+	return LCD_displayPrintText(&lcdPorDefecto, ptrTexto);
+}
+
+LCD_StatusTypedef LCD_printf(const char *formato, ...) {
+	va_list argumentos;
+	va_start(argumentos, formato);
+	LCD_displayBufferClear(&lcdPorDefecto);
+	LCD_StatusTypedef estado = LCD_displayImprimir(&lcdPorDefecto, LCD_FILA_1,
+			0, true, formato, argumentos);
+	va_end(argumentos);
+	return estado;
+}
+
+LCD_StatusTypedef LCD_printAt(uint8_t fila, uint8_t posicion,
+		const char *formato, ...) {
+	va_list argumentos;
+	va_start(argumentos, formato);
+	LCD_StatusTypedef estado = LCD_displayImprimir(&lcdPorDefecto, fila,
+			posicion, false, formato, argumentos);
+	va_end(argumentos);
+	return estado;
+}
+
+LCD_StatusTypedef LCD_writeSpan(uint8_t fila, uint8_t posicion,
+		const char *texto, size_t largo) {
+	return LCD_displayWriteSpan(&lcdPorDefecto, fila, posicion, texto, largo);
+}
+
+LCD_StatusTypedef LCD_bufferClear() {
+	return LCD_displayBufferClear(&lcdPorDefecto);
+}
+
+LCD_StatusTypedef LCD_bufferWrite(uint8_t fila, uint8_t posicion,
+		const char *ptrTexto) {
+	return LCD_displayBufferWrite(&lcdPorDefecto, fila, posicion, ptrTexto);
+}
+
+LCD_StatusTypedef LCD_flush() {
+	return LCD_displayFlush(&lcdPorDefecto);
+}
+
+LCD_StatusTypedef LCD_cursorOn() {
+	return LCD_displayCursorOn(&lcdPorDefecto);
+}
+
+LCD_StatusTypedef LCD_cursorOff() {
+	return LCD_displayCursorOff(&lcdPorDefecto);
+}
+
+LCD_StatusTypedef LCD_backlight(bool_t encendido) {
+	return LCD_displayBacklight(&lcdPorDefecto, encendido);
+}
+
+LCD_StatusTypedef LCD_marquesinaEscribir(uint8_t fila, const char *ptrTexto) {
+	return LCD_displayMarquesinaEscribir(&lcdPorDefecto, fila, ptrTexto);
+}
+
+LCD_StatusTypedef LCD_marquesinaIniciar(uint32_t periodoMs) {
+	return LCD_displayMarquesinaIniciar(&lcdPorDefecto, periodoMs);
+}
+
+LCD_StatusTypedef LCD_marquesinaTick() {
+	return LCD_displayMarquesinaTick(&lcdPorDefecto);
+}
+
+LCD_StatusTypedef LCD_marquesinaDetener() {
+	return LCD_displayMarquesinaDetener(&lcdPorDefecto);
+}
+
+LCD_StatusTypedef LCD_flushAsync() {
+	return LCD_displayFlushAsync(&lcdPorDefecto);
+}
+
+LCD_StatusTypedef LCD_printTextAsync(const char *ptrTexto) {
+	return LCD_displayPrintTextAsync(&lcdPorDefecto, ptrTexto);
+}
+
+LCD_StatusTypedef LCD_clearAsync() {
+	return LCD_displayClearAsync(&lcdPorDefecto);
+}
+
+LCD_StatusTypedef LCD_process() {
+	return LCD_displayProcess(&lcdPorDefecto);
+}
+
+void LCD_setCallback(LCD_CallbackTypedef callback) {
+	LCD_displaySetCallback(&lcdPorDefecto, callback);
+}
@@ -0,0 +1,243 @@
+/**
+ * @file API_lcd_formato.c
+ * @brief  Implementación del formateador de texto del
+ * 		   LCD. Los números se convierten en un arreglo
+ * 		   de dígitos de pocos bytes en el stack.
+ */
+
+#include "API_lcd_formato.h"
+
+#define NULL_CHAR					'\0'			//caracter nulo
+#define SIN_PRECISION				-1
+
+//dígitos de un unsigned long de 64 bits, más el punto decimal
+#define MAX_DIGITOS					21
+
+static const char DIGITOS_HEXA[] = "0123456789ABCDEF";
+
+/**
+ *	@brief Estado del formateo: la salida, su contexto
+ *		   y la cantidad de caracteres generados.
+ */
+typedef struct {
+	LCD_SalidaTypedef salida;
+	void *contexto;
+	uint16_t cantidad;
+} LCD_FormateoTypedef;
+
+/**
+ *	@brief Especificación de una conversión.
+ */
+typedef struct {
+	bool_t izquierda;
+	bool_t ceros;
+	uint16_t ancho;
+	int16_t precision;
+} LCD_EspecificacionTypedef;
+
+static void LCD_emitir(LCD_FormateoTypedef*, char);
+static void LCD_emitirRelleno(LCD_FormateoTypedef*, char, uint16_t);
+static void LCD_emitirNumero(LCD_FormateoTypedef*,
+		const LCD_EspecificacionTypedef*, bool_t, unsigned long, uint8_t,
+		bool_t, uint8_t);
+static void LCD_emitirTexto(LCD_FormateoTypedef*,
+		const LCD_EspecificacionTypedef*, const char*);
+static void LCD_emitirBytes(LCD_FormateoTypedef*, const uint8_t*, uint16_t);
+
+/**
+ *	@brief Recorre el formato, copiando los caracteres comunes
+ *		   a la salida y reemplazando cada especificación por el
+ *		   argumento convertido. Una conversión desconocida se
+ *		   copia sin cambios.
+ *	@retval Cantidad de caracteres generados.
+ */
+uint16_t LCD_formatear(LCD_SalidaTypedef salida, void *contexto,
+		const char *formato, va_list argumentos) {
+	LCD_FormateoTypedef formateo = { salida, contexto, 0 };
+	if (salida == NULL || formato == NULL)
+		return 0;
+
+	while (*formato != NULL_CHAR) {
+		if (*formato != '%') {
+			LCD_emitir(&formateo, *formato++);
+			continue;
+		}
+		formato++;
+
+		LCD_EspecificacionTypedef especificacion = { false, false, 0,
+				SIN_PRECISION };
+		for (;; formato++) {
+			if (*formato == '-')
+				especificacion.izquierda = true;
+			else if (*formato == '0')
+				especificacion.ceros = true;
+			else
+				break;
+		}
+		if (*formato == '*') {
+			int ancho = va_arg(argumentos, int);
+			especificacion.ancho = ancho > 0 ? (uint16_t) ancho : 0;
+			formato++;
+		}
+		while (*formato >= '0' && *formato <= '9')
+			especificacion.ancho = especificacion.ancho * 10 + (*formato++ - '0');
+		if (*formato == '.') {
+			formato++;
+			especificacion.precision = 0;
+			while (*formato >= '0' && *formato <= '9')
+				especificacion.precision = especificacion.precision * 10
+						+ (*formato++ - '0');
+		}
+		bool_t largo = false;
+		if (*formato == 'l') {
+			largo = true;
+			formato++;
+		}
+
+		char conversion = *formato;
+		if (conversion == NULL_CHAR)
+			break;
+		formato++;
+
+		switch (conversion) {
+		case 'd':
+		case 'i':
+		case 'q': {
+			long valor = largo ? va_arg(argumentos, long) :
+						va_arg(argumentos, int);
+			unsigned long magnitud =
+					valor < 0 ? 0UL - (unsigned long) valor : (unsigned long) valor;
+			uint8_t decimales = 0;
+			if (conversion == 'q' && especificacion.precision > 0)
+				decimales = especificacion.precision > LCD_MAX_DECIMALES ?
+				LCD_MAX_DECIMALES : (uint8_t) especificacion.precision;
+			LCD_emitirNumero(&formateo, &especificacion, valor < 0, magnitud, 10,
+					false, decimales);
+			break;
+		}
+		case 'u':
+		case 'x':
+		case 'X': {
+			unsigned long valor =
+					largo ? va_arg(argumentos, unsigned long) :
+							va_arg(argumentos, unsigned int);
+			LCD_emitirNumero(&formateo, &especificacion, false, valor,
+					conversion == 'u' ? 10 : 16, conversion == 'X', 0);
+			break;
+		}
+		case 'c': {
+			char caracter[2] = { (char) va_arg(argumentos, int), NULL_CHAR };
+			LCD_emitirTexto(&formateo, &especificacion, caracter);
+			break;
+		}
+		case 's':
+			LCD_emitirTexto(&formateo, &especificacion,
+					va_arg(argumentos, const char*));
+			break;
+		case 'h':
+			LCD_emitirBytes(&formateo, va_arg(argumentos, const uint8_t*),
+					especificacion.ancho);
+			break;
+		default:
+			LCD_emitir(&formateo, conversion);
+			break;
+		}
+	}
+
+	return formateo.cantidad;
+}
+
+static void LCD_emitir(LCD_FormateoTypedef *formateo, char caracter) {
+	formateo->salida(formateo->contexto, caracter);
+	formateo->cantidad++;
+}
+
+static void LCD_emitirRelleno(LCD_FormateoTypedef *formateo, char caracter,
+		uint16_t cantidad) {
+	while (cantidad-- > 0)
+		LCD_emitir(formateo, caracter);
+}
+
+/**
+ *	@brief Convierte un número a dígitos en la base indicada,
+ *		   del menos significativo al más significativo. Con
+ *		   decimales, se agrega el punto y se completan con ceros
+ *		   los dígitos que falten (5 con 2 decimales es 0.05).
+ *		   Luego se emite con el signo y el relleno pedidos.
+ */
+static void LCD_emitirNumero(LCD_FormateoTypedef *formateo,
+		const LCD_EspecificacionTypedef *especificacion, bool_t negativo,
+		unsigned long magnitud, uint8_t base, bool_t mayusculas,
+		uint8_t decimales) {
+	char digitos[MAX_DIGITOS];
+	uint8_t cantidad = 0;
+	do {
+		char digito = DIGITOS_HEXA[magnitud % base];
+		if (!mayusculas && digito >= 'A')
+			digito += 'a' - 'A';
+		digitos[cantidad++] = digito;
+		magnitud /= base;
+		if (decimales > 0 && cantidad == decimales) {
+			digitos[cantidad++] = '.';
+			decimales = 0;
+			if (magnitud == 0)
+				digitos[cantidad++] = '0';
+		}
+	} while (magnitud != 0 || decimales > 0);
+
+	uint16_t largo = cantidad + (negativo ? 1 : 0);
+	uint16_t relleno =
+			especificacion->ancho > largo ? especificacion->ancho - largo : 0;
+
+	if (!especificacion->izquierda && !especificacion->ceros)
+		LCD_emitirRelleno(formateo, ' ', relleno);
+	if (negativo)
+		LCD_emitir(formateo, '-');
+	if (!especificacion->izquierda && especificacion->ceros)
+		LCD_emitirRelleno(formateo, '0', relleno);
+	while (cantidad > 0)
+		LCD_emitir(formateo, digitos[--cantidad]);
+	if (especificacion->izquierda)
+		LCD_emitirRelleno(formateo, ' ', relleno);
+}
+
+/**
+ *	@brief Emite un texto, cortado a la precisión y
+ *		   completado con espacios hasta el ancho.
+ */
+static void LCD_emitirTexto(LCD_FormateoTypedef *formateo,
+		const LCD_EspecificacionTypedef *especificacion, const char *texto) {
+	if (texto == NULL)
+		texto = "(null)";
+
+	uint16_t largo = 0;
+	while (texto[largo] != NULL_CHAR
+			&& (especificacion->precision == SIN_PRECISION
+					|| largo < especificacion->precision))
+		largo++;
+	uint16_t relleno =
+			especificacion->ancho > largo ? especificacion->ancho - largo : 0;
+
+	if (!especificacion->izquierda)
+		LCD_emitirRelleno(formateo, ' ', relleno);
+	for (uint16_t indice = 0; indice < largo; indice++)
+		LCD_emitir(formateo, texto[indice]);
+	if (especificacion->izquierda)
+		LCD_emitirRelleno(formateo, ' ', relleno);
+}
+
+/**
+ *	@brief Emite los bytes en hexadecimal con dos
+ *		   dígitos, separados por un espacio.
+ */
+static void LCD_emitirBytes(LCD_FormateoTypedef *formateo, const uint8_t *bytes,
+		uint16_t cantidad) {
+	if (bytes == NULL)
+		return;
+	for (uint16_t indice = 0; indice < cantidad; indice++) {
+		if (indice > 0)
+			LCD_emitir(formateo, ' ');
+		LCD_emitir(formateo, DIGITOS_HEXA[bytes[indice] >> 4]);
+		LCD_emitir(formateo, DIGITOS_HEXA[bytes[indice] & 0x0F]);
+	}
+}
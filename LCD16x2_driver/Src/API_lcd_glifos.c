@@ -0,0 +1,173 @@
+/**
+ * @file API_lcd_glifos.c
+ * @brief  Implementación de las tablas de traducción
+ * 		   de caracteres Latin-1 y de los glifos propios.
+ */
+
+#include "API_lcd_glifos.h"
+
+//primer caracter Latin-1 de la tabla de traducción
+#define PRIMER_LATIN1					0x80
+
+/**
+ *	@brief Glifos propios. En la tabla de traducción se
+ *		   guarda el glifo más uno, para que las entradas
+ *		   sin inicializar (en 0) no tengan glifo.
+ */
+typedef enum {
+	GLIFO_A_AGUDA,
+	GLIFO_E_AGUDA,
+	GLIFO_I_AGUDA,
+	GLIFO_O_AGUDA,
+	GLIFO_U_AGUDA,
+	GLIFO_A_AGUDA_MAYUSCULA,
+	GLIFO_E_AGUDA_MAYUSCULA,
+	GLIFO_I_AGUDA_MAYUSCULA,
+	GLIFO_O_AGUDA_MAYUSCULA,
+	GLIFO_U_AGUDA_MAYUSCULA,
+	GLIFO_ENIE_MAYUSCULA,
+	GLIFO_U_DIERESIS_MAYUSCULA,
+	GLIFO_PREGUNTA_INVERTIDO,
+	GLIFO_EXCLAMACION_INVERTIDO,
+	CANTIDAD_GLIFOS
+} glifo_enum;
+
+/**
+ *	@brief Patrones de los glifos propios, de arriba hacia
+ *		   abajo. La última fila queda libre para el cursor.
+ */
+static const uint8_t PATRONES[CANTIDAD_GLIFOS][LCD_FILAS_GLIFO] = {
+		[GLIFO_A_AGUDA] = { 0x02, 0x04, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00 },
+		[GLIFO_E_AGUDA] = { 0x02, 0x04, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00 },
+		[GLIFO_I_AGUDA] = { 0x02, 0x04, 0x0C, 0x04, 0x04, 0x04, 0x0E, 0x00 },
+		[GLIFO_O_AGUDA] = { 0x02, 0x04, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00 },
+		[GLIFO_U_AGUDA] = { 0x02, 0x04, 0x11, 0x11, 0x11, 0x13, 0x0D, 0x00 },
+		[GLIFO_A_AGUDA_MAYUSCULA] = { 0x02, 0x04, 0x0E, 0x11, 0x1F, 0x11, 0x11,
+				0x00 },
+		[GLIFO_E_AGUDA_MAYUSCULA] = { 0x02, 0x04, 0x1F, 0x10, 0x1E, 0x10, 0x1F,
+				0x00 },
+		[GLIFO_I_AGUDA_MAYUSCULA] = { 0x02, 0x04, 0x0E, 0x04, 0x04, 0x04, 0x0E,
+				0x00 },
+		[GLIFO_O_AGUDA_MAYUSCULA] = { 0x02, 0x0E, 0x11, 0x11, 0x11, 0x11, 0x0E,
+				0x00 },
+		[GLIFO_U_AGUDA_MAYUSCULA] = { 0x02, 0x04, 0x11, 0x11, 0x11, 0x11, 0x0E,
+				0x00 },
+		[GLIFO_ENIE_MAYUSCULA] = { 0x0D, 0x12, 0x11, 0x19, 0x15, 0x13, 0x11,
+				0x00 },
+		[GLIFO_U_DIERESIS_MAYUSCULA] = { 0x0A, 0x00, 0x11, 0x11, 0x11, 0x11,
+				0x0E, 0x00 },
+		[GLIFO_PREGUNTA_INVERTIDO] = { 0x04, 0x00, 0x04, 0x08, 0x10, 0x11, 0x0E,
+				0x00 },
+		[GLIFO_EXCLAMACION_INVERTIDO] = { 0x04, 0x00, 0x04, 0x04, 0x04, 0x04,
+				0x04, 0x00 },
+		};
+
+//entradas de la tabla de traducción
+#define ROM(codigo, reemplazo)			{ (codigo), 0, (reemplazo) }
+#define GLIFO(glifo, reemplazo)			{ 0, (glifo) + 1, (reemplazo) }
+#define ASCII(reemplazo)				{ 0, 0, (reemplazo) }
+
+/**
+ *	@brief Traducción de los caracteres 0x80 a 0xFF. Los
+ *		   códigos de ROM corresponden a la ROM A00 (japonesa),
+ *		   la más común en los módulos de 16x2. Los caracteres
+ *		   sin entrada (controles C1) se muestran como '?'.
+ */
+static const LCD_TraduccionTypedef TRADUCCION[256 - PRIMER_LATIN1] = {
+		[0xA0 - PRIMER_LATIN1] = ASCII(' '),
+		[0xA1 - PRIMER_LATIN1] = GLIFO(GLIFO_EXCLAMACION_INVERTIDO, '!'),
+		[0xA7 - PRIMER_LATIN1] = ASCII('S'),
+		[0xAA - PRIMER_LATIN1] = ASCII('a'),
+		[0xAB - PRIMER_LATIN1] = ASCII('<'),
+		[0xAD - PRIMER_LATIN1] = ASCII('-'),
+		[0xB0 - PRIMER_LATIN1] = ROM(0xDF, 'o'),		//°
+		[0xB5 - PRIMER_LATIN1] = ROM(0xE4, 'u'),		//µ
+		[0xB7 - PRIMER_LATIN1] = ROM(0xA5, '.'),		//·
+		[0xBA - PRIMER_LATIN1] = ASCII('o'),
+		[0xBB - PRIMER_LATIN1] = ASCII('>'),
+		[0xBF - PRIMER_LATIN1] = GLIFO(GLIFO_PREGUNTA_INVERTIDO, '?'),
+		[0xC0 - PRIMER_LATIN1] = ASCII('A'),
+		[0xC1 - PRIMER_LATIN1] = GLIFO(GLIFO_A_AGUDA_MAYUSCULA, 'A'),
+		[0xC2 - PRIMER_LATIN1] = ASCII('A'),
+		[0xC3 - PRIMER_LATIN1] = ASCII('A'),
+		[0xC4 - PRIMER_LATIN1] = ASCII('A'),
+		[0xC5 - PRIMER_LATIN1] = ASCII('A'),
+		[0xC7 - PRIMER_LATIN1] = ASCII('C'),
+		[0xC8 - PRIMER_LATIN1] = ASCII('E'),
+		[0xC9 - PRIMER_LATIN1] = GLIFO(GLIFO_E_AGUDA_MAYUSCULA, 'E'),
+		[0xCA - PRIMER_LATIN1] = ASCII('E'),
+		[0xCB - PRIMER_LATIN1] = ASCII('E'),
+		[0xCC - PRIMER_LATIN1] = ASCII('I'),
+		[0xCD - PRIMER_LATIN1] = GLIFO(GLIFO_I_AGUDA_MAYUSCULA, 'I'),
+		[0xCE - PRIMER_LATIN1] = ASCII('I'),
+		[0xCF - PRIMER_LATIN1] = ASCII('I'),
+		[0xD1 - PRIMER_LATIN1] = GLIFO(GLIFO_ENIE_MAYUSCULA, 'N'),
+		[0xD2 - PRIMER_LATIN1] = ASCII('O'),
+		[0xD3 - PRIMER_LATIN1] = GLIFO(GLIFO_O_AGUDA_MAYUSCULA, 'O'),
+		[0xD4 - PRIMER_LATIN1] = ASCII('O'),
+		[0xD5 - PRIMER_LATIN1] = ASCII('O'),
+		[0xD6 - PRIMER_LATIN1] = ASCII('O'),
+		[0xD7 - PRIMER_LATIN1] = ASCII('x'),
+		[0xD9 - PRIMER_LATIN1] = ASCII('U'),
+		[0xDA - PRIMER_LATIN1] = GLIFO(GLIFO_U_AGUDA_MAYUSCULA, 'U'),
+		[0xDB - PRIMER_LATIN1] = ASCII('U'),
+		[0xDC - PRIMER_LATIN1] = GLIFO(GLIFO_U_DIERESIS_MAYUSCULA, 'U'),
+		[0xDD - PRIMER_LATIN1] = ASCII('Y'),
+		[0xDF - PRIMER_LATIN1] = ROM(0xE2, 's'),		//ß
+		[0xE0 - PRIMER_LATIN1] = ASCII('a'),
+		[0xE1 - PRIMER_LATIN1] = GLIFO(GLIFO_A_AGUDA, 'a'),
+		[0xE2 - PRIMER_LATIN1] = ASCII('a'),
+		[0xE3 - PRIMER_LATIN1] = ASCII('a'),
+		[0xE4 - PRIMER_LATIN1] = ROM(0xE1, 'a'),		//ä
+		[0xE5 - PRIMER_LATIN1] = ASCII('a'),
+		[0xE7 - PRIMER_LATIN1] = ASCII('c'),
+		[0xE8 - PRIMER_LATIN1] = ASCII('e'),
+		[0xE9 - PRIMER_LATIN1] = GLIFO(GLIFO_E_AGUDA, 'e'),
+		[0xEA - PRIMER_LATIN1] = ASCII('e'),
+		[0xEB - PRIMER_LATIN1] = ASCII('e'),
+		[0xEC - PRIMER_LATIN1] = ASCII('i'),
+		[0xED - PRIMER_LATIN1] = GLIFO(GLIFO_I_AGUDA, 'i'),
+		[0xEE - PRIMER_LATIN1] = ASCII('i'),
+		[0xEF - PRIMER_LATIN1] = ASCII('i'),
+		[0xF1 - PRIMER_LATIN1] = ROM(0xEE, 'n'),		//ñ
+		[0xF2 - PRIMER_LATIN1] = ASCII('o'),
+		[0xF3 - PRIMER_LATIN1] = GLIFO(GLIFO_O_AGUDA, 'o'),
+		[0xF4 - PRIMER_LATIN1] = ASCII('o'),
+		[0xF5 - PRIMER_LATIN1] = ASCII('o'),
+		[0xF6 - PRIMER_LATIN1] = ROM(0xEF, 'o'),		//ö
+		[0xF7 - PRIMER_LATIN1] = ROM(0xFD, '/'),		//÷
+		[0xF9 - PRIMER_LATIN1] = ASCII('u'),
+		[0xFA - PRIMER_LATIN1] = GLIFO(GLIFO_U_AGUDA, 'u'),
+		[0xFB - PRIMER_LATIN1] = ASCII('u'),
+		[0xFC - PRIMER_LATIN1] = ROM(0xF5, 'u'),		//ü
+		[0xFD - PRIMER_LATIN1] = ASCII('y'),
+		[0xFF - PRIMER_LATIN1] = ASCII('y'),
+		};
+
+/**
+ *	@brief Busca el caracter en la tabla de traducción.
+ *		   Las entradas sin reemplazo se muestran como '?'.
+ *	@retval Traducción del caracter.
+ */
+LCD_TraduccionTypedef LCD_traducirLatin1(uint8_t caracter) {
+	LCD_TraduccionTypedef traduccion = { 0, LCD_SIN_GLIFO, (char) caracter };
+	if (caracter < PRIMER_LATIN1)
+		return traduccion;
+
+	const LCD_TraduccionTypedef *entrada = &TRADUCCION[caracter
+			- PRIMER_LATIN1];
+	traduccion.rom = entrada->rom;
+	traduccion.glifo = entrada->glifo == 0 ? LCD_SIN_GLIFO : entrada->glifo - 1;
+	traduccion.ascii = entrada->ascii == 0 ? '?' : entrada->ascii;
+	return traduccion;
+}
+
+/**
+ *	@brief Devuelve el patrón del glifo propio.
+ *	@retval Puntero al patrón, o NULL si el glifo no existe.
+ */
+const uint8_t* LCD_patronGlifo(uint8_t glifo) {
+	if (glifo >= CANTIDAD_GLIFOS)
+		return NULL;
+	return PATRONES[glifo];
+}
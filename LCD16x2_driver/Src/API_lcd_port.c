@@ -2,28 +2,98 @@
  * @file API_lcd_port.c
  * @brief Módulo que implementa 
  *        la comunicación por I2C
- *        con el LCD.
+ *        con el LCD. Cada bus I2C tiene su propio
+ *        estado (handles de la HAL y transferencia en
+ *        curso), y la dirección del display se indica
+ *        en cada transferencia.
  */
 
 #include "API_lcd_port.h"
+#if INSTR_HABILITADA
+#include "API_instrumentacion.h"
+#else
+//sin instrumentación no se necesita la carpeta Common
+#define INSTR_INICIO(marca)
+#define INSTR_FIN(op, marca, bytes, timeout)
+#endif
+#if TRAZA_HABILITADA
+#include "API_traza.h"
+#else
+#define TRAZA_REGISTRAR(tipo, dispositivo, direccion, datos, largo, error)
+#endif
+
+#if I2C_CANTIDAD_BUSES > 2
+#error "Solo se definieron los periféricos de 2 buses I2C"
+#endif
+
+/**
+ * @brief Periférico I2C, interrupciones y stream de DMA de un bus.
+ */
+typedef struct {
+	I2C_TypeDef *instancia;
+	IRQn_Type irqEv;
+	IRQn_Type irqEr;
+	DMA_Stream_TypeDef *streamDma;
+	uint32_t canalDma;
+	IRQn_Type irqDma;
+} bus_i2c_config_t;
 
 /**
- *	@brief Variable global privada para controlar el periferico I2C.
+ * @brief Estado de un bus I2C: handles de la HAL y
+ *        transferencia asíncrona en curso.
  */
-static I2C_HandleTypeDef I2C_HANDLE;
+typedef struct {
+	I2C_HandleTypeDef i2c;
+#if I2C_USAR_DMA
+	DMA_HandleTypeDef dma;
+#endif
+	volatile bool_t transferenciaEnCurso;
+	port_callbackTypedef callbackTransferencia;
+	bool_t inicializado;
+} bus_i2c_t;
+
+static const bus_i2c_config_t BUSES_I2C[I2C_CANTIDAD_BUSES] = {
+		{ I2C_INSTANCE, I2C_EV_IRQN, I2C_ER_IRQN, I2C_DMA_STREAM,
+				I2C_DMA_CHANNEL, I2C_DMA_IRQN },
+#if I2C_CANTIDAD_BUSES > 1
+		{ I2C_BUS1_INSTANCE, I2C_BUS1_EV_IRQN, I2C_BUS1_ER_IRQN,
+				I2C_BUS1_DMA_STREAM, I2C_BUS1_DMA_CHANNEL, I2C_BUS1_DMA_IRQN },
+#endif
+		};
+
+static bus_i2c_t busesI2C[I2C_CANTIDAD_BUSES];
 
 /**
  *	@brief Función privada para inicializar el I2C.
  *	@retval Estado de ejecución.
  */
-static bool_t port_i2cInit();
+static bool_t port_i2cInit(uint8_t);
+static void port_contadorCiclosInit();
+static void port_finalizarTransferencia(uint8_t, bool_t);
+static int8_t port_busDeHandle(I2C_HandleTypeDef*);
 
 /**
- *   @brief Inicializa el periférico I2C.
+ *   @brief Inicializa el bus I2C la primera vez que se usa.
  *	@retval Estado de ejecución.
  **/
-bool_t port_init() {
-	return port_i2cInit();
+bool_t port_init(uint8_t bus) {
+	if (bus >= I2C_CANTIDAD_BUSES)
+		return false;
+	if (busesI2C[bus].inicializado)
+		return true;
+
+	port_contadorCiclosInit();
+	busesI2C[bus].inicializado = port_i2cInit(bus);
+	return busesI2C[bus].inicializado;
+}
+
+/**
+ *	@brief Habilita el contador de ciclos del DWT,
+ *		   que se utiliza en port_delayUs.
+ */
+static void port_contadorCiclosInit() {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
 
 /**
@@ -31,23 +101,50 @@ bool_t port_init() {
  *		   Utiliza la HAL de STM32 para la configuración.
  *	@retval Estado de ejecución.
  */
-static bool_t port_i2cInit() {
-	I2C_HANDLE.Instance = I2C_INSTANCE;
-	I2C_HANDLE.Init.ClockSpeed = I2C_CLOCK_SPEED;
-	I2C_HANDLE.Init.DutyCycle = I2C_DUTYCYCLE_2;
-	I2C_HANDLE.Init.OwnAddress1 = 0;
-	I2C_HANDLE.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
-	I2C_HANDLE.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
-	I2C_HANDLE.Init.OwnAddress2 = 0;
-	I2C_HANDLE.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
-	I2C_HANDLE.Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
+static bool_t port_i2cInit(uint8_t bus) {
+	I2C_HandleTypeDef *I2C = &busesI2C[bus].i2c;
+	const bus_i2c_config_t *config = &BUSES_I2C[bus];
+	I2C->Instance = config->instancia;
+	I2C->Init.ClockSpeed = I2C_CLOCK_SPEED;
+	I2C->Init.DutyCycle = I2C_DUTYCYCLE_2;
+	I2C->Init.OwnAddress1 = 0;
+	I2C->Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+	I2C->Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
+	I2C->Init.OwnAddress2 = 0;
+	I2C->Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
+	I2C->Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
 
 	bool_t estado = false;
 
-	if (HAL_I2C_Init(&I2C_HANDLE) == HAL_OK) {
+	if (HAL_I2C_Init(I2C) == HAL_OK) {
 		estado = true;
 	}
 
+#if I2C_USAR_DMA
+	DMA_HandleTypeDef *DMA = &busesI2C[bus].dma;
+	__HAL_RCC_DMA1_CLK_ENABLE();
+	DMA->Instance = config->streamDma;
+	DMA->Init.Channel = config->canalDma;
+	DMA->Init.Direction = DMA_MEMORY_TO_PERIPH;
+	DMA->Init.PeriphInc = DMA_PINC_DISABLE;
+	DMA->Init.MemInc = DMA_MINC_ENABLE;
+	DMA->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	DMA->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	DMA->Init.Mode = DMA_NORMAL;
+	DMA->Init.Priority = DMA_PRIORITY_LOW;
+	DMA->Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	if (HAL_DMA_Init(DMA) != HAL_OK)
+		estado = false;
+	__HAL_LINKDMA(I2C, hdmatx, *DMA);
+	HAL_NVIC_SetPriority(config->irqDma, I2C_PRIORIDAD_IRQ, 0);
+	HAL_NVIC_EnableIRQ(config->irqDma);
+#endif
+
+	HAL_NVIC_SetPriority(config->irqEv, I2C_PRIORIDAD_IRQ, 0);
+	HAL_NVIC_EnableIRQ(config->irqEv);
+	HAL_NVIC_SetPriority(config->irqEr, I2C_PRIORIDAD_IRQ, 0);
+	HAL_NVIC_EnableIRQ(config->irqEr);
+
 	return estado;
 }
 
@@ -57,12 +154,33 @@ static bool_t port_i2cInit() {
  *		   transmitir.
  *	@retval Estado de ejecución.
  */
-bool_t port_i2cWriteByte(uint8_t _byte) {
-	if (HAL_I2C_Master_Transmit(&I2C_HANDLE, LCD_ADDRESS << 1, &_byte, 1,
-			I2C_TIMEOUT) == HAL_OK)
-		return true;
-	else
+bool_t port_i2cWriteByte(uint8_t bus, uint8_t direccion, uint8_t _byte) {
+	return port_i2cWriteBuffer(bus, direccion, &_byte, 1);
+}
+
+/**
+ *   @brief Escribe una secuencia de bytes por I2C en
+ *		   una única transacción (una sola condición de
+ *		   start, dirección y stop). El timeout se extiende
+ *		   según el tiempo que demora transmitir los
+ *		   bytes a I2C_CLOCK_SPEED.
+ *	@retval Estado de ejecución.
+ */
+bool_t port_i2cWriteBuffer(uint8_t bus, uint8_t direccion,
+		const uint8_t *buffer, size_t largo) {
+	if (bus >= I2C_CANTIDAD_BUSES || buffer == NULL || largo == 0
+			|| largo > UINT16_MAX)
 		return false;
+
+	//9 bits por byte (8 de datos + ACK)
+	uint32_t timeout = I2C_TIMEOUT + (largo * 9 * 1000) / I2C_CLOCK_SPEED;
+	INSTR_INICIO(inicio);
+	HAL_StatusTypeDef estado = HAL_I2C_Master_Transmit(&busesI2C[bus].i2c,
+			direccion << 1, (uint8_t*) buffer, (uint16_t) largo, timeout);
+	INSTR_FIN(INSTR_I2C_WRITE, inicio, largo + 1, estado == HAL_TIMEOUT);
+	TRAZA_REGISTRAR(TRAZA_I2C_ESCRITURA, bus, direccion, buffer, largo,
+			estado != HAL_OK);
+	return estado == HAL_OK;
 }
 
 /**
@@ -70,6 +188,207 @@ bool_t port_i2cWriteByte(uint8_t _byte) {
  *		   utilizando HAL_Delay.
  */
 void port_delay(uint32_t delay) {
+	INSTR_INICIO(inicio);
 	HAL_Delay(delay);
+	INSTR_FIN(INSTR_DELAY, inicio, 0, false);
+}
+
+/**
+ *   @brief Implementa un delay bloqueante con resolución
+ *		   de microsegundos utilizando el contador de ciclos
+ *		   del DWT. La resta en uint32_t tolera el desborde
+ *		   del contador.
+ */
+void port_delayUs(uint32_t delay) {
+	uint32_t inicio = port_marcaTiempo();
+	while (!port_transcurrioUs(inicio, delay))
+		;
+	//la marca de tiempo es el mismo contador de ciclos que usa la instrumentación
+	INSTR_FIN(INSTR_DELAY, inicio, 0, false);
+}
+
+/**
+ *   @brief Devuelve el valor del contador de ciclos del DWT.
+ */
+uint32_t port_marcaTiempo() {
+	return DWT->CYCCNT;
+}
+
+/**
+ *   @brief Indica si transcurrieron al menos delay uS desde
+ *		   la marca de tiempo. La resta en uint32_t tolera
+ *		   el desborde del contador.
+ */
+bool_t port_transcurrioUs(uint32_t marca, uint32_t delay) {
+	uint32_t ciclos = delay * (SystemCoreClock / 1000000);
+	return (DWT->CYCCNT - marca) >= ciclos;
+}
+
+/**
+ *   @brief Lee la causa del reinicio en RCC->CSR. Es en caliente
+ *		   si no hubo un reinicio por encendido o por baja tensión
+ *		   (POR/BOR), que también reinician los displays. La causa
+ *		   se lee solo la primera vez y se conserva, y las banderas
+ *		   se borran para poder distinguir el próximo reinicio.
+ */
+bool_t port_reinicioEnCaliente() {
+	static bool_t leida = false;
+	static bool_t enCaliente = false;
+
+	if (!leida) {
+		enCaliente = !__HAL_RCC_GET_FLAG(RCC_FLAG_PORRST)
+				&& !__HAL_RCC_GET_FLAG(RCC_FLAG_BORRST);
+		__HAL_RCC_CLEAR_RESET_FLAGS();
+		leida = true;
+	}
+	return enCaliente;
 }
 
+/**
+ *   @brief Inicia una transmisión por I2C sin bloquear,
+ *		   con DMA o por interrupción según I2C_USAR_DMA.
+ *		   Al finalizar se llama al callback configurado. La
+ *		   transferencia se registra en la traza al iniciarla.
+ *	@retval Verdadero si se pudo iniciar la transferencia.
+ */
+bool_t port_i2cWriteBufferAsync(uint8_t bus, uint8_t direccion,
+		const uint8_t *buffer, size_t largo) {
+	if (bus >= I2C_CANTIDAD_BUSES || buffer == NULL || largo == 0
+			|| largo > UINT16_MAX)
+		return false;
+	bus_i2c_t *estadoBus = &busesI2C[bus];
+	if (estadoBus->transferenciaEnCurso)
+		return false;
+
+	estadoBus->transferenciaEnCurso = true;
+#if I2C_USAR_DMA
+	HAL_StatusTypeDef estado = HAL_I2C_Master_Transmit_DMA(&estadoBus->i2c,
+			direccion << 1, (uint8_t*) buffer, (uint16_t) largo);
+#else
+	HAL_StatusTypeDef estado = HAL_I2C_Master_Transmit_IT(&estadoBus->i2c,
+			direccion << 1, (uint8_t*) buffer, (uint16_t) largo);
+#endif
+	TRAZA_REGISTRAR(TRAZA_I2C_ESCRITURA, bus, direccion, buffer, largo,
+			estado != HAL_OK);
+	if (estado != HAL_OK) {
+		estadoBus->transferenciaEnCurso = false;
+		return false;
+	}
+	return true;
+}
+
+/**
+ *   @brief Indica si hay una transferencia asíncrona
+ *		   en curso en el bus.
+ */
+bool_t port_i2cOcupado(uint8_t bus) {
+	return bus < I2C_CANTIDAD_BUSES && busesI2C[bus].transferenciaEnCurso;
+}
+
+/**
+ *   @brief Configura la función que se llama al finalizar
+ *		   una transferencia asíncrona en el bus.
+ */
+void port_i2cSetCallback(uint8_t bus, port_callbackTypedef callback) {
+	if (bus < I2C_CANTIDAD_BUSES)
+		busesI2C[bus].callbackTransferencia = callback;
+}
+
+/**
+ *   @brief Marca la transferencia del bus como finalizada
+ *		   y notifica el resultado al callback.
+ */
+static void port_finalizarTransferencia(uint8_t bus, bool_t exito) {
+	busesI2C[bus].transferenciaEnCurso = false;
+	if (busesI2C[bus].callbackTransferencia != NULL)
+		busesI2C[bus].callbackTransferencia(bus, exito);
+}
+
+/**
+ *   @brief Busca el bus al que pertenece un handle de la HAL.
+ *	@retval Índice del bus, o -1 si el handle no es de este módulo.
+ */
+static int8_t port_busDeHandle(I2C_HandleTypeDef *hi2c) {
+	for (uint8_t bus = 0; bus < I2C_CANTIDAD_BUSES; bus++) {
+		if (hi2c == &busesI2C[bus].i2c)
+			return bus;
+	}
+	return -1;
+}
+
+void port_i2cTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+	int8_t bus = port_busDeHandle(hi2c);
+	if (bus >= 0)
+		port_finalizarTransferencia(bus, true);
+}
+
+void port_i2cErrorCallback(I2C_HandleTypeDef *hi2c) {
+	int8_t bus = port_busDeHandle(hi2c);
+	if (bus >= 0)
+		port_finalizarTransferencia(bus, false);
+}
+
+void port_i2cEvIrqHandler(uint8_t bus) {
+	if (bus < I2C_CANTIDAD_BUSES)
+		HAL_I2C_EV_IRQHandler(&busesI2C[bus].i2c);
+}
+
+void port_i2cErIrqHandler(uint8_t bus) {
+	if (bus < I2C_CANTIDAD_BUSES)
+		HAL_I2C_ER_IRQHandler(&busesI2C[bus].i2c);
+}
+
+void port_i2cDmaIrqHandler(uint8_t bus) {
+#if I2C_USAR_DMA
+	if (bus < I2C_CANTIDAD_BUSES)
+		HAL_DMA_IRQHandler(&busesI2C[bus].dma);
+#endif
+}
+
+#if LCD_DEFINIR_IRQ
+/**
+ *   @brief Callbacks de la HAL para el fin de una
+ *		   transmisión y para errores del I2C.
+ */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+	port_i2cTxCpltCallback(hi2c);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+	port_i2cErrorCallback(hi2c);
+}
+
+/**
+ *   @brief Rutinas de atención de interrupción del I2C
+ *		   y del stream de DMA de cada bus.
+ */
+void I2C_EV_IRQ_HANDLER(void) {
+	port_i2cEvIrqHandler(0);
+}
+
+void I2C_ER_IRQ_HANDLER(void) {
+	port_i2cErIrqHandler(0);
+}
+
+#if I2C_USAR_DMA
+void I2C_DMA_IRQ_HANDLER(void) {
+	port_i2cDmaIrqHandler(0);
+}
+#endif
+
+#if I2C_CANTIDAD_BUSES > 1
+void I2C_BUS1_EV_IRQ_HANDLER(void) {
+	port_i2cEvIrqHandler(1);
+}
+
+void I2C_BUS1_ER_IRQ_HANDLER(void) {
+	port_i2cErIrqHandler(1);
+}
+
+#if I2C_USAR_DMA
+void I2C_BUS1_DMA_IRQ_HANDLER(void) {
+	port_i2cDmaIrqHandler(1);
+}
+#endif
+#endif
+#endif
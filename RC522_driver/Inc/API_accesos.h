@@ -0,0 +1,105 @@
+/**
+ * @file API_accesos.h
+ * @brief Módulo que permite decidir si un UID leído
+ * 		  por el MFRC522 está autorizado. Ofrece dos
+ * 		  tipos de tabla con tiempo de búsqueda constante:
+ * 		  - Tabla estática con hash perfecto, generada en
+ * 		    tiempo de compilación y guardada en flash.
+ * 		  - Tabla dinámica con direccionamiento abierto,
+ * 		    que permite agregar y quitar UIDs en ejecución.
+ */
+
+#ifndef API_INC_API_ACCESOS_H_
+#define API_INC_API_ACCESOS_H_
+
+#include "API_types.h"
+#include "API_mfrc522.h"
+
+//porcentaje máximo de ocupación de la tabla dinámica
+#define ACCESOS_CARGA_MAXIMA		75
+
+/**
+ *   @brief Entrada de una tabla de accesos. largo = 0
+ *          indica una posición libre.
+ */
+typedef struct {
+	uint8_t largo;
+	uint8_t uid[MFRC522_UID_MAX];
+} accesos_entrada_t;
+
+/**
+ *   @brief Tabla estática con hash perfecto (hash y
+ *          desplazamiento). Cada UID se asigna a un grupo,
+ *          y el desplazamiento del grupo determina su posición
+ *          en la tabla sin colisiones. Se genera con la
+ *          herramienta Host/Tools/gen_tabla_accesos.c.
+ */
+typedef struct {
+	uint32_t semilla;
+	uint32_t cantidadGrupos;
+	uint32_t tamano;
+	const uint16_t *desplazamientos;
+	const accesos_entrada_t *entradas;
+} accesos_tablaEstatica_t;
+
+/**
+ *   @brief Tabla dinámica con direccionamiento abierto y
+ *          sondeo lineal. El almacenamiento lo provee la
+ *          aplicación y su capacidad debe ser potencia de 2.
+ */
+typedef struct {
+	accesos_entrada_t *entradas;
+	uint32_t capacidad;
+	uint32_t cantidad;
+} accesos_tabla_t;
+
+/**
+ *   @brief Calcula el hash de un UID (FNV-1a de 32 bits
+ *          con mezcla final) a partir de una semilla.
+ */
+uint32_t accesos_hash(const uint8_t *uid, uint8_t largo, uint32_t semilla);
+
+/**
+ *   @brief Calcula la posición de un UID en una tabla estática
+ *          a partir de su hash y del desplazamiento de su grupo.
+ */
+uint32_t accesos_posicionEstatica(uint32_t hash, uint16_t desplazamiento,
+		uint32_t tamano);
+
+/**
+ *   @brief Busca un UID en una tabla estática.
+ *   @retval Verdadero si el UID está en la tabla.
+ */
+bool_t accesos_estaticaBuscar(const accesos_tablaEstatica_t *tabla,
+		const uint8_t *uid, uint8_t largo);
+
+/**
+ *   @brief Inicializa una tabla dinámica vacía.
+ *   @retval Falso si la capacidad no es potencia de 2.
+ */
+bool_t accesos_tablaInit(accesos_tabla_t *tabla,
+		accesos_entrada_t *almacenamiento, uint32_t capacidad);
+
+/**
+ *   @brief Agrega un UID a una tabla dinámica.
+ *   @retval Verdadero si el UID queda en la tabla (también si
+ *           ya estaba), falso si la tabla está llena.
+ */
+bool_t accesos_tablaAgregar(accesos_tabla_t *tabla, const uint8_t *uid,
+		uint8_t largo);
+
+/**
+ *   @brief Quita un UID de una tabla dinámica.
+ *   @retval Verdadero si el UID estaba en la tabla.
+ */
+bool_t accesos_tablaQuitar(accesos_tabla_t *tabla, const uint8_t *uid,
+		uint8_t largo);
+
+/**
+ *   @brief Busca un UID en una tabla dinámica.
+ *   @retval Verdadero si el UID está en la tabla.
+ */
+bool_t accesos_tablaBuscar(const accesos_tabla_t *tabla, const uint8_t *uid,
+		uint8_t largo);
+
+#endif /* API_INC_API_ACCESOS_H_ */
@@ -12,8 +12,143 @@
 
 #include "API_types.h"
 
+//largo máximo de un UID (triple, nivel de cascada 3) según ISO/IEC 14443-3
+#define MFRC522_UID_MAX			10
+
+//parámetros por defecto del planificador de lecturas (mfrc522_poll), en ms
+#define MFRC522_POLL_MIN_MS		20		//período luego de detectar una tarjeta
+#define MFRC522_POLL_MAX_MS		320		//período máximo sin tarjetas
+#define MFRC522_POLL_BAJO_CONSUMO_MS	80	//a partir de este período se apaga el MFRC522 entre lecturas
+
+//parámetros por defecto del seguimiento de presencia (mfrc522_presencia)
+#define MFRC522_PRESENCIA_REBOTE		2		//sondeos fallidos seguidos para considerar retirada la tarjeta
+#define MFRC522_PRESENCIA_VENTANA_MS	500		//una tarjeta que vuelve antes de este tiempo no se informa de nuevo
+
+//tiempo máximo por defecto entre el fin de un comando REQA, WUPA, de
+//anticolisión, selección o HLTA y el inicio de la respuesta, en uS.
+//ISO/IEC 14443-3 fija la respuesta a 1236 / fc = 91 uS, y el timer del
+//MFRC522 se detiene al recibir los primeros bits.
+#define MFRC522_ESPERA_TRAMA_US		200
+
+//largo máximo de una trama enviada a la tarjeta (SEL, NVB, UID del nivel, BCC y CRC_A)
+#define MFRC522_TRAMA_MAX		9
+
+/**
+ *   @brief Datos de una tarjeta seleccionada: UID de
+ *          4, 7 o 10 bytes, SAK de la selección y
+ *          respuesta ATQA al comando REQA.
+ */
+typedef struct {
+	uint8_t largo;
+	uint8_t uid[MFRC522_UID_MAX];
+	uint8_t sak;
+	uint8_t atqa[2];
+} mfrc522_uid_t;
+
+/**
+ *   @brief Resultado de mfrc522_lectorProcesar.
+ */
+typedef enum {
+	MFRC522_LECTURA_EN_CURSO,		//esperando la respuesta de la tarjeta
+	MFRC522_LECTURA_TARJETA,		//se seleccionó una tarjeta
+	MFRC522_LECTURA_SIN_TARJETA,	//ninguna tarjeta respondió al REQA
+	MFRC522_LECTURA_ERROR			//la selección no se pudo completar
+} mfrc522_lectura_enum;
+
+/**
+ *   @brief Evento del seguimiento de presencia (mfrc522_lectorPresencia).
+ */
+typedef enum {
+	MFRC522_EVENTO_NINGUNO,			//sin novedades
+	MFRC522_EVENTO_LLEGADA,			//se acercó una tarjeta
+	MFRC522_EVENTO_PRESENTE,		//la tarjeta sigue en el campo RF
+	MFRC522_EVENTO_RETIRO			//la tarjeta se retiró del campo RF
+} mfrc522_evento_enum;
+
+/**
+ *   @brief Configuración del receptor y del transmisor de
+ *          RF. Los valores por defecto del MFRC522 luego de un
+ *          SoftReset son ganancia 4, umbral 8, conductanciaP 32
+ *          y conductanciaN 8.
+ */
+typedef struct {
+	uint8_t ganancia;			//RxGain de RFCfgReg (0 a 7: 18, 23, 18, 23, 33, 38, 43 y 48 dB)
+	uint8_t umbral;				//MinLevel de RxThresholdReg (0 a 15)
+	uint8_t conductanciaP;		//CWGsP de CWGsPReg (0 a 63), potencia de la portadora
+	uint8_t conductanciaN;		//CWGsN de GsNReg (0 a 15), potencia de la portadora
+} mfrc522_rf_t;
+
+/**
+ *   @brief Contadores de calidad del enlace de RF de un lector,
+ *          desde mfrc522_lectorInit o mfrc522_lectorTelemetriaBorrar.
+ *          Se obtienen de los resultados de las lecturas y del
+ *          ErrorReg que el driver ya lee en cada intercambio, sin
+ *          transferencias SPI adicionales.
+ */
+typedef struct {
+	uint32_t lecturas;			//lecturas iniciadas
+	uint32_t aciertos;			//lecturas que seleccionaron una tarjeta
+	uint32_t sinTarjeta;		//lecturas sin respuesta al REQA
+	uint32_t fallidas;			//lecturas con respuesta que no se completaron
+	uint32_t reintentos;		//lecturas fallidas seguidas antes de cada acierto
+	uint32_t intercambios;		//intercambios con respuesta esperada (sin HLTA)
+	uint32_t timeouts;			//intercambios sin respuesta de la tarjeta
+	uint32_t erroresCrc;		//CRC_A del SAK o BCC del UID incorrectos
+	uint32_t erroresParidad;	//ParityErr de ErrorReg
+	uint32_t erroresProtocolo;	//ProtocolErr de ErrorReg
+	uint32_t desbordesFifo;		//BufferOvfl de ErrorReg
+	uint32_t colisiones;		//CollErr de ErrorReg
+	uint8_t ultimoErrorReg;		//ErrorReg del último intercambio con errores
+} mfrc522_telemetria_t;
+
+/**
+ *   @brief Estado de un lector MFRC522. Lo reserva la
+ *          aplicación (uno por lector) y lo inicializa
+ *          mfrc522_lectorInit. Los campos son de uso
+ *          interno del driver.
+ */
+typedef struct {
+	uint8_t indice;				//lector del módulo API_mfrc522_port
+	//planificador de lecturas
+	uint32_t periodoMinimoPoll;
+	uint32_t periodoMaximoPoll;
+	uint32_t periodoPoll;
+	uint32_t proximoPoll;
+	bool_t bajoConsumo;
+	bool_t guardaCampo;			//la antena se encendió y las tarjetas todavía se energizan
+	uint32_t encendidoCampo;	//tick en que se encendió la antena
+	//lectura no bloqueante en curso
+	uint8_t etapa;
+	uint8_t nivel;
+	uint8_t bitsConocidos;
+	uint8_t colisiones;
+	uint32_t inicioIntercambio;
+	uint32_t esperaMaximaMs;	//límite de la espera del intercambio en curso
+	//timer del MFRC522
+	uint32_t esperaTramaUs;
+	uint32_t esperaTimerUs;		//espera programada en el timer (0 = desconocida)
+	uint16_t prescalerTimer;
+	uint8_t trama[MFRC522_TRAMA_MAX];
+	mfrc522_uid_t uid;
+	//seguimiento de presencia
+	bool_t tarjetaEnCampo;
+	bool_t tarjetaLista;		//la tarjeta quedó en READY y responde a la anticolisión
+	uint8_t reboteSondeos;
+	uint8_t sondeosFallidos;
+	uint32_t ventanaPresencia;
+	uint32_t ultimaPresencia;
+	mfrc522_uid_t tarjetaPresente;
+	//calidad del enlace de RF
+	mfrc522_telemetria_t telemetria;
+	uint32_t fallidasSeguidas;
+	//datos de la cadena de DMA, válidos hasta que termina
+	uint8_t valoresCadena[7];
+	uint8_t comandoCadena[MFRC522_TRAMA_MAX];
+} mfrc522_t;
+
 /**
  *   @brief Inicializa el módulo MFRC522
+ *          conectado como lector 0.
  */
 void mfrc522_init();
 
@@ -31,9 +166,179 @@ void mfrc522_reset();
  *          la tarjeta y lo almacena en la
  *          posición de memoria a la que apunta
  *          el puntero uid.
+ *          Se almacenan los primeros 4 bytes del UID,
+ *          por lo que para UIDs de 7 o 10 bytes debe
+ *          utilizarse mfrc522_leerUIDCompleto.
  *   @retval Devuelve verdadero si se logra detectar
  *           una tarjeta, en caso contrario devuelve falso.
  */
 bool_t mfrc522_leerUIDTarjeta(uint8_t *uid);
 
+/**
+ *   @brief Detecta si hay alguna tarjeta en proximidades
+ *          del lector y la selecciona con el procedimiento
+ *          de anticolisión de ISO/IEC 14443-3, recorriendo
+ *          los niveles de cascada necesarios. Si hay varias
+ *          tarjetas, se selecciona una de ellas.
+ *   @retval Devuelve verdadero si se selecciona una
+ *           tarjeta, en caso contrario devuelve falso.
+ */
+bool_t mfrc522_leerUIDCompleto(mfrc522_uid_t *uid);
+
+/**
+ *   @brief Lee el UID de todas las tarjetas presentes en
+ *          el campo RF. Cada tarjeta leída se detiene con
+ *          el comando HLTA para que no vuelva a responder,
+ *          hasta que salga del campo RF o reciba un WUPA.
+ *   @retval Cantidad de tarjetas leídas (como máximo maxTarjetas).
+ */
+uint8_t mfrc522_inventario(mfrc522_uid_t *tarjetas, uint8_t maxTarjetas);
+
+/**
+ *   @brief Configura el período mínimo y máximo entre
+ *          lecturas del planificador mfrc522_poll.
+ */
+void mfrc522_pollConfigurar(uint32_t periodoMinimo, uint32_t periodoMaximo);
+
+/**
+ *   @brief Planificador de lecturas no bloqueante. Debe
+ *          llamarse periódicamente desde el loop principal.
+ *          Cuando corresponde, intenta leer una tarjeta. El
+ *          período entre lecturas es mínimo luego de detectar
+ *          una tarjeta y se duplica con cada lectura sin tarjeta
+ *          hasta el máximo. Con períodos largos, el MFRC522 queda
+ *          en bajo consumo con la antena apagada entre lecturas.
+ *   @retval Verdadero si en esta llamada se leyó una tarjeta.
+ */
+bool_t mfrc522_poll(mfrc522_uid_t *uid);
+
+/**
+ *   @brief Configura el tiempo máximo en uS que se espera
+ *          la respuesta a los comandos REQA, WUPA, de
+ *          anticolisión, selección y HLTA. El timer del MFRC522
+ *          se programa con cada comando según su espera, por
+ *          lo que una lectura sin tarjeta termina en cuanto
+ *          vence y los comandos lentos no terminan antes.
+ */
+void mfrc522_esperaConfigurar(uint32_t esperaUs);
+
+/**
+ *   @brief Configura el seguimiento de presencia: cantidad de
+ *          sondeos fallidos seguidos (al menos 1) y tiempo en ms
+ *          sin respuesta de la tarjeta para informar que se retiró.
+ */
+void mfrc522_presenciaConfigurar(uint8_t rebote, uint32_t ventanaMs);
+
+/**
+ *   @brief Seguimiento de presencia de una tarjeta. Debe llamarse
+ *          periódicamente. Sin tarjeta conocida, intenta leer una
+ *          con REQA y la selección completa. Con una tarjeta
+ *          conocida, solo confirma que sigue en el campo RF con
+ *          un intercambio corto, sin volver a seleccionarla. Con
+ *          MFRC522_EVENTO_LLEGADA, MFRC522_EVENTO_PRESENTE y
+ *          MFRC522_EVENTO_RETIRO se copia la tarjeta en uid.
+ *   @retval Evento ocurrido en esta llamada.
+ */
+mfrc522_evento_enum mfrc522_presencia(mfrc522_uid_t *uid);
+
+/**
+ *   @brief Inicializa el lector indice del módulo
+ *          API_mfrc522_port y su estado.
+ *   @retval Falso si no se puede inicializar el bus SPI.
+ */
+bool_t mfrc522_lectorInit(mfrc522_t *lector, uint8_t indice);
+
+/**
+ *   @brief Equivalentes de mfrc522_reset, mfrc522_leerUIDCompleto,
+ *          mfrc522_inventario, mfrc522_pollConfigurar y
+ *          mfrc522_poll para un lector en particular.
+ */
+void mfrc522_lectorReset(mfrc522_t *lector);
+bool_t mfrc522_lectorLeerUID(mfrc522_t *lector, mfrc522_uid_t *uid);
+uint8_t mfrc522_lectorInventario(mfrc522_t *lector, mfrc522_uid_t *tarjetas,
+		uint8_t maxTarjetas);
+void mfrc522_lectorPollConfigurar(mfrc522_t *lector, uint32_t periodoMinimo,
+		uint32_t periodoMaximo);
+bool_t mfrc522_lectorPoll(mfrc522_t *lector, mfrc522_uid_t *uid);
+
+/**
+ *   @brief Equivalentes de mfrc522_presenciaConfigurar,
+ *          mfrc522_presencia y mfrc522_esperaConfigurar
+ *          para un lector en particular.
+ */
+void mfrc522_lectorPresenciaConfigurar(mfrc522_t *lector, uint8_t rebote,
+		uint32_t ventanaMs);
+mfrc522_evento_enum mfrc522_lectorPresencia(mfrc522_t *lector,
+		mfrc522_uid_t *uid);
+void mfrc522_lectorEsperaConfigurar(mfrc522_t *lector, uint32_t esperaUs);
+
+/**
+ *   @brief Inicia la lectura de una tarjeta sin esperar la
+ *          respuesta. Debe continuarse con mfrc522_lectorProcesar.
+ *   @retval Falso si el lector ya tiene una lectura en curso.
+ */
+bool_t mfrc522_lectorIniciarLectura(mfrc522_t *lector);
+
+/**
+ *   @brief Continúa la lectura iniciada con mfrc522_lectorIniciarLectura.
+ *          Si el intercambio con la tarjeta terminó, procesa la
+ *          respuesta y envía el comando siguiente, sin bloquear.
+ *   @retval MFRC522_LECTURA_EN_CURSO mientras la lectura no termina.
+ *           Con MFRC522_LECTURA_TARJETA se copia la tarjeta en uid.
+ */
+mfrc522_lectura_enum mfrc522_lectorProcesar(mfrc522_t *lector,
+		mfrc522_uid_t *uid);
+
+/**
+ *   @brief Realiza una lectura en cada uno de los lectores en
+ *          forma intercalada: mientras un lector espera la
+ *          respuesta de la tarjeta, se usa el bus SPI para los
+ *          demás. Para los lectores sin tarjeta, uids[i].largo = 0.
+ *   @retval Cantidad de lectores en los que se leyó una tarjeta.
+ */
+uint8_t mfrc522_leerLectores(mfrc522_t *lectores, uint8_t cantidad,
+		mfrc522_uid_t *uids);
+
+/**
+ *   @brief Lee la configuración de RF del lector en una
+ *          única transferencia SPI.
+ */
+void mfrc522_lectorRfLeer(mfrc522_t *lector, mfrc522_rf_t *rf);
+
+/**
+ *   @brief Escribe la configuración de RF del lector, sin
+ *          modificar los demás bits de los registros. Se pierde
+ *          con mfrc522_lectorReset o al cortar la alimentación
+ *          del MFRC522, por lo que la aplicación puede guardar
+ *          la obtenida con mfrc522_lectorAutoajustar y volver a
+ *          escribirla al arrancar.
+ *   @retval Falso si algún valor está fuera de rango.
+ */
+bool_t mfrc522_lectorRfConfigurar(mfrc522_t *lector, const mfrc522_rf_t *rf);
+
+/**
+ *   @brief Copia la telemetría del lector, o la borra.
+ */
+void mfrc522_lectorTelemetria(const mfrc522_t *lector,
+		mfrc522_telemetria_t *telemetria);
+void mfrc522_lectorTelemetriaBorrar(mfrc522_t *lector);
+
+/**
+ *   @brief Ajusta la configuración de RF del lector con una
+ *          tarjeta apoyada en él. Recorre los valores de la
+ *          ganancia, del umbral y de la potencia de la portadora
+ *          de a un parámetro por vez, manteniendo los demás en el
+ *          mejor valor hallado, y en cada configuración realiza
+ *          intentos lecturas. Se queda con la que más lecturas
+ *          completa y, entre ellas, con la que usa menos
+ *          intercambios (menos reintentos y timeouts). La
+ *          telemetría del lector no incluye estas lecturas.
+ *   @retval Falso si no se leyó la tarjeta con ninguna
+ *           configuración (se restaura la anterior). Con
+ *           verdadero, la configuración elegida queda escrita
+ *           y se copia en rf si no es NULL.
+ */
+bool_t mfrc522_lectorAutoajustar(mfrc522_t *lector, uint8_t intentos,
+		mfrc522_rf_t *rf);
+
 #endif /* API_INC_API_MFRC522_H_ */
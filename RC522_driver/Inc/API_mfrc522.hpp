@@ -0,0 +1,360 @@
+/**
+ * @file API_mfrc522.hpp
+ * @brief Interfaz en C++, solo de encabezado, para leer el UID
+ * 		  de tarjetas con el MFRC522. Cada lector es un tipo
+ * 		  Mfrc522<Bus, CsPin>: el bus SPI y el pin de CS son
+ * 		  parámetros del template, por lo que las direcciones de
+ * 		  los registros, la configuración y el timer se calculan
+ * 		  al compilar, y el compilador puede expandir en línea todo
+ * 		  el camino hasta el registro de datos del SPI. Varios
+ * 		  lectores son tipos distintos, sin índices, punteros a
+ * 		  funciones ni estado en RAM.
+ *
+ * 		  La lectura es bloqueante y consulta ComIrqReg por SPI.
+ * 		  El planificador, el seguimiento de presencia, la lectura
+ * 		  intercalada de varios lectores con DMA y la resolución de
+ * 		  colisiones están en el driver en C (API_mfrc522.h).
+ *
+ * 		  Bus debe proveer:
+ * 		  - static bool iniciar();
+ * 		  - template<class Cs> static void transferir(const uint8_t *tx,
+ * 		    uint8_t *rx, uint16_t largo); con el CS activo durante toda
+ * 		    la transferencia. rx puede ser nullptr.
+ * 		  - static uint32_t tickMs();
+ *
+ * 		  CsPin debe proveer static void iniciar(), activar() y liberar().
+ * 		  En API_mfrc522_port.hpp están los del STM32F4.
+ */
+
+#ifndef API_INC_API_MFRC522_HPP_
+#define API_INC_API_MFRC522_HPP_
+
+extern "C" {
+#include "API_mfrc522.h"
+}
+
+namespace mfrc522 {
+
+//registros utilizados, sección 9.2 de la hoja de datos
+enum class Registro : uint8_t {
+	CommandReg = 0x01,
+	ComIrqReg = 0x04,
+	ErrorReg = 0x06,
+	FIFODataReg = 0x09,
+	FIFOLevelReg = 0x0A,
+	BitFramingReg = 0x0D,
+	CollReg = 0x0E,
+	TxControlReg = 0x14,
+	TxASKReg = 0x15,
+	TModeReg = 0x2A,
+	TPrescalerReg = 0x2B,
+	TReloadRegH = 0x2C,
+	TReloadRegL = 0x2D,
+	VersionReg = 0x37
+};
+
+//comandos del MFRC522, sección 10.3 de la hoja de datos
+enum class Comando : uint8_t {
+	Idle = 0x00, Transceive = 0x0C, SoftReset = 0x0F
+};
+
+//comandos de ISO/IEC 14443-3
+constexpr uint8_t CMD_REQA = 0x26;
+constexpr uint8_t CMD_SEL[] = { 0x93, 0x95, 0x97 };
+constexpr uint8_t NVB_ANTICOLISION = 0x20;
+constexpr uint8_t NVB_SELECT = 0x70;
+constexpr uint8_t CASCADE_TAG = 0x88;
+constexpr uint8_t SAK_UID_INCOMPLETO = 1 << 2;
+constexpr uint8_t BITS_REQA = 7;
+constexpr uint8_t BYTES_NIVEL = 5;			//4 bytes de UID + BCC
+constexpr uint8_t NIVELES_CASCADA = 3;
+
+//bits de los registros
+constexpr uint8_t CommandReg_PowerDown = 1 << 4;
+constexpr uint8_t ComIrqReg_RxIrq = 1 << 5;
+constexpr uint8_t ComIrqReg_TimerIrq = 1 << 0;
+constexpr uint8_t ComIrqReg_TodosLosBits = 0x7F;
+constexpr uint8_t ErrorReg_CollErr = 1 << 3;
+constexpr uint8_t ErrorReg_ErroresRecepcion = (1 << 0) | (1 << 1) | (1 << 4);
+constexpr uint8_t FIFOLevelReg_FlushBuffer = 0x80;
+constexpr uint8_t BitFramingReg_StartSend = 0x80;
+constexpr uint8_t TModeReg_TAuto = 1 << 7;
+constexpr uint8_t TxControlReg_Antena = (1 << 7) | (1 << 1) | 1;
+constexpr uint8_t TxASKReg_Force100ASK = 0x40;
+
+//constantes del timer, iguales a las del driver en C
+constexpr uint32_t FRECUENCIA_TIMER_KHZ = 13560;
+constexpr uint16_t PRESCALER_TIMER = 169;		//cuentas de 25 uS
+constexpr uint16_t PRESCALER_TIMER_MAX = 0x0FFF;
+constexpr uint32_t CUENTAS_TIMER_MAX = 0x10000UL;
+constexpr uint32_t DURACION_BIT_CUS = 944;		//centésimas de uS
+constexpr uint32_t TIMEOUT_OSCILADOR_MS = 10;
+
+/**
+ *   @brief Primer byte de una transferencia SPI: dirección
+ *          desplazada un bit y bit de lectura (sección 8.1.2.3).
+ */
+constexpr uint8_t direccionEscritura(Registro reg) {
+	return (static_cast<uint8_t>(reg) << 1) & 0x7E;
+}
+
+constexpr uint8_t direccionLectura(Registro reg) {
+	return 0x80 | direccionEscritura(reg);
+}
+
+/**
+ *   @brief Prescaler y recarga del timer del MFRC522 para una
+ *          espera, calculados como mfrc522_calcularTimer.
+ */
+struct Timer {
+	uint16_t prescaler;
+	uint16_t recarga;
+};
+
+constexpr Timer calcularTimer(uint32_t esperaUs) {
+	uint64_t ciclos = ((uint64_t) esperaUs * FRECUENCIA_TIMER_KHZ + 999) / 1000;
+	uint32_t divisor = 2 * PRESCALER_TIMER + 1;
+	uint16_t prescaler = PRESCALER_TIMER;
+
+	if (ciclos > CUENTAS_TIMER_MAX * divisor) {
+		uint32_t valor = (uint32_t) ((ciclos + CUENTAS_TIMER_MAX - 1)
+				/ CUENTAS_TIMER_MAX) / 2;
+		if (valor > PRESCALER_TIMER_MAX)
+			valor = PRESCALER_TIMER_MAX;
+		divisor = 2 * valor + 1;
+		prescaler = (uint16_t) valor;
+	}
+
+	uint64_t cuentas = (ciclos + divisor - 1) / divisor;
+	if (cuentas == 0)
+		cuentas = 1;
+	if (cuentas > CUENTAS_TIMER_MAX)
+		cuentas = CUENTAS_TIMER_MAX;
+	return Timer { prescaler, (uint16_t) (cuentas - 1) };
+}
+
+/**
+ *   @brief CRC_A de ISO/IEC 14443-3 (Anexo B). Con argumentos
+ *          constantes se calcula al compilar.
+ */
+constexpr uint16_t calcularCRC(const uint8_t *datos, uint8_t largo) {
+	uint16_t crc = 0x6363;
+	for (uint8_t i = 0; i < largo; i++) {
+		uint8_t byte = datos[i] ^ (uint8_t) (crc & 0xFF);
+		byte ^= byte << 4;
+		crc = (crc >> 8) ^ ((uint16_t) byte << 8) ^ ((uint16_t) byte << 3)
+				^ (byte >> 4);
+	}
+	return crc;
+}
+
+/**
+ *   @brief Escritura de un registro, ya codificada como
+ *          los dos bytes de la transferencia SPI.
+ */
+struct Escritura {
+	uint8_t bytes[2];
+};
+
+constexpr Escritura escritura(Registro reg, uint8_t valor) {
+	return Escritura { { direccionEscritura(reg), valor } };
+}
+
+/**
+ *   @brief Configuración que se escribe luego del SoftReset.
+ *          El timer se calcula para EsperaUs, por lo que la
+ *          recarga no cambia entre comandos.
+ */
+template<uint32_t EsperaUs>
+struct Configuracion {
+	static constexpr Timer TIMER = calcularTimer(EsperaUs);
+	static constexpr Escritura SECUENCIA[] = {
+			escritura(Registro::TModeReg,
+					TModeReg_TAuto | (TIMER.prescaler >> 8)),
+			escritura(Registro::TPrescalerReg, TIMER.prescaler & 0xFF),
+			escritura(Registro::TReloadRegH, TIMER.recarga >> 8),
+			escritura(Registro::TReloadRegL, TIMER.recarga & 0xFF),
+			escritura(Registro::TxASKReg, TxASKReg_Force100ASK),
+			escritura(Registro::CollReg, 0x00),	//ValuesAfterColl = 0
+			escritura(Registro::TxControlReg, TxControlReg_Antena) };
+};
+
+//lectura de ComIrqReg, FIFOLevelReg, ErrorReg y CollReg en una transferencia
+constexpr uint8_t LECTURA_ESTADO[] = { direccionLectura(Registro::ComIrqReg),
+		direccionLectura(Registro::FIFOLevelReg),
+		direccionLectura(Registro::ErrorReg),
+		direccionLectura(Registro::CollReg), 0 };
+
+} /* namespace mfrc522 */
+
+/**
+ *   @brief Lector MFRC522 conectado al bus Bus con el pin de
+ *          CS CsPin. EsperaUs es el tiempo máximo hasta el
+ *          inicio de la respuesta de la tarjeta.
+ */
+template<class Bus, class CsPin, uint32_t EsperaUs = MFRC522_ESPERA_TRAMA_US>
+class Mfrc522 {
+public:
+	Mfrc522() = delete;
+
+	/**
+	 *   @brief Inicializa el bus y el pin de CS, realiza un
+	 *          SoftReset y escribe la configuración.
+	 *   @retval Falso si el MFRC522 no responde.
+	 */
+	static bool init() {
+		CsPin::iniciar();
+		if (!Bus::iniciar())
+			return false;
+		escribirRegistro<mfrc522::Registro::CommandReg>(
+				static_cast<uint8_t>(mfrc522::Comando::SoftReset));
+		uint32_t inicio = Bus::tickMs();
+		while (leerRegistro<mfrc522::Registro::CommandReg>()
+				& mfrc522::CommandReg_PowerDown) {
+			if (Bus::tickMs() - inicio > mfrc522::TIMEOUT_OSCILADOR_MS)
+				return false;
+		}
+		for (const mfrc522::Escritura &escritura : CONFIGURACION::SECUENCIA)
+			Bus::template transferir<CsPin>(escritura.bytes, nullptr, 2);
+		return true;
+	}
+
+	/**
+	 *   @brief Detecta una tarjeta con REQA y la selecciona
+	 *          recorriendo los niveles de cascada.
+	 *   @retval Falso si no hay tarjeta, si responden varias con
+	 *           UIDs distintos o si la selección falla.
+	 */
+	static bool leerUID(mfrc522_uid_t &uid) {
+		uint8_t trama[MFRC522_TRAMA_MAX] = { mfrc522::CMD_REQA };
+		uint8_t respuesta[mfrc522::BYTES_NIVEL] = { };
+		uint8_t largo;
+
+		Resultado resultado = transceive(trama, 1, mfrc522::BITS_REQA,
+				respuesta, largo);
+		if (resultado != Resultado::OK && resultado != Resultado::COLISION)
+			return false;
+		uid.atqa[0] = respuesta[0];
+		uid.atqa[1] = respuesta[1];
+		uid.largo = 0;
+
+		for (uint8_t nivel = 0; nivel < mfrc522::NIVELES_CASCADA; nivel++) {
+			trama[0] = mfrc522::CMD_SEL[nivel];
+			trama[1] = mfrc522::NVB_ANTICOLISION;
+			if (transceive(trama, 2, 0, &trama[2], largo) != Resultado::OK
+					|| largo != mfrc522::BYTES_NIVEL)
+				return false;
+			uint8_t bcc = 0;
+			for (uint8_t i = 0; i < mfrc522::BYTES_NIVEL; i++)
+				bcc ^= trama[2 + i];
+			if (bcc != 0)
+				return false;
+
+			trama[1] = mfrc522::NVB_SELECT;
+			uint16_t crc = mfrc522::calcularCRC(trama, 2 + mfrc522::BYTES_NIVEL);
+			trama[7] = crc & 0xFF;
+			trama[8] = crc >> 8;
+			if (transceive(trama, 9, 0, respuesta, largo) != Resultado::OK
+					|| largo != 3 || mfrc522::calcularCRC(respuesta, 3) != 0)
+				return false;
+
+			uid.sak = respuesta[0];
+			bool incompleto = uid.sak & mfrc522::SAK_UID_INCOMPLETO;
+			if (incompleto && (trama[2] != mfrc522::CASCADE_TAG
+					|| nivel == mfrc522::NIVELES_CASCADA - 1))
+				return false;
+			for (uint8_t i = incompleto ? 1 : 0; i < 4; i++)
+				uid.uid[uid.largo++] = trama[2 + i];
+			if (!incompleto)
+				return true;
+		}
+		return false;
+	}
+
+	/**
+	 *   @brief Acceso a un registro. La dirección es constante,
+	 *          por lo que se codifica al compilar.
+	 */
+	template<mfrc522::Registro Reg>
+	static void escribirRegistro(uint8_t valor) {
+		const uint8_t tx[] = { mfrc522::direccionEscritura(Reg), valor };
+		Bus::template transferir<CsPin>(tx, nullptr, sizeof(tx));
+	}
+
+	template<mfrc522::Registro Reg>
+	static uint8_t leerRegistro() {
+		const uint8_t tx[] = { mfrc522::direccionLectura(Reg), 0 };
+		uint8_t rx[sizeof(tx)];
+		Bus::template transferir<CsPin>(tx, rx, sizeof(tx));
+		return rx[1];
+	}
+
+private:
+	using CONFIGURACION = mfrc522::Configuracion<EsperaUs>;
+
+	enum class Resultado : uint8_t {
+		OK, TIMEOUT, COLISION, ERROR
+	};
+
+	//espera máxima del procesador: la trama más larga más la respuesta
+	static constexpr uint32_t ESPERA_MAXIMA_MS = ((MFRC522_TRAMA_MAX * 9 + 2)
+			* mfrc522::DURACION_BIT_CUS / 100 + EsperaUs) / 1000 + 1;
+
+	/**
+	 *   @brief Envía la trama a la tarjeta y espera la respuesta
+	 *          consultando ComIrqReg. Los bytes recibidos (hasta
+	 *          BYTES_NIVEL) se guardan en respuesta.
+	 */
+	static Resultado transceive(const uint8_t *trama, uint8_t largo,
+			uint8_t bitFraming, uint8_t *respuesta, uint8_t &largoRespuesta) {
+		uint8_t tx[mfrc522::BYTES_NIVEL + 1];
+		uint8_t rx[sizeof(tx)];
+		largoRespuesta = 0;
+
+		escribirRegistro<mfrc522::Registro::CommandReg>(
+				static_cast<uint8_t>(mfrc522::Comando::Idle));
+		escribirRegistro<mfrc522::Registro::ComIrqReg>(
+				mfrc522::ComIrqReg_TodosLosBits);
+		escribirRegistro<mfrc522::Registro::FIFOLevelReg>(
+				mfrc522::FIFOLevelReg_FlushBuffer);
+		uint8_t fifo[MFRC522_TRAMA_MAX + 1] = { mfrc522::direccionEscritura(
+				mfrc522::Registro::FIFODataReg) };
+		for (uint8_t i = 0; i < largo; i++)
+			fifo[i + 1] = trama[i];
+		Bus::template transferir<CsPin>(fifo, nullptr, largo + 1);
+		escribirRegistro<mfrc522::Registro::CommandReg>(
+				static_cast<uint8_t>(mfrc522::Comando::Transceive));
+		escribirRegistro<mfrc522::Registro::BitFramingReg>(
+				mfrc522::BitFramingReg_StartSend | bitFraming);
+
+		uint32_t inicio = Bus::tickMs();
+		while (!(leerRegistro<mfrc522::Registro::ComIrqReg>()
+				& (mfrc522::ComIrqReg_RxIrq | mfrc522::ComIrqReg_TimerIrq))) {
+			if (Bus::tickMs() - inicio > ESPERA_MAXIMA_MS)
+				return Resultado::TIMEOUT;
+		}
+
+		uint8_t estado[sizeof(mfrc522::LECTURA_ESTADO)];
+		Bus::template transferir<CsPin>(mfrc522::LECTURA_ESTADO, estado,
+				sizeof(estado));
+		if (!(estado[1] & mfrc522::ComIrqReg_RxIrq))
+			return Resultado::TIMEOUT;
+		if (estado[3] & mfrc522::ErrorReg_ErroresRecepcion)
+			return Resultado::ERROR;
+
+		uint8_t n = estado[2];
+		if (n > mfrc522::BYTES_NIVEL)
+			n = mfrc522::BYTES_NIVEL;
+		for (uint8_t i = 0; i < n; i++)
+			tx[i] = mfrc522::direccionLectura(mfrc522::Registro::FIFODataReg);
+		tx[n] = 0;
+		Bus::template transferir<CsPin>(tx, rx, n + 1);
+		for (uint8_t i = 0; i < n; i++)
+			respuesta[i] = rx[i + 1];
+		largoRespuesta = n;
+		return (estado[3] & mfrc522::ErrorReg_CollErr) ?
+				Resultado::COLISION : Resultado::OK;
+	}
+};
+
+#endif /* API_INC_API_MFRC522_HPP_ */
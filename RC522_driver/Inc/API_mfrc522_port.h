@@ -8,33 +8,223 @@
 #ifndef API_INC_API_MFRC522_PORT_H_
 #define API_INC_API_MFRC522_PORT_H_
 
+//con API_PORT_HOST definido el port se compila para PC (carpeta Host)
+#ifndef API_PORT_HOST
 #include "stm32f4xx.h"
+#endif
 #include "API_types.h"
 
-//constantes para la comunicación SPI
-#define SPI_INSTANCE        SPI1
-#define CS_Pin              GPIO_PIN_6
-#define CS_GPIO_Port        GPIOB
+//cantidad de lectores MFRC522 conectados (1 o 2 en este port). Cada lector
+//tiene su propio pin de CS y de IRQ, y usa el bus SPI indicado por LECTORn_BUS.
+#ifndef MFRC522_CANTIDAD_LECTORES
+#define MFRC522_CANTIDAD_LECTORES	2
+#endif
+//cantidad de buses SPI utilizados (1 o 2)
+#define SPI_CANTIDAD_BUSES			1
 #define SPI_TIMEOUT         10
+//reloj del SPI (APB2 de 84 MHz con SPI_BAUDRATEPRESCALER_128), para estimar
+//la duración de las transferencias
+#define SPI_FRECUENCIA_HZ   656250UL
+
+//constantes de cada lector. Los pines IRQ deben estar entre el 5 y
+//el 9 para compartir la interrupción IRQ_EXTI_IRQN.
+#define LECTOR0_BUS         0
+#define LECTOR0_CS_Pin      GPIO_PIN_6
+#define LECTOR0_CS_Port     GPIOB
+#define LECTOR0_IRQ_Pin     GPIO_PIN_7
+#define LECTOR0_IRQ_Port    GPIOB
+#define LECTOR1_BUS         0
+#define LECTOR1_CS_Pin      GPIO_PIN_8
+#define LECTOR1_CS_Port     GPIOB
+#define LECTOR1_IRQ_Pin     GPIO_PIN_9
+#define LECTOR1_IRQ_Port    GPIOB
+
+//constantes para el pin IRQ del MFRC522. Con IRQ_HABILITADA = 0
+//el driver consulta el registro ComIrqReg por SPI en lugar del pin.
+#ifndef IRQ_HABILITADA
+#define IRQ_HABILITADA      1
+#endif
+//con MFRC522_DEFINIR_IRQ = 1 el port define las rutinas de atención de
+//sus interrupciones y los callbacks de la HAL que usa. Con 0 los define la
+//aplicación (por ejemplo, en el stm32f4xx_it.c de CubeMX) y llama desde
+//ellos a las funciones port*Callback y portSpi*IrqHandler de este módulo.
+#ifndef MFRC522_DEFINIR_IRQ
+#define MFRC522_DEFINIR_IRQ 1
+#endif
+#define IRQ_EXTI_IRQN       EXTI9_5_IRQn
+#define IRQ_EXTI_HANDLER    EXTI9_5_IRQHandler
+#define IRQ_PRIORIDAD       5
+#define SPI_MAX_BURST       64      //máximo de bytes por transferencia (tamaño de la FIFO del MFRC522)
+
+//constantes para las transferencias encadenadas con DMA
+#define SPI_MAX_DESCRIPTORES        8
+#define SPI_READ_MASK               0x80    //bit de la dirección que indica lectura
+#define SPI_PRIORIDAD_IRQ           5
+
+//bus 0: SPI1 con los streams 3 (TX) y 0 (RX) del DMA2
+#define SPI_INSTANCE                SPI1
+#define SPI_DMA_TX_STREAM           DMA2_Stream3
+#define SPI_DMA_TX_CHANNEL          DMA_CHANNEL_3
+#define SPI_DMA_TX_IRQN             DMA2_Stream3_IRQn
+#define SPI_DMA_TX_IRQ_HANDLER      DMA2_Stream3_IRQHandler
+#define SPI_DMA_RX_STREAM           DMA2_Stream0
+#define SPI_DMA_RX_CHANNEL          DMA_CHANNEL_3
+#define SPI_DMA_RX_IRQN             DMA2_Stream0_IRQn
+#define SPI_DMA_RX_IRQ_HANDLER      DMA2_Stream0_IRQHandler
+
+//bus 1: SPI2 con los streams 4 (TX) y 3 (RX) del DMA1
+#define SPI_BUS1_INSTANCE           SPI2
+#define SPI_BUS1_DMA_TX_STREAM      DMA1_Stream4
+#define SPI_BUS1_DMA_TX_CHANNEL     DMA_CHANNEL_0
+#define SPI_BUS1_DMA_TX_IRQN        DMA1_Stream4_IRQn
+#define SPI_BUS1_DMA_TX_IRQ_HANDLER DMA1_Stream4_IRQHandler
+#define SPI_BUS1_DMA_RX_STREAM      DMA1_Stream3
+#define SPI_BUS1_DMA_RX_CHANNEL     DMA_CHANNEL_0
+#define SPI_BUS1_DMA_RX_IRQN        DMA1_Stream3_IRQn
+#define SPI_BUS1_DMA_RX_IRQ_HANDLER DMA1_Stream3_IRQHandler
+
+/**
+ *   @brief Descriptor de una transferencia encadenada.
+ *          Si reg_addr tiene el bit SPI_READ_MASK, se leen
+ *          largo bytes del registro y se guardan en datos.
+ *          Si no, se escriben en el registro los largo bytes
+ *          de datos. El buffer datos debe permanecer válido
+ *          hasta que finalice la cadena.
+ */
+typedef struct {
+	uint8_t reg_addr;
+	uint8_t *datos;
+	uint16_t largo;
+} spi_descriptor_t;
+
+/**
+ *   @brief Tipo de función que se llama (desde la interrupción
+ *          del DMA) al finalizar una cadena de transferencias.
+ */
+typedef void (*spi_callback_t)(bool_t);
 
 /**
- *   @brief Inicializa el periférico SPI.
+ *   @brief Inicializa el bus SPI del lector (si todavía no
+ *          fue inicializado por otro lector) y sus pines
+ *          de CS e IRQ.
  *   @retval Verdadero si se inicia correctamente,
  *           o falso si no se puede inicializar.
  */
-bool_t portInit();
+bool_t portInit(uint8_t lector);
 
 /**
  *   @brief Escribe la cantidad size de bytes desde el buffer txData
- *          al registro red_addr del dispositivo que está conectado por SPI.
+ *          al registro red_addr del lector indicado.
+ *          Todos los bytes se escriben en el mismo registro, en una
+ *          única transferencia. size no puede superar SPI_MAX_BURST.
  */
-void spiWrite(uint8_t reg_addr, uint8_t *txData, uint16_t size);
+void spiWrite(uint8_t lector, uint8_t reg_addr, const uint8_t *txData,
+		uint16_t size);
 
 /**
  *   @brief Lee la cantidad indicada por size de bytes
- *          desde el registro reg_addr y los guarda en
- *          el buffer rxData.
+ *          desde el registro reg_addr del lector indicado
+ *          y los guarda en el buffer rxData. Todos los bytes
+ *          se leen en una única transferencia. size no puede
+ *          superar SPI_MAX_BURST.
+ */
+void spiRead(uint8_t lector, uint8_t reg_addr, uint8_t *rxData, uint16_t size);
+
+/**
+ *   @brief Realiza una transferencia full-duplex de size bytes
+ *          con el CS del lector activo durante toda la transferencia.
+ *          rxData puede ser NULL si no interesan los datos recibidos.
+ *          size no puede superar SPI_MAX_BURST + 1.
+ */
+void spiTransfer(uint8_t lector, const uint8_t *txData, uint8_t *rxData,
+		uint16_t size);
+
+/**
+ *   @brief Devuelve el tiempo transcurrido en ms desde
+ *          el inicio del programa.
+ */
+uint32_t portGetTick();
+
+/**
+ *   @brief Espera bloqueando al menos la cantidad de ms indicada.
+ */
+void portDelay(uint32_t ms);
+
+/**
+ *   @brief Descarta los eventos del pin IRQ del lector
+ *          recibidos hasta el momento.
+ */
+void irqClearEvent(uint8_t lector);
+
+/**
+ *   @brief Indica, sin bloquear, si se produjo un flanco en
+ *          el pin IRQ del lector desde el último irqClearEvent.
+ */
+bool_t irqEvento(uint8_t lector);
+
+/**
+ *   @brief Espera, durmiendo el procesador, a que se
+ *          produzca un flanco en el pin IRQ del lector o a que
+ *          se cumpla el timeout en ms, lo que ocurra primero.
+ *   @retval Verdadero si se produjo el evento.
+ */
+bool_t irqWaitEvent(uint8_t lector, uint32_t timeout);
+
+/**
+ *   @brief Espera, durmiendo el procesador, a que se produzca
+ *          un flanco en el pin IRQ de alguno de los lectores
+ *          indicados en mascara (bit n = lector n), o a que se
+ *          cumpla el timeout en ms.
+ *   @retval Verdadero si se produjo algún evento.
+ */
+bool_t irqWaitAnyEvent(uint32_t mascara, uint32_t timeout);
+
+/**
+ *   @brief Registra un flanco en el pin IRQ del lector que usa
+ *          el pin indicado; los demás pines se ignoran. Con
+ *          MFRC522_DEFINIR_IRQ = 0, la aplicación la llama desde
+ *          su HAL_GPIO_EXTI_Callback.
+ */
+void portIrqCallback(uint16_t pin);
+
+/**
+ *   @brief Inicia una cadena de transferencias con DMA hacia
+ *          el lector, sin bloquear. Los descriptores se copian,
+ *          por lo que el arreglo no necesita permanecer válido.
+ *          Al finalizar la última transferencia se llama a
+ *          callback (puede ser NULL).
+ *   @retval Falso si hay otra cadena en curso en el bus del
+ *           lector o si los descriptores no son válidos.
+ */
+bool_t spiStartChain(uint8_t lector, const spi_descriptor_t *descriptores,
+		uint8_t cantidad, spi_callback_t callback);
+
+/**
+ *   @brief Indica si hay una cadena de transferencias en
+ *          curso en el bus del lector.
+ */
+bool_t spiChainBusy(uint8_t lector);
+
+#ifndef API_PORT_HOST
+/**
+ *   @brief Atienden la interrupción de los streams de DMA de
+ *          transmisión y de recepción del bus. Con
+ *          MFRC522_DEFINIR_IRQ = 0, la aplicación las llama desde
+ *          las rutinas de atención correspondientes.
+ */
+void portSpiDmaTxIrqHandler(uint8_t bus);
+void portSpiDmaRxIrqHandler(uint8_t bus);
+
+/**
+ *   @brief Avanzan la cadena de transferencias del bus al que
+ *          pertenece el handle; los handles de otros módulos se
+ *          ignoran. Con MFRC522_DEFINIR_IRQ = 0, la aplicación las
+ *          llama desde HAL_SPI_TxCpltCallback y
+ *          HAL_SPI_TxRxCpltCallback (portSpiCpltCallback) y desde
+ *          HAL_SPI_ErrorCallback (portSpiErrorCallback).
  */
-void spiRead(uint8_t reg_addr, uint8_t *rxData, uint16_t size);
+void portSpiCpltCallback(SPI_HandleTypeDef *hspi);
+void portSpiErrorCallback(SPI_HandleTypeDef *hspi);
+#endif
 
 #endif /* API_INC_API_MFRC522_PORT_H_ */
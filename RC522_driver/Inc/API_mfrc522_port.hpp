@@ -0,0 +1,131 @@
+/**
+ * @file API_mfrc522_port.hpp
+ * @brief Bus SPI y pin de CS del STM32F4 para Mfrc522<Bus, CsPin>
+ * 		  (API_mfrc522.hpp). La instancia del SPI y el puerto del
+ * 		  pin se indican con su dirección base (SPI1_BASE,
+ * 		  GPIOB_BASE), por lo que cada acceso a un registro es una
+ * 		  dirección constante. La inicialización usa la HAL con la
+ * 		  misma configuración que API_mfrc522_port.c; las
+ * 		  transferencias escriben y leen SPI_DR directamente.
+ *
+ * 		  Ejemplo con dos lectores en SPI1:
+ * 		  using Lector0 = Mfrc522<mfrc522::BusSpi<SPI1_BASE>,
+ * 		          mfrc522::PinGpio<GPIOB_BASE, GPIO_PIN_6>>;
+ * 		  using Lector1 = Mfrc522<mfrc522::BusSpi<SPI1_BASE>,
+ * 		          mfrc522::PinGpio<GPIOB_BASE, GPIO_PIN_8>>;
+ */
+
+#ifndef API_INC_API_MFRC522_PORT_HPP_
+#define API_INC_API_MFRC522_PORT_HPP_
+
+#ifndef API_PORT_HOST
+
+extern "C" {
+#include "API_mfrc522_port.h"
+}
+
+namespace mfrc522 {
+
+/**
+ *   @brief Pin de salida con el CS de un lector (activo en bajo).
+ */
+template<uintptr_t Puerto, uint16_t Pin>
+struct PinGpio {
+	static_assert(Puerto >= GPIOA_BASE && Puerto <= GPIOH_BASE,
+			"Puerto debe ser la dirección base de un GPIO");
+
+	static void iniciar() {
+		GPIO_InitTypeDef GPIO_InitStruct = { 0 };
+		RCC->AHB1ENR |= 1UL << ((Puerto - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE));
+		(void) RCC->AHB1ENR;		//espera a que se habilite el reloj
+		liberar();
+		GPIO_InitStruct.Pin = Pin;
+		GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+		GPIO_InitStruct.Pull = GPIO_NOPULL;
+		GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+		HAL_GPIO_Init(gpio(), &GPIO_InitStruct);
+	}
+
+	static void activar() {
+		gpio()->BSRR = (uint32_t) Pin << 16;
+	}
+
+	static void liberar() {
+		gpio()->BSRR = Pin;
+	}
+
+private:
+	static GPIO_TypeDef* gpio() {
+		return reinterpret_cast<GPIO_TypeDef*>(Puerto);
+	}
+};
+
+/**
+ *   @brief Bus SPI maestro en modo 0, compartido por todos los
+ *          lectores que lo usan. Las transferencias son
+ *          bloqueantes, sin DMA: cada byte se escribe en SPI_DR
+ *          y se espera el byte recibido.
+ */
+template<uintptr_t Instancia>
+struct BusSpi {
+	static bool iniciar() {
+		SPI_HandleTypeDef &SPI = handle();
+		if (SPI.State != HAL_SPI_STATE_RESET)
+			return true;					//lo inicializó otro lector
+		SPI.Instance = spi();
+		SPI.Init.Mode = SPI_MODE_MASTER;
+		SPI.Init.Direction = SPI_DIRECTION_2LINES;
+		SPI.Init.DataSize = SPI_DATASIZE_8BIT;
+		SPI.Init.CLKPolarity = SPI_POLARITY_LOW;
+		SPI.Init.CLKPhase = SPI_PHASE_1EDGE;
+		SPI.Init.NSS = SPI_NSS_SOFT;
+		SPI.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_128;
+		SPI.Init.FirstBit = SPI_FIRSTBIT_MSB;
+		SPI.Init.TIMode = SPI_TIMODE_DISABLE;
+		SPI.Init.CRCCalculation = SPI_CRCCALCULATION_DISABLE;
+		SPI.Init.CRCPolynomial = 10;
+		if (HAL_SPI_Init(&SPI) != HAL_OK)
+			return false;
+		__HAL_SPI_ENABLE(&SPI);
+		return true;
+	}
+
+	template<class Cs>
+	static void transferir(const uint8_t *tx, uint8_t *rx, uint16_t largo) {
+		SPI_TypeDef *SPI = spi();
+		Cs::activar();
+		for (uint16_t i = 0; i < largo; i++) {
+			while (!(SPI->SR & SPI_SR_TXE))
+				;
+			*reinterpret_cast<volatile uint8_t*>(&SPI->DR) = tx[i];
+			while (!(SPI->SR & SPI_SR_RXNE))
+				;
+			uint8_t dato = *reinterpret_cast<volatile uint8_t*>(&SPI->DR);
+			if (rx != nullptr)
+				rx[i] = dato;
+		}
+		while (SPI->SR & SPI_SR_BSY)
+			;
+		Cs::liberar();
+	}
+
+	static uint32_t tickMs() {
+		return HAL_GetTick();
+	}
+
+private:
+	static SPI_TypeDef* spi() {
+		return reinterpret_cast<SPI_TypeDef*>(Instancia);
+	}
+
+	static SPI_HandleTypeDef& handle() {
+		static SPI_HandleTypeDef SPI;
+		return SPI;
+	}
+};
+
+} /* namespace mfrc522 */
+
+#endif /* API_PORT_HOST */
+
+#endif /* API_INC_API_MFRC522_PORT_HPP_ */
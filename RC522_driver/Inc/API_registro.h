@@ -0,0 +1,118 @@
+/**
+ * @file API_registro.h
+ * @brief Módulo que guarda en la flash un registro de solo
+ * 		  agregado con cada lectura de tarjeta (UID, marca de
+ * 		  tiempo y decisión de acceso). Los eventos se acumulan
+ * 		  en un buffer circular en RAM y se escriben de a páginas
+ * 		  completas en un log circular que recorre todos los
+ * 		  sectores reservados, por lo que todos se borran la
+ * 		  misma cantidad de veces. Cada evento lleva su número
+ * 		  de secuencia y un CRC, por lo que al arrancar se
+ * 		  recupera la posición de escritura leyendo pocos eventos
+ * 		  y se descartan los que quedaron a medio escribir.
+ */
+
+#ifndef API_INC_API_REGISTRO_H_
+#define API_INC_API_REGISTRO_H_
+
+#include "API_types.h"
+#include "API_mfrc522.h"
+
+//cantidad de eventos que se escriben juntos en la flash
+#ifndef REGISTRO_EVENTOS_PAGINA
+#define REGISTRO_EVENTOS_PAGINA		8
+#endif
+//capacidad del buffer en RAM. Debe ser potencia de 2 y al menos una página.
+#ifndef REGISTRO_EVENTOS_RAM
+#define REGISTRO_EVENTOS_RAM		32
+#endif
+
+/**
+ *   @brief Decisión tomada con el UID leído.
+ */
+typedef enum {
+	REGISTRO_ACCESO_DENEGADO, REGISTRO_ACCESO_PERMITIDO
+} registro_decision_enum;
+
+/**
+ *   @brief Evento tal como se guarda en la flash (24 bytes,
+ *          sin relleno). El CRC-16 cubre los bytes anteriores
+ *          a él. Una posición borrada tiene todos los bytes
+ *          en 0xFF.
+ */
+typedef struct {
+	uint32_t secuencia;
+	uint32_t tiempo;				//marca de tiempo de la aplicación
+	uint8_t uid[MFRC522_UID_MAX];
+	uint8_t largo;
+	uint8_t decision;
+	uint16_t crc;
+	uint16_t reservado;
+} registro_evento_t;
+
+/**
+ *   @brief Posición de un recorrido del registro.
+ */
+typedef struct {
+	uint32_t posicion;		//índice del próximo evento en la flash
+	uint32_t restantes;		//posiciones que faltan recorrer
+} registro_iterador_t;
+
+/**
+ *   @brief Inicializa la flash y recupera el registro:
+ *          busca el sector más reciente y, dentro de él,
+ *          la primera posición libre con una búsqueda binaria.
+ *   @retval Falso si no se puede acceder a la flash.
+ */
+bool_t registro_init();
+
+/**
+ *   @brief Agrega un evento al buffer en RAM, sin acceder
+ *          a la flash. uid y largo son los de la tarjeta
+ *          leída (4 bytes con mfrc522_leerUIDTarjeta).
+ *   @retval Falso si el buffer está lleno (el evento se
+ *           descarta y se cuenta en registro_perdidos).
+ */
+bool_t registro_agregar(const uint8_t *uid, uint8_t largo,
+		registro_decision_enum decision, uint32_t tiempo);
+
+/**
+ *   @brief Avanza la escritura del registro. Debe llamarse
+ *          periódicamente desde el loop principal. Si hay una
+ *          página completa en RAM, la escribe; si el próximo
+ *          sector debe borrarse, inicia el borrado y retorna.
+ *   @retval Verdadero si quedan eventos o un borrado pendientes.
+ */
+bool_t registro_procesar();
+
+/**
+ *   @brief Escribe en la flash todos los eventos del buffer,
+ *          aunque no completen una página. Bloquea hasta
+ *          terminar (incluyendo el borrado de un sector).
+ */
+void registro_sincronizar();
+
+/**
+ *   @brief Cantidad de eventos guardados en la flash y
+ *          cantidad de eventos descartados por falta de lugar
+ *          en el buffer desde registro_init.
+ */
+uint32_t registro_cantidad();
+uint32_t registro_perdidos();
+
+/**
+ *   @brief Inicia un recorrido desde el evento más antiguo
+ *          guardado en la flash. Los eventos que todavía están
+ *          en RAM no se recorren (ver registro_sincronizar).
+ */
+void registro_iniciarRecorrido(registro_iterador_t *iterador);
+
+/**
+ *   @brief Copia el próximo evento válido del recorrido en
+ *          evento, salteando los que tienen un CRC incorrecto.
+ *   @retval Falso si no quedan eventos.
+ */
+bool_t registro_siguiente(registro_iterador_t *iterador,
+		registro_evento_t *evento);
+
+#endif /* API_INC_API_REGISTRO_H_ */
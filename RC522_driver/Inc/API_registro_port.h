@@ -0,0 +1,64 @@
+/**
+ * @file API_registro_port.h
+ * @brief Módulo que implementa las funciones de bajo nivel
+ *        para guardar el registro de accesos en la flash.
+ *        El registro ocupa REGISTRO_CANTIDAD_SECTORES sectores
+ *        consecutivos, y las direcciones se indican como un
+ *        desplazamiento desde el inicio del primero.
+ */
+
+#ifndef API_INC_API_REGISTRO_PORT_H_
+#define API_INC_API_REGISTRO_PORT_H_
+
+//con API_PORT_HOST definido el port se compila para PC (carpeta Host)
+#ifndef API_PORT_HOST
+#include "stm32f4xx.h"
+#endif
+#include "API_types.h"
+
+//sectores de la flash reservados para el registro. Con el STM32F401 se
+//usan los sectores 2 y 3 (16 KB cada uno), que el linker script debe
+//excluir de la región del programa.
+#ifndef REGISTRO_CANTIDAD_SECTORES
+#define REGISTRO_CANTIDAD_SECTORES		2
+#endif
+#ifndef REGISTRO_TAMANO_SECTOR
+#define REGISTRO_TAMANO_SECTOR			0x4000UL
+#endif
+#define REGISTRO_PRIMER_SECTOR			2			//FLASH_SECTOR_2
+#define REGISTRO_DIRECCION_FLASH		0x08008000UL
+
+/**
+ *   @brief Habilita la escritura de la flash.
+ *   @retval Falso si no se puede acceder a la flash.
+ */
+bool_t flashInit();
+
+/**
+ *   @brief Lee largo bytes desde el desplazamiento
+ *          direccion del registro.
+ */
+void flashLeer(uint32_t direccion, void *datos, uint32_t largo);
+
+/**
+ *   @brief Programa largo bytes (múltiplo de 4, con direccion
+ *          alineada a 4) en una zona borrada del registro.
+ *          Bloquea hasta que termina la programación.
+ *   @retval Falso si la flash está ocupada o la programación falla.
+ */
+bool_t flashProgramar(uint32_t direccion, const void *datos, uint32_t largo);
+
+/**
+ *   @brief Inicia el borrado del sector indicado (0 a
+ *          REGISTRO_CANTIDAD_SECTORES - 1) sin esperar
+ *          a que termine.
+ *   @retval Falso si la flash está ocupada.
+ */
+bool_t flashBorrarSector(uint8_t sector);
+
+/**
+ *   @brief Indica si hay un borrado en curso.
+ */
+bool_t flashOcupada();
+
+#endif /* API_INC_API_REGISTRO_PORT_H_ */
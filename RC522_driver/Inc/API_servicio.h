@@ -0,0 +1,85 @@
+/**
+ * @file API_servicio.h
+ * @brief Servicio de lectura en segundo plano. Sondea los
+ * 		  lectores con el seguimiento de presencia
+ * 		  (mfrc522_lectorPresencia) desde un contexto propio, una
+ * 		  interrupción periódica de un timer (API_servicio_port) o
+ * 		  una tarea de un RTOS, y publica las llegadas y retiros
+ * 		  de tarjetas en una cola circular de un productor y un
+ * 		  consumidor sin bloqueos. El loop principal retira los
+ * 		  eventos de a lotes con servicio_extraer, sin esperar
+ * 		  ninguna transferencia SPI ni respuesta de tarjeta.
+ *
+ * 		  Mientras el servicio está iniciado, la aplicación no debe
+ * 		  llamar a funciones del driver con los lectores atendidos.
+ */
+
+#ifndef API_INC_API_SERVICIO_H_
+#define API_INC_API_SERVICIO_H_
+
+#include "API_types.h"
+#include "API_mfrc522.h"
+
+//capacidad de la cola de eventos. Debe ser potencia de 2.
+#ifndef SERVICIO_CAPACIDAD_COLA
+#define SERVICIO_CAPACIDAD_COLA		32
+#endif
+
+/**
+ *   @brief Evento publicado por el servicio.
+ */
+typedef struct {
+	mfrc522_uid_t uid;
+	uint32_t tiempo;				//portGetTick al detectar el evento, en ms
+	uint8_t lector;					//índice del lector (mfrc522_lectorInit)
+	uint8_t evento;					//MFRC522_EVENTO_LLEGADA o MFRC522_EVENTO_RETIRO
+} servicio_evento_t;
+
+/**
+ *   @brief Vacía la cola e inicia el servicio con los lectores
+ *          indicados, ya inicializados con mfrc522_lectorInit.
+ *          Con periodoMs distinto de 0, el port llama a
+ *          servicio_ejecutar cada periodoMs ms. Con periodoMs en
+ *          0 no se inicia ningún contexto: la aplicación llama a
+ *          servicio_ejecutar desde su propia tarea.
+ *   @retval Falso si el servicio ya está iniciado, los
+ *           parámetros son inválidos o el port no puede
+ *           iniciar el contexto.
+ */
+bool_t servicio_iniciar(mfrc522_t *lectores, uint8_t cantidad,
+		uint32_t periodoMs);
+
+/**
+ *   @brief Detiene el servicio. Los eventos que quedan en
+ *          la cola se pueden seguir extrayendo.
+ */
+void servicio_detener();
+
+/**
+ *   @brief Sondea una vez cada lector y publica las llegadas
+ *          y retiros. Es el productor de la cola: solo debe
+ *          llamarse desde un único contexto.
+ */
+void servicio_ejecutar();
+
+/**
+ *   @brief Copia en eventos hasta maximo eventos de la cola,
+ *          del más antiguo al más reciente, y los libera. Es
+ *          el consumidor de la cola: solo debe llamarse desde
+ *          un único contexto.
+ *   @retval Cantidad de eventos copiados.
+ */
+uint32_t servicio_extraer(servicio_evento_t *eventos, uint32_t maximo);
+
+/**
+ *   @brief Cantidad de eventos en la cola.
+ */
+uint32_t servicio_pendientes();
+
+/**
+ *   @brief Cantidad de eventos descartados por encontrar la
+ *          cola llena desde servicio_iniciar.
+ */
+uint32_t servicio_desbordes();
+
+#endif /* API_INC_API_SERVICIO_H_ */
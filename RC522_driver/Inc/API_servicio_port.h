@@ -0,0 +1,58 @@
+/**
+ * @file API_servicio_port.h
+ * @brief Módulo que implementa el contexto propio del
+ *        servicio de lectura: llama a servicio_ejecutar
+ *        periódicamente, fuera del loop principal.
+ */
+
+#ifndef API_INC_API_SERVICIO_PORT_H_
+#define API_INC_API_SERVICIO_PORT_H_
+
+//con API_PORT_HOST definido el port se compila para PC (carpeta Host)
+#ifndef API_PORT_HOST
+#include "stm32f4xx.h"
+#endif
+#include "API_types.h"
+
+//timer que genera la interrupción del servicio. Su prioridad debe ser
+//menor (número mayor) que la del SysTick, IRQ_PRIORIDAD y
+//SPI_PRIORIDAD_IRQ, ya que el driver espera dentro de la interrupción
+//los flancos de IRQ, el fin de las cadenas de DMA y los timeouts.
+#define SERVICIO_TIM				TIM3
+#define SERVICIO_TIM_IRQN			TIM3_IRQn
+#define SERVICIO_TIM_HANDLER		TIM3_IRQHandler
+#define SERVICIO_PRIORIDAD_IRQ		6
+#define SERVICIO_FRECUENCIA_TIM		10000UL		//cuenta del timer, en Hz
+#define SERVICIO_PERIODO_MAX_MS		(0x10000UL * 1000 / SERVICIO_FRECUENCIA_TIM)
+//con SERVICIO_DEFINIR_IRQ = 1 el port define SERVICIO_TIM_HANDLER. Con 0
+//la rutina de atención la define la aplicación (por ejemplo, en el
+//stm32f4xx_it.c de CubeMX) y llama desde ella a temporizadorIrqHandler.
+#ifndef SERVICIO_DEFINIR_IRQ
+#define SERVICIO_DEFINIR_IRQ		1
+#endif
+
+/**
+ *   @brief Inicia el contexto del servicio, que llama a
+ *          servicio_ejecutar cada periodoMs ms.
+ *   @retval Falso si el período es inválido o las
+ *           prioridades no permiten ejecutar el servicio.
+ */
+bool_t temporizadorIniciar(uint32_t periodoMs);
+
+/**
+ *   @brief Detiene el contexto del servicio. Al retornar,
+ *          servicio_ejecutar no está en ejecución.
+ */
+void temporizadorDetener();
+
+#ifndef API_PORT_HOST
+/**
+ *   @brief Atiende la interrupción de actualización de
+ *          SERVICIO_TIM y ejecuta una pasada del servicio.
+ *          Con SERVICIO_DEFINIR_IRQ = 0, la aplicación la llama
+ *          desde la rutina de atención del timer.
+ */
+void temporizadorIrqHandler();
+#endif
+
+#endif /* API_INC_API_SERVICIO_PORT_H_ */
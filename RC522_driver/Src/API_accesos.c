@@ -0,0 +1,222 @@
+/**
+ * @file API_accesos.c
+ * @brief  Implementación de las tablas de
+ * 		   UIDs autorizados.
+ */
+
+#include "API_accesos.h"
+
+// Constantes del hash FNV-1a de 32 bits
+#define FNV_BASE						2166136261UL
+#define FNV_PRIMO						16777619UL
+// Constante para separar los desplazamientos de la tabla estática
+#define CONSTANTE_DORADA				0x9E3779B9UL
+
+/**
+ *	@brief Funciones privadas para manejar las entradas.
+ */
+static bool_t accesos_entradaIgual(const accesos_entrada_t*, const uint8_t*,
+		uint8_t);
+static void accesos_entradaCopiar(accesos_entrada_t*, const uint8_t*, uint8_t);
+static uint32_t accesos_mezclar(uint32_t);
+
+/**
+ *	@brief Calcula el hash FNV-1a del largo y los bytes del
+ *		   UID, y le aplica una mezcla final para que todos los
+ *		   bits del resultado dependan de todos los de la entrada.
+ *	@retval Hash de 32 bits.
+ */
+uint32_t accesos_hash(const uint8_t *uid, uint8_t largo, uint32_t semilla) {
+	uint32_t hash = FNV_BASE ^ semilla;
+	hash = (hash ^ largo) * FNV_PRIMO;
+	for (uint8_t i = 0; i < largo; i++) {
+		hash = (hash ^ uid[i]) * FNV_PRIMO;
+	}
+	return accesos_mezclar(hash);
+}
+
+/**
+ *	@brief Posición de un UID en la tabla estática. El hash
+ *		   se combina con el desplazamiento del grupo y se
+ *		   vuelve a mezclar, por lo que cada desplazamiento
+ *		   produce una distribución distinta del grupo.
+ *	@retval Posición en la tabla.
+ */
+uint32_t accesos_posicionEstatica(uint32_t hash, uint16_t desplazamiento,
+		uint32_t tamano) {
+	return accesos_mezclar(hash + desplazamiento * CONSTANTE_DORADA) % tamano;
+}
+
+/**
+ *	@brief Busca un UID en la tabla estática. Requiere
+ *		   un hash, una lectura del desplazamiento del grupo
+ *		   y una única comparación, sin importar la cantidad
+ *		   de UIDs de la tabla.
+ *	@retval Verdadero si el UID está en la tabla.
+ */
+bool_t accesos_estaticaBuscar(const accesos_tablaEstatica_t *tabla,
+		const uint8_t *uid, uint8_t largo) {
+	if (tabla == NULL || uid == NULL || largo == 0 || tabla->tamano == 0
+			|| tabla->cantidadGrupos == 0)
+		return false;
+
+	uint32_t hash = accesos_hash(uid, largo, tabla->semilla);
+	uint16_t desplazamiento = tabla->desplazamientos[hash
+			% tabla->cantidadGrupos];
+	uint32_t posicion = accesos_posicionEstatica(hash, desplazamiento,
+			tabla->tamano);
+	return accesos_entradaIgual(&tabla->entradas[posicion], uid, largo);
+}
+
+/**
+ *	@brief Inicializa una tabla dinámica marcando
+ *		   todas las posiciones como libres.
+ *	@retval Falso si la capacidad no es potencia de 2.
+ */
+bool_t accesos_tablaInit(accesos_tabla_t *tabla,
+		accesos_entrada_t *almacenamiento, uint32_t capacidad) {
+	if (tabla == NULL || almacenamiento == NULL || capacidad == 0
+			|| (capacidad & (capacidad - 1)) != 0)
+		return false;
+
+	tabla->entradas = almacenamiento;
+	tabla->capacidad = capacidad;
+	tabla->cantidad = 0;
+	for (uint32_t i = 0; i < capacidad; i++) {
+		almacenamiento[i].largo = 0;
+	}
+	return true;
+}
+
+/**
+ *	@brief Agrega un UID con sondeo lineal desde la
+ *		   posición indicada por su hash. Se limita la
+ *		   ocupación a ACCESOS_CARGA_MAXIMA para que las
+ *		   secuencias de sondeo se mantengan cortas.
+ *	@retval Verdadero si el UID queda en la tabla.
+ */
+bool_t accesos_tablaAgregar(accesos_tabla_t *tabla, const uint8_t *uid,
+		uint8_t largo) {
+	if (tabla == NULL || uid == NULL || largo == 0 || largo > MFRC522_UID_MAX
+			|| tabla->capacidad == 0)
+		return false;
+
+	uint32_t mascara = tabla->capacidad - 1;
+	uint32_t posicion = accesos_hash(uid, largo, 0) & mascara;
+	while (tabla->entradas[posicion].largo != 0) {
+		if (accesos_entradaIgual(&tabla->entradas[posicion], uid, largo))
+			return true;
+		posicion = (posicion + 1) & mascara;
+	}
+
+	if ((tabla->cantidad + 1) * 100 > tabla->capacidad * ACCESOS_CARGA_MAXIMA)
+		return false;
+
+	accesos_entradaCopiar(&tabla->entradas[posicion], uid, largo);
+	tabla->cantidad++;
+	return true;
+}
+
+/**
+ *	@brief Quita un UID de la tabla. Para no dejar marcas de
+ *		   borrado que alarguen las búsquedas, se corren hacia
+ *		   atrás las entradas siguientes de la secuencia de
+ *		   sondeo que pueden ocupar la posición liberada.
+ *	@retval Verdadero si el UID estaba en la tabla.
+ */
+bool_t accesos_tablaQuitar(accesos_tabla_t *tabla, const uint8_t *uid,
+		uint8_t largo) {
+	if (tabla == NULL || uid == NULL || largo == 0 || tabla->capacidad == 0)
+		return false;
+
+	uint32_t mascara = tabla->capacidad - 1;
+	uint32_t libre = accesos_hash(uid, largo, 0) & mascara;
+	while (!accesos_entradaIgual(&tabla->entradas[libre], uid, largo)) {
+		if (tabla->entradas[libre].largo == 0)
+			return false;
+		libre = (libre + 1) & mascara;
+	}
+
+	uint32_t siguiente = libre;
+	while (true) {
+		siguiente = (siguiente + 1) & mascara;
+		accesos_entrada_t *entrada = &tabla->entradas[siguiente];
+		if (entrada->largo == 0)
+			break;
+
+		// La entrada se puede mover si su posición inicial
+		// no está entre la posición libre y la actual.
+		uint32_t inicial = accesos_hash(entrada->uid, entrada->largo, 0)
+				& mascara;
+		bool_t enRango = (libre <= siguiente) ?
+				(libre < inicial && inicial <= siguiente) :
+				(libre < inicial || inicial <= siguiente);
+		if (enRango)
+			continue;
+
+		tabla->entradas[libre] = *entrada;
+		libre = siguiente;
+	}
+
+	tabla->entradas[libre].largo = 0;
+	tabla->cantidad--;
+	return true;
+}
+
+/**
+ *	@brief Busca un UID con sondeo lineal hasta
+ *		   encontrarlo o llegar a una posición libre.
+ *	@retval Verdadero si el UID está en la tabla.
+ */
+bool_t accesos_tablaBuscar(const accesos_tabla_t *tabla, const uint8_t *uid,
+		uint8_t largo) {
+	if (tabla == NULL || uid == NULL || largo == 0 || tabla->capacidad == 0)
+		return false;
+
+	uint32_t mascara = tabla->capacidad - 1;
+	uint32_t posicion = accesos_hash(uid, largo, 0) & mascara;
+	while (tabla->entradas[posicion].largo != 0) {
+		if (accesos_entradaIgual(&tabla->entradas[posicion], uid, largo))
+			return true;
+		posicion = (posicion + 1) & mascara;
+	}
+	return false;
+}
+
+/**
+ *	@brief Compara una entrada con un UID.
+ *	@retval Verdadero si son iguales.
+ */
+static bool_t accesos_entradaIgual(const accesos_entrada_t *entrada,
+		const uint8_t *uid, uint8_t largo) {
+	if (entrada->largo != largo)
+		return false;
+	for (uint8_t i = 0; i < largo; i++) {
+		if (entrada->uid[i] != uid[i])
+			return false;
+	}
+	return true;
+}
+
+/**
+ *	@brief Copia un UID en una entrada.
+ */
+static void accesos_entradaCopiar(accesos_entrada_t *entrada,
+		const uint8_t *uid, uint8_t largo) {
+	entrada->largo = largo;
+	for (uint8_t i = 0; i < largo; i++) {
+		entrada->uid[i] = uid[i];
+	}
+}
+
+/**
+ *	@brief Mezcla final de MurmurHash3 de 32 bits.
+ */
+static uint32_t accesos_mezclar(uint32_t valor) {
+	valor ^= valor >> 16;
+	valor *= 0x85EBCA6BUL;
+	valor ^= valor >> 13;
+	valor *= 0xC2B2AE35UL;
+	valor ^= valor >> 16;
+	return valor;
+}
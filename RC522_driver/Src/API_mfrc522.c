@@ -10,6 +10,13 @@
 
 #include "API_mfrc522.h"
 #include "API_mfrc522_port.h"
+#if INSTR_HABILITADA
+#include "API_instrumentacion.h"
+#else
+//sin instrumentación no se necesita la carpeta Common
+#define INSTR_INICIO(marca)
+#define INSTR_FIN(op, marca, bytes, timeout)
+#endif
 
 // Definición de máscaras para definir si se lee o escribe en un registro.
 // Definidas en sección 8.1.2.3 del manual.
@@ -17,16 +24,74 @@ static const uint8_t READ_MASK = 0x80;
 static const uint8_t WRITE_MASK = 0;
 
 // Definiciones de algunos bits de registros utilizados
+#define TxControlReg_InvTx2RFOn			(1<<7)
 #define TxControlReg_Tx2RFEn				(1<<1)
 #define TxControlReg_Tx1RFEn				1
+#define CommandReg_PowerDown				(1<<4)
 #define ComIrqReg_RxIrq  					(1<<5)
 #define ComIrqReg_TimerIrq					(1<<0)
 #define FIFOLevelReg_FlushBuffer			0x80
 #define BitFramingReg_StartSend				0x80
 #define ComIrqReg_Set1						0x80
+#define ComIrqReg_TodosLosBits				0x7F
+#define ComIEnReg_IRqInv					(1<<7)
+#define ComIEnReg_RxIEn						(1<<5)
+#define ComIEnReg_TimerIEn					(1<<0)
+#define DivIEnReg_IRQPushPull				(1<<7)
+#define ErrorReg_ProtocolErr				(1<<0)
+#define ErrorReg_ParityErr					(1<<1)
+#define ErrorReg_CollErr					(1<<3)
+#define ErrorReg_BufferOvfl					(1<<4)
+#define ErrorReg_ErroresRecepcion			(ErrorReg_ProtocolErr | ErrorReg_ParityErr \
+											| ErrorReg_BufferOvfl)
+#define ErrorReg_ErroresTelemetria			(ErrorReg_ErroresRecepcion | ErrorReg_CollErr)
+#define CollReg_ValuesAfterColl				(1<<7)
+#define CollReg_CollPosNotValid				(1<<5)
+#define CollReg_CollPos						0x1F
+#define BitFramingReg_RxAlign_Pos			4
+#define RFCfgReg_RxGain_Pos					4
+#define RFCfgReg_RxGain						(0x07 << RFCfgReg_RxGain_Pos)
+#define RxThresholdReg_MinLevel_Pos			4
+#define RxThresholdReg_MinLevel				(0x0F << RxThresholdReg_MinLevel_Pos)
+#define GsNReg_CWGsN_Pos					4
+#define GsNReg_CWGsN						(0x0F << GsNReg_CWGsN_Pos)
+#define CWGsPReg_CWGsP						0x3F
 
 #define UID_SIZE							4
-#define NVB_CL1								0x20
+
+// Timer interno del MFRC522 (sección 8.5 del manual). Con TPrescaler = 169
+// cada cuenta dura (2 * 169 + 1) / 13,56 MHz = 25 uS, y con la recarga de
+// 16 bits alcanza 1,6 s. Para esperas mayores se aumenta el prescaler.
+#define FRECUENCIA_TIMER_KHZ				13560
+#define PRESCALER_TIMER						169
+#define PRESCALER_TIMER_MAX					0x0FFF
+#define CUENTAS_TIMER_MAX					0x10000UL
+#define TModeReg_TAuto						(1<<7)
+// Duración de un bit a 106 kbit/s (128 / fc), en centésimas de uS
+#define DURACION_BIT_CUS					944
+// Duración de la respuesta más larga que se espera (la FIFO completa, 64
+// bytes de 9 bits), en uS
+#define DURACION_RESPUESTA_MAX_US			((64 * 9 + 2) * DURACION_BIT_CUS / 100)
+// Descriptores de la recarga del timer al inicio de la cadena de cada comando
+#define DESCRIPTORES_RECARGA				2
+
+// Constantes de ISO/IEC 14443-3 para la anticolisión y selección
+#define NIVELES_CASCADA						3
+#define BYTES_NIVEL							5		//4 bytes de UID + BCC
+#define NVB_SELECT							0x70	//7 bytes: SEL, NVB, UID, BCC
+#define NVB_ANTICOLISION					0x20	//2 bytes: SEL, NVB
+#define CASCADE_TAG							0x88
+#define SAK_UID_INCOMPLETO					(1<<2)
+#define BITS_REQA							7
+#define CRC_A_INICIAL						0x6363
+#define MAX_COLISIONES						32		//una por cada bit del UID de un nivel
+
+// Tiempo en ms que se espera luego de encender la antena antes de enviar el
+// primer comando, para que las tarjetas se energicen (ISO/IEC 14443-3, 6.2.2).
+#define TIEMPO_GUARDA_CAMPO_MS				5
+// Tiempo máximo en ms que se espera a que arranque el oscilador luego de un
+// SoftReset o del bajo consumo (el bit PowerDown de CommandReg pasa a 0)
+#define TIMEOUT_OSCILADOR_MS				10
 
 //registros definidos en sección 9.2 de la hoja de datos
 typedef enum {
@@ -110,219 +175,1526 @@ typedef enum {
 
 // Comandos a enviar a la tarjeta obtenidos de ISO/IEC 14443-3
 typedef enum {
-	CMD_REQA = 0x26, CMD_SEL_CL1 = 0x93
+	CMD_REQA = 0x26,
+	CMD_WUPA = 0x52,
+	CMD_HLTA = 0x50,
+	CMD_SEL_CL1 = 0x93,
+	CMD_SEL_CL2 = 0x95,
+	CMD_SEL_CL3 = 0x97
 } comandos_tarjeta_enum;
 
+// Resultado de un intercambio con la tarjeta
+typedef enum {
+	TRANSCEIVE_OK, TRANSCEIVE_TIMEOUT, TRANSCEIVE_COLISION, TRANSCEIVE_ERROR
+} resultado_transceive_enum;
+
+// Etapas de una lectura no bloqueante
+typedef enum {
+	ETAPA_INACTIVA, ETAPA_REQA, ETAPA_ANTICOLISION, ETAPA_SELECCION
+} etapa_lectura_enum;
+
+// Respuesta de la tarjeta a un intercambio
+typedef struct {
+	resultado_transceive_enum resultado;
+	uint8_t datos[BYTES_NIVEL];
+	uint8_t largo;
+	uint8_t posicionColision;	//primer bit en colisión (comenzando en 1)
+} respuesta_tarjeta_t;
+
+// Valor de un registro de la configuración y bits que se comparan
+// para detectar un MFRC522 que ya está configurado
+typedef struct {
+	registros_MFRC522_enum reg;
+	uint8_t valor;
+	uint8_t mascara;
+} configuracion_registro_t;
+
+/**
+ *	@brief Configuración de los registros que se escribe luego
+ *		   de un SoftReset, en una única cadena de DMA. Los valores
+ *		   quedan en flash durante la cadena. TxControlReg enciende
+ *		   la antena y no se compara, porque el planificador la
+ *		   apaga en bajo consumo.
+ */
+static const configuracion_registro_t CONFIGURACION[] = {
+		// El módulo MFRC522 tiene un timer interno que puede ser utilizado para evitar
+		// que una operación quede bloqueando el programa.
+		// TModeReg = 0x80 para que el timer inicie automáticamente al finalizar una transmisión.
+		// TPrescalerReg = 169 para cuentas de 25 uS. La recarga (TReloadReg) no
+		// forma parte de la configuración: se escribe con cada comando a la
+		// tarjeta según el tiempo de espera de su respuesta.
+		{ TModeReg, TModeReg_TAuto | (PRESCALER_TIMER >> 8), 0xFF },
+		{ TPrescalerReg, PRESCALER_TIMER & 0xFF, 0xFF },
+		{ TxASKReg, 0x40, 0xFF },		// Configura modulación 100% ASK
+		// ValuesAfterColl = 0: los bits recibidos después de una colisión
+		// se leen en 0, como requiere el procedimiento de anticolisión.
+		{ CollReg, 0x00, CollReg_ValuesAfterColl },
+#if IRQ_HABILITADA
+		// El pin IRQ se configura como salida push-pull activa en bajo,
+		// y se activa al recibir una respuesta (RxIrq) o en timeout (TimerIrq).
+		{ DivIEnReg, DivIEnReg_IRQPushPull, 0xFF },
+		{ ComIEnReg, ComIEnReg_IRqInv | ComIEnReg_RxIEn | ComIEnReg_TimerIEn,
+				0xFF },
+#endif
+		{ TxControlReg, TxControlReg_InvTx2RFOn | TxControlReg_Tx2RFEn
+				| TxControlReg_Tx1RFEn, 0x00 } };
+
+#define CANTIDAD_CONFIGURACION	((uint8_t) (sizeof(CONFIGURACION) / sizeof(CONFIGURACION[0])))
+
+// Comando SEL de cada nivel de cascada
+static const uint8_t CMD_SEL_NIVEL[NIVELES_CASCADA] = { CMD_SEL_CL1,
+		CMD_SEL_CL2, CMD_SEL_CL3 };
+
+// Registros de la configuración de RF, en el orden de mfrc522_lectorRfLeer
+static const registros_MFRC522_enum REGISTROS_RF[] = { RFCfgReg, RxThresholdReg,
+		GsNReg, CWGsPReg };
+#define CANTIDAD_REGISTROS_RF	(sizeof(REGISTROS_RF) / sizeof(REGISTROS_RF[0]))
+
+// Valores que recorre mfrc522_lectorAutoajustar. Las ganancias 0 y 1
+// son iguales a 2 y 3. La potencia de la portadora se ajusta con
+// CWGsP y CWGsN juntos, desde la mitad hasta el doble de la inicial.
+static const uint8_t GANANCIAS_AJUSTE[] = { 2, 3, 4, 5, 6, 7 };
+static const uint8_t UMBRALES_AJUSTE[] = { 2, 4, 6, 8, 10, 12, 14 };
+static const uint8_t CONDUCTANCIAS_AJUSTE[][2] = { { 0x10, 0x04 },
+		{ 0x20, 0x08 }, { 0x30, 0x0C }, { 0x3F, 0x0F } };
+
+// Parámetros de la configuración de RF que recorre el ajuste
+typedef enum {
+	AJUSTE_GANANCIA, AJUSTE_UMBRAL, AJUSTE_CONDUCTANCIA
+} parametro_ajuste_enum;
+
+// Resultado de las lecturas de prueba con una configuración de RF
+typedef struct {
+	uint32_t aciertos;
+	uint32_t intercambios;
+} puntaje_rf_t;
+
+/**
+ *	@brief Lector utilizado por las funciones que no
+ *		   reciben un lector (conectado como lector 0).
+ */
+static mfrc522_t lectorPorDefecto;
+
 /**
  *	@brief Declaración de funciones privadas
  *		   que se utilizan para manejar el
  *		   funcionamiento del MFRC522.
  */
-static bool_t mfrc522_leerUID(uint8_t *uid);
-static bool_t mfrc522_detectarTarjeta();
-static bool_t mfrc522_leerBufferFIFO(uint8_t*, uint8_t);
-static bool_t mfrc522_esperarRespuestaTarjeta();
-static void mfrc522_enviarComandoTarjeta(uint8_t *comando, uint8_t largo,
-		uint8_t txSize);
-static void mfrc522_encenderAntena();
+static bool_t mfrc522_iniciarLectura(mfrc522_t *lector,
+		comandos_tarjeta_enum despertar);
+static mfrc522_lectura_enum mfrc522_leer(mfrc522_t *lector,
+		comandos_tarjeta_enum despertar);
+static mfrc522_lectura_enum mfrc522_continuarLectura(mfrc522_t *lector);
+static mfrc522_lectura_enum mfrc522_avanzarLectura(mfrc522_t *lector,
+		const respuesta_tarjeta_t *respuesta);
+static mfrc522_lectura_enum mfrc522_procesarAnticolision(mfrc522_t *lector,
+		const respuesta_tarjeta_t *respuesta);
+static mfrc522_lectura_enum mfrc522_procesarSeleccion(mfrc522_t *lector,
+		const respuesta_tarjeta_t *respuesta);
+static void mfrc522_enviarAnticolision(mfrc522_t *lector);
+static void mfrc522_enviarSeleccion(mfrc522_t *lector);
+static mfrc522_lectura_enum mfrc522_terminarLectura(mfrc522_t *lector,
+		mfrc522_lectura_enum resultado);
+static void mfrc522_haltTarjeta(mfrc522_t *lector);
+static resultado_transceive_enum mfrc522_sondearTarjeta(mfrc522_t *lector);
+static resultado_transceive_enum mfrc522_confirmarTarjeta(mfrc522_t *lector);
+static uint16_t mfrc522_calcularCRC(const uint8_t *datos, uint8_t largo);
+static bool_t mfrc522_intercambioTerminado(mfrc522_t *lector);
+static void mfrc522_finalizarIntercambio(mfrc522_t *lector,
+		respuesta_tarjeta_t *respuesta);
+static void mfrc522_esperarRespuestaTarjeta(mfrc522_t *lector,
+		respuesta_tarjeta_t *respuesta);
+static void mfrc522_enviarComandoTarjeta(mfrc522_t *lector,
+		const uint8_t *comando, uint8_t largo, uint8_t bitFraming,
+		uint32_t esperaUs);
+static void mfrc522_calcularTimer(uint32_t esperaUs, uint16_t *prescaler,
+		uint16_t *recarga);
+static void mfrc522_encenderAntena(mfrc522_t *lector);
+static void mfrc522_apagarAntena(mfrc522_t *lector);
+static void mfrc522_entrarBajoConsumo(mfrc522_t *lector);
+static void mfrc522_salirBajoConsumo(mfrc522_t *lector);
+static void mfrc522_iniciarGuardaCampo(mfrc522_t *lector);
+static void mfrc522_esperarGuardaCampo(mfrc522_t *lector);
+static bool_t mfrc522_esperarOscilador(mfrc522_t *lector);
+static bool_t mfrc522_configuracionVigente(mfrc522_t *lector);
+static void mfrc522_escribirConfiguracion(mfrc522_t *lector);
+static void mfrc522_registrarIntercambio(mfrc522_t *lector, uint8_t comIrq,
+		uint8_t error);
+static void mfrc522_ajustarParametro(mfrc522_t *lector,
+		parametro_ajuste_enum parametro, uint8_t intentos, mfrc522_rf_t *mejor,
+		puntaje_rf_t *mejorPuntaje);
+static puntaje_rf_t mfrc522_evaluarRf(mfrc522_t *lector, const mfrc522_rf_t *rf,
+		uint8_t intentos);
 
 /**
  *	@brief Funciones para comunicarse con
  *		   el módulo por SPI.
  */
-static void mfrc522_writeRegister(registros_MFRC522_enum, uint8_t);
-static uint8_t mfrc522_readRegister(registros_MFRC522_enum);
+static void mfrc522_writeRegister(mfrc522_t*, registros_MFRC522_enum, uint8_t);
+static uint8_t mfrc522_readRegister(mfrc522_t*, registros_MFRC522_enum);
+static void mfrc522_readRegisterBurst(mfrc522_t*, registros_MFRC522_enum,
+		uint8_t*, uint8_t);
+static void mfrc522_readRegisters(mfrc522_t*, const registros_MFRC522_enum*,
+		uint8_t*, uint8_t);
 
 /**
- *	@brief Inicializa el periférico SPI
- *		   y luego configura los parámetros
- *		   de funcionamiento del MFRC522.
- *
+ *	@brief Inicializa el lector 0.
  */
 void mfrc522_init() {
-	bool_t spiActivo = portInit();
+	mfrc522_lectorInit(&lectorPorDefecto, 0);
+}
+
+/**
+ *	@brief Inicializa el periférico SPI y los pines
+ *		   del lector, y luego configura los parámetros
+ *		   de funcionamiento del MFRC522. Si el MFRC522 ya
+ *		   tiene la configuración (reinicio del procesador sin
+ *		   cortar la alimentación del lector), solo se detiene
+ *		   el comando en curso y se enciende la antena. Si no,
+ *		   se realiza un SoftReset y se escribe la configuración.
+ *		   En ambos casos se espera a que el oscilador esté
+ *		   funcionando en lugar de usar delays fijos.
+ *	@retval Falso si no se puede inicializar el SPI o el
+ *			MFRC522 no responde.
+ */
+bool_t mfrc522_lectorInit(mfrc522_t *lector, uint8_t indice) {
+	if (lector == NULL || indice >= MFRC522_CANTIDAD_LECTORES)
+		return false;
+
+	lector->indice = indice;
+	lector->periodoMinimoPoll = MFRC522_POLL_MIN_MS;
+	lector->periodoMaximoPoll = MFRC522_POLL_MAX_MS;
+	lector->periodoPoll = MFRC522_POLL_MIN_MS;
+	lector->proximoPoll = 0;
+	lector->bajoConsumo = false;
+	lector->guardaCampo = false;
+	lector->etapa = ETAPA_INACTIVA;
+	lector->tarjetaEnCampo = false;
+	lector->tarjetaLista = false;
+	lector->reboteSondeos = MFRC522_PRESENCIA_REBOTE;
+	lector->sondeosFallidos = 0;
+	lector->ventanaPresencia = MFRC522_PRESENCIA_VENTANA_MS;
+	lector->esperaTramaUs = MFRC522_ESPERA_TRAMA_US;
+	lector->esperaTimerUs = 0;		//la recarga se escribe con el primer comando
+	lector->prescalerTimer = PRESCALER_TIMER;
+	lector->esperaMaximaMs = 1;
+	mfrc522_lectorTelemetriaBorrar(lector);
+
+	bool_t spiActivo = portInit(indice);
 
 	if (!spiActivo)
-		return;
+		return false;
 
-	mfrc522_reset();
+	if (mfrc522_configuracionVigente(lector)) {
+		// Idle detiene el comando en curso y sale del bajo consumo
+		mfrc522_writeRegister(lector, CommandReg, Idle);
+		if (!mfrc522_esperarOscilador(lector))
+			return false;
+		mfrc522_encenderAntena(lector);		// Enciende la antena para transmitir
+		return true;
+	}
 
-	// El módulo MFRC522 tiene un timer interno que puede ser utilizado para evitar
-	// que una operación quede bloqueando el programa.
-	// Se configura TModeReg = 0x80 para que el timer inicie automáticamente al finalizar una transmisión.
-	mfrc522_writeRegister(TModeReg, 0x80);
+	mfrc522_writeRegister(lector, CommandReg, SoftReset);
+	if (!mfrc522_esperarOscilador(lector))
+		return false;
+	mfrc522_escribirConfiguracion(lector);		// también enciende la antena
+	mfrc522_iniciarGuardaCampo(lector);
+	return true;
+}
+
+/**
+ *	@brief Lee CommandReg y los registros de la configuración
+ *		   en una única transferencia SPI, y los compara con
+ *		   los valores de CONFIGURACION.
+ *	@retval Verdadero si el MFRC522 ya está configurado.
+ */
+static bool_t mfrc522_configuracionVigente(mfrc522_t *lector) {
+	registros_MFRC522_enum regs[CANTIDAD_CONFIGURACION + 1];
+	uint8_t valores[CANTIDAD_CONFIGURACION + 1];
+
+	regs[0] = CommandReg;
+	for (uint8_t i = 0; i < CANTIDAD_CONFIGURACION; i++)
+		regs[i + 1] = CONFIGURACION[i].reg;
+	mfrc522_readRegisters(lector, regs, valores, CANTIDAD_CONFIGURACION + 1);
+
+	for (uint8_t i = 0; i < CANTIDAD_CONFIGURACION; i++) {
+		uint8_t mascara = CONFIGURACION[i].mascara;
+		if ((valores[i + 1] & mascara) != (CONFIGURACION[i].valor & mascara))
+			return false;
+	}
+	return true;
+}
+
+/**
+ *	@brief Escribe la tabla CONFIGURACION como una cadena de
+ *		   descriptores que el puerto ejecuta con DMA, y espera a
+ *		   que termine. Si no se puede iniciar la cadena, se
+ *		   realizan las escrituras bloqueantes.
+ */
+static void mfrc522_escribirConfiguracion(mfrc522_t *lector) {
+	spi_descriptor_t descriptores[SPI_MAX_DESCRIPTORES];
+	uint8_t cantidad = 0;
 
-	// Se configura el registro TPrescalerReg = 0xFF para una frecuencia de 26 kHz
-	// y el valor de Reload en 0x0D = 13. Esto resulta en un timeout = 500 uS.
-	mfrc522_writeRegister(TPrescalerReg, 0xFF);
-	mfrc522_writeRegister(TReloadRegL, 0x0D);
+	for (uint8_t i = 0; i < CANTIDAD_CONFIGURACION; i++) {
+		// el puerto solo lee los datos de los descriptores de escritura
+		descriptores[cantidad].reg_addr = WRITE_MASK
+				| CONFIGURACION[i].reg << 1;
+		descriptores[cantidad].datos = (uint8_t*) &CONFIGURACION[i].valor;
+		descriptores[cantidad].largo = 1;
+		cantidad++;
+		if (cantidad < SPI_MAX_DESCRIPTORES && i + 1 < CANTIDAD_CONFIGURACION)
+			continue;
 
-	mfrc522_writeRegister(TxASKReg, 0x40);		// Configura modulación 100% ASK
+		while (spiChainBusy(lector->indice))
+			;
+		if (!spiStartChain(lector->indice, descriptores, cantidad, NULL)) {
+			for (uint8_t j = 0; j < cantidad; j++)
+				spiWrite(lector->indice, descriptores[j].reg_addr,
+						descriptores[j].datos, 1);
+		}
+		cantidad = 0;
+	}
+	while (spiChainBusy(lector->indice))
+		;
+}
 
-	mfrc522_encenderAntena();			// Enciende la antena para transmitir
+/**
+ *	@brief Espera a que el bit PowerDown de CommandReg pase a 0,
+ *		   lo que indica que el oscilador está funcionando y el
+ *		   MFRC522 puede ejecutar comandos (secciones 8.6.2 y
+ *		   10.3.1.10 del manual).
+ *	@retval Falso si no arranca en TIMEOUT_OSCILADOR_MS.
+ */
+static bool_t mfrc522_esperarOscilador(mfrc522_t *lector) {
+	uint32_t inicio = portGetTick();
+	while (mfrc522_readRegister(lector, CommandReg) & CommandReg_PowerDown) {
+		if (portGetTick() - inicio > TIMEOUT_OSCILADOR_MS)
+			return false;
+	}
+	return true;
 }
 
 /**
  *	@brief Realiza un reseteo por software
  *		   del MFRC522. Esto se hace enviandole
- *		   el comando SoftReset (sección 10.3.1.10 del manual).s
+ *		   el comando SoftReset (sección 10.3.1.10 del manual)
+ *		   y esperando a que vuelva a arrancar el oscilador.
  */
 void mfrc522_reset() {
-	mfrc522_writeRegister(CommandReg, SoftReset);
+	mfrc522_lectorReset(&lectorPorDefecto);
+}
+
+void mfrc522_lectorReset(mfrc522_t *lector) {
+	mfrc522_writeRegister(lector, CommandReg, SoftReset);
+	mfrc522_esperarOscilador(lector);
 }
 
 /**
  *	@brief Enciende la antena para transmitir
- *		   la portadora de RF.
+ *		   la portadora de RF. Si estaba apagada,
+ *		   inicia el tiempo de guarda del campo.
  */
-static void mfrc522_encenderAntena() {
+static void mfrc522_encenderAntena(mfrc522_t *lector) {
 	const uint8_t valor_deseado = TxControlReg_Tx1RFEn | TxControlReg_Tx2RFEn;
 
-	uint8_t valor_registro = mfrc522_readRegister(TxControlReg);
-	if (valor_deseado != (valor_registro & valor_deseado))
-		mfrc522_writeRegister(TxControlReg, valor_registro | valor_deseado);
+	uint8_t valor_registro = mfrc522_readRegister(lector, TxControlReg);
+	if (valor_deseado != (valor_registro & valor_deseado)) {
+		mfrc522_writeRegister(lector, TxControlReg,
+				valor_registro | valor_deseado);
+		mfrc522_iniciarGuardaCampo(lector);
+	}
+}
+
+/**
+ *	@brief Apaga la antena, dejando de
+ *		   transmitir la portadora de RF.
+ */
+static void mfrc522_apagarAntena(mfrc522_t *lector) {
+	const uint8_t valor_antena = TxControlReg_Tx1RFEn | TxControlReg_Tx2RFEn;
+
+	uint8_t valor_registro = mfrc522_readRegister(lector, TxControlReg);
+	if (valor_registro & valor_antena)
+		mfrc522_writeRegister(lector, TxControlReg,
+				valor_registro & ~valor_antena);
+}
+
+/**
+ *	@brief Apaga la antena y pasa el MFRC522 al modo
+ *		   de bajo consumo por software (sección 8.6.2
+ *		   del manual). Los registros conservan su valor.
+ */
+static void mfrc522_entrarBajoConsumo(mfrc522_t *lector) {
+	mfrc522_apagarAntena(lector);
+	mfrc522_writeRegister(lector, CommandReg, CommandReg_PowerDown | NoCmdChange);
+	lector->bajoConsumo = true;
+}
+
+/**
+ *	@brief Sale del modo de bajo consumo. El bit PowerDown
+ *		   se lee en 1 hasta que el oscilador se estabiliza,
+ *		   por lo que se espera a que pase a 0 en lugar de
+ *		   usar un delay fijo. Luego enciende la antena; el
+ *		   primer comando a la tarjeta espera lo que falte
+ *		   del tiempo de guarda.
+ */
+static void mfrc522_salirBajoConsumo(mfrc522_t *lector) {
+	mfrc522_writeRegister(lector, CommandReg, NoCmdChange);
+	mfrc522_esperarOscilador(lector);
+	mfrc522_encenderAntena(lector);
+	lector->bajoConsumo = false;
+}
+
+/**
+ *	@brief Registra que se encendió la antena, para que
+ *		   el próximo comando a la tarjeta espere
+ *		   TIEMPO_GUARDA_CAMPO_MS desde ese momento.
+ */
+static void mfrc522_iniciarGuardaCampo(mfrc522_t *lector) {
+	lector->encendidoCampo = portGetTick();
+	lector->guardaCampo = true;
+}
+
+/**
+ *	@brief Si la antena se encendió hace menos de
+ *		   TIEMPO_GUARDA_CAMPO_MS, espera lo que falta para
+ *		   que las tarjetas se energicen. Se suma un tick
+ *		   porque el encendido pudo ocurrir al final del tick.
+ */
+static void mfrc522_esperarGuardaCampo(mfrc522_t *lector) {
+	if (!lector->guardaCampo)
+		return;
+	uint32_t transcurrido = portGetTick() - lector->encendidoCampo;
+	if (transcurrido <= TIEMPO_GUARDA_CAMPO_MS)
+		portDelay(TIEMPO_GUARDA_CAMPO_MS + 1 - transcurrido);
+	lector->guardaCampo = false;
+}
+
+/**
+ *	@brief Configura los períodos del planificador
+ *		   y reinicia el período actual al mínimo.
+ */
+void mfrc522_pollConfigurar(uint32_t periodoMinimo, uint32_t periodoMaximo) {
+	mfrc522_lectorPollConfigurar(&lectorPorDefecto, periodoMinimo,
+			periodoMaximo);
+}
+
+void mfrc522_lectorPollConfigurar(mfrc522_t *lector, uint32_t periodoMinimo,
+		uint32_t periodoMaximo) {
+	if (periodoMinimo == 0 || periodoMaximo < periodoMinimo)
+		return;
+	lector->periodoMinimoPoll = periodoMinimo;
+	lector->periodoMaximoPoll = periodoMaximo;
+	lector->periodoPoll = periodoMinimo;
+}
+
+/**
+ *	@brief Planificador de lecturas adaptativo. Si el
+ *		   MFRC522 está en bajo consumo, se despierta
+ *		   TIEMPO_GUARDA_CAMPO_MS (más un tick) antes de la
+ *		   próxima lectura, para que la antena ya haya
+ *		   energizado las tarjetas al enviar REQA. Luego de cada lectura se ajusta el
+ *		   período: mínimo si hubo tarjeta, el doble (hasta el
+ *		   máximo) si no. Si el período resultante es de al
+ *		   menos MFRC522_POLL_BAJO_CONSUMO_MS, se vuelve al
+ *		   bajo consumo hasta la próxima lectura.
+ *	@retval Verdadero si en esta llamada se leyó una tarjeta.
+ */
+bool_t mfrc522_poll(mfrc522_uid_t *uid) {
+	return mfrc522_lectorPoll(&lectorPorDefecto, uid);
+}
+
+bool_t mfrc522_lectorPoll(mfrc522_t *lector, mfrc522_uid_t *uid) {
+	uint32_t ahora = portGetTick();
+
+	if (lector->bajoConsumo
+			&& (int32_t) (lector->proximoPoll - ahora)
+					<= TIEMPO_GUARDA_CAMPO_MS + 1)
+		mfrc522_salirBajoConsumo(lector);
+
+	if ((int32_t) (ahora - lector->proximoPoll) < 0 || lector->bajoConsumo)
+		return false;
+
+	bool_t tarjetaLeida = mfrc522_lectorLeerUID(lector, uid);
+	if (tarjetaLeida) {
+		lector->periodoPoll = lector->periodoMinimoPoll;
+	} else {
+		lector->periodoPoll *= 2;
+		if (lector->periodoPoll > lector->periodoMaximoPoll)
+			lector->periodoPoll = lector->periodoMaximoPoll;
+	}
+	lector->proximoPoll = ahora + lector->periodoPoll;
+
+	if (lector->periodoPoll >= MFRC522_POLL_BAJO_CONSUMO_MS)
+		mfrc522_entrarBajoConsumo(lector);
+
+	return tarjetaLeida;
 }
 
 /**
  *	@brief Detecta si el usuario aproxima una tarjeta
- *		   al lector. En caso afirmativo, envía un comando
- *		   para que la tarjeta le devuelva su UID.
+ *		   al lector. En caso afirmativo, la selecciona
+ *		   y copia los primeros 4 bytes de su UID.
  *	@retval Verdadero si se lee correctamente el UID, o
  *			falso si no se detecta tarjeta o si no se puede
  *			leer el UID.
  */
 bool_t mfrc522_leerUIDTarjeta(uint8_t *uid) {
-	bool_t estado = false;
-	bool_t tarjetaDetectada = mfrc522_detectarTarjeta();//enviar comando tarjeta
-	if (tarjetaDetectada)
-		return mfrc522_leerUID(uid);		// si tarjeta presente, leer uid
+	INSTR_INICIO(inicio);
+	mfrc522_uid_t tarjeta;
+	bool_t leida = mfrc522_leerUIDCompleto(&tarjeta);
+	INSTR_FIN(INSTR_LEER_UID, inicio, leida ? UID_SIZE : 0, !leida);
+	if (!leida)
+		return false;
 
-	return estado;
+	for (uint8_t i = 0; i < UID_SIZE; i++) {
+		uid[i] = tarjeta.uid[i];
+	}
+	return true;
 }
 
 /**
- *	@brief Detecta la presencia de una tarjeta
- *		   cerca del lector. Para hacer esto,
- *		   el MFRC522 envía el comando REQA
- *		   (definido en ISO/IEC 14443-3).
- *		   Cuando una tarjeta recibe este comando,
- *		   envía una respuesta al MFRC522.
- *	@retval Verdadero si recibe respuesta de una tarjeta,
- *			o falso si no se recibe respuesta.
+ *	@brief Detecta una tarjeta con REQA y, si hay
+ *		   respuesta, la selecciona recorriendo los
+ *		   niveles de cascada.
+ *	@retval Verdadero si se selecciona una tarjeta.
  */
-static bool_t mfrc522_detectarTarjeta() {
-	const uint8_t cmd = CMD_REQA;
-	const uint8_t txSize = 7;		//el comando REQA tiene un largo de 7 bits.
-	mfrc522_enviarComandoTarjeta(&cmd, 1, txSize);
-	bool_t respuestaRecibida = mfrc522_esperarRespuestaTarjeta();
-	return respuestaRecibida;
+bool_t mfrc522_leerUIDCompleto(mfrc522_uid_t *uid) {
+	return mfrc522_lectorLeerUID(&lectorPorDefecto, uid);
+}
+
+bool_t mfrc522_lectorLeerUID(mfrc522_t *lector, mfrc522_uid_t *uid) {
+	if (uid == NULL)
+		return false;
 
+	if (mfrc522_leer(lector, CMD_REQA) != MFRC522_LECTURA_TARJETA)
+		return false;
+	*uid = lector->uid;
+	return true;
 }
 
 /**
- *	@brief Envía los comandos CMD_SEL_CL1 y
- *		   NVB_CL1 para que la tarjeta responda
- *		   con su UID de 4 bytes.
- *	@retval Verdadero si se lee correctamente el UID,
- *			falso si no se puede leer.
+ *	@brief Lee todas las tarjetas del campo RF. En cada
+ *		   ciclo envía REQA: solo responden las tarjetas
+ *		   que todavía no fueron detenidas. Selecciona una
+ *		   de ellas con la anticolisión, guarda su UID y la
+ *		   detiene con HLTA. Termina cuando ninguna tarjeta
+ *		   responde al REQA.
+ *	@retval Cantidad de tarjetas leídas.
  */
-static bool_t mfrc522_leerUID(uint8_t *uid) {
-	uint8_t cmdBuffer[] = { CMD_SEL_CL1, NVB_CL1 };
+uint8_t mfrc522_inventario(mfrc522_uid_t *tarjetas, uint8_t maxTarjetas) {
+	return mfrc522_lectorInventario(&lectorPorDefecto, tarjetas, maxTarjetas);
+}
 
-	const uint8_t txSize = 0;		//txSize = 0 indica que se transmite 8 bits.
-	mfrc522_enviarComandoTarjeta(cmdBuffer, sizeof(cmdBuffer), txSize);
+uint8_t mfrc522_lectorInventario(mfrc522_t *lector, mfrc522_uid_t *tarjetas,
+		uint8_t maxTarjetas) {
+	uint8_t cantidad = 0;
+	uint8_t fallos = 0;
 
-	bool_t respuestaRecibida = mfrc522_esperarRespuestaTarjeta();
-	if (!respuestaRecibida)
-		return respuestaRecibida;
+	if (tarjetas == NULL)
+		return 0;
 
-	uint8_t responseBuffer[UID_SIZE];
-	bool_t lecturaUid = mfrc522_leerBufferFIFO(responseBuffer, UID_SIZE);
+	while (cantidad < maxTarjetas && fallos < maxTarjetas) {
+		mfrc522_lectura_enum resultado = mfrc522_leer(lector, CMD_REQA);
+		if (resultado == MFRC522_LECTURA_SIN_TARJETA)
+			break;					//no quedan tarjetas sin leer
 
-	if (lecturaUid) {
-		for (uint8_t i = 0; i < UID_SIZE; i++) {
-			uid[i] = responseBuffer[i];
+		if (resultado == MFRC522_LECTURA_TARJETA) {
+			tarjetas[cantidad++] = lector->uid;
+		} else {
+			fallos++;				//limita los reintentos ante errores de RF
 		}
+		mfrc522_haltTarjeta(lector);
 	}
 
-	return lecturaUid;
+	return cantidad;
 }
 
 /**
- *	@brief Envía uno o varios comandos a la tarjeta.
- *		   La cantidad depende del argumento largo.
+ *	@brief Configura la espera de las respuestas de la
+ *		   tarjeta. Se aplica desde el próximo comando.
  */
-static void mfrc522_enviarComandoTarjeta(uint8_t *comando, uint8_t largo,
-		uint8_t txSize) {
-	mfrc522_writeRegister(CommandReg, Idle);
+void mfrc522_esperaConfigurar(uint32_t esperaUs) {
+	mfrc522_lectorEsperaConfigurar(&lectorPorDefecto, esperaUs);
+}
 
-	// Se resetean los bits de interrupciones
-	// en el registro ComIrqReg para luego
-	// poder detectar si se activa alguno.
-	uint8_t valor_ComIrqReg = mfrc522_readRegister(ComIrqReg);
-	mfrc522_writeRegister(ComIrqReg, valor_ComIrqReg & (~ComIrqReg_Set1));
+void mfrc522_lectorEsperaConfigurar(mfrc522_t *lector, uint32_t esperaUs) {
+	if (lector == NULL || esperaUs == 0)
+		return;
+	lector->esperaTramaUs = esperaUs;
+}
 
-	mfrc522_writeRegister(FIFOLevelReg, FIFOLevelReg_FlushBuffer);
-	for (uint8_t i = 0; i < largo; i++) {
-		mfrc522_writeRegister(FIFODataReg, *(comando + i));
+/**
+ *	@brief Configura el rebote y la ventana del
+ *		   seguimiento de presencia.
+ */
+void mfrc522_presenciaConfigurar(uint8_t rebote, uint32_t ventanaMs) {
+	mfrc522_lectorPresenciaConfigurar(&lectorPorDefecto, rebote, ventanaMs);
+}
+
+void mfrc522_lectorPresenciaConfigurar(mfrc522_t *lector, uint8_t rebote,
+		uint32_t ventanaMs) {
+	if (lector == NULL || rebote == 0)
+		return;
+	lector->reboteSondeos = rebote;
+	lector->ventanaPresencia = ventanaMs;
+}
+
+/**
+ *	@brief Máquina de estados de presencia. Al leer una tarjeta
+ *		   nueva se la detiene con HLTA y se informa la llegada.
+ *		   Mientras está en el campo RF, cada llamada la sondea con
+ *		   mfrc522_sondearTarjeta en lugar de repetir REQA y la
+ *		   selección. Un sondeo con colisión (otra tarjeta también
+ *		   responde) no confirma ni descarta la tarjeta. El retiro
+ *		   se informa luego de reboteSondeos sondeos fallidos
+ *		   seguidos y de ventanaPresencia ms sin respuesta, por lo
+ *		   que una tarjeta que se aleja y vuelve enseguida no se
+ *		   informa dos veces.
+ *	@retval Evento ocurrido en esta llamada.
+ */
+mfrc522_evento_enum mfrc522_presencia(mfrc522_uid_t *uid) {
+	return mfrc522_lectorPresencia(&lectorPorDefecto, uid);
+}
+
+mfrc522_evento_enum mfrc522_lectorPresencia(mfrc522_t *lector,
+		mfrc522_uid_t *uid) {
+	if (lector == NULL || uid == NULL || lector->etapa != ETAPA_INACTIVA)
+		return MFRC522_EVENTO_NINGUNO;
+	if (lector->bajoConsumo) {
+		mfrc522_salirBajoConsumo(lector);
+		lector->tarjetaLista = false;	//al apagar el campo las tarjetas vuelven a IDLE
 	}
 
-	mfrc522_writeRegister(CommandReg, Transceive);
+	uint32_t ahora = portGetTick();
+	if (!lector->tarjetaEnCampo) {
+		if (mfrc522_leer(lector, CMD_REQA) != MFRC522_LECTURA_TARJETA)
+			return MFRC522_EVENTO_NINGUNO;
+		mfrc522_haltTarjeta(lector);		//para despertarla luego con WUPA
+		lector->tarjetaPresente = lector->uid;
+		lector->tarjetaEnCampo = true;
+		lector->tarjetaLista = false;
+		lector->sondeosFallidos = 0;
+		lector->ultimaPresencia = ahora;
+		*uid = lector->tarjetaPresente;
+		return MFRC522_EVENTO_LLEGADA;
+	}
+
+	resultado_transceive_enum resultado = mfrc522_sondearTarjeta(lector);
+	if (resultado == TRANSCEIVE_OK) {
+		lector->sondeosFallidos = 0;
+		lector->ultimaPresencia = ahora;
+		*uid = lector->tarjetaPresente;
+		return MFRC522_EVENTO_PRESENTE;
+	}
+	if (resultado == TRANSCEIVE_COLISION)
+		return MFRC522_EVENTO_NINGUNO;
 
-	// Inicia la transmisión e indica que se transmiten solo txSize bits.
-	// txSize = 0 indica que se transmiten 8 bits.
-	mfrc522_writeRegister(BitFramingReg, BitFramingReg_StartSend | txSize);
+	if (lector->sondeosFallidos < lector->reboteSondeos)
+		lector->sondeosFallidos++;
+	if (lector->sondeosFallidos < lector->reboteSondeos
+			|| ahora - lector->ultimaPresencia < lector->ventanaPresencia)
+		return MFRC522_EVENTO_NINGUNO;
+
+	lector->tarjetaEnCampo = false;
+	lector->tarjetaLista = false;
+	*uid = lector->tarjetaPresente;
+	return MFRC522_EVENTO_RETIRO;
 }
 
 /**
- *	@brief Espera a que se reciba una
- *		   respuesta de la tarjeta, o
- *		   que se cumpla el timeout del
- *		   timer interno del MFRC522, lo
- *		   que ocurra primero. Para saber si
- *		   la tarjeta respondió, se consulta
- *		   el bit RxIrq del registro ComIrqReg,
- *		   que se pone en 1 cuando se finaliza de
- *		   recibir datos de la tarjeta.
- *	@retval Verdadero si se recibe una respuesta,
- *			falso si ocurre timeout.
- */
-static bool_t mfrc522_esperarRespuestaTarjeta() {
-	bool_t respuestaRecibida = false;
-	uint16_t MAX_LOOPS = 10000;	//variable para evitar un  loop infinito en caso de que haya problemas con el módulo
-	while (!respuestaRecibida) {
-		uint8_t irqReg = mfrc522_readRegister(ComIrqReg);
-		if (irqReg & ComIrqReg_TimerIrq)		//ver si ocurre un timeout
+ *	@brief Lee RFCfgReg, RxThresholdReg, GsNReg y CWGsPReg
+ *		   juntos con mfrc522_readRegisters.
+ */
+void mfrc522_lectorRfLeer(mfrc522_t *lector, mfrc522_rf_t *rf) {
+	uint8_t valores[CANTIDAD_REGISTROS_RF];
+
+	if (lector == NULL || rf == NULL)
+		return;
+	mfrc522_readRegisters(lector, REGISTROS_RF, valores, sizeof(valores));
+	rf->ganancia = (valores[0] & RFCfgReg_RxGain) >> RFCfgReg_RxGain_Pos;
+	rf->umbral = (valores[1] & RxThresholdReg_MinLevel)
+			>> RxThresholdReg_MinLevel_Pos;
+	rf->conductanciaN = (valores[2] & GsNReg_CWGsN) >> GsNReg_CWGsN_Pos;
+	rf->conductanciaP = valores[3] & CWGsPReg_CWGsP;
+}
+
+/**
+ *	@brief Lee los registros de RF y escribe solo los que
+ *		   cambian, conservando los bits que no son parte de
+ *		   la configuración (CollLevel, ModGsN y reservados).
+ */
+bool_t mfrc522_lectorRfConfigurar(mfrc522_t *lector, const mfrc522_rf_t *rf) {
+	uint8_t valores[CANTIDAD_REGISTROS_RF];
+
+	if (lector == NULL || rf == NULL || rf->ganancia > 7 || rf->umbral > 15
+			|| rf->conductanciaP > CWGsPReg_CWGsP || rf->conductanciaN > 15)
+		return false;
+
+	mfrc522_readRegisters(lector, REGISTROS_RF, valores, sizeof(valores));
+	const uint8_t nuevos[CANTIDAD_REGISTROS_RF] = {
+			(valores[0] & ~RFCfgReg_RxGain)
+					| (rf->ganancia << RFCfgReg_RxGain_Pos),
+			(valores[1] & ~RxThresholdReg_MinLevel)
+					| (rf->umbral << RxThresholdReg_MinLevel_Pos),
+			(valores[2] & ~GsNReg_CWGsN)
+					| (rf->conductanciaN << GsNReg_CWGsN_Pos),
+			(valores[3] & ~CWGsPReg_CWGsP) | rf->conductanciaP };
+	for (uint8_t i = 0; i < CANTIDAD_REGISTROS_RF; i++) {
+		if (nuevos[i] != valores[i])
+			mfrc522_writeRegister(lector, REGISTROS_RF[i], nuevos[i]);
+	}
+	return true;
+}
+
+void mfrc522_lectorTelemetria(const mfrc522_t *lector,
+		mfrc522_telemetria_t *telemetria) {
+	if (lector != NULL && telemetria != NULL)
+		*telemetria = lector->telemetria;
+}
+
+void mfrc522_lectorTelemetriaBorrar(mfrc522_t *lector) {
+	const mfrc522_telemetria_t vacia = { 0 };
+	if (lector == NULL)
+		return;
+	lector->telemetria = vacia;
+	lector->fallidasSeguidas = 0;
+}
+
+/**
+ *	@brief Búsqueda por coordenadas: la ganancia, el umbral y
+ *		   la potencia se recorren de a uno, y luego se vuelve a
+ *		   recorrer la ganancia, que depende de la potencia
+ *		   elegida. Se evalúan a lo sumo 20 configuraciones en
+ *		   lugar de las 168 combinaciones de los valores recorridos.
+ */
+bool_t mfrc522_lectorAutoajustar(mfrc522_t *lector, uint8_t intentos,
+		mfrc522_rf_t *rf) {
+	static const parametro_ajuste_enum PASOS[] = { AJUSTE_GANANCIA,
+			AJUSTE_UMBRAL, AJUSTE_CONDUCTANCIA, AJUSTE_GANANCIA };
+	mfrc522_rf_t inicial, mejor;
+
+	if (lector == NULL || intentos == 0 || lector->etapa != ETAPA_INACTIVA)
+		return false;
+	if (lector->bajoConsumo)
+		mfrc522_salirBajoConsumo(lector);
+
+	mfrc522_telemetria_t telemetria = lector->telemetria;
+	uint32_t fallidasSeguidas = lector->fallidasSeguidas;
+	mfrc522_lectorRfLeer(lector, &inicial);
+	mejor = inicial;
+	puntaje_rf_t mejorPuntaje = mfrc522_evaluarRf(lector, &mejor, intentos);
+	for (uint8_t i = 0; i < sizeof(PASOS) / sizeof(PASOS[0]); i++)
+		mfrc522_ajustarParametro(lector, PASOS[i], intentos, &mejor,
+				&mejorPuntaje);
+
+	lector->telemetria = telemetria;
+	lector->fallidasSeguidas = fallidasSeguidas;
+	lector->tarjetaLista = false;		//las lecturas de prueba detienen la tarjeta
+
+	if (mejorPuntaje.aciertos == 0) {
+		mfrc522_lectorRfConfigurar(lector, &inicial);
+		return false;
+	}
+	mfrc522_lectorRfConfigurar(lector, &mejor);
+	if (rf != NULL)
+		*rf = mejor;
+	return true;
+}
+
+/**
+ *	@brief Prueba los valores de un parámetro con los demás
+ *		   en la mejor configuración, y la actualiza si alguno
+ *		   completa más lecturas o, con las mismas lecturas,
+ *		   usa menos intercambios.
+ */
+static void mfrc522_ajustarParametro(mfrc522_t *lector,
+		parametro_ajuste_enum parametro, uint8_t intentos, mfrc522_rf_t *mejor,
+		puntaje_rf_t *mejorPuntaje) {
+	uint8_t cantidad;
+
+	switch (parametro) {
+	case AJUSTE_GANANCIA:
+		cantidad = sizeof(GANANCIAS_AJUSTE);
+		break;
+	case AJUSTE_UMBRAL:
+		cantidad = sizeof(UMBRALES_AJUSTE);
+		break;
+	default:
+		cantidad = sizeof(CONDUCTANCIAS_AJUSTE) / sizeof(CONDUCTANCIAS_AJUSTE[0]);
+		break;
+	}
+
+	mfrc522_rf_t base = *mejor;
+	for (uint8_t i = 0; i < cantidad; i++) {
+		mfrc522_rf_t candidata = base;
+		switch (parametro) {
+		case AJUSTE_GANANCIA:
+			candidata.ganancia = GANANCIAS_AJUSTE[i];
+			break;
+		case AJUSTE_UMBRAL:
+			candidata.umbral = UMBRALES_AJUSTE[i];
 			break;
-		if (irqReg & ComIrqReg_RxIrq)	//si se recibe una respuesta
-			respuestaRecibida = true;
-		if (--MAX_LOOPS == 0)//si se cumple la cantidad máxima de loops, terminar.
+		default:
+			candidata.conductanciaP = CONDUCTANCIAS_AJUSTE[i][0];
+			candidata.conductanciaN = CONDUCTANCIAS_AJUSTE[i][1];
 			break;
+		}
+		if (candidata.ganancia == base.ganancia && candidata.umbral == base.umbral
+				&& candidata.conductanciaP == base.conductanciaP
+				&& candidata.conductanciaN == base.conductanciaN)
+			continue;		//ya evaluada
+
+		puntaje_rf_t puntaje = mfrc522_evaluarRf(lector, &candidata, intentos);
+		if (puntaje.aciertos > mejorPuntaje->aciertos
+				|| (puntaje.aciertos == mejorPuntaje->aciertos
+						&& puntaje.intercambios < mejorPuntaje->intercambios)) {
+			*mejor = candidata;
+			*mejorPuntaje = puntaje;
+		}
 	}
-	return respuestaRecibida;
 }
 
 /**
- *	@brief Lee el buffer FIFO interno del MFRC522.
- *		   Este se utiliza para intercambiar comandos
- *		   y datos desde el MFRC522 a la tarjeta, y viceversa.
- *		   Los datos leídos se guardan en la memoria indicada
- *		   por el argumento response.
- *	@retval Verdadero si se leen datos del buffer, falso si no
- *			hay datos para leer.
+ *	@brief Escribe la configuración y realiza intentos
+ *		   lecturas completas. Cada una comienza con WUPA y
+ *		   termina con HLTA, por lo que la tarjeta responde a
+ *		   la siguiente sin apagar el campo RF.
  */
-static bool_t mfrc522_leerBufferFIFO(uint8_t *response, uint8_t max_bytes) {
-	uint8_t n = mfrc522_readRegister(FIFOLevelReg);	//consulta cuantos bytes hay disponibles para leer
-	if (n == 0)
-		return false;
-	if (n > max_bytes)
-		n = max_bytes;					//limito el máximo de bytes que se  leen
-	for (uint8_t i = 0; i < n; i++) {
-		response[i] = mfrc522_readRegister(FIFODataReg);
+static puntaje_rf_t mfrc522_evaluarRf(mfrc522_t *lector, const mfrc522_rf_t *rf,
+		uint8_t intentos) {
+	puntaje_rf_t puntaje = { 0 };
+
+	mfrc522_lectorRfConfigurar(lector, rf);
+	uint32_t intercambios = lector->telemetria.intercambios;
+	for (uint8_t i = 0; i < intentos; i++) {
+		if (mfrc522_leer(lector, CMD_WUPA) == MFRC522_LECTURA_TARJETA)
+			puntaje.aciertos++;
+		mfrc522_haltTarjeta(lector);
+	}
+	puntaje.intercambios = lector->telemetria.intercambios - intercambios;
+	return puntaje;
+}
+
+/**
+ *	@brief Confirma que la tarjeta conocida sigue en el campo
+ *		   RF. Si quedó en READY por el sondeo anterior, alcanza
+ *		   con un comando de anticolisión, al que responde sin
+ *		   cambiar de estado (ISO/IEC 14443-3, sección 6.3). Si
+ *		   no responde (estaba detenida con HLTA, o salió del
+ *		   campo y volvió en IDLE), se la despierta con WUPA y
+ *		   se repite la anticolisión.
+ *	@retval TRANSCEIVE_OK si la tarjeta responde con su UID.
+ */
+static resultado_transceive_enum mfrc522_sondearTarjeta(mfrc522_t *lector) {
+	resultado_transceive_enum resultado;
+
+	if (lector->tarjetaLista) {
+		resultado = mfrc522_confirmarTarjeta(lector);
+		if (resultado == TRANSCEIVE_OK || resultado == TRANSCEIVE_COLISION)
+			return resultado;
+	}
+
+	const uint8_t cmd = CMD_WUPA;
+	respuesta_tarjeta_t respuesta;
+	mfrc522_enviarComandoTarjeta(lector, &cmd, 1, BITS_REQA,
+			lector->esperaTramaUs);
+	mfrc522_esperarRespuestaTarjeta(lector, &respuesta);
+	if (respuesta.resultado != TRANSCEIVE_OK
+			&& respuesta.resultado != TRANSCEIVE_COLISION) {
+		lector->tarjetaLista = false;
+		return respuesta.resultado;
+	}
+
+	resultado = mfrc522_confirmarTarjeta(lector);
+	lector->tarjetaLista = (resultado == TRANSCEIVE_OK);
+	return resultado;
+}
+
+/**
+ *	@brief Envía la anticolisión del primer nivel de cascada
+ *		   sin bits conocidos y compara la respuesta (UID del
+ *		   nivel y BCC) con la de la tarjeta conocida. Para UIDs
+ *		   de 7 o 10 bytes el nivel comienza con CASCADE_TAG.
+ *	@retval TRANSCEIVE_OK si responde la tarjeta conocida, o
+ *			TRANSCEIVE_ERROR si responde otra.
+ */
+static resultado_transceive_enum mfrc522_confirmarTarjeta(mfrc522_t *lector) {
+	const uint8_t cmd[2] = { CMD_SEL_CL1, NVB_ANTICOLISION };
+	const mfrc522_uid_t *tarjeta = &lector->tarjetaPresente;
+	respuesta_tarjeta_t respuesta;
+
+	mfrc522_enviarComandoTarjeta(lector, cmd, sizeof(cmd), 0,
+			lector->esperaTramaUs);
+	mfrc522_esperarRespuestaTarjeta(lector, &respuesta);
+	if (respuesta.resultado != TRANSCEIVE_OK)
+		return respuesta.resultado;
+	if (respuesta.largo != BYTES_NIVEL)
+		return TRANSCEIVE_ERROR;
+
+	uint8_t nivel[BYTES_NIVEL];
+	uint8_t desde = 0;
+	if (tarjeta->largo > UID_SIZE)
+		nivel[desde++] = CASCADE_TAG;
+	nivel[UID_SIZE] = 0;
+	for (uint8_t i = desde; i < UID_SIZE; i++) {
+		nivel[i] = tarjeta->uid[i - desde];
 	}
+	for (uint8_t i = 0; i < UID_SIZE; i++) {
+		nivel[UID_SIZE] ^= nivel[i];		//BCC
+	}
+	for (uint8_t i = 0; i < BYTES_NIVEL; i++) {
+		if (respuesta.datos[i] != nivel[i])
+			return TRANSCEIVE_ERROR;
+	}
+	return TRANSCEIVE_OK;
+}
+
+/**
+ *	@brief Inicia una lectura enviando REQA (definido en
+ *		   ISO/IEC 14443-3). Cuando una tarjeta recibe este
+ *		   comando, envía una respuesta al MFRC522 (ATQA).
+ *		   La respuesta se procesa en mfrc522_lectorProcesar.
+ *	@retval Falso si ya hay una lectura en curso.
+ */
+bool_t mfrc522_lectorIniciarLectura(mfrc522_t *lector) {
+	return mfrc522_iniciarLectura(lector, CMD_REQA);
+}
+
+/**
+ *	@brief Inicia una lectura con REQA o WUPA. WUPA
+ *		   despierta también a las tarjetas detenidas con HLTA.
+ *	@retval Falso si ya hay una lectura en curso.
+ */
+static bool_t mfrc522_iniciarLectura(mfrc522_t *lector,
+		comandos_tarjeta_enum despertar) {
+	const uint8_t cmd = despertar;
+
+	if (lector == NULL || lector->etapa != ETAPA_INACTIVA)
+		return false;
+	if (lector->bajoConsumo)
+		mfrc522_salirBajoConsumo(lector);
+
+	lector->uid.largo = 0;
+	lector->uid.atqa[0] = 0;
+	lector->uid.atqa[1] = 0;
+	lector->etapa = ETAPA_REQA;
+	lector->telemetria.lecturas++;
+	mfrc522_enviarComandoTarjeta(lector, &cmd, 1, BITS_REQA,
+			lector->esperaTramaUs);
 	return true;
 }
 
+/**
+ *	@brief Si terminó el intercambio en curso, lee la
+ *		   respuesta y avanza la lectura. No bloquea.
+ *	@retval Estado de la lectura.
+ */
+mfrc522_lectura_enum mfrc522_lectorProcesar(mfrc522_t *lector,
+		mfrc522_uid_t *uid) {
+	if (lector == NULL || lector->etapa == ETAPA_INACTIVA)
+		return MFRC522_LECTURA_ERROR;
+	if (!mfrc522_intercambioTerminado(lector))
+		return MFRC522_LECTURA_EN_CURSO;
+
+	mfrc522_lectura_enum resultado = mfrc522_continuarLectura(lector);
+	if (resultado == MFRC522_LECTURA_TARJETA && uid != NULL)
+		*uid = lector->uid;
+	return resultado;
+}
+
+/**
+ *	@brief Planificador de lecturas intercaladas. Se envía
+ *		   REQA en todos los lectores y luego se atiende a los
+ *		   que terminaron su intercambio: se lee la respuesta
+ *		   y se envía el comando siguiente. El intercambio de
+ *		   RF de cada lector (que dura cientos de uS) transcurre
+ *		   mientras el bus SPI atiende a los demás, por lo que
+ *		   el tiempo total crece poco con la cantidad de lectores.
+ *		   Si en una pasada ningún lector avanzó, el procesador
+ *		   duerme hasta el próximo flanco de IRQ.
+ *	@retval Cantidad de lectores en los que se leyó una tarjeta.
+ */
+uint8_t mfrc522_leerLectores(mfrc522_t *lectores, uint8_t cantidad,
+		mfrc522_uid_t *uids) {
+	uint8_t pendientes = 0;
+	uint8_t leidas = 0;
+
+	if (lectores == NULL || uids == NULL)
+		return 0;
+
+	for (uint8_t i = 0; i < cantidad; i++) {
+		uids[i].largo = 0;
+		if (mfrc522_lectorIniciarLectura(&lectores[i]))
+			pendientes++;
+	}
+
+	while (pendientes > 0) {
+		uint32_t mascara = 0;
+		uint32_t espera = 0;
+		bool_t progreso = false;
+
+		for (uint8_t i = 0; i < cantidad; i++) {
+			mfrc522_t *lector = &lectores[i];
+			if (lector->etapa == ETAPA_INACTIVA)
+				continue;
+			if (!mfrc522_intercambioTerminado(lector)) {
+				mascara |= 1UL << lector->indice;
+				if (espera == 0 || lector->esperaMaximaMs < espera)
+					espera = lector->esperaMaximaMs;
+				continue;
+			}
+
+			progreso = true;
+			mfrc522_lectura_enum resultado = mfrc522_continuarLectura(lector);
+			if (resultado == MFRC522_LECTURA_EN_CURSO)
+				continue;
+			pendientes--;
+			if (resultado == MFRC522_LECTURA_TARJETA) {
+				uids[i] = lector->uid;
+				leidas++;
+			}
+		}
+
+#if IRQ_HABILITADA
+		if (!progreso && mascara != 0)
+			irqWaitAnyEvent(mascara, espera);
+#else
+		(void) progreso;
+		(void) mascara;
+		(void) espera;
+#endif
+	}
+
+	return leidas;
+}
+
+/**
+ *	@brief Realiza una lectura completa, iniciada con
+ *		   REQA o WUPA, esperando cada respuesta de la tarjeta.
+ *	@retval Resultado de la lectura.
+ */
+static mfrc522_lectura_enum mfrc522_leer(mfrc522_t *lector,
+		comandos_tarjeta_enum despertar) {
+	respuesta_tarjeta_t respuesta;
+
+	if (!mfrc522_iniciarLectura(lector, despertar))
+		return MFRC522_LECTURA_ERROR;
+
+	mfrc522_lectura_enum resultado = MFRC522_LECTURA_EN_CURSO;
+	while (resultado == MFRC522_LECTURA_EN_CURSO) {
+		mfrc522_esperarRespuestaTarjeta(lector, &respuesta);
+		resultado = mfrc522_avanzarLectura(lector, &respuesta);
+	}
+	return resultado;
+}
+
+/**
+ *	@brief Lee la respuesta del intercambio terminado
+ *		   y avanza la lectura.
+ */
+static mfrc522_lectura_enum mfrc522_continuarLectura(mfrc522_t *lector) {
+	respuesta_tarjeta_t respuesta;
+	mfrc522_finalizarIntercambio(lector, &respuesta);
+	return mfrc522_avanzarLectura(lector, &respuesta);
+}
+
+/**
+ *	@brief Procesa la respuesta a la etapa actual de la
+ *		   lectura. Si responden varias tarjetas al REQA la
+ *		   respuesta tiene colisiones, pero indica igualmente
+ *		   que hay tarjetas presentes, y se selecciona una de
+ *		   ellas recorriendo los niveles de cascada.
+ *	@retval MFRC522_LECTURA_EN_CURSO si se envió un nuevo
+ *			comando a la tarjeta, o el resultado de la lectura.
+ */
+static mfrc522_lectura_enum mfrc522_avanzarLectura(mfrc522_t *lector,
+		const respuesta_tarjeta_t *respuesta) {
+	switch (lector->etapa) {
+	case ETAPA_REQA:
+		if (respuesta->resultado != TRANSCEIVE_OK
+				&& respuesta->resultado != TRANSCEIVE_COLISION)
+			return mfrc522_terminarLectura(lector, MFRC522_LECTURA_SIN_TARJETA);
+		for (uint8_t i = 0; i < respuesta->largo && i < 2; i++) {
+			lector->uid.atqa[i] = respuesta->datos[i];
+		}
+		lector->nivel = 0;
+		mfrc522_enviarAnticolision(lector);
+		return MFRC522_LECTURA_EN_CURSO;
+	case ETAPA_ANTICOLISION:
+		return mfrc522_procesarAnticolision(lector, respuesta);
+	case ETAPA_SELECCION:
+		return mfrc522_procesarSeleccion(lector, respuesta);
+	default:
+		return mfrc522_terminarLectura(lector, MFRC522_LECTURA_ERROR);
+	}
+}
+
+/**
+ *	@brief Inicia la anticolisión del nivel de cascada
+ *		   actual (ISO/IEC 14443-3, sección 6.5.3) o la
+ *		   continúa luego de una colisión. Envía SEL, NVB y
+ *		   los bits del UID ya conocidos; las tarjetas cuyo UID
+ *		   comienza con esos bits responden con los restantes.
+ *		   RxAlign ubica el primer bit recibido a continuación
+ *		   de los enviados.
+ */
+static void mfrc522_enviarAnticolision(mfrc522_t *lector) {
+	if (lector->etapa != ETAPA_ANTICOLISION) {
+		lector->etapa = ETAPA_ANTICOLISION;
+		lector->trama[0] = CMD_SEL_NIVEL[lector->nivel];
+		lector->bitsConocidos = 0;
+		lector->colisiones = 0;
+	}
+
+	uint8_t bytesCompletos = lector->bitsConocidos / 8;
+	uint8_t bitsSueltos = lector->bitsConocidos % 8;
+
+	lector->trama[1] = ((2 + bytesCompletos) << 4) | bitsSueltos;		//NVB
+	uint8_t largoTx = 2 + bytesCompletos + (bitsSueltos ? 1 : 0);
+	uint8_t bitFraming = (bitsSueltos << BitFramingReg_RxAlign_Pos)
+			| bitsSueltos;
+	mfrc522_enviarComandoTarjeta(lector, lector->trama, largoTx, bitFraming,
+			lector->esperaTramaUs);
+}
+
+/**
+ *	@brief Procesa la respuesta a la anticolisión. Si hay una
+ *		   colisión, los bits anteriores son válidos, se elige
+ *		   el valor 1 para el bit en colisión y se repite con
+ *		   un bit conocido más. Si se obtienen los 4 bytes del
+ *		   UID del nivel y el BCC es correcto, se envía SELECT.
+ *	@retval MFRC522_LECTURA_EN_CURSO o MFRC522_LECTURA_ERROR.
+ */
+static mfrc522_lectura_enum mfrc522_procesarAnticolision(mfrc522_t *lector,
+		const respuesta_tarjeta_t *respuesta) {
+	uint8_t *trama = lector->trama;		//SEL, NVB, UID del nivel, BCC
+	uint8_t bytesCompletos = lector->bitsConocidos / 8;
+	uint8_t bitsSueltos = lector->bitsConocidos % 8;
+
+	if (respuesta->resultado != TRANSCEIVE_OK
+			&& respuesta->resultado != TRANSCEIVE_COLISION)
+		return mfrc522_terminarLectura(lector, MFRC522_LECTURA_ERROR);
+
+	// Une los bits recibidos con los conocidos. El primer byte
+	// recibido comparte los bitsSueltos menos significativos
+	// con el último byte enviado.
+	uint8_t largoRespuesta = respuesta->largo;
+	if (largoRespuesta > BYTES_NIVEL - bytesCompletos)
+		largoRespuesta = BYTES_NIVEL - bytesCompletos;
+	for (uint8_t i = 0; i < largoRespuesta; i++) {
+		uint8_t indice = 2 + bytesCompletos + i;
+		if (i == 0 && bitsSueltos) {
+			uint8_t mascara = (1 << bitsSueltos) - 1;
+			trama[indice] = (trama[indice] & mascara)
+					| (respuesta->datos[0] & ~mascara);
+		} else {
+			trama[indice] = respuesta->datos[i];
+		}
+	}
+
+	if (respuesta->resultado == TRANSCEIVE_COLISION) {
+		// CollPos se cuenta desde el primer bit del primer byte de
+		// la FIFO, que incluye los bitsSueltos alineados con RxAlign.
+		uint8_t posicion = bytesCompletos * 8 + respuesta->posicionColision;
+		if (posicion <= lector->bitsConocidos || posicion > BYTES_NIVEL * 8
+				|| ++lector->colisiones > MAX_COLISIONES)
+			return mfrc522_terminarLectura(lector, MFRC522_LECTURA_ERROR);
+		lector->bitsConocidos = posicion;
+		uint8_t indice = 2 + (posicion - 1) / 8;
+		uint8_t bit = (posicion - 1) % 8;
+		trama[indice] |= (1 << bit);		//elige las tarjetas con 1 en ese bit
+		trama[indice] &= (2 << bit) - 1;	//descarta los bits siguientes
+		mfrc522_enviarAnticolision(lector);
+		return MFRC522_LECTURA_EN_CURSO;
+	}
+
+	if (bytesCompletos + largoRespuesta < BYTES_NIVEL)
+		return mfrc522_terminarLectura(lector, MFRC522_LECTURA_ERROR);	//respuesta incompleta
+
+	uint8_t bcc = 0;
+	for (uint8_t i = 0; i < BYTES_NIVEL; i++) {
+		bcc ^= trama[2 + i];
+	}
+	if (bcc != 0) {
+		lector->telemetria.erroresCrc++;
+		return mfrc522_terminarLectura(lector, MFRC522_LECTURA_ERROR);
+	}
+
+	mfrc522_enviarSeleccion(lector);
+	return MFRC522_LECTURA_EN_CURSO;
+}
+
+/**
+ *	@brief Selecciona la tarjeta del nivel de cascada con
+ *		   SEL, NVB = 0x70, el UID del nivel, BCC y CRC_A.
+ *		   La trama de la anticolisión ya contiene SEL y
+ *		   el UID del nivel, por lo que solo se completa.
+ */
+static void mfrc522_enviarSeleccion(mfrc522_t *lector) {
+	uint8_t *trama = lector->trama;
+	trama[1] = NVB_SELECT;
+	uint16_t crc = mfrc522_calcularCRC(trama, 2 + BYTES_NIVEL);
+	trama[2 + BYTES_NIVEL] = crc & 0xFF;
+	trama[2 + BYTES_NIVEL + 1] = crc >> 8;
+
+	lector->etapa = ETAPA_SELECCION;
+	mfrc522_enviarComandoTarjeta(lector, trama, 2 + BYTES_NIVEL + 2, 0,
+			lector->esperaTramaUs);
+}
+
+/**
+ *	@brief Procesa la respuesta SAK al SELECT y consulta
+ *		   el bit de UID incompleto. Si está activo, el primer
+ *		   byte del nivel es CASCADE_TAG y se continúa con la
+ *		   anticolisión del siguiente nivel.
+ *	@retval MFRC522_LECTURA_TARJETA si se completó el UID.
+ */
+static mfrc522_lectura_enum mfrc522_procesarSeleccion(mfrc522_t *lector,
+		const respuesta_tarjeta_t *respuesta) {
+	mfrc522_uid_t *uid = &lector->uid;
+	const uint8_t *uidNivel = &lector->trama[2];
+
+	if (respuesta->resultado != TRANSCEIVE_OK || respuesta->largo != 3)
+		return mfrc522_terminarLectura(lector, MFRC522_LECTURA_ERROR);
+	if (mfrc522_calcularCRC(respuesta->datos, 3) != 0) {		//el CRC_A sobre datos + CRC da 0
+		lector->telemetria.erroresCrc++;
+		return mfrc522_terminarLectura(lector, MFRC522_LECTURA_ERROR);
+	}
+
+	uid->sak = respuesta->datos[0];
+	if (uid->sak & SAK_UID_INCOMPLETO) {
+		if (uidNivel[0] != CASCADE_TAG || lector->nivel == NIVELES_CASCADA - 1)
+			return mfrc522_terminarLectura(lector, MFRC522_LECTURA_ERROR);
+		for (uint8_t i = 1; i < UID_SIZE; i++) {
+			uid->uid[uid->largo++] = uidNivel[i];
+		}
+		lector->nivel++;
+		mfrc522_enviarAnticolision(lector);
+		return MFRC522_LECTURA_EN_CURSO;
+	}
+
+	for (uint8_t i = 0; i < UID_SIZE; i++) {
+		uid->uid[uid->largo++] = uidNivel[i];
+	}
+	return mfrc522_terminarLectura(lector, MFRC522_LECTURA_TARJETA);
+}
+
+/**
+ *	@brief Deja el lector sin lectura en curso y cuenta el
+ *		   resultado. Las lecturas fallidas (la tarjeta respondió
+ *		   pero no se completó la selección) se suman como
+ *		   reintentos al siguiente acierto; las lecturas sin
+ *		   tarjeta no, ya que no se puede saber si había una.
+ *	@retval El resultado recibido.
+ */
+static mfrc522_lectura_enum mfrc522_terminarLectura(mfrc522_t *lector,
+		mfrc522_lectura_enum resultado) {
+	mfrc522_telemetria_t *telemetria = &lector->telemetria;
+
+	lector->etapa = ETAPA_INACTIVA;
+	switch (resultado) {
+	case MFRC522_LECTURA_TARJETA:
+		telemetria->aciertos++;
+		telemetria->reintentos += lector->fallidasSeguidas;
+		lector->fallidasSeguidas = 0;
+		break;
+	case MFRC522_LECTURA_SIN_TARJETA:
+		telemetria->sinTarjeta++;
+		break;
+	default:
+		telemetria->fallidas++;
+		lector->fallidasSeguidas++;
+		break;
+	}
+	return resultado;
+}
+
+/**
+ *	@brief Envía HLTA a la tarjeta seleccionada para que
+ *		   pase al estado HALT. La tarjeta no responde,
+ *		   por lo que la espera termina por timeout.
+ */
+static void mfrc522_haltTarjeta(mfrc522_t *lector) {
+	uint8_t trama[4] = { CMD_HLTA, 0x00 };
+	uint16_t crc = mfrc522_calcularCRC(trama, 2);
+	trama[2] = crc & 0xFF;
+	trama[3] = crc >> 8;
+
+	respuesta_tarjeta_t respuesta;
+	uint32_t intercambios = lector->telemetria.intercambios;
+	uint32_t timeouts = lector->telemetria.timeouts;
+	mfrc522_enviarComandoTarjeta(lector, trama, sizeof(trama), 0,
+			lector->esperaTramaUs);
+	mfrc522_esperarRespuestaTarjeta(lector, &respuesta);
+	lector->telemetria.intercambios = intercambios;		//el timeout es la respuesta esperada
+	lector->telemetria.timeouts = timeouts;
+}
+
+/**
+ *	@brief Calcula el CRC_A de ISO/IEC 14443-3 (Anexo B)
+ *		   por software, para no usar el coprocesador de
+ *		   CRC del MFRC522 y ahorrar accesos por SPI.
+ *	@retval CRC_A. El byte menos significativo se transmite primero.
+ */
+static uint16_t mfrc522_calcularCRC(const uint8_t *datos, uint8_t largo) {
+	uint16_t crc = CRC_A_INICIAL;
+	for (uint8_t i = 0; i < largo; i++) {
+		uint8_t byte = datos[i] ^ (uint8_t) (crc & 0xFF);
+		byte ^= byte << 4;
+		crc = (crc >> 8) ^ ((uint16_t) byte << 8) ^ ((uint16_t) byte << 3)
+				^ (byte >> 4);
+	}
+	return crc;
+}
+
+/**
+ *	@brief Indica, sin bloquear, si terminó el intercambio
+ *		   con la tarjeta: el MFRC522 activó el pin IRQ (o,
+ *		   sin IRQ_HABILITADA, RxIrq o TimerIrq en ComIrqReg),
+ *		   o pasaron esperaMaximaMs desde el envío.
+ */
+static bool_t mfrc522_intercambioTerminado(mfrc522_t *lector) {
+	if (spiChainBusy(lector->indice))
+		return false;
+#if IRQ_HABILITADA
+	if (irqEvento(lector->indice))
+		return true;
+#else
+	if (mfrc522_readRegister(lector, ComIrqReg)
+			& (ComIrqReg_RxIrq | ComIrqReg_TimerIrq))
+		return true;
+#endif
+	return (portGetTick() - lector->inicioIntercambio) > lector->esperaMaximaMs;
+}
+
+/**
+ *	@brief Lee la respuesta de la tarjeta. ComIrqReg, la
+ *		   cantidad de bytes en la FIFO, los errores y la
+ *		   posición de colisión se leen juntos en una única
+ *		   transferencia, y luego los bytes de la FIFO en otra.
+ *		   Si RxIrq no está activo, la tarjeta no respondió.
+ */
+static void mfrc522_finalizarIntercambio(mfrc522_t *lector,
+		respuesta_tarjeta_t *respuesta) {
+	const registros_MFRC522_enum regs[] = { ComIrqReg, FIFOLevelReg, ErrorReg,
+			CollReg };
+	uint8_t valores[sizeof(regs) / sizeof(regs[0])];
+	mfrc522_readRegisters(lector, regs, valores, sizeof(valores));
+	mfrc522_registrarIntercambio(lector, valores[0], valores[2]);
+
+	respuesta->largo = 0;
+	respuesta->posicionColision = 0;
+	if (!(valores[0] & ComIrqReg_RxIrq)) {
+		respuesta->resultado = TRANSCEIVE_TIMEOUT;
+		return;
+	}
+	if (valores[2] & ErrorReg_ErroresRecepcion) {
+		respuesta->resultado = TRANSCEIVE_ERROR;
+		return;
+	}
+
+	uint8_t n = valores[1];		//cantidad de bytes disponibles para leer
+	if (n > sizeof(respuesta->datos))
+		n = sizeof(respuesta->datos);	//limito el máximo de bytes que se leen
+	respuesta->largo = n;
+	mfrc522_readRegisterBurst(lector, FIFODataReg, respuesta->datos, n);	//lee los n bytes en una transferencia
+
+	respuesta->resultado = TRANSCEIVE_OK;
+	if (valores[2] & ErrorReg_CollErr) {
+		respuesta->resultado = TRANSCEIVE_COLISION;
+		if (valores[3] & CollReg_CollPosNotValid)
+			respuesta->resultado = TRANSCEIVE_ERROR;
+		respuesta->posicionColision = valores[3] & CollReg_CollPos;
+		if (respuesta->posicionColision == 0)
+			respuesta->posicionColision = 32;	//CollPos = 0 indica el bit 32
+	}
+}
+
+/**
+ *	@brief Cuenta el intercambio en la telemetría con los
+ *		   valores de ComIrqReg y ErrorReg ya leídos.
+ */
+static void mfrc522_registrarIntercambio(mfrc522_t *lector, uint8_t comIrq,
+		uint8_t error) {
+	mfrc522_telemetria_t *telemetria = &lector->telemetria;
+
+	telemetria->intercambios++;
+	if (!(comIrq & ComIrqReg_RxIrq)) {
+		telemetria->timeouts++;
+		return;
+	}
+	if (!(error & ErrorReg_ErroresTelemetria))
+		return;
+	telemetria->ultimoErrorReg = error;
+	if (error & ErrorReg_ParityErr)
+		telemetria->erroresParidad++;
+	if (error & ErrorReg_ProtocolErr)
+		telemetria->erroresProtocolo++;
+	if (error & ErrorReg_BufferOvfl)
+		telemetria->desbordesFifo++;
+	if (error & ErrorReg_CollErr)
+		telemetria->colisiones++;
+}
+
+/**
+ *	@brief Envía uno o varios comandos a la tarjeta.
+ *		   La cantidad depende del argumento largo.
+ *		   Toda la secuencia de escrituras se arma como una
+ *		   cadena de descriptores que el puerto ejecuta con
+ *		   DMA, por lo que la función retorna sin esperar al
+ *		   SPI. Los accesos siguientes a registros esperan a
+ *		   que finalice la cadena. Si no se puede iniciar la
+ *		   cadena, se realizan las escrituras bloqueantes.
+ *		   Si la antena se acaba de encender, primero espera
+ *		   el resto del tiempo de guarda del campo.
+ *		   esperaUs es el tiempo máximo entre el fin de la
+ *		   transmisión y el inicio de la respuesta. Si cambia
+ *		   respecto del comando anterior, la recarga del timer
+ *		   se agrega a la misma cadena. Con la duración de la
+ *		   cadena, de la transmisión y de la respuesta más
+ *		   larga se calcula también esperaMaximaMs, el límite
+ *		   de la espera del lado del procesador.
+ */
+static void mfrc522_enviarComandoTarjeta(mfrc522_t *lector,
+		const uint8_t *comando, uint8_t largo, uint8_t bitFraming,
+		uint32_t esperaUs) {
+	// Los datos de la cadena deben permanecer válidos hasta que
+	// termine el DMA, por eso se copian al estado del lector.
+	uint8_t *valores = lector->valoresCadena;
+	uint8_t primero = DESCRIPTORES_RECARGA;		//sin cambios en la recarga
+
+	if (largo == 0 || largo > MFRC522_TRAMA_MAX)
+		return;
+
+	mfrc522_esperarGuardaCampo(lector);
+	while (spiChainBusy(lector->indice))
+		;		//la cadena anterior todavía usa el bus
+	irqClearEvent(lector->indice);	//el próximo flanco en IRQ corresponde a este comando
+
+	if (esperaUs != lector->esperaTimerUs) {
+		uint16_t prescaler, recarga;
+		mfrc522_calcularTimer(esperaUs, &prescaler, &recarga);
+		if (prescaler != lector->prescalerTimer) {
+			// solo en esperas de más de 1,6 s
+			mfrc522_writeRegister(lector, TModeReg,
+					TModeReg_TAuto | (prescaler >> 8));
+			mfrc522_writeRegister(lector, TPrescalerReg, prescaler & 0xFF);
+			lector->prescalerTimer = prescaler;
+		}
+		valores[5] = recarga >> 8;
+		valores[6] = recarga & 0xFF;
+		lector->esperaTimerUs = esperaUs;
+		primero = 0;
+	}
+
+	for (uint8_t i = 0; i < largo; i++) {
+		lector->comandoCadena[i] = comando[i];
+	}
+	valores[0] = Idle;
+	// Escribir Set1 = 0 borra los bits marcados con 1 de
+	// ComIrqReg, por lo que no hace falta leerlo antes.
+	valores[1] = ComIrqReg_TodosLosBits & (~ComIrqReg_Set1);
+	valores[2] = FIFOLevelReg_FlushBuffer;
+	valores[3] = Transceive;
+	// Inicia la transmisión. bitFraming indica cuántos bits del último
+	// byte se transmiten (TxLastBits, 0 = 8 bits) y en qué bit se ubica
+	// el primer bit recibido (RxAlign).
+	valores[4] = BitFramingReg_StartSend | bitFraming;
+
+	const spi_descriptor_t descriptores[] = {
+			{ WRITE_MASK | TReloadRegH << 1, &valores[5], 1 },
+			{ WRITE_MASK | TReloadRegL << 1, &valores[6], 1 },
+			{ WRITE_MASK | CommandReg << 1, &valores[0], 1 },
+			{ WRITE_MASK | ComIrqReg << 1, &valores[1], 1 },
+			{ WRITE_MASK | FIFOLevelReg << 1, &valores[2], 1 },
+			{ WRITE_MASK | FIFODataReg << 1, lector->comandoCadena, largo },
+			{ WRITE_MASK | CommandReg << 1, &valores[3], 1 },
+			{ WRITE_MASK | BitFramingReg << 1, &valores[4], 1 } };
+	uint8_t cantidad = sizeof(descriptores) / sizeof(descriptores[0]);
+
+	// El límite cubre la cadena por SPI, la transmisión (9 bits por byte
+	// con la paridad, más el inicio y el fin), la espera del inicio de la
+	// respuesta y la respuesta más larga. Se redondea hacia arriba y, como
+	// mfrc522_intercambioTerminado compara por mayor, la fase del tick no
+	// acorta la espera.
+	uint32_t bytesCadena = 0;
+	for (uint8_t i = primero; i < cantidad; i++)
+		bytesCadena += 1 + descriptores[i].largo;
+	uint32_t duracionUs = bytesCadena * 8 * 1000000UL / SPI_FRECUENCIA_HZ
+			+ ((uint32_t) largo * 9 + 2) * DURACION_BIT_CUS / 100 + esperaUs
+			+ DURACION_RESPUESTA_MAX_US;
+	lector->esperaMaximaMs = (duracionUs + 999) / 1000;
+	lector->inicioIntercambio = portGetTick();
+	if (spiStartChain(lector->indice, &descriptores[primero],
+			cantidad - primero, NULL))
+		return;
+
+	for (uint8_t i = primero; i < cantidad; i++)
+		spiWrite(lector->indice, descriptores[i].reg_addr,
+				descriptores[i].datos, descriptores[i].largo);
+}
+
+/**
+ *	@brief Calcula el prescaler y la recarga del timer
+ *		   del MFRC522 para que TimerIrq se active luego de
+ *		   al menos esperaUs. El período de cada cuenta es
+ *		   (2 * prescaler + 1) / 13,56 MHz. Se usa PRESCALER_TIMER
+ *		   mientras la recarga alcance, por su resolución de 25 uS.
+ */
+static void mfrc522_calcularTimer(uint32_t esperaUs, uint16_t *prescaler,
+		uint16_t *recarga) {
+	uint64_t ciclos = ((uint64_t) esperaUs * FRECUENCIA_TIMER_KHZ + 999) / 1000;
+	uint32_t divisor = 2 * PRESCALER_TIMER + 1;
+
+	if (ciclos > CUENTAS_TIMER_MAX * divisor) {
+		uint32_t minimo = (uint32_t) ((ciclos + CUENTAS_TIMER_MAX - 1)
+				/ CUENTAS_TIMER_MAX);
+		uint32_t valor = minimo / 2;		//2 * valor + 1 >= minimo
+		if (valor > PRESCALER_TIMER_MAX)
+			valor = PRESCALER_TIMER_MAX;
+		divisor = 2 * valor + 1;
+		*prescaler = (uint16_t) valor;
+	} else {
+		*prescaler = PRESCALER_TIMER;
+	}
+
+	uint64_t cuentas = (ciclos + divisor - 1) / divisor;
+	if (cuentas == 0)
+		cuentas = 1;
+	if (cuentas > CUENTAS_TIMER_MAX)
+		cuentas = CUENTAS_TIMER_MAX;
+	*recarga = (uint16_t) (cuentas - 1);		//el timer cuenta recarga + 1 períodos
+}
+
+/**
+ *	@brief Espera a que se reciba una
+ *		   respuesta de la tarjeta, o
+ *		   que se cumpla el timeout del
+ *		   timer interno del MFRC522, lo
+ *		   que ocurra primero, y lee la
+ *		   respuesta. Para saber si la tarjeta
+ *		   respondió, se consulta el bit RxIrq
+ *		   del registro ComIrqReg, que se pone
+ *		   en 1 cuando se finaliza de recibir
+ *		   datos de la tarjeta.
+ *		   Con IRQ_HABILITADA, el procesador duerme hasta
+ *		   que el MFRC522 activa el pin IRQ (por RxIrq o
+ *		   TimerIrq), sin tráfico SPI durante la espera.
+ */
+static void mfrc522_esperarRespuestaTarjeta(mfrc522_t *lector,
+		respuesta_tarjeta_t *respuesta) {
+	INSTR_INICIO(inicio);
+#if IRQ_HABILITADA
+	irqWaitEvent(lector->indice, lector->esperaMaximaMs);
+#else
+	while (!mfrc522_intercambioTerminado(lector))
+		;		//respuesta, timeout del MFRC522 o esperaMaximaMs
+#endif
+	mfrc522_finalizarIntercambio(lector, respuesta);
+	INSTR_FIN(INSTR_ESPERAR_RESPUESTA, inicio, respuesta->largo,
+			respuesta->resultado == TRANSCEIVE_TIMEOUT);
+}
+
 /**
  *	@brief Escribe el valor data en el
  *		   registro reg. Agrega el
@@ -331,9 +1703,10 @@ static bool_t mfrc522_leerBufferFIFO(uint8_t *response, uint8_t max_bytes) {
  *		   según indica la sección 8.1.2.3 del manual.
  *		   Utiliza la función spiWrite del módulo API_mfrc522_port.
  */
-static void mfrc522_writeRegister(registros_MFRC522_enum reg, uint8_t data) {
+static void mfrc522_writeRegister(mfrc522_t *lector, registros_MFRC522_enum reg,
+		uint8_t data) {
 	uint8_t reg_addr = WRITE_MASK | reg << 1;
-	spiWrite(reg_addr, &data, 1);
+	spiWrite(lector->indice, reg_addr, &data, 1);
 }
 
 /**
@@ -344,9 +1717,48 @@ static void mfrc522_writeRegister(registros_MFRC522_enum reg, uint8_t data) {
  *		   Utiliza la función spiRead del módulo API_mfrc522_port.
  *	@retval Devuelve el valor leido del registro.
  */
-static uint8_t mfrc522_readRegister(registros_MFRC522_enum reg) {
+static uint8_t mfrc522_readRegister(mfrc522_t *lector,
+		registros_MFRC522_enum reg) {
 	uint8_t rxBuffer = 0;
 	uint8_t reg_addr = READ_MASK | reg << 1;
-	spiRead(reg_addr, &rxBuffer, 1);
+	spiRead(lector->indice, reg_addr, &rxBuffer, 1);
 	return rxBuffer;
 }
+
+/**
+ *	@brief Lee largo bytes del registro reg con una
+ *		   única transferencia SPI, repitiendo la dirección
+ *		   de lectura. Se utiliza para leer la FIFO.
+ */
+static void mfrc522_readRegisterBurst(mfrc522_t *lector,
+		registros_MFRC522_enum reg, uint8_t *data, uint8_t largo) {
+	if (largo == 0)
+		return;
+	uint8_t reg_addr = READ_MASK | reg << 1;
+	spiRead(lector->indice, reg_addr, data, largo);
+}
+
+/**
+ *	@brief Lee varios registros distintos en una única
+ *		   transferencia SPI. Se envía la dirección de cada
+ *		   registro y un 0 final, y cada byte recibido
+ *		   corresponde a la dirección enviada en el byte
+ *		   anterior (sección 8.1.2.1 del manual).
+ */
+static void mfrc522_readRegisters(mfrc522_t *lector,
+		const registros_MFRC522_enum *regs, uint8_t *data, uint8_t cantidad) {
+	uint8_t txBuffer[SPI_MAX_BURST + 1];
+	uint8_t rxBuffer[SPI_MAX_BURST + 1];
+
+	if (cantidad == 0 || cantidad > SPI_MAX_BURST)
+		return;
+
+	for (uint8_t i = 0; i < cantidad; i++) {
+		txBuffer[i] = READ_MASK | regs[i] << 1;
+	}
+	txBuffer[cantidad] = 0;
+	spiTransfer(lector->indice, txBuffer, rxBuffer, cantidad + 1);
+	for (uint8_t i = 0; i < cantidad; i++) {
+		data[i] = rxBuffer[i + 1];
+	}
+}
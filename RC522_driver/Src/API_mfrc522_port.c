@@ -1,57 +1,164 @@
 /**
  * @file API_mfrc522_port.c
- * @brief Implementa las funciones 
+ * @brief Implementa las funciones
  *		  del módulo API_mfrc522_port.
+ *		  Cada bus SPI tiene su propio estado (handle de la
+ *		  HAL, streams de DMA, buffers y cadena en curso), y
+ *		  cada lector indica su bus y sus pines de CS e IRQ.
  */
 
 #include "API_mfrc522_port.h"
+#if INSTR_HABILITADA
+#include "API_instrumentacion.h"
+#else
+//sin instrumentación no se necesita la carpeta Common
+#define INSTR_INICIO(marca)
+#define INSTR_FIN(op, marca, bytes, timeout)
+#endif
+#if TRAZA_HABILITADA
+#include "API_traza.h"
+#else
+#define TRAZA_REGISTRAR(tipo, dispositivo, direccion, datos, largo, error)
+#define TRAZA_TRANSFERENCIA(lector, tx, rx, largo, error)
+#endif
+
+#if MFRC522_CANTIDAD_LECTORES > 2 || SPI_CANTIDAD_BUSES > 2
+#error "Solo se definieron los pines de 2 lectores y 2 buses"
+#endif
+
+/**
+ * @brief Pines y bus de un lector.
+ */
+typedef struct {
+	uint8_t bus;
+	GPIO_TypeDef *csPuerto;
+	uint16_t csPin;
+	GPIO_TypeDef *irqPuerto;
+	uint16_t irqPin;
+} lector_config_t;
+
+/**
+ * @brief Periférico SPI y streams de DMA de un bus.
+ */
+typedef struct {
+	SPI_TypeDef *instancia;
+	DMA_Stream_TypeDef *streamTx;
+	uint32_t canalTx;
+	IRQn_Type irqTx;
+	DMA_Stream_TypeDef *streamRx;
+	uint32_t canalRx;
+	IRQn_Type irqRx;
+} bus_config_t;
 
 /**
- * @brief estructura global privada para manejar el periférico SPI.
+ * @brief Estado de un bus SPI: handles de la HAL, buffers
+ *        para armar las transferencias (dirección + datos)
+ *        sin usar memoria de la pila, y cadena de
+ *        transferencias en curso con el lector que la inició.
  */
-static SPI_HandleTypeDef SPI;
+typedef struct {
+	SPI_HandleTypeDef spi;
+	DMA_HandleTypeDef dmaTx;
+	DMA_HandleTypeDef dmaRx;
+	uint8_t bufferTx[SPI_MAX_BURST + 1];
+	uint8_t bufferRx[SPI_MAX_BURST + 1];
+	spi_descriptor_t cadena[SPI_MAX_DESCRIPTORES];
+	uint8_t cantidadCadena;
+	volatile uint8_t indiceCadena;
+	volatile bool_t cadenaEnCurso;
+	spi_callback_t callbackCadena;
+	uint8_t lectorCadena;
+	bool_t inicializado;
+	bool_t timeoutSpi;		//la última transferencia terminó por timeout (instrumentación)
+} bus_t;
+
+static const lector_config_t LECTORES[MFRC522_CANTIDAD_LECTORES] = {
+		{ LECTOR0_BUS, LECTOR0_CS_Port, LECTOR0_CS_Pin, LECTOR0_IRQ_Port,
+				LECTOR0_IRQ_Pin },
+#if MFRC522_CANTIDAD_LECTORES > 1
+		{ LECTOR1_BUS, LECTOR1_CS_Port, LECTOR1_CS_Pin, LECTOR1_IRQ_Port,
+				LECTOR1_IRQ_Pin },
+#endif
+		};
+
+static const bus_config_t BUSES[SPI_CANTIDAD_BUSES] = {
+		{ SPI_INSTANCE, SPI_DMA_TX_STREAM, SPI_DMA_TX_CHANNEL, SPI_DMA_TX_IRQN,
+				SPI_DMA_RX_STREAM, SPI_DMA_RX_CHANNEL, SPI_DMA_RX_IRQN },
+#if SPI_CANTIDAD_BUSES > 1
+		{ SPI_BUS1_INSTANCE, SPI_BUS1_DMA_TX_STREAM, SPI_BUS1_DMA_TX_CHANNEL,
+				SPI_BUS1_DMA_TX_IRQN, SPI_BUS1_DMA_RX_STREAM,
+				SPI_BUS1_DMA_RX_CHANNEL, SPI_BUS1_DMA_RX_IRQN },
+#endif
+		};
+
+static bus_t buses[SPI_CANTIDAD_BUSES];
+
+/**
+ * @brief Banderas que se activan desde la interrupción
+ *        del pin IRQ de cada lector.
+ */
+static volatile bool_t eventoIrq[MFRC522_CANTIDAD_LECTORES];
 
 /**
  *	@brief Funciones privadas usadas durante la
  *		   inicialización del SPI.
  */
-static bool_t SPI_Init();
-static void GPIO_Init();
+static bool_t SPI_Init(uint8_t);
+static void GPIO_Init(uint8_t);
+static bool_t DMA_Init(uint8_t);
+static void IRQ_Init(uint8_t);
+static bool_t spiIniciarDescriptor(bus_t*);
+static void spiFinalizarDescriptor(bus_t*, bool_t);
+static bus_t* spiBusDeHandle(SPI_HandleTypeDef*);
+static bool_t irqAlgunEvento(uint32_t);
+static void spiTransferir(uint8_t, const uint8_t*, uint8_t*, uint16_t);
 
 /**
- *   @brief Inicializa el periférico SPI y configura
- *		   el pin GPIO usado para el CS.
+ *   @brief Inicializa el bus SPI del lector la primera
+ *		   vez que se usa y configura los pines de CS e IRQ.
  *   @retval Verdadero si se inicia correctamente,
  *           o falso si no se puede inicializar.
  */
-bool_t portInit() {
-	bool_t estado = SPI_Init();
-	GPIO_Init();
+bool_t portInit(uint8_t lector) {
+	if (lector >= MFRC522_CANTIDAD_LECTORES)
+		return false;
+
+	uint8_t bus = LECTORES[lector].bus;
+	bool_t estado = true;
+	if (!buses[bus].inicializado) {
+		estado = SPI_Init(bus);
+		if (!DMA_Init(bus))
+			estado = false;
+		buses[bus].inicializado = estado;
+	}
+	GPIO_Init(lector);
+	IRQ_Init(lector);
 	return estado;
 }
 
 /**
- *   @brief Inicializa el periférico SPI.
+ *   @brief Inicializa el periférico SPI de un bus.
  *   @retval Verdadero si se inicia correctamente,
  *           o falso si no se puede inicializar.
  */
-static bool_t SPI_Init() {
-	SPI.Instance = SPI_INSTANCE;
-	SPI.Init.Mode = SPI_MODE_MASTER;
-	SPI.Init.Direction = SPI_DIRECTION_2LINES;
-	SPI.Init.DataSize = SPI_DATASIZE_8BIT;
-	SPI.Init.CLKPolarity = SPI_POLARITY_LOW;
-	SPI.Init.CLKPhase = SPI_PHASE_1EDGE;
-	SPI.Init.NSS = SPI_NSS_SOFT;
-	SPI.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_128;
-	SPI.Init.FirstBit = SPI_FIRSTBIT_MSB;
-	SPI.Init.TIMode = SPI_TIMODE_DISABLE;
-	SPI.Init.CRCCalculation = SPI_CRCCALCULATION_DISABLE;
-	SPI.Init.CRCPolynomial = 10;
+static bool_t SPI_Init(uint8_t bus) {
+	SPI_HandleTypeDef *SPI = &buses[bus].spi;
+	SPI->Instance = BUSES[bus].instancia;
+	SPI->Init.Mode = SPI_MODE_MASTER;
+	SPI->Init.Direction = SPI_DIRECTION_2LINES;
+	SPI->Init.DataSize = SPI_DATASIZE_8BIT;
+	SPI->Init.CLKPolarity = SPI_POLARITY_LOW;
+	SPI->Init.CLKPhase = SPI_PHASE_1EDGE;
+	SPI->Init.NSS = SPI_NSS_SOFT;
+	SPI->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_128;
+	SPI->Init.FirstBit = SPI_FIRSTBIT_MSB;
+	SPI->Init.TIMode = SPI_TIMODE_DISABLE;
+	SPI->Init.CRCCalculation = SPI_CRCCALCULATION_DISABLE;
+	SPI->Init.CRCPolynomial = 10;
 
 	bool_t estado = true;
 
-	if (HAL_SPI_Init(&SPI) != HAL_OK) {
+	if (HAL_SPI_Init(SPI) != HAL_OK) {
 		estado = false;
 	}
 
@@ -59,46 +166,449 @@ static bool_t SPI_Init() {
 }
 
 /**
- *   @brief Configura el pin de CS.
+ *   @brief Configura los streams de DMA de transmisión
+ *		   y recepción del SPI de un bus y sus interrupciones.
+ *   @retval Verdadero si se inicia correctamente.
+ */
+static bool_t DMA_Init(uint8_t bus) {
+	DMA_HandleTypeDef *DMA_TX = &buses[bus].dmaTx;
+	DMA_HandleTypeDef *DMA_RX = &buses[bus].dmaRx;
+	const bus_config_t *config = &BUSES[bus];
+
+	__HAL_RCC_DMA1_CLK_ENABLE();
+	__HAL_RCC_DMA2_CLK_ENABLE();
+
+	DMA_TX->Instance = config->streamTx;
+	DMA_TX->Init.Channel = config->canalTx;
+	DMA_TX->Init.Direction = DMA_MEMORY_TO_PERIPH;
+	DMA_TX->Init.PeriphInc = DMA_PINC_DISABLE;
+	DMA_TX->Init.MemInc = DMA_MINC_ENABLE;
+	DMA_TX->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	DMA_TX->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	DMA_TX->Init.Mode = DMA_NORMAL;
+	DMA_TX->Init.Priority = DMA_PRIORITY_LOW;
+	DMA_TX->Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+
+	DMA_RX->Instance = config->streamRx;
+	DMA_RX->Init = DMA_TX->Init;
+	DMA_RX->Init.Channel = config->canalRx;
+	DMA_RX->Init.Direction = DMA_PERIPH_TO_MEMORY;
+
+	bool_t estado = true;
+	if (HAL_DMA_Init(DMA_TX) != HAL_OK || HAL_DMA_Init(DMA_RX) != HAL_OK)
+		estado = false;
+
+	__HAL_LINKDMA(&buses[bus].spi, hdmatx, *DMA_TX);
+	__HAL_LINKDMA(&buses[bus].spi, hdmarx, *DMA_RX);
+
+	HAL_NVIC_SetPriority(config->irqTx, SPI_PRIORIDAD_IRQ, 0);
+	HAL_NVIC_EnableIRQ(config->irqTx);
+	HAL_NVIC_SetPriority(config->irqRx, SPI_PRIORIDAD_IRQ, 0);
+	HAL_NVIC_EnableIRQ(config->irqRx);
+
+	return estado;
+}
+
+/**
+ *   @brief Configura el pin conectado a la salida IRQ del
+ *		   MFRC522 como interrupción por flanco descendente
+ *		   (el driver configura la salida como activa en bajo).
  */
-static void GPIO_Init() {
+static void IRQ_Init(uint8_t lector) {
+#if IRQ_HABILITADA
 	GPIO_InitTypeDef GPIO_InitStruct = { 0 };
 	__HAL_RCC_GPIOB_CLK_ENABLE();
-	HAL_GPIO_WritePin(CS_GPIO_Port, CS_Pin, GPIO_PIN_SET);
-	GPIO_InitStruct.Pin = CS_Pin;
+	GPIO_InitStruct.Pin = LECTORES[lector].irqPin;
+	GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
+	GPIO_InitStruct.Pull = GPIO_PULLUP;
+	HAL_GPIO_Init(LECTORES[lector].irqPuerto, &GPIO_InitStruct);
+
+	HAL_NVIC_SetPriority(IRQ_EXTI_IRQN, IRQ_PRIORIDAD, 0);
+	HAL_NVIC_EnableIRQ(IRQ_EXTI_IRQN);
+#endif
+}
+
+/**
+ *   @brief Configura el pin de CS del lector.
+ */
+static void GPIO_Init(uint8_t lector) {
+	GPIO_InitTypeDef GPIO_InitStruct = { 0 };
+	__HAL_RCC_GPIOB_CLK_ENABLE();
+	HAL_GPIO_WritePin(LECTORES[lector].csPuerto, LECTORES[lector].csPin,
+			GPIO_PIN_SET);
+	GPIO_InitStruct.Pin = LECTORES[lector].csPin;
 	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
 	GPIO_InitStruct.Pull = GPIO_NOPULL;
 	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
-	HAL_GPIO_Init(CS_GPIO_Port, &GPIO_InitStruct);
+	HAL_GPIO_Init(LECTORES[lector].csPuerto, &GPIO_InitStruct);
 }
 
 /**
  *   @brief Escribe la cantidad size de bytes desde el buffer txData
- *          al registro red_addr del dispositivo que está conectado por SPI.
- *		   Primero transmite la dirección del registro, y luego los datos.
+ *          al registro red_addr del lector indicado.
+ *		   La dirección del registro y los datos se transmiten en una
+ *		   única transferencia. El MFRC522 escribe todos los bytes que
+ *		   siguen a la dirección en el mismo registro (sección 8.1.2.2).
  */
-void spiWrite(uint8_t reg_addr, uint8_t *txData, uint16_t size) {
-	HAL_GPIO_WritePin(CS_GPIO_Port, CS_Pin, GPIO_PIN_RESET);
-	HAL_SPI_Transmit(&SPI, &reg_addr, 1, SPI_TIMEOUT);
-	HAL_SPI_Transmit(&SPI, txData, size, SPI_TIMEOUT);
-	HAL_GPIO_WritePin(CS_GPIO_Port, CS_Pin, GPIO_PIN_SET);
+void spiWrite(uint8_t lector, uint8_t reg_addr, const uint8_t *txData,
+		uint16_t size) {
+	bus_t *bus = &buses[LECTORES[lector].bus];
+	while (bus->cadenaEnCurso)
+		;
+	if (size > SPI_MAX_BURST)
+		size = SPI_MAX_BURST;
+
+	INSTR_INICIO(inicio);
+	bus->bufferTx[0] = reg_addr;
+	for (uint16_t i = 0; i < size; i++) {
+		bus->bufferTx[i + 1] = txData[i];
+	}
+	spiTransferir(lector, bus->bufferTx, NULL, size + 1);
+	INSTR_FIN(INSTR_SPI_WRITE, inicio, size + 1, bus->timeoutSpi);
+	TRAZA_REGISTRAR(TRAZA_SPI_ESCRITURA, lector, reg_addr, txData, size,
+			bus->timeoutSpi);
 }
 
 /**
  *   @brief Lee la cantidad indicada por size de bytes
  *          desde el registro reg_addr y los guarda en
  *          el buffer rxData.
- *		   Primero transmite la dirección del registro,
- *		   y luego recibe los datos. Para leer un byte se envía un 0
- *		   y se el byte recibido por MISO.
+ *		   Para leer n bytes del mismo registro se envía la
+ *		   dirección n veces y luego un 0 para finalizar. Cada
+ *		   byte recibido corresponde a la dirección enviada en
+ *		   el byte anterior (sección 8.1.2.1 del manual).
  */
-void spiRead(uint8_t reg_addr, uint8_t *rxData, uint16_t size) {
-	uint8_t dummyTx[size];
+void spiRead(uint8_t lector, uint8_t reg_addr, uint8_t *rxData, uint16_t size) {
+	bus_t *bus = &buses[LECTORES[lector].bus];
+	while (bus->cadenaEnCurso)
+		;
+	if (size > SPI_MAX_BURST)
+		size = SPI_MAX_BURST;
+
+	INSTR_INICIO(inicio);
+	for (uint16_t i = 0; i < size; i++) {
+		bus->bufferTx[i] = reg_addr;
+	}
+	bus->bufferTx[size] = 0;
+	spiTransferir(lector, bus->bufferTx, bus->bufferRx, size + 1);
 	for (uint16_t i = 0; i < size; i++) {
-		dummyTx[i] = 0;
+		rxData[i] = bus->bufferRx[i + 1];
+	}
+	INSTR_FIN(INSTR_SPI_READ, inicio, size + 1, bus->timeoutSpi);
+	TRAZA_REGISTRAR(TRAZA_SPI_LECTURA, lector, reg_addr, rxData, size,
+			bus->timeoutSpi);
+}
+
+/**
+ *   @brief Realiza una transferencia full-duplex y la registra
+ *		   en la traza con los bytes transmitidos y recibidos.
+ */
+void spiTransfer(uint8_t lector, const uint8_t *txData, uint8_t *rxData,
+		uint16_t size) {
+	spiTransferir(lector, txData, rxData, size);
+	TRAZA_TRANSFERENCIA(lector, txData, rxData, size,
+			buses[LECTORES[lector].bus].timeoutSpi);
+}
+
+/**
+ *   @brief Realiza una transferencia full-duplex con una única
+ *		   activación del CS y una única llamada a la HAL.
+ *		   Si hay una cadena con DMA en curso en el bus, espera
+ *		   a que finalice para respetar el orden de los accesos.
+ *		   spiWrite y spiRead la usan directamente para registrar
+ *		   en la traza el registro y los datos, sin la dirección.
+ */
+static void spiTransferir(uint8_t lector, const uint8_t *txData,
+		uint8_t *rxData, uint16_t size) {
+	const lector_config_t *config = &LECTORES[lector];
+	bus_t *bus = &buses[config->bus];
+	while (bus->cadenaEnCurso)
+		;
+	HAL_StatusTypeDef estado;
+	HAL_GPIO_WritePin(config->csPuerto, config->csPin, GPIO_PIN_RESET);
+	if (rxData == NULL)
+		estado = HAL_SPI_Transmit(&bus->spi, (uint8_t*) txData, size,
+				SPI_TIMEOUT);
+	else
+		estado = HAL_SPI_TransmitReceive(&bus->spi, (uint8_t*) txData, rxData,
+				size, SPI_TIMEOUT);
+	HAL_GPIO_WritePin(config->csPuerto, config->csPin, GPIO_PIN_SET);
+	bus->timeoutSpi = (estado == HAL_TIMEOUT);
+}
+
+/**
+ *   @brief Devuelve el tiempo en ms utilizando HAL_GetTick.
+ */
+uint32_t portGetTick() {
+	return HAL_GetTick();
+}
+
+/**
+ *   @brief Espera utilizando HAL_Delay.
+ */
+void portDelay(uint32_t ms) {
+	HAL_Delay(ms);
+}
+
+/**
+ *   @brief Descarta los eventos del pin IRQ del lector
+ *          recibidos hasta el momento.
+ */
+void irqClearEvent(uint8_t lector) {
+	eventoIrq[lector] = false;
+}
+
+/**
+ *   @brief Consulta la bandera del pin IRQ del lector.
+ */
+bool_t irqEvento(uint8_t lector) {
+	return eventoIrq[lector];
+}
+
+/**
+ *   @brief Espera a que se produzca un flanco en el pin IRQ
+ *		   o a que se cumpla el timeout en ms. Entre
+ *		   interrupciones el procesador duerme con WFI
+ *		   (el SysTick lo despierta cada 1 ms para
+ *		   controlar el timeout).
+ *   @retval Verdadero si se produjo el evento.
+ */
+bool_t irqWaitEvent(uint8_t lector, uint32_t timeout) {
+	return irqWaitAnyEvent(1UL << lector, timeout);
+}
+
+/**
+ *   @brief Igual que irqWaitEvent, pero termina con el
+ *		   evento de cualquiera de los lectores de la máscara.
+ *   @retval Verdadero si se produjo algún evento.
+ */
+bool_t irqWaitAnyEvent(uint32_t mascara, uint32_t timeout) {
+	uint32_t inicio = HAL_GetTick();
+	while (!irqAlgunEvento(mascara)) {
+		if ((HAL_GetTick() - inicio) > timeout)
+			return false;
+		__WFI();
 	}
-	HAL_GPIO_WritePin(CS_GPIO_Port, CS_Pin, GPIO_PIN_RESET);
-	HAL_SPI_Transmit(&SPI, &reg_addr, 1, SPI_TIMEOUT);
-	HAL_SPI_TransmitReceive(&SPI, dummyTx, rxData, size, SPI_TIMEOUT);
-	HAL_GPIO_WritePin(CS_GPIO_Port, CS_Pin, GPIO_PIN_SET);
+	return true;
+}
+
+/**
+ *   @brief Indica si algún lector de la máscara tiene
+ *		   la bandera de evento activa.
+ */
+static bool_t irqAlgunEvento(uint32_t mascara) {
+	for (uint8_t i = 0; i < MFRC522_CANTIDAD_LECTORES; i++) {
+		if ((mascara & (1UL << i)) && eventoIrq[i])
+			return true;
+	}
+	return false;
+}
+
+void portIrqCallback(uint16_t pin) {
+	for (uint8_t i = 0; i < MFRC522_CANTIDAD_LECTORES; i++) {
+		if (pin == LECTORES[i].irqPin)
+			eventoIrq[i] = true;
+	}
+}
+
+/**
+ *   @brief Callback de la HAL para las interrupciones
+ *		   externas y rutina de atención del EXTI de los
+ *		   pines IRQ, que comparten la misma interrupción.
+ *		   Solo se definen si el driver usa el pin IRQ, ya que
+ *		   la HAL tiene un único callback para todas las líneas.
+ */
+#if IRQ_HABILITADA && MFRC522_DEFINIR_IRQ
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+	portIrqCallback(GPIO_Pin);
+}
+
+void IRQ_EXTI_HANDLER(void) {
+	for (uint8_t i = 0; i < MFRC522_CANTIDAD_LECTORES; i++) {
+		HAL_GPIO_EXTI_IRQHandler(LECTORES[i].irqPin);
+	}
+}
+#endif
+
+/**
+ *   @brief Copia los descriptores e inicia la primera
+ *		   transferencia de la cadena. Las siguientes se
+ *		   inician desde la interrupción de fin de DMA.
+ *		   Cada bus tiene su propia cadena, por lo que
+ *		   lectores en buses distintos transfieren a la vez.
+ *   @retval Falso si hay otra cadena en curso en el bus
+ *           o si los descriptores no son válidos.
+ */
+bool_t spiStartChain(uint8_t lector, const spi_descriptor_t *descriptores,
+		uint8_t cantidad, spi_callback_t callback) {
+	bus_t *bus = &buses[LECTORES[lector].bus];
+	if (bus->cadenaEnCurso || descriptores == NULL || cantidad == 0
+			|| cantidad > SPI_MAX_DESCRIPTORES)
+		return false;
+
+	for (uint8_t i = 0; i < cantidad; i++) {
+		if (descriptores[i].largo == 0
+				|| descriptores[i].largo > SPI_MAX_BURST)
+			return false;
+		bus->cadena[i] = descriptores[i];
+	}
+	bus->cantidadCadena = cantidad;
+	bus->indiceCadena = 0;
+	bus->callbackCadena = callback;
+	bus->lectorCadena = lector;
+	bus->cadenaEnCurso = true;
+
+	if (!spiIniciarDescriptor(bus)) {
+		bus->cadenaEnCurso = false;
+		return false;
+	}
+	return true;
+}
+
+/**
+ *   @brief Indica si hay una cadena de transferencias
+ *		   en curso en el bus del lector.
+ */
+bool_t spiChainBusy(uint8_t lector) {
+	return buses[LECTORES[lector].bus].cadenaEnCurso;
+}
+
+/**
+ *   @brief Arma el buffer de transmisión del descriptor actual
+ *		   con el mismo formato que spiWrite/spiRead, activa el
+ *		   CS del lector de la cadena e inicia el DMA.
+ *   @retval Verdadero si se pudo iniciar la transferencia.
+ */
+static bool_t spiIniciarDescriptor(bus_t *bus) {
+	const lector_config_t *config = &LECTORES[bus->lectorCadena];
+	const spi_descriptor_t *descriptor = &bus->cadena[bus->indiceCadena];
+	HAL_StatusTypeDef estado;
+
+	HAL_GPIO_WritePin(config->csPuerto, config->csPin, GPIO_PIN_RESET);
+	if (descriptor->reg_addr & SPI_READ_MASK) {
+		for (uint16_t i = 0; i < descriptor->largo; i++) {
+			bus->bufferTx[i] = descriptor->reg_addr;
+		}
+		bus->bufferTx[descriptor->largo] = 0;
+		estado = HAL_SPI_TransmitReceive_DMA(&bus->spi, bus->bufferTx,
+				bus->bufferRx, descriptor->largo + 1);
+	} else {
+		bus->bufferTx[0] = descriptor->reg_addr;
+		for (uint16_t i = 0; i < descriptor->largo; i++) {
+			bus->bufferTx[i + 1] = descriptor->datos[i];
+		}
+		estado = HAL_SPI_Transmit_DMA(&bus->spi, bus->bufferTx,
+				descriptor->largo + 1);
+	}
+
+	if (estado != HAL_OK) {
+		HAL_GPIO_WritePin(config->csPuerto, config->csPin, GPIO_PIN_SET);
+		return false;
+	}
+	return true;
+}
+
+/**
+ *   @brief Finaliza la transferencia actual: desactiva el CS,
+ *		   copia los datos leídos e inicia el siguiente descriptor.
+ *		   Al terminar la cadena (o ante un error) llama al callback.
+ */
+static void spiFinalizarDescriptor(bus_t *bus, bool_t exito) {
+	const lector_config_t *config = &LECTORES[bus->lectorCadena];
+	HAL_GPIO_WritePin(config->csPuerto, config->csPin, GPIO_PIN_SET);
+
+	const spi_descriptor_t *descriptor = &bus->cadena[bus->indiceCadena];
+	if (exito && (descriptor->reg_addr & SPI_READ_MASK)) {
+		for (uint16_t i = 0; i < descriptor->largo; i++) {
+			descriptor->datos[i] = bus->bufferRx[i + 1];
+		}
+	}
+	TRAZA_REGISTRAR(
+			(descriptor->reg_addr & SPI_READ_MASK) ?
+					TRAZA_SPI_LECTURA : TRAZA_SPI_ESCRITURA, bus->lectorCadena,
+			descriptor->reg_addr, descriptor->datos, descriptor->largo, !exito);
+
+	if (exito && ++bus->indiceCadena < bus->cantidadCadena) {
+		if (spiIniciarDescriptor(bus))
+			return;
+		exito = false;
+	}
+
+	bus->cadenaEnCurso = false;
+	if (bus->callbackCadena != NULL)
+		bus->callbackCadena(exito);
+}
+
+/**
+ *   @brief Busca el bus al que pertenece un handle de la HAL.
+ *   @retval Puntero al bus, o NULL si el handle no es de este módulo.
+ */
+static bus_t* spiBusDeHandle(SPI_HandleTypeDef *hspi) {
+	for (uint8_t i = 0; i < SPI_CANTIDAD_BUSES; i++) {
+		if (hspi == &buses[i].spi)
+			return &buses[i];
+	}
+	return NULL;
+}
+
+void portSpiCpltCallback(SPI_HandleTypeDef *hspi) {
+	bus_t *bus = spiBusDeHandle(hspi);
+	if (bus != NULL && bus->cadenaEnCurso)
+		spiFinalizarDescriptor(bus, true);
+}
+
+void portSpiErrorCallback(SPI_HandleTypeDef *hspi) {
+	bus_t *bus = spiBusDeHandle(hspi);
+	if (bus != NULL && bus->cadenaEnCurso)
+		spiFinalizarDescriptor(bus, false);
+}
+
+void portSpiDmaTxIrqHandler(uint8_t bus) {
+	if (bus < SPI_CANTIDAD_BUSES)
+		HAL_DMA_IRQHandler(&buses[bus].dmaTx);
+}
+
+void portSpiDmaRxIrqHandler(uint8_t bus) {
+	if (bus < SPI_CANTIDAD_BUSES)
+		HAL_DMA_IRQHandler(&buses[bus].dmaRx);
+}
+
+#if MFRC522_DEFINIR_IRQ
+/**
+ *   @brief Callbacks de la HAL para el fin de una
+ *		   transferencia con DMA y para errores del SPI.
+ */
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+	portSpiCpltCallback(hspi);
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
+	portSpiCpltCallback(hspi);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
+	portSpiErrorCallback(hspi);
+}
+
+/**
+ *   @brief Rutinas de atención de interrupción
+ *		   de los streams de DMA de cada bus.
+ */
+void SPI_DMA_TX_IRQ_HANDLER(void) {
+	portSpiDmaTxIrqHandler(0);
+}
+
+void SPI_DMA_RX_IRQ_HANDLER(void) {
+	portSpiDmaRxIrqHandler(0);
+}
+
+#if SPI_CANTIDAD_BUSES > 1
+void SPI_BUS1_DMA_TX_IRQ_HANDLER(void) {
+	portSpiDmaTxIrqHandler(1);
+}
+
+void SPI_BUS1_DMA_RX_IRQ_HANDLER(void) {
+	portSpiDmaRxIrqHandler(1);
 }
+#endif
+#endif
@@ -0,0 +1,379 @@
+/**
+ * @file API_registro.c
+ * @brief  Implementación del registro de accesos.
+ * 		   La flash se recorre como un arreglo circular de
+ * 		   POSICIONES_TOTALES eventos. Cada sector se borra
+ * 		   completo justo antes de escribir su primer evento,
+ * 		   por lo que las posiciones usadas de un sector forman
+ * 		   siempre un prefijo y los sectores se reutilizan en
+ * 		   orden, con el mismo desgaste.
+ */
+
+#include <string.h>
+#include "API_registro.h"
+#include "API_registro_port.h"
+
+#define EVENTOS_SECTOR		(REGISTRO_TAMANO_SECTOR / sizeof(registro_evento_t))
+#define POSICIONES_TOTALES	(EVENTOS_SECTOR * REGISTRO_CANTIDAD_SECTORES)
+#define BYTES_CRC			offsetof(registro_evento_t, crc)
+#define SIN_SECUENCIA		0xFFFFFFFFUL
+
+// CRC-16/CCITT (polinomio 0x1021, valor inicial 0xFFFF)
+#define CRC_POLINOMIO		0x1021
+#define CRC_INICIAL			0xFFFF
+
+#if REGISTRO_CANTIDAD_SECTORES < 2
+#error "El registro necesita al menos 2 sectores"
+#endif
+#if (REGISTRO_EVENTOS_RAM & (REGISTRO_EVENTOS_RAM - 1)) != 0 \
+	|| REGISTRO_EVENTOS_RAM < REGISTRO_EVENTOS_PAGINA
+#error "REGISTRO_EVENTOS_RAM debe ser potencia de 2 y al menos una página"
+#endif
+
+/**
+ *	@brief Estado del registro. cabeza y cola son contadores
+ *		   libres del buffer en RAM: los eventos pendientes
+ *		   son cabeza - cola.
+ */
+typedef struct {
+	uint32_t escritura;			//próxima posición libre en la flash
+	uint32_t inicio;			//posición del evento más antiguo
+	uint32_t cantidad;			//posiciones usadas desde inicio
+	uint32_t proximaSecuencia;
+	bool_t sectorListo;			//el sector de escritura ya se borró
+	registro_evento_t pendientes[REGISTRO_EVENTOS_RAM];
+	uint32_t cabeza;
+	uint32_t cola;
+	uint32_t perdidos;
+} registro_t;
+
+static registro_t registro;
+
+/**
+ *	@brief Declaración de funciones privadas.
+ */
+static bool_t registro_escribir(uint32_t cantidad);
+static uint32_t registro_espacioPagina();
+static void registro_leerPosicion(uint32_t posicion, registro_evento_t *evento);
+static bool_t registro_posicionBorrada(uint32_t posicion);
+static bool_t registro_eventoValido(const registro_evento_t *evento);
+static uint32_t registro_primeraSecuencia(uint8_t sector);
+static uint32_t registro_distancia(uint32_t desde, uint32_t hasta);
+static uint16_t registro_crc(const uint8_t *datos, uint32_t largo);
+
+/**
+ *	@brief Recupera el registro en tres pasos: lee el primer
+ *		   evento de cada sector para encontrar el más reciente
+ *		   y el más antiguo, busca con una búsqueda binaria la
+ *		   primera posición borrada del más reciente, y lee el
+ *		   último evento válido para continuar la secuencia. Se
+ *		   leen del orden de log2(EVENTOS_SECTOR) eventos en
+ *		   lugar de todo el registro. Un sector sin ningún evento
+ *		   válido (borrado o con otros datos) se considera libre.
+ *	@retval Falso si no se puede acceder a la flash.
+ */
+bool_t registro_init() {
+	registro.escritura = 0;
+	registro.inicio = 0;
+	registro.cantidad = 0;
+	registro.proximaSecuencia = 0;
+	registro.sectorListo = false;	//se borra antes del primer evento
+	registro.cabeza = 0;
+	registro.cola = 0;
+	registro.perdidos = 0;
+
+	if (!flashInit())
+		return false;
+
+	int16_t reciente = -1, antiguo = -1;
+	uint32_t secuenciaReciente = 0, secuenciaAntigua = 0;
+	for (uint8_t sector = 0; sector < REGISTRO_CANTIDAD_SECTORES; sector++) {
+		uint32_t secuencia = registro_primeraSecuencia(sector);
+		if (secuencia == SIN_SECUENCIA)
+			continue;
+		if (reciente < 0 || secuencia > secuenciaReciente) {
+			reciente = sector;
+			secuenciaReciente = secuencia;
+		}
+		if (antiguo < 0 || secuencia < secuenciaAntigua) {
+			antiguo = sector;
+			secuenciaAntigua = secuencia;
+		}
+	}
+	if (reciente < 0)
+		return true;				//registro vacío
+
+	// Búsqueda binaria de la primera posición borrada del sector
+	uint32_t base = reciente * EVENTOS_SECTOR;
+	uint32_t bajo = 0, alto = EVENTOS_SECTOR;
+	while (bajo < alto) {
+		uint32_t medio = (bajo + alto) / 2;
+		if (registro_posicionBorrada(base + medio))
+			alto = medio;
+		else
+			bajo = medio + 1;
+	}
+
+	// Último evento válido, para continuar la secuencia
+	registro_evento_t evento;
+	registro.proximaSecuencia = secuenciaReciente + 1;
+	for (uint32_t i = bajo; i > 0; i--) {
+		registro_leerPosicion(base + i - 1, &evento);
+		if (registro_eventoValido(&evento)) {
+			registro.proximaSecuencia = evento.secuencia + 1;
+			break;
+		}
+	}
+
+	registro.escritura = (base + bajo) % POSICIONES_TOTALES;
+	registro.sectorListo = (bajo < EVENTOS_SECTOR);
+	registro.inicio = antiguo * EVENTOS_SECTOR;
+	registro.cantidad = registro_distancia(registro.inicio, registro.escritura);
+	if (registro.cantidad == 0)
+		registro.cantidad = POSICIONES_TOTALES;	//el próximo evento borra el más antiguo
+	return true;
+}
+
+/**
+ *	@brief Copia el evento al buffer en RAM. La secuencia
+ *		   y el CRC se completan al escribirlo en la flash.
+ *	@retval Falso si el buffer está lleno.
+ */
+bool_t registro_agregar(const uint8_t *uid, uint8_t largo,
+		registro_decision_enum decision, uint32_t tiempo) {
+	if (uid == NULL || largo > MFRC522_UID_MAX)
+		return false;
+	if (registro.cabeza - registro.cola >= REGISTRO_EVENTOS_RAM) {
+		registro.perdidos++;
+		return false;
+	}
+
+	registro_evento_t *evento = &registro.pendientes[registro.cabeza
+			& (REGISTRO_EVENTOS_RAM - 1)];
+	evento->tiempo = tiempo;
+	for (uint8_t i = 0; i < MFRC522_UID_MAX; i++) {
+		evento->uid[i] = i < largo ? uid[i] : 0xFF;
+	}
+	evento->largo = largo;
+	evento->decision = (uint8_t) decision;
+	evento->reservado = 0xFFFF;
+	registro.cabeza++;
+	return true;
+}
+
+/**
+ *	@brief Escribe una página si el buffer tiene suficientes
+ *		   eventos para completarla. No bloquea durante un borrado.
+ *	@retval Verdadero si quedan eventos o un borrado pendientes.
+ */
+bool_t registro_procesar() {
+	if (flashOcupada())
+		return true;
+	uint32_t pendientes = registro.cabeza - registro.cola;
+	if (pendientes == 0)
+		return false;
+
+	uint32_t espacio = registro_espacioPagina();
+	if (pendientes >= espacio)
+		registro_escribir(espacio);
+	return registro.cabeza != registro.cola || flashOcupada();
+}
+
+/**
+ *	@brief Escribe todos los eventos pendientes, completando
+ *		   páginas mientras se puede y luego el resto. Si la
+ *		   flash falla, los eventos quedan en el buffer.
+ */
+void registro_sincronizar() {
+	while (registro.cabeza != registro.cola) {
+		while (flashOcupada())
+			;
+		bool_t borrar = !registro.sectorListo;
+		uint32_t pendientes = registro.cabeza - registro.cola;
+		uint32_t espacio = registro_espacioPagina();
+		if (!registro_escribir(pendientes < espacio ? pendientes : espacio)
+				&& !(borrar && registro.sectorListo))
+			break;					//la flash no responde
+	}
+	while (flashOcupada())
+		;
+}
+
+uint32_t registro_cantidad() {
+	return registro.cantidad;
+}
+
+uint32_t registro_perdidos() {
+	return registro.perdidos;
+}
+
+/**
+ *	@brief Inicia el recorrido en el evento más antiguo.
+ */
+void registro_iniciarRecorrido(registro_iterador_t *iterador) {
+	if (iterador == NULL)
+		return;
+	iterador->posicion = registro.inicio;
+	iterador->restantes = registro.cantidad;
+}
+
+/**
+ *	@brief Avanza el recorrido hasta el próximo evento
+ *		   con CRC correcto.
+ *	@retval Falso si no quedan eventos.
+ */
+bool_t registro_siguiente(registro_iterador_t *iterador,
+		registro_evento_t *evento) {
+	if (iterador == NULL || evento == NULL)
+		return false;
+	while (iterador->restantes > 0) {
+		registro_leerPosicion(iterador->posicion, evento);
+		iterador->posicion = (iterador->posicion + 1) % POSICIONES_TOTALES;
+		iterador->restantes--;
+		if (registro_eventoValido(evento))
+			return true;
+	}
+	return false;
+}
+
+/**
+ *	@brief Escribe cantidad eventos del buffer (como máximo el
+ *		   espacio de la página actual) con una única programación.
+ *		   Si el sector de escritura todavía no se borró, inicia el
+ *		   borrado y retorna: el sector contiene los eventos más
+ *		   antiguos, que se descartan. Si la programación falla, las
+ *		   posiciones se anulan programándolas con ceros (un evento
+ *		   inválido que no está borrado), se dan por usadas y los
+ *		   eventos quedan en el buffer para escribirse en las
+ *		   siguientes. Una posición borrada entre posiciones usadas
+ *		   confundiría la búsqueda de registro_init, que llevaría
+ *		   la escritura a ese hueco y luego sobre los eventos
+ *		   siguientes. Si tampoco se pueden anular, las posiciones
+ *		   no se usan.
+ *	@retval Verdadero si se escribieron los eventos.
+ */
+static bool_t registro_escribir(uint32_t cantidad) {
+	registro_evento_t pagina[REGISTRO_EVENTOS_PAGINA];
+	uint8_t sector = registro.escritura / EVENTOS_SECTOR;
+
+	if (cantidad == 0)
+		return false;
+	if (!registro.sectorListo) {
+		if (!flashBorrarSector(sector))
+			return false;
+		registro.sectorListo = true;
+		if (registro.cantidad > 0 && registro.inicio / EVENTOS_SECTOR == sector) {
+			registro.inicio = ((sector + 1) % REGISTRO_CANTIDAD_SECTORES)
+					* EVENTOS_SECTOR;
+			registro.cantidad = registro_distancia(registro.inicio,
+					registro.escritura);
+		}
+		if (registro.cantidad == 0)
+			registro.inicio = registro.escritura;
+		return false;
+	}
+
+	for (uint32_t i = 0; i < cantidad; i++) {
+		pagina[i] = registro.pendientes[(registro.cola + i)
+				& (REGISTRO_EVENTOS_RAM - 1)];
+		pagina[i].secuencia = registro.proximaSecuencia + i;
+		pagina[i].crc = registro_crc((const uint8_t*) &pagina[i], BYTES_CRC);
+	}
+
+	uint32_t direccion = sector * REGISTRO_TAMANO_SECTOR
+			+ (registro.escritura % EVENTOS_SECTOR) * sizeof(registro_evento_t);
+	bool_t escrito = flashProgramar(direccion, pagina,
+			cantidad * sizeof(registro_evento_t));
+	if (!escrito) {
+		//los ceros se pueden programar sobre cualquier contenido
+		memset(pagina, 0, cantidad * sizeof(registro_evento_t));
+		if (!flashProgramar(direccion, pagina,
+				cantidad * sizeof(registro_evento_t)))
+			return false;
+	}
+
+	registro.escritura = (registro.escritura + cantidad) % POSICIONES_TOTALES;
+	registro.cantidad += cantidad;
+	if (registro.escritura % EVENTOS_SECTOR == 0)
+		registro.sectorListo = false;		//el próximo sector debe borrarse
+	if (!escrito)
+		return false;
+	registro.proximaSecuencia += cantidad;
+	registro.cola += cantidad;
+	return true;
+}
+
+/**
+ *	@brief Posiciones libres hasta el fin de la página actual.
+ *		   Las páginas se alinean al inicio de cada sector; la
+ *		   última de un sector puede ser más corta.
+ */
+static uint32_t registro_espacioPagina() {
+	uint32_t desplazamiento = registro.escritura % EVENTOS_SECTOR;
+	uint32_t espacio = REGISTRO_EVENTOS_PAGINA
+			- desplazamiento % REGISTRO_EVENTOS_PAGINA;
+	if (espacio > EVENTOS_SECTOR - desplazamiento)
+		espacio = EVENTOS_SECTOR - desplazamiento;
+	return espacio;
+}
+
+static void registro_leerPosicion(uint32_t posicion, registro_evento_t *evento) {
+	uint32_t direccion = (posicion / EVENTOS_SECTOR) * REGISTRO_TAMANO_SECTOR
+			+ (posicion % EVENTOS_SECTOR) * sizeof(registro_evento_t);
+	flashLeer(direccion, evento, sizeof(*evento));
+}
+
+/**
+ *	@brief Indica si todos los bytes de la posición están
+ *		   borrados. Un evento a medio escribir no lo está.
+ */
+static bool_t registro_posicionBorrada(uint32_t posicion) {
+	registro_evento_t evento;
+	registro_leerPosicion(posicion, &evento);
+	const uint8_t *bytes = (const uint8_t*) &evento;
+	for (uint32_t i = 0; i < sizeof(evento); i++) {
+		if (bytes[i] != 0xFF)
+			return false;
+	}
+	return true;
+}
+
+static bool_t registro_eventoValido(const registro_evento_t *evento) {
+	return evento->secuencia != SIN_SECUENCIA
+			&& evento->crc == registro_crc((const uint8_t*) evento, BYTES_CRC);
+}
+
+/**
+ *	@brief Secuencia del primer evento válido del sector.
+ *		   Normalmente es el primero; se sigue buscando solo
+ *		   si quedó a medio escribir.
+ *	@retval SIN_SECUENCIA si el sector no tiene eventos válidos.
+ */
+static uint32_t registro_primeraSecuencia(uint8_t sector) {
+	registro_evento_t evento;
+	for (uint32_t i = 0; i < EVENTOS_SECTOR; i++) {
+		registro_leerPosicion(sector * EVENTOS_SECTOR + i, &evento);
+		if (registro_eventoValido(&evento))
+			return evento.secuencia;
+		if (evento.secuencia == SIN_SECUENCIA)
+			break;					//posición borrada: no hay más eventos
+	}
+	return SIN_SECUENCIA;
+}
+
+static uint32_t registro_distancia(uint32_t desde, uint32_t hasta) {
+	return (hasta + POSICIONES_TOTALES - desde) % POSICIONES_TOTALES;
+}
+
+/**
+ *	@brief Calcula el CRC-16/CCITT bit a bit, sin tabla.
+ */
+static uint16_t registro_crc(const uint8_t *datos, uint32_t largo) {
+	uint16_t crc = CRC_INICIAL;
+	for (uint32_t i = 0; i < largo; i++) {
+		crc ^= (uint16_t) datos[i] << 8;
+		for (uint8_t bit = 0; bit < 8; bit++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ CRC_POLINOMIO : crc << 1;
+	}
+	return crc;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file API_registro_port.c
+ * @brief Implementa las funciones del módulo API_registro_port
+ *		  con la flash interna del STM32F4. La flash se lee
+ *		  directamente por estar mapeada en memoria, se programa
+ *		  de a palabras con la HAL y el borrado de un sector se
+ *		  inicia escribiendo FLASH_CR sin esperar a que termine.
+ * @note  En los STM32F4 de un solo banco, el procesador se detiene
+ *		  al leer la flash mientras se borra un sector, por lo que
+ *		  conviene llamar a registro_procesar cuando el lector no
+ *		  está esperando una tarjeta.
+ */
+
+#include "API_registro_port.h"
+#include <string.h>
+
+static bool_t borrando = false;
+
+/**
+ *   @brief Borra las banderas de error de operaciones anteriores.
+ *   @retval Verdadero.
+ */
+bool_t flashInit() {
+	__HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR
+			| FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+	borrando = false;
+	return true;
+}
+
+void flashLeer(uint32_t direccion, void *datos, uint32_t largo) {
+	memcpy(datos, (const void*) (REGISTRO_DIRECCION_FLASH + direccion), largo);
+}
+
+/**
+ *   @brief Programa los datos de a palabras de 32 bits. La
+ *          HAL espera a que termine cada palabra (16 uS típico).
+ *   @retval Falso si hay un borrado en curso o falla la programación.
+ */
+bool_t flashProgramar(uint32_t direccion, const void *datos, uint32_t largo) {
+	const uint8_t *bytes = datos;
+	bool_t correcto = true;
+
+	if (flashOcupada() || (direccion % 4) != 0 || (largo % 4) != 0)
+		return false;
+
+	HAL_FLASH_Unlock();
+	for (uint32_t i = 0; i < largo && correcto; i += 4) {
+		uint32_t palabra;
+		memcpy(&palabra, &bytes[i], sizeof(palabra));
+		correcto = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD,
+				REGISTRO_DIRECCION_FLASH + direccion + i, palabra) == HAL_OK;
+	}
+	HAL_FLASH_Lock();
+	return correcto;
+}
+
+/**
+ *   @brief Inicia el borrado del sector con FLASH_Erase_Sector,
+ *          que solo configura FLASH_CR y activa STRT. La flash
+ *          queda desbloqueada hasta que flashOcupada detecta
+ *          el fin del borrado.
+ *   @retval Falso si hay otra operación en curso.
+ */
+bool_t flashBorrarSector(uint8_t sector) {
+	if (flashOcupada() || sector >= REGISTRO_CANTIDAD_SECTORES)
+		return false;
+
+	HAL_FLASH_Unlock();
+	FLASH_Erase_Sector(REGISTRO_PRIMER_SECTOR + sector, FLASH_VOLTAGE_RANGE_3);
+	borrando = true;
+	return true;
+}
+
+/**
+ *   @brief Consulta el bit BSY. Al terminar un borrado, deja
+ *          FLASH_CR como lo hace HAL_FLASHEx_Erase y vuelve
+ *          a bloquear la flash.
+ */
+bool_t flashOcupada() {
+	if (__HAL_FLASH_GET_FLAG(FLASH_FLAG_BSY))
+		return true;
+	if (borrando) {
+		CLEAR_BIT(FLASH->CR, (FLASH_CR_SER | FLASH_CR_SNB));
+		HAL_FLASH_Lock();
+		borrando = false;
+	}
+	return false;
+}
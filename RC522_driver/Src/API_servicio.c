@@ -0,0 +1,149 @@
+/**
+ * @file API_servicio.c
+ * @brief  Implementación del servicio de lectura. La cola usa
+ * 		   contadores libres como el buffer de API_registro: el
+ * 		   productor solo escribe cabeza y el consumidor solo
+ * 		   escribe cola, por lo que alcanza con publicar cada
+ * 		   contador con orden release y leer el del otro con
+ * 		   orden acquire (en el Cortex-M4, un acceso de 32 bits
+ * 		   y una barrera DMB). No se deshabilitan interrupciones.
+ */
+
+#include <stdatomic.h>
+#include "API_servicio.h"
+#include "API_servicio_port.h"
+#include "API_mfrc522_port.h"
+
+#if (SERVICIO_CAPACIDAD_COLA & (SERVICIO_CAPACIDAD_COLA - 1)) != 0
+#error "SERVICIO_CAPACIDAD_COLA debe ser potencia de 2"
+#endif
+
+/**
+ *	@brief Estado del servicio. Los eventos en la cola
+ *		   son cabeza - cola.
+ */
+typedef struct {
+	mfrc522_t *lectores;
+	uint8_t cantidad;
+	uint32_t periodoMs;
+	atomic_bool iniciado;
+	servicio_evento_t eventos[SERVICIO_CAPACIDAD_COLA];
+	atomic_uint_least32_t cabeza;		//escrita por el productor
+	atomic_uint_least32_t cola;			//escrita por el consumidor
+	atomic_uint_least32_t desbordes;	//escrita por el productor
+} servicio_t;
+
+static servicio_t servicio;
+
+/**
+ *	@brief Declaración de funciones privadas.
+ */
+static void servicio_publicar(uint8_t lector, mfrc522_evento_enum evento,
+		const mfrc522_uid_t *uid);
+
+bool_t servicio_iniciar(mfrc522_t *lectores, uint8_t cantidad,
+		uint32_t periodoMs) {
+	if (atomic_load(&servicio.iniciado) || lectores == NULL || cantidad == 0)
+		return false;
+
+	servicio.lectores = lectores;
+	servicio.cantidad = cantidad;
+	servicio.periodoMs = periodoMs;
+	atomic_store(&servicio.cabeza, 0);
+	atomic_store(&servicio.cola, 0);
+	atomic_store(&servicio.desbordes, 0);
+	atomic_store(&servicio.iniciado, true);
+
+	if (periodoMs != 0 && !temporizadorIniciar(periodoMs)) {
+		atomic_store(&servicio.iniciado, false);
+		return false;
+	}
+	return true;
+}
+
+void servicio_detener() {
+	if (!atomic_exchange(&servicio.iniciado, false))
+		return;
+	if (servicio.periodoMs != 0)
+		temporizadorDetener();
+}
+
+/**
+ *	@brief Los sondeos de presencia bloquean hasta la
+ *		   respuesta de cada tarjeta, pero en el contexto del
+ *		   servicio y no en el del consumidor.
+ */
+void servicio_ejecutar() {
+	mfrc522_uid_t uid;
+
+	if (!atomic_load_explicit(&servicio.iniciado, memory_order_acquire))
+		return;
+
+	for (uint8_t i = 0; i < servicio.cantidad; i++) {
+		mfrc522_evento_enum evento = mfrc522_lectorPresencia(
+				&servicio.lectores[i], &uid);
+		if (evento == MFRC522_EVENTO_LLEGADA || evento == MFRC522_EVENTO_RETIRO)
+			servicio_publicar(servicio.lectores[i].indice, evento, &uid);
+	}
+}
+
+/**
+ *	@brief Los eventos se copian de a lotes: se lee cabeza
+ *		   una sola vez y se libera todo el lote con una
+ *		   única escritura de cola.
+ */
+uint32_t servicio_extraer(servicio_evento_t *eventos, uint32_t maximo) {
+	if (eventos == NULL)
+		return 0;
+
+	uint32_t cola = atomic_load_explicit(&servicio.cola, memory_order_relaxed);
+	uint32_t cabeza = atomic_load_explicit(&servicio.cabeza,
+			memory_order_acquire);
+	uint32_t cantidad = cabeza - cola;
+	if (cantidad > maximo)
+		cantidad = maximo;
+
+	for (uint32_t i = 0; i < cantidad; i++) {
+		eventos[i] = servicio.eventos[(cola + i) & (SERVICIO_CAPACIDAD_COLA - 1)];
+	}
+	atomic_store_explicit(&servicio.cola, cola + cantidad, memory_order_release);
+	return cantidad;
+}
+
+uint32_t servicio_pendientes() {
+	uint32_t cola = atomic_load_explicit(&servicio.cola, memory_order_acquire);
+	return atomic_load_explicit(&servicio.cabeza, memory_order_acquire) - cola;
+}
+
+uint32_t servicio_desbordes() {
+	return atomic_load_explicit(&servicio.desbordes, memory_order_relaxed);
+}
+
+/**
+ *	@brief Copia el evento en la posición libre y lo publica
+ *		   avanzando cabeza. Con la cola llena, el evento se
+ *		   descarta y se cuenta: los ya publicados se conservan
+ *		   para que el consumidor los reciba en orden.
+ */
+static void servicio_publicar(uint8_t lector, mfrc522_evento_enum evento,
+		const mfrc522_uid_t *uid) {
+	uint32_t cabeza = atomic_load_explicit(&servicio.cabeza,
+			memory_order_relaxed);
+	uint32_t cola = atomic_load_explicit(&servicio.cola, memory_order_acquire);
+
+	if (cabeza - cola == SERVICIO_CAPACIDAD_COLA) {
+		uint32_t desbordes = atomic_load_explicit(&servicio.desbordes,
+				memory_order_relaxed);
+		atomic_store_explicit(&servicio.desbordes, desbordes + 1,
+				memory_order_relaxed);
+		return;
+	}
+
+	servicio_evento_t *destino =
+			&servicio.eventos[cabeza & (SERVICIO_CAPACIDAD_COLA - 1)];
+	destino->uid = *uid;
+	destino->tiempo = portGetTick();
+	destino->lector = lector;
+	destino->evento = (uint8_t) evento;
+	atomic_store_explicit(&servicio.cabeza, cabeza + 1, memory_order_release);
+}
@@ -0,0 +1,69 @@
+/**
+ * @file API_servicio_port.c
+ * @brief Implementa las funciones del módulo API_servicio_port
+ *		  con la interrupción de actualización de SERVICIO_TIM.
+ *		  El timer cuenta a SERVICIO_FRECUENCIA_TIM y se recarga
+ *		  cada periodoMs ms. Si una pasada del servicio dura más
+ *		  que el período, la interrupción queda pendiente y la
+ *		  siguiente pasada empieza al terminar la actual.
+ */
+
+#include "API_servicio_port.h"
+#include "API_servicio.h"
+
+/**
+ *   @brief Configura el timer y habilita su interrupción.
+ *          El reloj de los timers de APB1 es el doble de PCLK1
+ *          si APB1 tiene prescaler.
+ *   @retval Falso si el período no entra en el timer o si el
+ *           SysTick no puede interrumpir al servicio (HAL_GetTick
+ *           no avanzaría durante las esperas del driver).
+ */
+bool_t temporizadorIniciar(uint32_t periodoMs) {
+	if (periodoMs == 0 || periodoMs > SERVICIO_PERIODO_MAX_MS
+			|| NVIC_GetPriority(SysTick_IRQn) >= SERVICIO_PRIORIDAD_IRQ)
+		return false;
+
+	uint32_t reloj = HAL_RCC_GetPCLK1Freq();
+	if (RCC->CFGR & RCC_CFGR_PPRE1_2)
+		reloj *= 2;
+
+	__HAL_RCC_TIM3_CLK_ENABLE();
+	SERVICIO_TIM->CR1 = 0;
+	SERVICIO_TIM->PSC = reloj / SERVICIO_FRECUENCIA_TIM - 1;
+	SERVICIO_TIM->ARR = periodoMs * SERVICIO_FRECUENCIA_TIM / 1000 - 1;
+	SERVICIO_TIM->EGR = TIM_EGR_UG;		//carga PSC sin esperar una actualización
+	SERVICIO_TIM->SR = 0;
+	SERVICIO_TIM->DIER = TIM_DIER_UIE;
+
+	HAL_NVIC_SetPriority(SERVICIO_TIM_IRQN, SERVICIO_PRIORIDAD_IRQ, 0);
+	HAL_NVIC_EnableIRQ(SERVICIO_TIM_IRQN);
+	SERVICIO_TIM->CR1 = TIM_CR1_CEN;
+	return true;
+}
+
+/**
+ *   @brief Como la interrupción del servicio tiene prioridad
+ *          sobre el loop principal, al ejecutarse esta función
+ *          no hay una pasada en curso.
+ */
+void temporizadorDetener() {
+	SERVICIO_TIM->CR1 = 0;
+	SERVICIO_TIM->DIER = 0;
+	HAL_NVIC_DisableIRQ(SERVICIO_TIM_IRQN);
+	HAL_NVIC_ClearPendingIRQ(SERVICIO_TIM_IRQN);
+	SERVICIO_TIM->SR = 0;
+}
+
+void temporizadorIrqHandler() {
+	if (SERVICIO_TIM->SR & TIM_SR_UIF) {
+		SERVICIO_TIM->SR = ~TIM_SR_UIF;
+		servicio_ejecutar();
+	}
+}
+
+#if SERVICIO_DEFINIR_IRQ
+void SERVICIO_TIM_HANDLER(void) {
+	temporizadorIrqHandler();
+}
+#endif
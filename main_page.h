@@ -17,12 +17,49 @@ Este trabajo consiste en el desarrollo de un sistema de control de acceso que ut
 *
 * El driver permite el acceso a una interfaz simple con funciones que permiten inicializar el módulo y leer el UID de una tarjeta. El resto de funciones necesarias para el correcto manejo del módulo están declaradas como static en el archivo API_mfrc522.c.
 *
+* Para usar varios lectores, cada uno se maneja con una estructura mfrc522_t y las funciones mfrc522_lector*. Cada lector tiene sus propios pines de CS e IRQ y puede compartir el bus SPI con los demás (configuración en API_mfrc522_port.h). La función mfrc522_leerLectores lee todos los lectores en forma intercalada: mientras un lector espera la respuesta de la tarjeta, el bus SPI se usa para los demás. Las funciones sin lector operan sobre el lector 0.
+* Arranque en caliente: mfrc522_lectorInit lee la configuración del MFRC522 en una única transferencia y, si el lector ya está configurado (el procesador se reinició sin cortar la alimentación), solo detiene el comando en curso y enciende la antena. Si no, realiza un SoftReset y escribe la configuración con una única cadena de DMA. En ambos casos espera a que el bit PowerDown pase a 0 en lugar de usar delays fijos. LCD_init consulta la causa del reinicio (port_reinicioEnCaliente) y, en un reinicio en caliente, omite las esperas del encendido y solo resincroniza el modo de 4 bits.
+* Seguimiento de presencia: mfrc522_presencia informa la llegada, la permanencia y el retiro de una tarjeta. Solo la llegada usa REQA y la selección completa; luego la tarjeta se detiene con HLTA y se despierta con WUPA, y mientras queda en READY cada sondeo es un único comando de anticolisión que además verifica el UID. El retiro se informa luego de una cantidad de sondeos fallidos seguidos y de una ventana de tiempo sin respuesta (mfrc522_presenciaConfigurar), para no informar dos veces una tarjeta que se aleja y vuelve enseguida.
+* Tiempo de espera: cada comando a la tarjeta indica el tiempo máximo hasta el inicio de su respuesta, y el driver programa el timer del MFRC522 con ese valor (la recarga viaja en la misma cadena de DMA del comando, solo si cambió). El mismo valor, sumado a la duración de la transmisión, limita la espera del procesador. Los comandos de la lectura usan MFRC522_ESPERA_TRAMA_US (configurable con mfrc522_esperaConfigurar), por lo que una lectura sin tarjeta termina en cuanto lo permite ISO/IEC 14443-3.
+* Telemetría y ajuste del receptor: cada lector cuenta sus lecturas (aciertos, sin tarjeta, fallidas y reintentos por acierto) y los errores de cada intercambio (timeouts, CRC, paridad, protocolo, desbordes de la FIFO y colisiones), con los valores de ComIrqReg y ErrorReg que el driver ya lee, sin transferencias SPI adicionales. mfrc522_lectorTelemetria devuelve los contadores y el último ErrorReg con error. mfrc522_lectorRfLeer y mfrc522_lectorRfConfigurar leen y escriben la ganancia (RFCfgReg), el umbral de recepción (RxThresholdReg) y la conductancia de la antena (CWGsPReg, GsNReg). mfrc522_lectorAutoajustar, con una tarjeta apoyada en el lector, recorre esos parámetros de a uno (ganancia, umbral, conductancia y de nuevo ganancia), mide cada configuración con lecturas WUPA y HLTA, y deja la que logra más lecturas con menos intercambios; si ninguna lee la tarjeta, restaura la configuración anterior.
+* Interrupciones: API_mfrc522_port.c define las rutinas de atención de los streams de DMA del SPI y los callbacks HAL_SPI_TxCpltCallback, HAL_SPI_TxRxCpltCallback y HAL_SPI_ErrorCallback, y con IRQ_HABILITADA = 1 también la de EXTI9_5 y HAL_GPIO_EXTI_Callback. Como la HAL tiene un único callback de cada tipo para todos los periféricos, una aplicación que ya los define (por ejemplo, con CubeMX) compila con MFRC522_DEFINIR_IRQ = 0 y llama desde ellos a portIrqCallback, portSpiCpltCallback, portSpiErrorCallback, portSpiDmaTxIrqHandler y portSpiDmaRxIrqHandler.
+*
+* Los archivos API_accesos.h y API_accesos.c permiten decidir si un UID está autorizado con un tiempo de búsqueda constante. Las listas fijas se convierten con la herramienta Host/Tools/gen_tabla_accesos.c en una tabla con hash perfecto que se guarda en flash, y las listas que cambian en ejecución se guardan en una tabla con direccionamiento abierto.
+*
+* Los archivos API_registro.h y API_registro.c guardan en la flash un registro de cada lectura (UID, marca de tiempo y decisión de acceso). registro_agregar solo copia el evento a un buffer en RAM, y registro_procesar escribe páginas de REGISTRO_EVENTOS_PAGINA eventos en un log circular que recorre los sectores reservados en orden, por lo que todos se borran la misma cantidad de veces. El borrado de un sector se inicia sin bloquear. Cada evento lleva un número de secuencia y un CRC-16: al arrancar, registro_init encuentra la posición de escritura leyendo el primer evento de cada sector y con una búsqueda binaria, y el recorrido (registro_iniciarRecorrido, registro_siguiente) descarta los eventos que quedaron a medio escribir. El acceso a la flash está en API_registro_port.h y API_registro_port.c (sectores 2 y 3 del STM32F4, que el linker script debe excluir de la región FLASH).
+*
+* Los archivos API_servicio.h y API_servicio.c ejecutan el seguimiento de presencia de varios lectores en segundo plano: servicio_ejecutar sondea cada lector y publica las llegadas y retiros, con el UID, el lector y el tiempo, en una cola circular de un productor y un consumidor sin bloqueos (contadores atómicos, sin deshabilitar interrupciones). El loop principal retira los eventos de a lotes con servicio_extraer, y los eventos que encuentran la cola llena se cuentan en servicio_desbordes. API_servicio_port.h y API_servicio_port.c llaman a servicio_ejecutar desde la interrupción de TIM3, con prioridad menor que el SysTick y las interrupciones del driver; con un RTOS se puede llamar desde una tarea. Si la aplicación ya define TIM3_IRQHandler, se compila con SERVICIO_DEFINIR_IRQ = 0 y se llama desde ella a temporizadorIrqHandler.
+*
 *
 *
 * @subsection display_lcd Display LCD
 Se desarrolló un driver para un display LCD de 16x2 con adaptador para comunicación por I2C. 
 
 El driver está compuesto por los archivos API_lcd.h, API_lcd.c y la implementación para acceder al hardware API_lcd_port.h y API_lcd_port.c. La implementación pública en API_lcd.h permite el acceso a funciones para la inicialización, borrado de pantalla, escritura de un caracter, escritura de un texto y configuración del cursor.
+
+El driver mantiene en RAM una copia de la pantalla. Las funciones LCD_bufferWrite y LCD_flush permiten preparar el contenido en RAM y luego enviar al LCD únicamente los caracteres que cambiaron.
+
+También dispone de un modo asíncrono: las funciones LCD_printTextAsync, LCD_flushAsync y LCD_clearAsync agregan mensajes a una cola que se envía por I2C con interrupciones o DMA, avanzando con LCD_process sin bloquear el loop principal. API_lcd_port.c define las rutinas de atención del I2C y del DMA y los callbacks HAL_I2C_MasterTxCpltCallback y HAL_I2C_ErrorCallback; si la aplicación ya los define (por ejemplo, con CubeMX o para otros periféricos I2C), se compila con LCD_DEFINIR_IRQ = 0 y se llama desde ellos a port_i2cEvIrqHandler, port_i2cErIrqHandler, port_i2cDmaIrqHandler, port_i2cTxCpltCallback y port_i2cErrorCallback.
+
+Para usar varios displays, cada uno se maneja con una estructura LCD_HandleTypedef y las funciones LCD_display*, indicando su bus I2C, su dirección y su geometría (hasta 20x4). Los displays de un mismo bus se atienden por turnos: en cada turno se envía a un display un lote de hasta LCD_MENSAJES_POR_TURNO mensajes de su cola, y mientras un display ejecuta un comando lento el bus atiende a los demás. Las funciones sin handle operan sobre el display por defecto (LCD_BUS, LCD_ADDRESS, 16x2).
+
+Los textos pueden contener caracteres Latin-1, escritos en UTF-8 o Latin-1. Los archivos API_lcd_glifos.h y API_lcd_glifos.c contienen una tabla constante que traduce cada caracter a un código de la ROM del display (por ejemplo ñ y °), a un glifo propio (por ejemplo á, é, ¿ y ¡) o a un caracter ASCII de reemplazo. Cada display lleva la cuenta de los glifos cargados en las 8 posiciones de la CGRAM: un glifo se carga solo la primera vez que se necesita, y cuando no hay lugar se reemplaza el usado hace más tiempo entre los que no están en pantalla.
+
+Los textos más largos que una fila se muestran con una marquesina: LCD_marquesinaEscribir escribe el texto una sola vez en la linea de 40 posiciones de DDRAM de la fila, y LCD_marquesinaTick, llamada desde el loop principal, encola un comando de desplazamiento del display cada vez que pasa el período indicado en LCD_marquesinaIniciar. Cada paso cuesta un comando (4 bytes por I2C) en lugar de volver a escribir la fila. El desplazamiento lo hace el controlador y mueve todas las filas a la vez.
+
+LCD_printf y LCD_printAt generan texto con formato directamente en el buffer de pantalla, con el formateador reducido de API_lcd_formato.c (enteros, hexadecimal, punto fijo, relleno y bytes en hexadecimal para mostrar un UID con %*h), sin printf de la biblioteca C, sin memoria dinámica y sin buffers intermedios. LCD_writeSpan escribe una cantidad acotada de caracteres de un texto que no necesita terminar en '\\0'.
+*
+*
+*
+* @subsection interfaz_cpp Interfaz en C++
+Los archivos API_mfrc522.hpp y API_lcd.hpp, solo de encabezado, ofrecen una interfaz en C++17 para un subconjunto bloqueante de ambos drivers: cada lector es un tipo Mfrc522<Bus, CsPin> y cada display un tipo Lcd<Bus, Address, Cols, Rows>. El bus, el pin de CS, la dirección y la geometría son parámetros del template, por lo que las secuencias de configuración de registros, el valor del timer, la secuencia de inicialización del PCF8574 y las direcciones de DDRAM de cada fila se calculan al compilar, sin handles ni punteros a funciones. API_mfrc522_port.hpp y API_lcd_port.hpp contienen el bus SPI, el pin de CS y el bus I2C del STM32F4. Los DMA, las interrupciones, el seguimiento de tarjetas, el buffer de pantalla, la cola asíncrona y los glifos siguen estando solo en los drivers en C.
+*
+*
+*
+* @subsection instrumentacion Instrumentación
+Los archivos API_instrumentacion.h y API_instrumentacion.c (carpeta Common) permiten medir, para las transferencias SPI e I2C, los delays, la lectura de UID, la espera de respuesta de la tarjeta y LCD_printText, la cantidad de llamadas, los bytes, los timeouts y un histograma de latencia en ciclos del procesador. Se habilita compilando con INSTR_HABILITADA = 1; por defecto las macros de medición no generan código. Los drivers solo incluyen API_instrumentacion.h cuando está habilitada, por lo que recién entonces hay que agregar Common/Inc a las rutas de include y Common/Src a las fuentes del proyecto.
+*
+* Los archivos API_traza.h y API_traza.c (carpeta Common) registran cada transacción de los ports (spiWrite, spiRead, spiTransfer, las cadenas con DMA y las escrituras I2C) con su tiempo, lector o bus, registro o dirección, datos y error, en un buffer circular en RAM de TRAZA_TAMANIO_BUFFER bytes con encabezados de 5 bytes. traza_volcar entrega la traza como texto, por ejemplo para enviarla por una UART. Se habilita compilando con TRAZA_HABILITADA = 1, y al igual que la instrumentación, solo entonces los ports incluyen API_traza.h y hace falta la carpeta Common. En la PC, Host/Tools/comparar_trazas.c reproduce una traza en el driver del MFRC522 con el port API_mfrc522_port_replay.c, que devuelve al driver las lecturas grabadas, y compara las transacciones y el tiempo de bus con los grabados; también compara dos trazas entre sí.
 *
 *
 *